@@ -0,0 +1,35 @@
+#ifndef SYSYF_ALIASUTILS_H
+#define SYSYF_ALIASUTILS_H
+
+#include "Instruction.h"
+#include "Value.h"
+#include "internal_types.h"
+
+namespace SysYF {
+namespace IR {
+
+/**
+ * @brief the global, alloca or argument that ptr is derived from through geps and bitcasts
+ */
+Ptr<Value> get_underlying_object(Ptr<Value> ptr);
+
+/**
+ * @brief whether pointers into the two underlying objects may overlap
+ *
+ * Distinct globals and allocas never overlap. A pointer argument may point
+ * into any global or into the array another argument points to, but not
+ * into an alloca of the function it is passed to.
+ */
+bool may_alias_objects(Ptr<Value> obj1, Ptr<Value> obj2);
+
+/**
+ * @brief byte offset of a gep whose indices are all constants
+ *
+ * @return false if some index is not a constant
+ */
+bool get_constant_offset(Ptr<GetElementPtrInst> gep, int &offset);
+
+}
+}
+
+#endif // SYSYF_ALIASUTILS_H
@@ -0,0 +1,110 @@
+#ifndef SYSYF_CFGUTILS_H
+#define SYSYF_CFGUTILS_H
+
+#include "BasicBlock.h"
+#include "CloneUtils.h"
+#include "DominateTree.h"
+#include "Function.h"
+#include "Instruction.h"
+#include "internal_types.h"
+#include <set>
+#include <vector>
+
+namespace SysYF {
+namespace IR {
+
+/**
+ * Edits of the CFG shared by the passes. Each one leaves the terminators,
+ * the predecessor and successor lists and the phis consistent with each
+ * other. New blocks are unnamed; one that takes over edges into a block is
+ * placed in front of it unless that is the entry, the second half of a
+ * split block right after the first half, and copies at the end.
+ *
+ * The edits that take an updates list append the edges they added and
+ * removed to it when it is given, for DominateTree::apply_updates().
+ */
+
+/**
+ * @brief the blocks reachable from the entry of f in reverse post order
+ */
+PtrVec<BasicBlock> get_reverse_post_order(Ptr<Function> f);
+
+/**
+ * @brief delete the blocks of f that the entry does not reach
+ *
+ * Phis drop their entries from the deleted blocks, and a phi left without
+ * entries is replaced by zero. Returns whether a block was deleted.
+ */
+bool remove_unreachable_blocks(Ptr<Function> f, std::vector<DominateTree::Update> *updates = nullptr);
+
+/**
+ * @brief put a new block on the edge from -> to and return it
+ *
+ * The branches of from to to go to the new block, which jumps to to. The
+ * phis of to take their values from the new block.
+ */
+Ptr<BasicBlock> split_edge(Ptr<BasicBlock> from, Ptr<BasicBlock> to,
+                           std::vector<DominateTree::Update> *updates = nullptr);
+
+/**
+ * @brief move inst and the instructions after it to a new block and return it
+ *
+ * The block of inst jumps to the new block, which takes over its
+ * successors. inst must not be a phi.
+ */
+Ptr<BasicBlock> split_block_at(Ptr<Instruction> inst);
+
+/**
+ * @brief give the loop of header a single predecessor outside of it
+ *
+ * The edges into header from outside loop_blocks go to a new block that
+ * jumps to header, which is returned; nullptr when there are no such edges.
+ * Where they bring different values into a phi of header, a phi in the
+ * new block merges them.
+ */
+Ptr<BasicBlock> insert_preheader(Ptr<BasicBlock> header, const std::set<Ptr<BasicBlock>> &loop_blocks,
+                                 std::vector<DominateTree::Update> *updates = nullptr);
+
+/**
+ * @brief make the loop left only into blocks that nothing else jumps to
+ *
+ * An exit of loop_blocks that is also entered from outside the loop gets a
+ * new block for the edges from the loop, like insert_preheader. Returns
+ * whether a block was added.
+ */
+bool form_dedicated_exits(const std::set<Ptr<BasicBlock>> &loop_blocks);
+
+/**
+ * @brief copy blocks to the end of f and return the copies in the same order
+ *
+ * Values that vmap maps already are replaced by what they map to, e.g.
+ * the arguments of the function the blocks come from. On return vmap maps
+ * every block and instruction of the region to its copy as well.
+ *
+ * A branch out of the region keeps its target, and the phis there get the
+ * same entry for the copy as for the original. The phis of the copies keep
+ * their entries from outside the region; the edges that enter the copy
+ * are up to the caller.
+ */
+PtrVec<BasicBlock> clone_region(const PtrVec<BasicBlock> &blocks, Ptr<Function> f, ValueMap &vmap);
+
+/**
+ * @brief append bb to its single predecessor when that one always jumps to bb
+ *
+ * bb is removed from its function. Returns whether it was merged.
+ */
+bool merge_into_predecessor(Ptr<BasicBlock> bb, std::vector<DominateTree::Update> *updates = nullptr);
+
+/**
+ * @brief replace a conditional branch of bb on a constant by a jump
+ *
+ * The phis of the target that is no longer taken drop their entries from
+ * bb, which may leave that target unreachable. Returns the taken target,
+ * or nullptr when bb does not end in such a branch.
+ */
+Ptr<BasicBlock> fold_constant_branch(Ptr<BasicBlock> bb);
+
+}
+}
+
+#endif // SYSYF_CFGUTILS_H
@@ -6,20 +6,41 @@
 #include "Instruction.h"
 #include "Module.h"
 #include "Pass.h"
+#include "internal_types.h"
 
 namespace SysYF {
 namespace IR {
 
+/**
+ * Verifies the IR: the pred and succ lists of the blocks agree, every block
+ * ends in its only terminator, every operand is in its use list and is
+ * defined, and a definition dominates its uses.
+ *
+ * A function that passed keeps a fingerprint of its blocks, instructions,
+ * operands and edges, and is skipped while the fingerprint stays the same,
+ * so checking after every pass costs a walk of each function plus the
+ * checks of the functions the pass changed. All errors are written to
+ * stderr.
+ */
 class Check: public Pass {
 private:
     const std::string name = "Check";
 public:
     explicit Check(WeakPtr<Module> m): Pass(m) {}
     ~Check() {}
-    void execute() final;
+    // exits when the module is broken
+    bool execute() final;
     const std::string get_name() const override {return name;}
+    // checks the functions changed since the last call, returns the number of errors
+    int verify();
+
+private:
+    static std::size_t fingerprint(Ptr<Function> func);
+    int verify_function(Ptr<Function> func);
+
+    DenseMap<Function *, std::size_t> verified;
 };
 
 }
 }
-#endif
\ No newline at end of file
+#endif
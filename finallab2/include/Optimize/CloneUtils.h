@@ -0,0 +1,45 @@
+#ifndef SYSYF_CLONEUTILS_H
+#define SYSYF_CLONEUTILS_H
+
+#include "BasicBlock.h"
+#include "Function.h"
+#include "Instruction.h"
+#include "internal_types.h"
+#include <map>
+#include <string>
+
+namespace SysYF {
+namespace IR {
+
+using ValueMap = std::map<Ptr<Value>, Ptr<Value>>;
+
+/**
+ * @brief append a copy of inst to bb
+ *
+ * Branch targets and phi incoming blocks are looked up in vmap right away,
+ * other operands still refer to the original values until remap_operands.
+ */
+Ptr<Instruction> clone_instruction(Ptr<Instruction> inst, Ptr<BasicBlock> bb, const ValueMap &vmap);
+
+/**
+ * @brief rewrite every operand of inst that has an entry in vmap
+ */
+void remap_operands(Ptr<Instruction> inst, const ValueMap &vmap);
+
+/**
+ * @brief copy the body of src into the empty function dst
+ *
+ * Arguments are mapped by position. On return vmap maps every argument,
+ * basic block and instruction of src to its copy in dst.
+ */
+void clone_function_body(Ptr<Function> src, Ptr<Function> dst, ValueMap &vmap);
+
+/**
+ * @brief prefix followed by the smallest number no function of m is named with
+ */
+std::string get_unique_function_name(Ptr<Module> m, const std::string &prefix);
+
+}
+}
+
+#endif // SYSYF_CLONEUTILS_H
@@ -12,6 +12,7 @@
 #include "Instruction.h"
 #include "IRBuilder.h"
 #include "Constant.h"
+#include "CFGUtils.h"
 #include <string>
 #include <vector>
 
@@ -27,24 +28,24 @@ public:
         return "CodeSizeOptimizer";
     }
     
-    void execute() override;
+    bool execute() override;
 
 private:
     bool is_loop_block(Ptr<BasicBlock> bb);
-    void optimize_loop_block(Ptr<BasicBlock> bb);
+    bool optimize_loop_block(Ptr<BasicBlock> bb);
     bool is_loop_invariant(Ptr<Instruction> instr);
-    Ptr<BasicBlock> create_loop_preheader(Ptr<BasicBlock> loop_header, 
-                                        const std::vector<Ptr<Instruction>>& invariant_instrs);
+    Ptr<BasicBlock> create_loop_preheader(Ptr<BasicBlock> loop_header);
     void move_invariant_instructions(const std::vector<Ptr<Instruction>>& invariant_instrs,
                                    Ptr<BasicBlock> preheader);
     std::string get_expression_key(Ptr<BinaryInst> binop);
     std::string get_operand_string(Value* op);
-    void replace_all_uses_with(Ptr<Value> old_val, Ptr<Value> new_val);
-    void merge_similar_functions();
+    bool merge_similar_functions();
     bool are_functions_similar(Ptr<Function> f1, Ptr<Function> f2);
     float calculate_similarity(Ptr<Function> f1, Ptr<Function> f2);
+    // copies the bodies of f1 and f2 into a new function that runs the one
+    // its last argument selects, 0 for f1; f1 and f2 no longer use any value
     Ptr<Function> create_merged_function(Ptr<Function> f1, Ptr<Function> f2);
-    void replace_function_calls(Ptr<Function> old_func, Ptr<Function> new_func);
+    void replace_function_calls(Ptr<Function> old_func, Ptr<Function> new_func, int discriminator);
     std::string get_merged_name(Ptr<Function> f1, Ptr<Function> f2);
 };
 
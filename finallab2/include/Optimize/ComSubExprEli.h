@@ -32,6 +32,12 @@ struct cmp_expr{
         if(opa < opb) return true;
         else if(opa > opb) return false;
 
+        // casts of one value differ only in their type, the module keeps one object per type
+        Type *tya = a.lock()->get_type().get();
+        Type *tyb = b.lock()->get_type().get();
+        if(tya < tyb) return true;
+        else if(tya > tyb) return false;
+
         if(a.lock()->isBinary()) {
             Ptr<Value> opral = a.lock()->get_operand(0);
             Ptr<Value> oprar = a.lock()->get_operand(1);
@@ -43,7 +49,8 @@ struct cmp_expr{
             int oprbl_numbering = nu.const_expr_numbering(oprbl);
             int oprbr_numbering = nu.const_expr_numbering(oprbr);
 
-            if(opa == Instruction::OpID::add || opa == Instruction::OpID::mul || opa == Instruction::OpID::fadd || opa == Instruction::OpID::fmul ) {
+            if(opa == Instruction::OpID::add || opa == Instruction::OpID::mul || opa == Instruction::OpID::fadd || opa == Instruction::OpID::fmul ||
+               opa == Instruction::OpID::and_ || opa == Instruction::OpID::or_ || opa == Instruction::OpID::xor_) {
                 if(opral_numbering > oprar_numbering) {std::swap(opral, oprar);std::swap(opral_numbering, oprar_numbering);}
                 if(oprbl_numbering > oprbr_numbering) {std::swap(oprbl, oprbr);std::swap(oprbl_numbering, oprbr_numbering);}
             }
@@ -86,7 +93,8 @@ struct cmp_expr{
                 if(oprar_ptr < oprbr_ptr) return true;
                 else return false;
             }
-        } else if(a.lock()->is_gep()){
+        } else if(a.lock()->is_gep() || a.lock()->is_select() ||
+                  a.lock()->is_insertelement() || a.lock()->is_extractelement()){
             int opra_num = a.lock()->get_num_operand();
             int oprb_num = b.lock()->get_num_operand();
             if(opra_num <= oprb_num) {
@@ -143,7 +151,7 @@ struct cmp_expr{
                 }
                 return false;
             }
-        } else { //sitofp
+        } else { // casts: sitofp, fptosi, zext, bitcast, ...
             int opra_numbering = nu.const_expr_numbering(a.lock()->get_operand(0));
             int oprb_numbering = nu.const_expr_numbering(b.lock()->get_operand(0));
             if(opra_numbering < oprb_numbering) return true;
@@ -237,7 +245,7 @@ class ComSubExprEli : public Pass {
 public:
     explicit ComSubExprEli(WeakPtr<Module> m):Pass(m){}
     const std::string get_name() const override {return name;}
-    void execute() override;
+    bool execute() override;
     void compute_local_gen(Ptr<Function> func);
     void compute_global_in_out(Ptr<Function> func);
     void compute_global_common_expr(Ptr<Function> func);
@@ -0,0 +1,71 @@
+#ifndef SYSYF_CONDITIONUTILS_H
+#define SYSYF_CONDITIONUTILS_H
+
+#include "BasicBlock.h"
+#include "Instruction.h"
+#include "Value.h"
+#include "internal_types.h"
+#include <map>
+#include <vector>
+
+namespace SysYF {
+namespace IR {
+
+/**
+ * @brief a compare that is known to give taken
+ */
+struct Condition {
+    Ptr<CmpInst> cmp;
+    bool taken;
+};
+
+using ConditionMap = std::map<Ptr<BasicBlock>, std::vector<Condition>>;
+
+/**
+ * @brief the op of b op' a that is a op b
+ */
+CmpInst::CmpOp swap_operands(CmpInst::CmpOp op);
+
+/**
+ * @brief the op that holds exactly when op does not
+ */
+CmpInst::CmpOp negate(CmpInst::CmpOp op);
+
+/**
+ * @brief the signed compare lhs op rhs
+ */
+bool evaluate_compare(CmpInst::CmpOp op, int lhs, int rhs);
+
+/**
+ * @brief whether a and b are the same value; constants are not unique, so they are compared by value
+ */
+bool is_same_value(Ptr<Value> a, Ptr<Value> b);
+
+/**
+ * @brief whether the terminator of from branches on a compare, and its outcome towards to
+ *
+ * A branch on icmp ne (zext %c), 0 is taken as a branch on %c.
+ */
+bool get_edge_condition(Ptr<BasicBlock> from, Ptr<BasicBlock> to, Condition &cond);
+
+/**
+ * @brief the conditions that hold in each block of order
+ *
+ * order is a reverse post order whose idoms are up to date. A block has
+ * the conditions of its idom, and the condition of the edge from its
+ * predecessor when that is the only one.
+ */
+void collect_conditions(const PtrVec<BasicBlock> &order, ConditionMap &conditions);
+
+/**
+ * @brief whether one of conds on the same operands decides lhs op rhs
+ *
+ * @return false if none of them does, result is the outcome otherwise
+ */
+bool decide_by_conditions(const std::vector<Condition> &conds, CmpInst::CmpOp op,
+                          Ptr<Value> lhs, Ptr<Value> rhs, bool &result);
+
+}
+}
+
+#endif // SYSYF_CONDITIONUTILS_H
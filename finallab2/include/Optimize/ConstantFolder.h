@@ -0,0 +1,38 @@
+#ifndef SYSYF_CONSTANTFOLDER_H
+#define SYSYF_CONSTANTFOLDER_H
+
+#include "Constant.h"
+#include "Function.h"
+#include "Instruction.h"
+#include "Module.h"
+#include "internal_types.h"
+
+namespace SysYF {
+namespace IR {
+
+/**
+ * @brief evaluate inst when all of its operands are constants
+ *
+ * @return the folded constant, or nullptr if inst can not be folded
+ * (non-constant operands, division by zero, overflowing fptosi, ...)
+ */
+Ptr<Constant> fold_constant(Ptr<Instruction> inst, Ptr<Module> m);
+
+/**
+ * @brief evaluate the i32 binary operation lhs op rhs
+ *
+ * @return the folded constant, or nullptr if it is undefined
+ */
+Ptr<Constant> fold_binary(Instruction::OpID op, Ptr<ConstantInt> lhs, Ptr<ConstantInt> rhs, Ptr<Module> m);
+
+/**
+ * @brief replace every foldable instruction of f by its value
+ *
+ * @return true if any instruction was removed
+ */
+bool fold_constants(Ptr<Function> f);
+
+}
+}
+
+#endif // SYSYF_CONSTANTFOLDER_H
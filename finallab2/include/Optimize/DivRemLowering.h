@@ -0,0 +1,49 @@
+#ifndef SYSYF_DIVREMLOWERING_H
+#define SYSYF_DIVREMLOWERING_H
+
+#include "BasicBlock.h"
+#include "Constant.h"
+#include "Function.h"
+#include "Instruction.h"
+#include "Module.h"
+#include "Pass.h"
+#include "internal_types.h"
+
+namespace SysYF {
+namespace IR {
+
+/*****************************DivRemLowering**************************************/
+/**
+ * Rewrites sdiv and srem by a constant into shifts and multiplications.
+ * A power-of-two divisor becomes a biased arithmetic shift, any other
+ * divisor a multiplication by its magic number that keeps the high half
+ * of the 64 bit product (Hacker's Delight, chapter 10). The quotient is
+ * rounded toward zero like sdiv, the remainder is x - q * d. udiv and
+ * urem by a power of two become a logical shift and a mask.
+ */
+class DivRemLowering : public Pass {
+public:
+    explicit DivRemLowering(WeakPtr<Module> m) : Pass(m) {}
+    const std::string get_name() const override {return name;}
+    bool execute() override;
+
+private:
+    Ptr<Value> lower(Ptr<BinaryInst> inst, int divisor);
+    Ptr<Value> add_rounding_bias(Ptr<Value> x, int k);
+    Ptr<Value> lower_pow2_div(Ptr<Value> x, int divisor);
+    Ptr<Value> lower_pow2_rem(Ptr<Value> x, int divisor);
+    Ptr<Value> lower_magic_div(Ptr<Value> x, int divisor);
+    // move a freshly created instruction from the end of its block in front of pos_
+    template <typename T>
+    Ptr<T> insert(Ptr<T> inst);
+    Ptr<ConstantInt> get_int(int val);
+
+    Ptr<BasicBlock> bb_;
+    Ptr<Instruction> pos_;
+    const std::string name = "DivRemLowering";
+};
+
+}
+}
+
+#endif // SYSYF_DIVREMLOWERING_H
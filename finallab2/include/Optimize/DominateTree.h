@@ -2,28 +2,76 @@
 #define SYSYF_DOMINATETREE_H
 
 #include "BasicBlock.h"
+#include "Instruction.h"
 #include "Module.h"
 #include "Pass.h"
 #include "internal_types.h"
 #include <memory>
+#include <vector>
 
 namespace SysYF {
 namespace IR {
 
+/*****************************DominateTree**************************************/
+/**
+ * Finds the immediate dominators with the iterative algorithm of Cooper,
+ * Harvey and Kennedy, and stores on every block its idom, its children in
+ * the tree, its dominance frontier and the numbers of a walk of the tree.
+ * A block dominates another when its numbers enclose the other's, so
+ * dominates() answers in constant time. The results hold until the CFG
+ * changes.
+ *
+ * Blocks that cannot be reached from the entry have no idom and no
+ * numbers, and are left out of the frontiers.
+ *
+ * A pass that adds or removes edges can keep the results with
+ * apply_updates() instead of running the pass again. Only the idoms below
+ * the nearest common dominator of the changed edges can change, so only
+ * that subtree is recomputed, together with the frontiers of its blocks.
+ * The frontiers are rebuilt right away rather than on first use because
+ * they are stored on the blocks, and mem2reg reads them from there
+ * without going through this class.
+ */
 class DominateTree: public Pass {
 public:
+    // an edge from -> to that was added to or removed from the CFG
+    struct Update {
+        enum Kind {Insert, Delete};
+        Kind kind;
+        Ptr<BasicBlock> from;
+        Ptr<BasicBlock> to;
+    };
+
     explicit DominateTree(WeakPtr<Module> m): Pass(m) {}
-    void execute() final;
-    void get_revserse_post_order(Ptr<Function> f);
-    void get_post_order(Ptr<BasicBlock> bb, PtrSet<BasicBlock>& visited);
-    void get_bb_idom(Ptr<Function> f);
-    void get_bb_dom_front(Ptr<Function> f);
-    Ptr<BasicBlock> intersect(Ptr<BasicBlock> b1, Ptr<BasicBlock> b2);
+    bool execute() final;
     const std::string get_name() const override {return name;}
+
+    // computes the results of f alone
+    void run(Ptr<Function> f);
+    // brings the results of f up to date once the CFG reflects updates;
+    // new blocks need no entry of their own beyond the edges that reach them
+    void apply_updates(Ptr<Function> f, const std::vector<Update> &updates);
+
+    // a block dominates itself, and every block dominates an unreachable one
+    static bool dominates(Ptr<BasicBlock> a, Ptr<BasicBlock> b);
+    // a is in a block that strictly dominates the block of b, or comes before b in the same block;
+    // the block numbers its instructions again on the first query after an insertion
+    static bool dominates(Ptr<Instruction> a, Ptr<Instruction> b);
+
 private:
-    WeakPtrList<BasicBlock> reverse_post_order;
-    WeakPtrMap<BasicBlock, int> bb2int;
-    WeakPtrVec<BasicBlock> doms;
+    // recomputes the subtree of root, whose own idom stays; a block takes part
+    // while it is unnumbered or numbered within [lo, hi]
+    void update_subtree(Ptr<BasicBlock> root, int lo, int hi);
+    void get_reverse_post_order(Ptr<BasicBlock> root, int lo, int hi);
+    void get_bb_idom();
+    void get_bb_dom_front();
+    // numbers the subtree of root from counter on, returns the next free number
+    static int number_tree(Ptr<BasicBlock> root, int counter);
+    int intersect(int b1, int b2);
+
+    PtrVec<BasicBlock> reverse_post_order;
+    DenseMap<BasicBlock *, int> bb2int;     // position in reverse_post_order
+    std::vector<int> doms;                  // idom by position, -1 while unknown
     const std::string name = "DominateTree";
 };
 
@@ -0,0 +1,43 @@
+#ifndef SYSYF_FINALVALUEREPLACEMENT_H
+#define SYSYF_FINALVALUEREPLACEMENT_H
+
+#include "BasicBlock.h"
+#include "Function.h"
+#include "Instruction.h"
+#include "Module.h"
+#include "Pass.h"
+#include "ScalarEvolution.h"
+#include "internal_types.h"
+
+namespace SysYF {
+namespace IR {
+
+/*****************************FinalValueReplacement**************************************/
+/***************************This class is based on SSA form*********************************/
+/**
+ * Deletes loops that do nothing but compute values used after them,
+ * replacing those values by their closed form.
+ *
+ *   i = 0; s = 0;
+ *   while (i < n) { s = s + i; i = i + 1; }      =>     t = n > 0 ? n : 0;
+ *   use(s);                                             use((t >> 1) * ((t - 1) | 1));
+ *
+ * The loop must have a trip count, must not store or call, and every value
+ * it leaves behind must be a recurrence ScalarEvolution can evaluate.
+ */
+class FinalValueReplacement : public Pass {
+public:
+    explicit FinalValueReplacement(WeakPtr<Module> m) : Pass(m) {}
+    const std::string get_name() const override {return name;}
+    bool execute() override;
+
+private:
+    bool replace_loop(Ptr<BasicBlock> header);
+
+    const std::string name = "FinalValueReplacement";
+};
+
+}
+}
+
+#endif // SYSYF_FINALVALUEREPLACEMENT_H
@@ -0,0 +1,42 @@
+#ifndef SYSYF_GLOBALDCE_H
+#define SYSYF_GLOBALDCE_H
+
+#include "Function.h"
+#include "GlobalVariable.h"
+#include "Instruction.h"
+#include "Module.h"
+#include "Pass.h"
+#include "internal_types.h"
+#include <map>
+#include <set>
+
+namespace SysYF {
+namespace IR {
+
+/*****************************GlobalDeadCodeElimination**************************************/
+/**
+ * Removes functions (including runtime declarations) that can not be
+ * reached from main, global variables that are never read, and arguments
+ * that are never used. Functions with dead arguments are recreated with
+ * the smaller signature and every call site is rewritten.
+ */
+class GlobalDCE : public Pass {
+public:
+    explicit GlobalDCE(WeakPtr<Module> m) : Pass(m) {}
+    const std::string get_name() const override {return name;}
+    bool execute() override;
+
+private:
+    bool remove_dead_functions();
+    bool remove_dead_globals();
+    bool remove_dead_args();
+    Ptr<Function> drop_args(Ptr<Function> f, const std::vector<bool> &is_dead, PtrVec<CallInst> &calls);
+    static bool is_write_only(Ptr<Value> ptr, PtrVec<Instruction> &writes);
+
+    const std::string name = "GlobalDCE";
+};
+
+}
+}
+
+#endif // SYSYF_GLOBALDCE_H
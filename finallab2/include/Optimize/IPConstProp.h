@@ -0,0 +1,67 @@
+#ifndef SYSYF_IPCONSTPROP_H
+#define SYSYF_IPCONSTPROP_H
+
+#include "Constant.h"
+#include "Function.h"
+#include "Instruction.h"
+#include "Module.h"
+#include "Pass.h"
+#include "internal_types.h"
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace SysYF {
+namespace IR {
+
+/*****************************InterproceduralConstantPropagation*****************************/
+/***************************This class is based on SSA form*********************************/
+/**
+ * Arguments that receive the same constant at every call site are replaced
+ * by that constant. When the call sites disagree, call sites that share the
+ * same constant arguments are redirected to a specialized clone of the
+ * callee, as long as the clone budget allows it.
+ *
+ * The branches the constants decide are folded in the function or clone
+ * they were put into, and the arms that are no longer taken are removed.
+ */
+class IPConstProp : public Pass {
+public:
+    explicit IPConstProp(WeakPtr<Module> m) : Pass(m) {}
+    const std::string get_name() const override {return name;}
+    bool execute() override;
+    // clone-budget=N
+    bool set_option(const std::string &key, const std::string &value) override;
+
+private:
+    // (argument no, constant passed at a call site)
+    using ArgBinding = std::vector<std::pair<unsigned, Ptr<Constant>>>;
+
+    void collect_call_sites(Ptr<Function> f);
+    bool propagate_uniform_args(Ptr<Function> f);
+    bool specialize(Ptr<Function> f);
+    ArgBinding get_binding(Ptr<Function> f, Ptr<CallInst> call);
+    Ptr<Function> create_specialization(Ptr<Function> f, const ArgBinding &binding);
+    static bool is_same_constant(Ptr<Value> a, Ptr<Value> b);
+    static bool is_interesting_arg(Ptr<Argument> arg);
+    // folds the constants and the branches on them, and removes the arms not taken
+    void simplify(Ptr<Function> f);
+    static unsigned get_instr_count(Ptr<Function> f);
+
+    const std::string name = "IPConstProp";
+    std::map<Ptr<Function>, PtrVec<CallInst>> call_sites;
+    unsigned clone_budget = 0;
+
+    // a function larger than this is never cloned
+    static const unsigned max_spec_func_size = 200;
+    // at most this many clones of one function
+    static const unsigned max_spec_per_func = 4;
+    // total instructions the pass may add to the module
+    unsigned max_clone_budget = 1000;
+};
+
+}
+}
+
+#endif // SYSYF_IPCONSTPROP_H
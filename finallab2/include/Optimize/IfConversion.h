@@ -0,0 +1,51 @@
+#ifndef SYSYF_IFCONVERSION_H
+#define SYSYF_IFCONVERSION_H
+
+#include "BasicBlock.h"
+#include "Function.h"
+#include "Instruction.h"
+#include "Module.h"
+#include "Pass.h"
+#include "internal_types.h"
+
+namespace SysYF {
+namespace IR {
+
+/*****************************IfConversion**************************************/
+/***************************This class is based on SSA form*********************************/
+/**
+ * Replaces small branch diamonds and triangles by select instructions.
+ *
+ *     head                head
+ *    /    \              /    \
+ *  then   else         then    |
+ *    \    /              \    /
+ *     join                join
+ *
+ * The side blocks must only hold a few instructions that can be executed
+ * unconditionally (no memory access, calls or division that may trap).
+ * They are hoisted into head, every phi of join gets a select for the
+ * two incoming values, and head branches straight to join.
+ */
+class IfConversion : public Pass {
+public:
+    explicit IfConversion(WeakPtr<Module> m) : Pass(m) {}
+    const std::string get_name() const override {return name;}
+    bool execute() override;
+
+private:
+    bool convert(Ptr<BasicBlock> head);
+    // then is a side block of head that falls through to join
+    static bool is_side_block(Ptr<BasicBlock> bb, Ptr<BasicBlock> head, Ptr<BasicBlock> join);
+    static bool is_speculatable(Ptr<Instruction> inst);
+    static Ptr<BasicBlock> get_single_succ(Ptr<BasicBlock> bb);
+
+    const std::string name = "IfConversion";
+    // the most instructions hoisted from one side block
+    static const int max_side_size = 4;
+};
+
+}
+}
+
+#endif // SYSYF_IFCONVERSION_H
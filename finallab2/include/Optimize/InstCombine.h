@@ -0,0 +1,76 @@
+#ifndef SYSYF_INSTCOMBINE_H
+#define SYSYF_INSTCOMBINE_H
+
+#include "BasicBlock.h"
+#include "Constant.h"
+#include "Function.h"
+#include "Instruction.h"
+#include "Module.h"
+#include "Pass.h"
+#include "internal_types.h"
+#include <deque>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace SysYF {
+namespace IR {
+
+/*****************************InstructionCombining**************************************/
+/***************************This class is based on SSA form*********************************/
+/**
+ * Peephole simplification driven by a table of algebraic rewrite rules.
+ * Each rule either returns a value that replaces the instruction, rewrites
+ * the instruction in place and returns it, or returns nullptr. Every
+ * instruction starts on a worklist; after a rewrite its users (and the
+ * operands that may have become dead) are revisited until nothing changes.
+ */
+class InstCombine : public Pass {
+public:
+    explicit InstCombine(WeakPtr<Module> m);
+    const std::string get_name() const override {return name;}
+    bool execute() override;
+
+private:
+    using RuleFn = Ptr<Value> (InstCombine::*)(Ptr<Instruction>);
+    struct Rule {
+        std::string name;
+        RuleFn apply;
+    };
+
+    void add_rule(std::vector<Instruction::OpID> ops, std::string rule_name, RuleFn apply);
+    bool combine(Ptr<Function> f);
+    void push(Ptr<Value> val);
+    void push_users(Ptr<Instruction> inst);
+    void erase(Ptr<Instruction> inst);
+    // create the instruction at the end of the block, then move it in front of pos
+    template <typename T>
+    Ptr<T> insert_before(Ptr<T> inst, Ptr<Instruction> pos);
+
+    // rewrite rules
+    Ptr<Value> fold_constant_operands(Ptr<Instruction> inst);
+    Ptr<Value> move_constant_to_rhs(Ptr<Instruction> inst);
+    Ptr<Value> fold_identity(Ptr<Instruction> inst);
+    Ptr<Value> fold_float_identity(Ptr<Instruction> inst);
+    Ptr<Value> fold_same_operands(Ptr<Instruction> inst);
+    Ptr<Value> fold_double_negation(Ptr<Instruction> inst);
+    Ptr<Value> reassociate_constants(Ptr<Instruction> inst);
+    Ptr<Value> fold_bool_compare(Ptr<Instruction> inst);
+    Ptr<Value> fold_compare_of_difference(Ptr<Instruction> inst);
+    Ptr<Value> fold_cast_round_trip(Ptr<Instruction> inst);
+    Ptr<Value> fold_select(Ptr<Instruction> inst);
+
+    static bool is_trivially_dead(Ptr<Instruction> inst);
+    static bool is_exact_in_float(Ptr<Value> val);
+
+    std::map<Instruction::OpID, std::vector<Rule>> rules_;
+    std::deque<Ptr<Instruction>> worklist_;
+    std::set<Ptr<Instruction>> in_worklist_;
+    std::set<Ptr<Instruction>> erased_;
+    const std::string name = "InstCombine";
+};
+
+}
+}
+
+#endif // SYSYF_INSTCOMBINE_H
@@ -0,0 +1,81 @@
+#ifndef SYSYF_JUMPTHREADING_H
+#define SYSYF_JUMPTHREADING_H
+
+#include "BasicBlock.h"
+#include "ConditionUtils.h"
+#include "Constant.h"
+#include "DominateTree.h"
+#include "Function.h"
+#include "Instruction.h"
+#include "Module.h"
+#include "Pass.h"
+#include "internal_types.h"
+#include <map>
+#include <set>
+#include <vector>
+
+namespace SysYF {
+namespace IR {
+
+/*****************************JumpThreading**************************************/
+/***************************This class is based on SSA form*********************************/
+/**
+ * Sends a predecessor straight to the final target when the branch of the
+ * block it jumps to is already decided on that edge.
+ *
+ *   p0: br label %b                        p0: br label %b0
+ *   p1: br label %b                        p1: br label %b1
+ *   b:  %s = phi [ 1, %p0 ], [ 0, %p1 ] => b0: br label %t
+ *       %c = icmp eq i32 %s, 1             b1: br label %f
+ *       br i1 %c, label %t, label %f
+ *
+ * The outcome is known when the condition folds to a constant once the
+ * phis of the block take the values of the edge, or when a compare on the
+ * same operands is known to hold at the end of the predecessor, e.g. the
+ * second test of i > 3 in (i > 3 && i < 10) after the first. The block is
+ * copied for that predecessor, which is cheap as long as it holds at most
+ * max_duplicate instructions; the values it defines get phis where the
+ * copy and the original meet again. Loop headers are neither copied nor
+ * jumped to, so the loops keep their shape.
+ *
+ * Blocks that are always entered from a single predecessor are merged into
+ * it first, so a phi and the compare on it end up in the same block.
+ */
+class JumpThreading : public Pass {
+public:
+    explicit JumpThreading(WeakPtr<Module> m) : Pass(m) {}
+    const std::string get_name() const override {return name;}
+    bool execute() override;
+    // max-rounds=N, max-duplicate=N
+    bool set_option(const std::string &key, const std::string &value) override;
+
+private:
+    void find_loop_headers(Ptr<Function> f);
+    // the conditions of pred and of the edge pred to bb
+    bool decide_by_conditions(Ptr<CmpInst> cmp, Ptr<Value> lhs, Ptr<Value> rhs,
+                              Ptr<BasicBlock> pred, Ptr<BasicBlock> bb, bool &result);
+
+    // the successor bb goes to when entered from pred, or nullptr
+    Ptr<BasicBlock> get_known_target(Ptr<BasicBlock> bb, Ptr<BasicBlock> pred);
+    // what val is when bb is entered from pred: a constant, a value from outside bb, or nullptr
+    Ptr<Value> get_value_on_edge(Ptr<Value> val, Ptr<BasicBlock> bb, Ptr<BasicBlock> pred);
+    bool can_thread(Ptr<BasicBlock> bb);
+    void thread_edge(Ptr<BasicBlock> pred, Ptr<BasicBlock> bb, Ptr<BasicBlock> target);
+
+    // rewrites the uses of def outside bb and copy to the copy_def or a phi of both
+    void repair_ssa(Ptr<Instruction> def, Ptr<BasicBlock> bb, Ptr<Value> copy_def, Ptr<BasicBlock> copy);
+
+    ConditionMap conditions_;
+    std::set<Ptr<BasicBlock>> loop_headers_;
+    // the edges changed since the dominator tree was last brought up to date
+    std::vector<DominateTree::Update> cfg_updates_;
+
+    const std::string name = "JumpThreading";
+    int max_duplicate = 6;
+    int max_rounds = 8;
+};
+
+}
+}
+
+#endif // SYSYF_JUMPTHREADING_H
@@ -0,0 +1,103 @@
+#ifndef SYSYF_LAZYCODEMOTION_H
+#define SYSYF_LAZYCODEMOTION_H
+
+#include "BasicBlock.h"
+#include "Constant.h"
+#include "Function.h"
+#include "Instruction.h"
+#include "Module.h"
+#include "Pass.h"
+#include "internal_types.h"
+#include <map>
+#include <set>
+#include <tuple>
+#include <vector>
+
+namespace SysYF {
+namespace IR {
+
+/*****************************LazyCodeMotion**************************************/
+/***************************This class is based on SSA form*********************************/
+/**
+ * Partial redundancy elimination: computes an expression on the paths that
+ * lack it, so that a later computation is available on every path and can
+ * be removed.
+ *
+ *   if (c) {                           if (c) {
+ *       x = a * b;                         x = a * b;
+ *   }                          =>      } else {
+ *   y = a * b;                             t = a * b;
+ *                                      }
+ *                                      y = phi(x, t);
+ *
+ * The placement is lazy code motion: a computation is only inserted where
+ * the expression is anticipated, i.e. computed on every path from there,
+ * so no path computes it more often than before, and as late as possible,
+ * so that no value lives longer than needed. An expression computed before
+ * a loop whose header is always run once more, e.g. by the exit test, is
+ * moved to the preheader this way.
+ *
+ * Expressions are the side effect free instructions, identified by opcode
+ * and operands. An expression is killed in the block that defines one of
+ * its operands. Critical edges are split only when an insertion needs them;
+ * the paths through such an edge take one more jump, in exchange for the
+ * computation removed after it.
+ */
+class LazyCodeMotion : public Pass {
+public:
+    explicit LazyCodeMotion(WeakPtr<Module> m) : Pass(m) {}
+    const std::string get_name() const override {return name;}
+    bool execute() override;
+    // max-rounds=N
+    bool set_option(const std::string &key, const std::string &value) override;
+
+private:
+    // (kind, value, constant): kind 0 for a value, or the kind of the constant
+    using Operand = std::tuple<int, Ptr<Value>, int>;
+    struct Expression {
+        Instruction::OpID op;
+        int cmp_op;
+        std::vector<Operand> operands;
+        bool operator<(const Expression &other) const {
+            return std::tie(op, cmp_op, operands) < std::tie(other.op, other.cmp_op, other.operands);
+        }
+    };
+
+    static bool is_candidate(Ptr<Instruction> inst);
+    static Expression get_expression(Ptr<Instruction> inst);
+
+    bool run(Ptr<Function> f);
+    void collect_expressions(Ptr<Function> f);
+    void compute_local_sets();
+    void solve();
+    // rewrites the computations of expression e, false when nothing changed
+    bool move_expression(int e);
+    Ptr<Instruction> insert_on_edge(int edge, Ptr<Instruction> expr);
+    // the block put on edge, split the first time it is asked for
+    Ptr<BasicBlock> get_edge_block(int edge);
+
+    PtrVec<BasicBlock> blocks_;
+    DenseMap<BasicBlock *, int> index_;
+    // (from, to) block indices of the edges between distinct blocks
+    std::vector<std::pair<int, int>> edges_;
+    std::vector<std::vector<int>> in_edges_;
+    std::vector<std::vector<int>> out_edges_;
+    std::map<int, Ptr<BasicBlock>> split_blocks_;
+    SmallPtrSet<BasicBlock *, 32> reachable_;
+
+    // the computations of each expression in program order
+    std::vector<PtrVec<Instruction>> occurrences_;
+    // per block or edge, one bit for each expression
+    std::vector<std::vector<bool>> transp_, comp_, antloc_;
+    std::vector<std::vector<bool>> avout_, antin_, antout_;
+    std::vector<std::vector<bool>> later_, laterin_;
+    std::set<Ptr<Instruction>> removed_;
+
+    const std::string name = "LazyCodeMotion";
+    int max_rounds = 4;
+};
+
+}
+}
+
+#endif // SYSYF_LAZYCODEMOTION_H
@@ -11,7 +11,7 @@ class LiveVar : public Pass
 {
 public:
     LiveVar(WeakPtr<Module> m) : Pass(m) {}
-    void execute() final;
+    bool execute() final;
     const std::string get_name() const override {return name;}
     void dump();
 private:
@@ -0,0 +1,71 @@
+#ifndef SYSYF_LOOPUNSWITCH_H
+#define SYSYF_LOOPUNSWITCH_H
+
+#include "BasicBlock.h"
+#include "CloneUtils.h"
+#include "Constant.h"
+#include "Function.h"
+#include "Instruction.h"
+#include "Module.h"
+#include "Pass.h"
+#include "ScalarEvolution.h"
+#include "internal_types.h"
+#include <set>
+
+namespace SysYF {
+namespace IR {
+
+/*****************************LoopUnswitch**************************************/
+/***************************This class is based on SSA form*********************************/
+/**
+ * Moves a branch on a loop invariant condition out of the loop, and runs
+ * one of two copies of the loop, each with the branch folded.
+ *
+ *   while (i < n) {                    if (flag) {
+ *       if (flag) s = s + a[i];            while (i < n) { s = s + a[i]; i = i + 1; }
+ *       i = i + 1;             =>      } else {
+ *   }                                      while (i < n) { i = i + 1; }
+ *                                      }
+ *
+ * The condition may use values from outside the loop, arguments, and
+ * loads of scalar globals the loop neither stores to nor may change
+ * through a call; its computation is copied to the preheader. Both copies
+ * get their own preheader and exit block, so they keep the shape
+ * ScalarEvolution::find_loop expects and later loop passes see them.
+ *
+ * Loops of more than max_loop_size instructions are left alone, and a
+ * function grows by at most max_growth instructions.
+ */
+class LoopUnswitch : public Pass {
+public:
+    explicit LoopUnswitch(WeakPtr<Module> m) : Pass(m) {}
+    const std::string get_name() const override {return name;}
+    bool execute() override;
+    // max-loop-size=N, max-growth=N
+    bool set_option(const std::string &key, const std::string &value) override;
+
+private:
+    bool unswitch_loop(Ptr<BasicBlock> header, int &growth);
+    // the first block of the loop that ends in a branch on an invariant condition
+    Ptr<BasicBlock> find_invariant_branch(Ptr<BasicBlock> header, const ScalarEvolution::Loop &loop);
+    bool is_invariant(Ptr<Value> val, const ScalarEvolution::Loop &loop, int &size);
+    // copies the computation of val in the loop to the end of the preheader
+    Ptr<Value> hoist(Ptr<Value> val, const ScalarEvolution::Loop &loop, ValueMap &vmap);
+    void unswitch(const ScalarEvolution::Loop &loop, Ptr<BasicBlock> bb);
+    static void fold_branch(Ptr<BasicBlock> bb, bool taken);
+    static void remove_dead_condition(Ptr<Value> val);
+
+    // the scalar globals stored to in the loop being checked
+    std::set<Ptr<Value>> stored_globals_;
+    bool calls_defined_function_;
+
+    const std::string name = "LoopUnswitch";
+    int max_loop_size = 80;
+    int max_growth = 320;
+    static const int max_condition_size = 8;
+};
+
+}
+}
+
+#endif // SYSYF_LOOPUNSWITCH_H
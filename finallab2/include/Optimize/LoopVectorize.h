@@ -0,0 +1,109 @@
+#ifndef SYSYF_LOOPVECTORIZE_H
+#define SYSYF_LOOPVECTORIZE_H
+
+#include "BasicBlock.h"
+#include "Constant.h"
+#include "Function.h"
+#include "Instruction.h"
+#include "Module.h"
+#include "Pass.h"
+#include "internal_types.h"
+#include <map>
+#include <vector>
+
+namespace SysYF {
+namespace IR {
+
+/*****************************LoopVectorize**************************************/
+/***************************This class is based on SSA form*********************************/
+/**
+ * Runs countable innermost loops vector_width iterations at a time.
+ *
+ *   header: %i = phi [ %init, %pre ], [ %i.next, %body ]
+ *           %c = icmp slt i32 %i, %n
+ *           br i1 %c, label %body, label %exit
+ *   body:   ...
+ *           %i.next = add i32 %i, 1
+ *           br label %header
+ *
+ * The body must be a single block whose memory accesses go through geps
+ * that are consecutive in %i, i.e. whose last index is %i plus a constant
+ * and whose other operands are loop invariant. Accesses to the same array
+ * must not be less than vector_width elements apart, and arrays that may
+ * alias (pointer arguments against each other or against globals) must
+ * not be written. Header phis other than %i must be integer sums.
+ *
+ * A vector copy of the loop is put in front of the original one, which
+ * stays as the remainder loop and starts where the vector loop stopped.
+ * Sums are accumulated per lane and added up between the two loops.
+ */
+class LoopVectorize : public Pass {
+public:
+    explicit LoopVectorize(WeakPtr<Module> m) : Pass(m) {}
+    const std::string get_name() const override {return name;}
+    bool execute() override;
+
+private:
+    // what a value of the scalar loop becomes in the vector loop
+    enum class Kind {
+        Invariant,  // the same in every iteration, splatted where a vector is needed
+        Induction,  // %i plus a constant, lane k holds the value of iteration k
+        Vector,     // computed per lane
+        Address     // a consecutive gep, becomes a pointer to a whole vector
+    };
+
+    struct MemAccess {
+        Ptr<Instruction> inst;
+        bool is_store;
+        Ptr<GetElementPtrInst> gep;
+        int offset;     // constant part of the last gep index
+    };
+
+    struct LoopShape {
+        Ptr<BasicBlock> preheader;
+        Ptr<BasicBlock> header;
+        Ptr<BasicBlock> body;
+        Ptr<BasicBlock> exit;
+        Ptr<PhiInst> iv;
+        Ptr<Instruction> iv_next;
+        Ptr<Value> bound;
+        PtrVec<PhiInst> reductions;
+        PtrVec<Instruction> updates;    // updates[k] is the add feeding reductions[k]
+    };
+
+    bool vectorize(Ptr<BasicBlock> header);
+    bool match_loop(Ptr<BasicBlock> header, LoopShape &loop);
+    bool match_reduction(Ptr<PhiInst> phi, LoopShape &loop);
+    bool classify(LoopShape &loop);
+    bool check_dependences();
+    void transform(LoopShape &loop);
+    // records why the loop is not vectorized, returns false
+    bool miss(Ptr<Instruction> inst, const std::string &reason);
+
+    bool is_in_loop(Ptr<Value> val);
+    Ptr<Value> get_scalar(Ptr<Value> val);
+    Ptr<Value> widen(Ptr<Value> val);
+    Ptr<Value> splat(Ptr<Value> val, Ptr<BasicBlock> bb);
+
+    LoopShape *loop_;
+    std::map<Ptr<Value>, Kind> kinds_;
+    std::map<Ptr<Value>, int> offsets_;         // Induction values: %i + offset
+    std::vector<MemAccess> accesses_;
+    std::map<Ptr<Value>, Ptr<Value>> scalars_;  // Invariant and Induction values in the vector loop
+    std::map<Ptr<Value>, Ptr<Value>> vectors_;  // vector values, and vector pointers of Address geps
+    Ptr<BasicBlock> vec_pre_;
+    Ptr<BasicBlock> vec_body_;
+    // headers of the loops left as remainders, not vectorized again when the pass is rerun
+    PtrSet<BasicBlock> remainders_;
+    // where and why the last loop was not vectorized, empty when it was no loop
+    Ptr<Instruction> missed_at_;
+    std::string missed_reason_;
+
+    const std::string name = "LoopVectorize";
+    static const int vector_width = 4;
+};
+
+}
+}
+
+#endif // SYSYF_LOOPVECTORIZE_H
@@ -26,27 +26,27 @@ private:
 public:
 	explicit Mem2Reg(WeakPtr<Module> m) : Pass(m) {}
 	~Mem2Reg(){};
-	void execute() final;
+	bool execute() final;
 	void genPhi();
 	void insideBlockForwarding();
 	void valueDefineCounting();
 	void valueForwarding(Ptr<BasicBlock> bb);
-	void removeAlloc();
+	bool removeAlloc();
     const std::string get_name() const override {return name;}
 
 	bool isLocalVarOp(Ptr<Instruction> inst){
 		if (inst->get_instr_type() == Instruction::OpID::store){
 			auto sinst = static_pointer_cast<StoreInst>(inst);
 			auto lvalue = sinst->get_lval();
-			auto glob = dynamic_pointer_cast<GlobalVariable>(lvalue);
-			auto array_element_ptr = dynamic_pointer_cast<GetElementPtrInst>(lvalue);
+			auto glob = dyn_cast<GlobalVariable>(lvalue);
+			auto array_element_ptr = dyn_cast<GetElementPtrInst>(lvalue);
 			return !glob && !array_element_ptr;
 		}
 		else if (inst->get_instr_type() == Instruction::OpID::load){
 			auto linst = static_pointer_cast<LoadInst>(inst);
 			auto lvalue = linst->get_lval();
-			auto glob = dynamic_pointer_cast<GlobalVariable>(lvalue);
-			auto array_element_ptr = dynamic_pointer_cast<GetElementPtrInst>(lvalue);
+			auto glob = dyn_cast<GlobalVariable>(lvalue);
+			auto array_element_ptr = dyn_cast<GetElementPtrInst>(lvalue);
 			return !glob && !array_element_ptr;
 		}
 		else
@@ -2,19 +2,29 @@
 #define SYSYF_PASS_H
 
 
+#include <functional>
+#include <map>
 #include <memory>
 #include <string>
 #include <list>
+#include <vector>
 #include "Module.h"
 
 namespace SysYF{
 namespace IR{
 
+class Check;
+
 class Pass{
 public:
     explicit Pass(WeakPtr<Module> m){module = m;}
-    virtual void execute() = 0;
+    // returns whether the IR was changed
+    virtual bool execute() = 0;
     virtual const std::string get_name() const = 0;
+    // takes key=value given in a pipeline, false when key is not an option of the pass
+    virtual bool set_option(const std::string &key, const std::string &value){return false;}
+    // false when value is not a non-negative number
+    static bool parse_int(const std::string &value, int &result);
 protected:
     WeakPtr<Module> module;
 };
@@ -22,18 +32,60 @@ protected:
 template<typename T>
 using PassList = PtrList<T>;
 
+/**
+ * Runs a pipeline of passes, built with addPass() or parsed from a text
+ * such as "domtree,mem2reg,fixpoint(instcombine,cse),jump-threading<max-rounds=2>":
+ *
+ *   pipeline := element (',' element)*
+ *   element  := name ['<' key '=' value (';' key '=' value)* '>']
+ *             | 'repeat' '<' count '>' '(' pipeline ')'
+ *             | 'fixpoint' ['<' limit '>'] '(' pipeline ')'
+ *
+ * A repeat group runs its passes count times, a fixpoint group runs them
+ * until none of them changes the IR, at most limit times. A name is one
+ * given to register_pass(); the passes of the compiler are registered
+ * under their command line flags, e.g. cse, and domtree, rdomtree and
+ * verify.
+ */
 class PassMgr{
 public:
-    explicit PassMgr(WeakPtr<Module> m){module = m;pass_list = PassList<Pass>();}
-    template <typename PassTy> void addPass(){pass_list.emplace_back(new PassTy(module));}
-    void execute() {
-        for (auto pass : pass_list) {
-            pass->execute();
-        }
+    // when the IR is verified: never, once after the last pass, or after every pass
+    enum VerifyMode {VerifyOff, VerifyAfterPipeline, VerifyAfterEachPass};
+    using PassFactory = std::function<Ptr<Pass>(WeakPtr<Module>)>;
+
+    explicit PassMgr(WeakPtr<Module> m){module = m;}
+    template <typename PassTy> void addPass(){pipeline.push_back({Node::Single, Ptr<Pass>(new PassTy(module)), 1, {}});}
+    // makes PassTy known to parse_pipeline() as name
+    template <typename PassTy> static void register_pass(const std::string &name){
+        get_registry()[name] = [](WeakPtr<Module> m){return Ptr<Pass>(new PassTy(m));};
     }
+    // appends the passes of text; on an error nothing is added and error says what is wrong
+    bool parse_pipeline(const std::string &text, std::string &error);
+    void set_verify_mode(VerifyMode mode){verify_mode = mode;}
+    // exits after reporting the errors when a verification fails
+    void execute();
 private:
+    // a pass, or a group run count times or until its passes change nothing
+    struct Node {
+        enum Kind {Single, Repeat, Fixpoint};
+        Kind kind;
+        Ptr<Pass> pass;
+        int count;
+        std::vector<Node> children;
+    };
+
+    static std::map<std::string, PassFactory> &get_registry();
+    bool parse_elements(const std::string &text, std::size_t &pos, std::vector<Node> &nodes, std::string &error);
+    // returns whether a pass changed the IR
+    bool run(const std::vector<Node> &nodes, Check &check);
+    // where is the pass that ran last, or the pipeline
+    void verify(Check &check, const std::string &where);
+
     WeakPtr<Module> module;
-    PassList<Pass> pass_list;
+    std::vector<Node> pipeline;
+    VerifyMode verify_mode = VerifyAfterPipeline;
+    bool ran_pass = false;
+    static const int max_fixpoint_rounds = 8;
 };
 
 }
@@ -15,9 +15,9 @@ namespace IR {
 class RDominateTree : public Pass{//reverse dominate tree
 public:
     explicit RDominateTree(WeakPtr<Module> m): Pass(m){}
-    void execute()final;
+    bool execute() final;
     void get_revserse_post_order(Ptr<Function>  f);
-    void get_post_order(Ptr<BasicBlock> bb, PtrSet<BasicBlock>& visited);
+    void get_post_order(Ptr<BasicBlock> bb, SmallPtrSet<BasicBlock *, 16>& visited);
     void get_bb_irdom(Ptr<Function>  f);
     void get_bb_rdoms(Ptr<Function>  f);
     void get_bb_rdom_front(Ptr<Function>  f);
@@ -26,7 +26,7 @@ public:
 private:
     Ptr<BasicBlock>  exit_block = nullptr;
     PtrList<BasicBlock> reverse_post_order;
-    Map<Ptr<BasicBlock>,int> bb2int;
+    DenseMap<BasicBlock *, int> bb2int;
     PtrVec<BasicBlock> rdoms;
     const std::string name = "RDominateTree";
 };
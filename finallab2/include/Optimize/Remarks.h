@@ -0,0 +1,70 @@
+#ifndef SYSYF_REMARKS_H
+#define SYSYF_REMARKS_H
+
+#include "BasicBlock.h"
+#include "Function.h"
+#include "Instruction.h"
+#include "internal_types.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace SysYF {
+namespace IR {
+
+/**
+ * What a pass did at an instruction, a block or a function, or why it did
+ * not, written to the file of -remarks=<file>:
+ *
+ *   --- !Missed
+ *   Pass:            LoopVectorize
+ *   Name:            NotVectorized
+ *   Function:        main
+ *   Block:           label12
+ *   Instruction:     '%op20'
+ *   Args:
+ *     - Reason:          'the body has a call'
+ *   ...
+ *
+ * The file is YAML, or a JSON array of the same fields when its name ends
+ * in .json. emit() drops the remarks while no file is open, a pass that
+ * has to work to build a remark asks enabled() first.
+ */
+class Remark {
+public:
+    // Passed: a transformation was done, Missed: one was tried and not done
+    enum Kind {Passed, Missed, Analysis};
+
+    Remark(Kind kind, const std::string &pass, const std::string &name, Ptr<Function> func);
+    Remark(Kind kind, const std::string &pass, const std::string &name, Ptr<BasicBlock> bb);
+    Remark(Kind kind, const std::string &pass, const std::string &name, Ptr<Instruction> inst);
+
+    // appends key: value to the arguments
+    Remark &arg(const std::string &key, const std::string &value);
+    Remark &arg(const std::string &key, const char *value);
+    Remark &arg(const std::string &key, int value);
+    // a value as it is printed: a constant, %name, @name, or the opcode when it has no name yet
+    Remark &arg(const std::string &key, Ptr<Value> value);
+
+    // false when file cannot be written
+    static bool open(const std::string &file);
+    static void close();
+    static bool enabled();
+    static void emit(const Remark &remark);
+
+private:
+    static std::string describe(Ptr<Value> value);
+
+    Kind kind_;
+    std::string pass_;
+    std::string name_;
+    std::string function_;
+    std::string block_;
+    std::string instruction_;
+    std::vector<std::pair<std::string, std::string>> args_;
+};
+
+}
+}
+
+#endif // SYSYF_REMARKS_H
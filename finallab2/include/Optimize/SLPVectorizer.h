@@ -0,0 +1,81 @@
+#ifndef SYSYF_SLPVECTORIZER_H
+#define SYSYF_SLPVECTORIZER_H
+
+#include "BasicBlock.h"
+#include "Constant.h"
+#include "Function.h"
+#include "Instruction.h"
+#include "Module.h"
+#include "Pass.h"
+#include "internal_types.h"
+#include <map>
+#include <vector>
+
+namespace SysYF {
+namespace IR {
+
+/*****************************SLPVectorizer**************************************/
+/***************************This class is based on SSA form*********************************/
+/**
+ * Packs vector_width stores to adjacent elements of one array row into a
+ * single vector store, together with the isomorphic expression trees that
+ * compute the stored values.
+ *
+ *   %x0 = load b[0]                    %v = load <4 x i32> b[0..3]
+ *   %y0 = add %x0, 1                   %w = add <4 x i32> %v, <1, 1, 1, 1>
+ *   store %y0, a[0]            =>      store <4 x i32> %w, a[0..3]
+ *   ... lanes 1 to 3 ...
+ *
+ * Only geps with constant indices are considered. The lanes of a tree node
+ * are vectorized when they are the same operation (a binary operator, a
+ * cast, or loads of adjacent elements) and have no other use, otherwise
+ * they are gathered with insertelement. A bundle is only replaced when the
+ * vector code needs fewer instructions than the scalar code.
+ *
+ * The vector loads and the store are done at the position of the last
+ * store of the bundle, so the memory accesses in between must not touch
+ * the elements that are moved across them.
+ */
+class SLPVectorizer : public Pass {
+public:
+    explicit SLPVectorizer(WeakPtr<Module> m) : Pass(m) {}
+    const std::string get_name() const override {return name;}
+    bool execute() override;
+
+private:
+    enum class NodeKind { Store, Binary, Cast, Load, Constant, Gather };
+
+    struct Node {
+        NodeKind kind;
+        PtrVec<Value> lanes;
+        std::vector<int> children;
+    };
+
+    bool vectorize_block(Ptr<BasicBlock> bb);
+    bool try_bundle(const PtrVec<Instruction> &stores);
+    // returns the index of the new node in tree_
+    int build_node(const PtrVec<Value> &lanes, int depth);
+    NodeKind get_node_kind(const PtrVec<Value> &lanes, int depth);
+    // whether the pointers address vector_width adjacent elements of one row, in lane order
+    static bool is_consecutive(const PtrVec<Value> &ptrs);
+    static bool may_alias(Ptr<Value> ptr1, Ptr<Value> ptr2);
+    bool check_memory_order();
+    Ptr<Value> emit(int index);
+    // move a freshly created instruction from the end of bb_ in front of pos_
+    template <typename T>
+    Ptr<T> insert(Ptr<T> inst);
+
+    std::vector<Node> tree_;
+    std::map<Ptr<Instruction>, int> position_;
+    Ptr<BasicBlock> bb_;
+    Ptr<Instruction> pos_;
+
+    const std::string name = "SLPVectorizer";
+    static const int vector_width = 4;
+    static const int max_depth = 8;
+};
+
+}
+}
+
+#endif // SYSYF_SLPVECTORIZER_H
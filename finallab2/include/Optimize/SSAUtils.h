@@ -0,0 +1,60 @@
+#ifndef SYSYF_SSAUTILS_H
+#define SYSYF_SSAUTILS_H
+
+#include "BasicBlock.h"
+#include "Instruction.h"
+#include "Module.h"
+#include "Type.h"
+#include "internal_types.h"
+#include <functional>
+#include <map>
+
+namespace SysYF {
+namespace IR {
+
+/**
+ * @brief the zero of ty, false for i1
+ */
+Ptr<Value> get_zero(Ptr<Type> ty, Ptr<Module> m);
+
+/**
+ * @brief the values that reach the uses of a value with several definitions
+ *
+ * The blocks that end with a definition are given by add_definition. The
+ * value reaching any other point is looked up through the predecessors,
+ * with a phi where paths with different values meet. The phis are placed
+ * before their entries are known, remove_trivial_phis takes out the ones
+ * that turned out not to be needed. A block no definition reaches gets
+ * the zero of the type.
+ */
+class SSAUpdater {
+public:
+    // whether a predecessor gets an entry in the phis, all of them if not given
+    using BlockFilter = std::function<bool(Ptr<BasicBlock>)>;
+
+    SSAUpdater(Ptr<Type> ty, Ptr<Module> m, BlockFilter has_entry = nullptr)
+        : type_(ty), module_(m), has_entry_(std::move(has_entry)) {}
+
+    // val is the value at the end of bb
+    void add_definition(Ptr<BasicBlock> bb, Ptr<Value> val) { defs_[bb] = val; }
+    Ptr<Value> get_value_at_end(Ptr<BasicBlock> bb);
+    Ptr<Value> get_value_at_entry(Ptr<BasicBlock> bb);
+    // phis whose entries all agree are replaced by that value
+    void remove_trivial_phis();
+
+private:
+    Ptr<PhiInst> create_phi(Ptr<BasicBlock> bb);
+
+    Ptr<Type> type_;
+    WeakPtr<Module> module_;
+    BlockFilter has_entry_;
+    std::map<Ptr<BasicBlock>, Ptr<Value>> defs_;
+    // nullptr while the single predecessor of the block is being looked at
+    std::map<Ptr<BasicBlock>, Ptr<Value>> entry_values_;
+    PtrVec<PhiInst> new_phis_;
+};
+
+}
+}
+
+#endif // SYSYF_SSAUTILS_H
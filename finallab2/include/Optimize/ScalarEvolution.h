@@ -0,0 +1,108 @@
+#ifndef SYSYF_SCALAREVOLUTION_H
+#define SYSYF_SCALAREVOLUTION_H
+
+#include "BasicBlock.h"
+#include "Constant.h"
+#include "Function.h"
+#include "Instruction.h"
+#include "Module.h"
+#include "internal_types.h"
+#include <map>
+#include <set>
+#include <vector>
+
+namespace SysYF {
+namespace IR {
+
+/*****************************ScalarEvolution**************************************/
+/***************************This class is based on SSA form*********************************/
+/**
+ * Describes how the i32 values of one loop change from iteration to
+ * iteration, as add-recurrences over loop invariant linear expressions.
+ *
+ *   {a0, +, a1, +, a2}      value in iteration k: a0 + a1 * C(k, 1) + a2 * C(k, 2)
+ *
+ * i = i + 1 starting from 0 is {0, +, 1}, s = s + i starting from 0 is
+ * {0, +, 0, +, 1}. All arithmetic wraps around like the i32 instructions
+ * it models, so the closed forms are exact even when the loop overflows.
+ *
+ * The loop is entered from its preheader, has a single latch, and is only
+ * left through the exit test at the end of the header. The trip count is
+ * known when that test compares an affine recurrence of step 1 or -1 with
+ * an invariant bound.
+ */
+class ScalarEvolution {
+public:
+    struct Loop {
+        Ptr<BasicBlock> preheader;
+        Ptr<BasicBlock> header;
+        Ptr<BasicBlock> latch;
+        Ptr<BasicBlock> exit;
+        std::set<Ptr<BasicBlock>> blocks;
+    };
+
+    // constant + sum of coefficient * value, over values defined outside the loop
+    struct Linear {
+        int constant = 0;
+        std::map<Ptr<Value>, int> terms;
+
+        bool is_constant() const { return terms.empty(); }
+    };
+
+    // ops.size() == 1 means the value is loop invariant
+    struct AddRec {
+        std::vector<Linear> ops;
+
+        bool is_invariant() const { return ops.size() == 1; }
+    };
+
+    // the body runs guard ? count : 0 times, without a guard always count times
+    struct TripCount {
+        Linear count;
+        bool has_guard = false;
+        CmpInst::CmpOp guard_op;
+        Linear guard_lhs;
+        Linear guard_rhs;
+
+        bool is_constant() const { return !has_guard && count.is_constant(); }
+    };
+
+    explicit ScalarEvolution(Ptr<Module> m) : module_(m) {}
+
+    // whether header starts a loop of the shape described above
+    static bool find_loop(Ptr<BasicBlock> header, Loop &loop);
+
+    void set_loop(const Loop &loop);
+    bool get_scev(Ptr<Value> val, AddRec &scev);
+    bool get_trip_count(TripCount &trip);
+    // whether expand_exit_value can handle the degree of scev
+    static bool is_expandable(const AddRec &scev, const TripCount &trip);
+    // emits the value scev has when the loop is left in front of pos
+    Ptr<Value> expand_exit_value(const AddRec &scev, const TripCount &trip, Ptr<Instruction> pos);
+
+private:
+    bool compute_scev(Ptr<Value> val, AddRec &scev);
+    bool compute_phi_scev(Ptr<PhiInst> phi, AddRec &scev);
+    bool is_in_loop(Ptr<Value> val);
+
+    Ptr<Value> expand(const Linear &linear, Ptr<Instruction> pos);
+    // a null lhs of add stands for 0, constant operands are folded where it is free
+    Ptr<Value> expand_add(Ptr<Value> lhs, Ptr<Value> rhs, Ptr<Instruction> pos);
+    Ptr<Value> expand_mul(Ptr<Value> lhs, Ptr<Value> rhs, Ptr<Instruction> pos);
+    template <typename T>
+    Ptr<T> insert(Ptr<T> inst, Ptr<Instruction> pos);
+
+    Ptr<Module> module_;
+    Loop loop_;
+    std::map<Ptr<Value>, AddRec> scevs_;
+    std::set<Ptr<PhiInst>> pending_;
+    Ptr<Value> trip_count_;     // emitted by the first expand_exit_value of the loop
+
+    // C(k, j) is computed exactly up to this j for a known trip count, 2 otherwise
+    static const int max_degree = 3;
+};
+
+}
+}
+
+#endif // SYSYF_SCALAREVOLUTION_H
@@ -0,0 +1,45 @@
+#ifndef SYSYF_STATISTICS_H
+#define SYSYF_STATISTICS_H
+
+#include <ostream>
+#include <vector>
+
+namespace SysYF {
+namespace IR {
+
+/**
+ * A counter of a pass, defined at the top of the .cpp of the pass:
+ *
+ *   static Statistic num_removed("ComSubExprEli", "common subexpressions removed");
+ *   ...
+ *   ++num_removed;
+ *
+ * A counter registers itself when it is constructed and always counts,
+ * print_all() writes the ones that are not zero, which is what -stats
+ * shows after the pipeline.
+ */
+class Statistic {
+public:
+    Statistic(const char *pass, const char *desc);
+    Statistic(const Statistic &) = delete;
+    Statistic &operator=(const Statistic &) = delete;
+
+    Statistic &operator++(){value_++; return *this;}
+    Statistic &operator+=(unsigned n){value_ += n; return *this;}
+    unsigned get_value() const {return value_;}
+
+    // the counters that are not zero, sorted by pass
+    static void print_all(std::ostream &out);
+
+private:
+    static std::vector<Statistic *> &get_registry();
+
+    const char *pass_;
+    const char *desc_;
+    unsigned value_ = 0;
+};
+
+}
+}
+
+#endif // SYSYF_STATISTICS_H
@@ -0,0 +1,62 @@
+#ifndef SYSYF_SWITCHFORMATION_H
+#define SYSYF_SWITCHFORMATION_H
+
+#include "BasicBlock.h"
+#include "Constant.h"
+#include "Function.h"
+#include "Instruction.h"
+#include "Module.h"
+#include "Pass.h"
+#include "internal_types.h"
+#include <set>
+
+namespace SysYF {
+namespace IR {
+
+/*****************************SwitchFormation**************************************/
+/***************************This class is based on SSA form*********************************/
+/**
+ * Folds chains of equality compares on the same value into one switch.
+ *
+ *   b0: %c0 = icmp eq i32 %x, 1            b0: switch i32 %x, label %other [
+ *       br i1 %c0, label %t0, label %b1            i32 1, label %t0
+ *   b1: %c1 = icmp eq i32 %x, 2       =>          i32 2, label %t1
+ *       br i1 %c1, label %t1, label %b2            i32 3, label %t2 ]
+ *   b2: %c2 = icmp eq i32 %x, 3
+ *       br i1 %c2, label %t2, label %other
+ *
+ * Every block after the first must hold nothing but its compare and
+ * branch, and icmp ne is followed along its true edge. Chains shorter
+ * than min_cases are left alone.
+ */
+class SwitchFormation : public Pass {
+public:
+    explicit SwitchFormation(WeakPtr<Module> m) : Pass(m) {}
+    const std::string get_name() const override {return name;}
+    bool execute() override;
+
+private:
+    struct ChainLink {
+        Ptr<BasicBlock> bb;
+        Ptr<ConstantInt> val;
+        Ptr<BasicBlock> dest;
+        Ptr<BasicBlock> next;
+    };
+
+    bool form_switch(Ptr<BasicBlock> head);
+    // whether bb ends in a branch on x == constant, a null x is taken from the compare
+    static bool match_link(Ptr<BasicBlock> bb, Ptr<Value> &x, ChainLink &link);
+    // whether the phis of dest get the same value from every block of the chain
+    static bool can_merge_phi_entries(Ptr<BasicBlock> dest, const std::set<Ptr<BasicBlock>> &chain);
+    // replace those entries by num_edges entries from head, one per switch edge
+    static void merge_phi_entries(Ptr<BasicBlock> dest, const std::set<Ptr<BasicBlock>> &chain,
+                                  Ptr<BasicBlock> head, int num_edges);
+
+    const std::string name = "SwitchFormation";
+    static const int min_cases = 3;
+};
+
+}
+}
+
+#endif // SYSYF_SWITCHFORMATION_H
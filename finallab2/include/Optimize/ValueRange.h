@@ -0,0 +1,86 @@
+#ifndef SYSYF_VALUERANGE_H
+#define SYSYF_VALUERANGE_H
+
+#include "BasicBlock.h"
+#include "ConditionUtils.h"
+#include "Constant.h"
+#include "Function.h"
+#include "Instruction.h"
+#include "Module.h"
+#include "Pass.h"
+#include "internal_types.h"
+#include <map>
+#include <vector>
+
+namespace SysYF {
+namespace IR {
+
+/*****************************ValueRange**************************************/
+/***************************This class is based on SSA form*********************************/
+/**
+ * Computes a signed interval for every i32 and i1 value and uses it to
+ * remove work the program does not need.
+ *
+ *   if (i < n) {                               if (i < n) {
+ *       if (i < n) x = a[i];           =>          x = a[i];
+ *       r = (a[i] & 255) % 16;                     r = (a[i] & 255) urem 16;
+ *   }                                          }
+ *
+ * The intervals are propagated through binary operators, phis, selects
+ * and calls, and are narrowed by the branch conditions that hold in a
+ * block, i.e. the conditions of the edges that dominate it. Arguments of
+ * functions that are only called directly get the union of what their
+ * call sites pass. Loops are handled by widening a bound to the limit of
+ * the type once it kept growing for max_updates rounds.
+ *
+ * Compares that always give the same answer are folded together with the
+ * branches on them, and the blocks that become unreachable are removed.
+ * sdiv and srem on non-negative operands become udiv and urem.
+ */
+class ValueRange : public Pass {
+public:
+    explicit ValueRange(WeakPtr<Module> m) : Pass(m) {}
+    const std::string get_name() const override {return name;}
+    bool execute() override;
+
+private:
+    // [lo, hi], empty if lo > hi
+    struct Range {
+        long long lo;
+        long long hi;
+
+        bool is_empty() const { return lo > hi; }
+        bool is_single() const { return lo == hi; }
+        bool operator==(const Range &other) const { return lo == other.lo && hi == other.hi; }
+        bool operator!=(const Range &other) const { return !(*this == other); }
+    };
+
+    void analyze();
+    Range evaluate(Ptr<Instruction> inst);
+    Range evaluate_binary(Ptr<Instruction> inst, Range lhs, Range rhs);
+    bool update(Ptr<Value> val, Range range);
+
+    Range get_range(Ptr<Value> val);
+    // the range of val where the conditions of bb hold
+    Range get_range_at(Ptr<Value> val, Ptr<BasicBlock> bb);
+    // the range of val along the edge from -> to
+    Range get_range_on_edge(Ptr<Value> val, Ptr<BasicBlock> from, Ptr<BasicBlock> to);
+    Range refine(Ptr<Value> val, Range range, const Condition &cond);
+
+    bool fold_compares(Ptr<Function> f);
+    bool fold_branches(Ptr<Function> f);
+    bool narrow_divisions(Ptr<Function> f);
+
+    std::map<Ptr<Value>, Range> ranges_;        // values, and the return values of functions
+    std::map<Ptr<Value>, int> updates_;
+    ConditionMap conditions_;
+    std::map<Ptr<Function>, PtrVec<BasicBlock>> orders_;
+
+    const std::string name = "ValueRange";
+    static const int max_updates = 3;
+};
+
+}
+}
+
+#endif // SYSYF_VALUERANGE_H
@@ -20,7 +20,7 @@ class Function;
 class Instruction;
 class Module;
 
-class BasicBlock : public Value
+class BasicBlock : public Value, public IListNode<BasicBlock>
 {
 public:
     static Ptr<BasicBlock> create(Ptr<Module> m, const std::string &name ,
@@ -31,6 +31,7 @@ public:
 
     // return parent, or null if none.
     Ptr<Function> get_parent() { return parent_.lock(); }
+    void set_parent(Ptr<Function> parent) { parent_ = parent; }
     
     Ptr<Module> get_module();
 
@@ -43,11 +44,11 @@ public:
 
     void remove_pre_basic_block(Ptr<BasicBlock> bb) {
         auto match = [bb](const WeakPtr<BasicBlock> &ptr) { return ptr.lock() == bb; };
-        pre_bbs_.remove_if(match);
+        pre_bbs_.erase(std::remove_if(pre_bbs_.begin(), pre_bbs_.end(), match), pre_bbs_.end());
     }
     void remove_succ_basic_block(Ptr<BasicBlock> bb) {
         auto match = [bb](const WeakPtr<BasicBlock> &ptr) { return ptr.lock() == bb; };
-        succ_bbs_.remove_if(match);
+        succ_bbs_.erase(std::remove_if(succ_bbs_.begin(), succ_bbs_.end(), match), succ_bbs_.end());
     }
 
     /****************api about cfg****************/
@@ -61,31 +62,41 @@ public:
     }
     
     void add_instruction(Ptr<Instruction> instr);
-    void add_instruction(PtrList<Instruction>::iterator instr_pos, Ptr<Instruction> instr);
+    void add_instruction(IList<Instruction>::iterator instr_pos, Ptr<Instruction> instr);
     void add_instr_begin(Ptr<Instruction> instr);
 
-    PtrList<Instruction>::iterator find_instruction(Ptr<Instruction> instr);
+    // constant time, the instruction knows its position
+    IList<Instruction>::iterator find_instruction(Ptr<Instruction> instr);
 
     void delete_instr(Ptr<Instruction> instr);
 
     bool empty() { return instr_list_.empty(); }
 
     int get_num_of_instr() { return instr_list_.size(); }
-    PtrList<Instruction> &get_instructions() { return instr_list_; }
+    IList<Instruction> &get_instructions() { return instr_list_; }
     
     void erase_from_parent();
     
     virtual std::string print() override;
 
+    static bool classof(const Value *val) { return val->get_value_id() == BasicBlockVal; }
+
     /****************api about dominate tree****************/
     void set_idom(Ptr<BasicBlock> bb){idom_ = bb;}
     auto get_idom(){return idom_;}
     void add_dom_frontier(Ptr<BasicBlock> bb){dom_frontier_.insert(bb);}
+    void clear_dom_frontier(){dom_frontier_.clear();}
     void add_rdom_frontier(Ptr<BasicBlock> bb){rdom_frontier_.insert(bb);}
     void clear_rdom_frontier(){rdom_frontier_.clear();}
     auto add_rdom(Ptr<BasicBlock> bb){return rdoms_.insert(bb);}
     void clear_rdom(){rdoms_.clear();}
     auto& get_dom_frontier(){return dom_frontier_;}
+    auto& get_dom_children(){return dom_children_;}
+    // numbers of the block in a walk of the dominator tree, -1 if it is unreachable;
+    // a block dominates those whose numbers lie between its own
+    void set_dom_order(int in, int out){dom_in_ = in; dom_out_ = out;}
+    int get_dom_in(){return dom_in_;}
+    int get_dom_out(){return dom_out_;}
     auto& get_rdom_frontier(){return rdom_frontier_;}
     auto& get_rdoms(){return rdoms_;}
 
@@ -116,13 +127,17 @@ private:
                         Ptr<Function> parent );
     void init(Ptr<Module> m, const std::string &name ,
                         Ptr<Function> parent );
-    WeakPtrList<BasicBlock> pre_bbs_;
-    WeakPtrList<BasicBlock> succ_bbs_;
-    PtrList<Instruction> instr_list_;
-    WeakPtrSet<BasicBlock> dom_frontier_;
-    WeakPtrSet<BasicBlock> rdom_frontier_;
-    WeakPtrSet<BasicBlock> rdoms_;
+    // a block has one or two of each almost always
+    SmallVector<WeakPtr<BasicBlock>, 2> pre_bbs_;
+    SmallVector<WeakPtr<BasicBlock>, 2> succ_bbs_;
+    IList<Instruction> instr_list_;
+    WeakPtrSortedSet<BasicBlock> dom_frontier_;
+    WeakPtrSortedSet<BasicBlock> rdom_frontier_;
+    WeakPtrSortedSet<BasicBlock> rdoms_;
     WeakPtr<BasicBlock> idom_;
+    SmallVector<WeakPtr<BasicBlock>, 2> dom_children_;
+    int dom_in_ = -1;
+    int dom_out_ = -1;
     WeakPtrSet<Value> live_in;
     WeakPtrSet<Value> live_out;
     WeakPtr<Function> parent_;
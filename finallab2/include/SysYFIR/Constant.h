@@ -12,13 +12,19 @@ namespace IR
 class Constant : public User
 {
 protected:
-    explicit Constant(Ptr<Type> ty, const std::string &name = "", unsigned num_ops = 0, Ptr<Module> m=nullptr)
-    : User(ty, name, num_ops), parent_(m) {}
+    explicit Constant(Ptr<Type> ty, unsigned id, const std::string &name = "", unsigned num_ops = 0, Ptr<Module> m=nullptr)
+    : User(ty, id, name, num_ops), parent_(m) {}
     void init(Ptr<Type> ty, const std::string &name = "", unsigned num_ops = 0);
     // int value;
 public:
     WeakPtr<Module> parent_;
     ~Constant() = default;
+    // integer 0, float +0.0 or zeroinitializer
+    bool is_zero_value();
+
+    static bool classof(const Value *val) {
+        return val->get_value_id() >= ConstantIntVal && val->get_value_id() <= ConstantZeroVal;
+    }
 };
 
 class ConstantInt : public Constant
@@ -26,7 +32,7 @@ class ConstantInt : public Constant
 private:
     int value_;
     explicit ConstantInt(Ptr<Type> ty, int val, Ptr<Module> m) 
-        : Constant(ty,"",0,m),value_(val) {}
+        : Constant(ty,ConstantIntVal,"",0,m),value_(val) {}
     void init(Ptr<Type> ty, int val, Ptr<Module> m);
 
 public:
@@ -35,7 +41,9 @@ public:
     int get_value() { return value_; }
     static Ptr<ConstantInt> create(int val, Ptr<Module> m);
     static Ptr<ConstantInt> create(bool val, Ptr<Module> m);
+    static Ptr<ConstantInt> create(Ptr<IntegerType> ty, int val, Ptr<Module> m);
     virtual std::string print() override;
+    static bool classof(const Value *val) { return val->get_value_id() == ConstantIntVal; }
 };
 
 class ConstantFloat : public Constant
@@ -43,7 +51,7 @@ class ConstantFloat : public Constant
 private:
     float value_;
     explicit ConstantFloat(Ptr<Type>  ty,float val, Ptr<Module> m) 
-        : Constant(ty,"",0,m),value_(val) {}
+        : Constant(ty,ConstantFloatVal,"",0,m),value_(val) {}
     void init(Ptr<Type> ty, float val, Ptr<Module> m);
 
 public:
@@ -52,12 +60,17 @@ public:
     float get_value() { return value_; }
     static Ptr<ConstantFloat> create(float val, Ptr<Module> m);
     virtual std::string print() override;
+    static bool classof(const Value *val) { return val->get_value_id() == ConstantFloatVal; }
 };
 
+// Only a prefix of the elements is stored, the elements past it are zero.
+// An array with a long zero tail is emitted as the packed struct
+// <{ [k x T], [N-k x T] }> so that the tail becomes a zeroinitializer.
 class ConstantArray : public Constant
 {
 private:
-    PtrVec<Constant> const_array;
+    PtrVec<Constant> const_array;   // explicit elements
+    Ptr<Constant> zero_;            // value of the elements in the tail
     explicit ConstantArray(Ptr<ArrayType> ty, const PtrVec<Constant> &val, Ptr<Module> m);
     void init(Ptr<ArrayType> ty, const PtrVec<Constant> &val, Ptr<Module> m);
 
@@ -67,23 +80,51 @@ public:
 
     Ptr<Constant> get_element_value(int index);
 
-    unsigned get_size_of_array() { return const_array.size(); } 
+    unsigned get_size_of_array();
+    unsigned get_num_explicit_elements() { return const_array.size(); }
+    bool has_zero_tail() { return get_num_explicit_elements() < get_size_of_array(); }
 
+    // val may be shorter than the array, missing elements are zero
     static Ptr<ConstantArray> create(Ptr<ArrayType> ty, const PtrVec<Constant> &val, Ptr<Module> m);
+    // same as create, but gives a ConstantZero if every element is zero
+    static Ptr<Constant> get(Ptr<ArrayType> ty, const PtrVec<Constant> &val, Ptr<Module> m);
+
+    // type of the emitted initializer, differs from get_type() if has_zero_tail()
+    std::string print_storage_type();
+    virtual std::string print() override;
+    static bool classof(const Value *val) { return val->get_value_id() == ConstantArrayVal; }
+};
+
+class ConstantVector : public Constant
+{
+private:
+    PtrVec<Constant> elements_;
+    explicit ConstantVector(Ptr<VectorType> ty, const PtrVec<Constant> &val, Ptr<Module> m)
+        : Constant(ty, ConstantVectorVal, "", val.size(), m) {}
+    void init(Ptr<VectorType> ty, const PtrVec<Constant> &val, Ptr<Module> m);
+
+public:
+    Ptr<Constant> get_element_value(int index) { return elements_[index]; }
+    unsigned get_num_of_elements() { return elements_.size(); }
 
+    static Ptr<ConstantVector> create(Ptr<VectorType> ty, const PtrVec<Constant> &val, Ptr<Module> m);
+    // a vector of num_elements copies of val
+    static Ptr<ConstantVector> get_splat(unsigned num_elements, Ptr<Constant> val, Ptr<Module> m);
     virtual std::string print() override;
+    static bool classof(const Value *val) { return val->get_value_id() == ConstantVectorVal; }
 };
 
 class ConstantZero : public Constant 
 {
 private:
     explicit ConstantZero(Ptr<Type> ty, Ptr<Module> m)
-        : Constant(ty,"",0,m) {}
+        : Constant(ty,ConstantZeroVal,"",0,m) {}
     void init(Ptr<Type> ty, Ptr<Module> m);
 
 public:
     static Ptr<ConstantZero> create(Ptr<Type> ty, Ptr<Module> m);
     virtual std::string print() override;
+    static bool classof(const Value *val) { return val->get_value_id() == ConstantZeroVal; }
 };
 
 }
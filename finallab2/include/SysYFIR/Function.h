@@ -35,6 +35,8 @@ public:
     Ptr<Type> get_return_type() const;
 
     void add_basic_block(Ptr<BasicBlock> bb);
+    // move all basic blocks of f to the end of this function, f is left empty
+    void move_basic_blocks_from(Ptr<Function> f);
 
     unsigned get_num_of_args() const;
     unsigned get_num_basic_blocks() const;
@@ -47,21 +49,24 @@ public:
     void remove(Ptr<BasicBlock>  bb);
     Ptr<BasicBlock> get_entry_block() { return *basic_blocks_.begin(); }
 
-    PtrList<BasicBlock> &get_basic_blocks() { return basic_blocks_; }
+    IList<BasicBlock> &get_basic_blocks() { return basic_blocks_; }
     PtrList<Argument> &get_args() { return arguments_; }
     
     bool is_declaration() { return basic_blocks_.empty(); }
 
+    // number the values without a name, named ones keep theirs
     void set_instr_name();
     std::string print();
 
+    static bool classof(const Value *val) { return val->get_value_id() == FunctionVal; }
+
 private:
     explicit Function(Ptr<FunctionType> ty, const std::string &name, Ptr<Module> parent);
     void init(Ptr<FunctionType> ty, const std::string &name, Ptr<Module> parent);
     void build_args();
 
 private:
-    PtrList<BasicBlock> basic_blocks_;    // basic blocks
+    IList<BasicBlock> basic_blocks_;      // basic blocks
     PtrList<Argument> arguments_;         // arguments
     WeakPtr<Module> parent_;
     unsigned seq_cnt_;
@@ -90,11 +95,13 @@ public:
     }
 
     virtual std::string print() override ;
+
+    static bool classof(const Value *val) { return val->get_value_id() == ArgumentVal; }
 private:
     // Argument constructor.
     explicit Argument(Ptr<Type> ty, const std::string &name = "", Ptr<Function> f = nullptr,
                     unsigned arg_no = 0)
-        : Value(ty, name), parent_(f), arg_no_(arg_no) {}
+        : Value(ty, ArgumentVal, name), parent_(f), arg_no_(arg_no) {}
     WeakPtr<Function> parent_;
     unsigned arg_no_;  // argument No.
 };
@@ -22,6 +22,8 @@ public:
     Ptr<Constant> get_init() { return init_val_; }
     bool is_const() { return is_const_; }
     std::string print();
+
+    static bool classof(const Value *val) { return val->get_value_id() == GlobalVariableVal; }
 };
 
 }
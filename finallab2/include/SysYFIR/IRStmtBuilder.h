@@ -26,6 +26,14 @@ public:
     Ptr<BinaryInst> create_imul( Ptr<Value> lhs, Ptr<Value> rhs){ return BinaryInst::create_mul( lhs, rhs, this->BB_, m_);}
     Ptr<BinaryInst> create_isdiv( Ptr<Value> lhs, Ptr<Value> rhs){ return BinaryInst::create_sdiv( lhs, rhs, this->BB_, m_);}
     Ptr<BinaryInst> create_isrem( Ptr<Value> lhs, Ptr<Value> rhs){ return BinaryInst::create_srem( lhs, rhs, this->BB_, m_);}
+    Ptr<BinaryInst> create_iudiv( Ptr<Value> lhs, Ptr<Value> rhs){ return BinaryInst::create_udiv( lhs, rhs, this->BB_, m_);}
+    Ptr<BinaryInst> create_iurem( Ptr<Value> lhs, Ptr<Value> rhs){ return BinaryInst::create_urem( lhs, rhs, this->BB_, m_);}
+    Ptr<BinaryInst> create_ishl( Ptr<Value> lhs, Ptr<Value> rhs){ return BinaryInst::create_shl( lhs, rhs, this->BB_, m_);}
+    Ptr<BinaryInst> create_iashr( Ptr<Value> lhs, Ptr<Value> rhs){ return BinaryInst::create_ashr( lhs, rhs, this->BB_, m_);}
+    Ptr<BinaryInst> create_ilshr( Ptr<Value> lhs, Ptr<Value> rhs){ return BinaryInst::create_lshr( lhs, rhs, this->BB_, m_);}
+    Ptr<BinaryInst> create_iand( Ptr<Value> lhs, Ptr<Value> rhs){ return BinaryInst::create_and( lhs, rhs, this->BB_, m_);}
+    Ptr<BinaryInst> create_ior( Ptr<Value> lhs, Ptr<Value> rhs){ return BinaryInst::create_or( lhs, rhs, this->BB_, m_);}
+    Ptr<BinaryInst> create_ixor( Ptr<Value> lhs, Ptr<Value> rhs){ return BinaryInst::create_xor( lhs, rhs, this->BB_, m_);}
 
     Ptr<CmpInst> create_icmp_eq( Ptr<Value> lhs, Ptr<Value> rhs){ return CmpInst::create_cmp(CmpInst::EQ, lhs, rhs, this->BB_, m_); }
     Ptr<CmpInst> create_icmp_ne( Ptr<Value> lhs, Ptr<Value> rhs){ return CmpInst::create_cmp(CmpInst::NE, lhs, rhs, this->BB_, m_); }
@@ -49,7 +57,7 @@ public:
     Ptr<CallInst> create_call(Ptr<Value> func, PtrVec<Value> args)
     {
 #ifdef DEBUG
-        assert( dynamic_pointer_cast<Function>(func) && "func must be Ptr<Function> type");
+        assert( isa<Function>(func) && "func must be Ptr<Function> type");
 #endif
         return CallInst::create(static_pointer_cast<Function>(func) ,args, this->BB_); 
     }
@@ -57,6 +65,8 @@ public:
     Ptr<BranchInst> create_br(Ptr<BasicBlock> if_true){ return BranchInst::create_br(if_true, this->BB_); }
     Ptr<BranchInst> create_cond_br(Ptr<Value> cond, Ptr<BasicBlock> if_true, Ptr<BasicBlock> if_false){ return BranchInst::create_cond_br(cond, if_true, if_false,this->BB_); }
     
+    Ptr<SwitchInst> create_switch(Ptr<Value> cond, Ptr<BasicBlock> default_bb) { return SwitchInst::create_switch(cond, default_bb, this->BB_); }
+
     Ptr<ReturnInst> create_ret(Ptr<Value> val) { return ReturnInst::create_ret(val,this->BB_); }
     Ptr<ReturnInst> create_void_ret() { return ReturnInst::create_void_ret(this->BB_); }
 
@@ -72,10 +82,17 @@ public:
         return LoadInst::create_load(ptr->get_type()->get_pointer_element_type(), ptr, this->BB_); 
     }
 
+    Ptr<SelectInst> create_select(Ptr<Value> cond, Ptr<Value> true_val, Ptr<Value> false_val) { return SelectInst::create_select(cond, true_val, false_val, this->BB_); }
+    Ptr<InsertElementInst> create_insertelement(Ptr<Value> vec, Ptr<Value> elt, Ptr<Value> idx) { return InsertElementInst::create_insertelement(vec, elt, idx, this->BB_); }
+    Ptr<ExtractElementInst> create_extractelement(Ptr<Value> vec, Ptr<Value> idx) { return ExtractElementInst::create_extractelement(vec, idx, this->BB_); }
+
     Ptr<AllocaInst> create_alloca(Ptr<Type> ty) { return AllocaInst::create_alloca(ty, this->BB_); }
     Ptr<ZextInst> create_zext(Ptr<Value> val, Ptr<Type> ty) { return ZextInst::create_zext(val, ty, this->BB_); }
+    Ptr<SextInst> create_sext(Ptr<Value> val, Ptr<Type> ty) { return SextInst::create_sext(val, ty, this->BB_); }
+    Ptr<TruncInst> create_trunc(Ptr<Value> val, Ptr<Type> ty) { return TruncInst::create_trunc(val, ty, this->BB_); }
     Ptr<FpToSiInst> create_fptosi(Ptr<Value> val, Ptr<Type> ty) { return FpToSiInst::create_fptosi(val, ty, this->BB_); }
     Ptr<SiToFpInst> create_sitofp(Ptr<Value> val, Ptr<Type> ty) { return SiToFpInst::create_sitofp(val, ty, this->BB_); }
+    Ptr<BitCastInst> create_bitcast(Ptr<Value> val, Ptr<Type> ty) { return BitCastInst::create_bitcast(val, ty, this->BB_); }
 };
 
 }
@@ -15,7 +15,7 @@ class BasicBlock;
 class Function;
 class Instruction;
 
-class Instruction : public User
+class Instruction : public User, public IListNode<Instruction>
 {
 public:
     enum OpID
@@ -23,12 +23,22 @@ public:
         // Terminator Instructions
         ret,
         br,
+        switch_,
         // Standard binary operators
         add,
         sub,
         mul,
         sdiv,
         srem,
+        udiv,
+        urem,
+        // Shift and bitwise operators
+        shl,
+        ashr,
+        lshr,
+        and_,
+        or_,
+        xor_,
         // Float binaru opeartors
         fadd,
         fsub,
@@ -44,15 +54,35 @@ public:
         phi,
         call,
         getelementptr, 
-        // Zero extend
+        select,
+        // Vector lane access
+        insertelement,
+        extractelement,
+        // Zero extend, sign extend and truncate between integer types
         zext,
+        sext,
+        trunc,
         // type cast bewteen float and singed integer
         fptosi,
         sitofp,
+        // reinterpret a pointer as a pointer to another type
+        bitcast,
     };
     inline const Ptr<BasicBlock> get_parent() const { return parent_.lock(); }
     inline Ptr<BasicBlock> get_parent() { return parent_.lock(); }
     void set_parent(Ptr<BasicBlock> parent) { this->parent_ = parent; }
+
+    /****************constant time list edits****************/
+    // put the instruction in front of or after pos, in the block of pos;
+    // one that is in a block already is moved there
+    void insert_before(Ptr<Instruction> pos);
+    void insert_after(Ptr<Instruction> pos);
+    // move the instruction to the end of bb, in front of its terminator if it has one
+    void move_to(Ptr<BasicBlock> bb);
+    // take the instruction out of its block, it keeps its operands
+    void remove_from_parent();
+    // take the instruction out of its block and drop its operands, like BasicBlock::delete_instr
+    void erase_from_parent();
     // Return the function this instruction belongs to.
     Ptr<Function> get_function();
     Ptr<Module> get_module();
@@ -63,11 +93,20 @@ public:
         {
             case ret: return "ret"; break;
             case br: return "br"; break;
+            case switch_: return "switch"; break;
             case add: return "add"; break;
             case sub: return "sub"; break;
             case mul: return "mul"; break;
             case sdiv: return "sdiv"; break;
             case srem: return "srem"; break;
+            case udiv: return "udiv"; break;
+            case urem: return "urem"; break;
+            case shl: return "shl"; break;
+            case ashr: return "ashr"; break;
+            case lshr: return "lshr"; break;
+            case and_: return "and"; break;
+            case or_: return "or"; break;
+            case xor_: return "xor"; break;
             case fadd: return "fadd"; break;
             case fsub: return "fsub"; break;
             case fmul: return "fmul"; break;
@@ -80,9 +119,15 @@ public:
             case phi: return "phi"; break;
             case call: return "call"; break;
             case getelementptr: return "getelementptr"; break;
+            case select: return "select"; break;
+            case insertelement: return "insertelement"; break;
+            case extractelement: return "extractelement"; break;
             case zext: return "zext"; break;
+            case sext: return "sext"; break;
+            case trunc: return "trunc"; break;
             case fptosi: return "fptosi"; break;
             case sitofp: return "sitofp"; break;
+            case bitcast: return "bitcast"; break;
         
         default: return ""; break;
         }
@@ -90,7 +135,7 @@ public:
 
 
 
-    bool is_void() { return ((op_id_ == ret) || (op_id_ == br) || (op_id_ == store) || (op_id_ == call && this->get_type()->is_void_type())); }
+    bool is_void() { return ((op_id_ == ret) || (op_id_ == br) || (op_id_ == switch_) || (op_id_ == store) || (op_id_ == call && this->get_type()->is_void_type())); }
 
     bool is_phi() { return op_id_ == phi; }
     bool is_store() { return op_id_ == store; }
@@ -98,12 +143,22 @@ public:
     bool is_ret() { return op_id_ == ret; }
     bool is_load() { return op_id_ == load; }
     bool is_br() { return op_id_ == br; }
+    bool is_switch() { return op_id_ == switch_; }
 
     bool is_add() { return op_id_ == add; }
     bool is_sub() { return op_id_ == sub; }
     bool is_mul() { return op_id_ == mul; }
     bool is_div() { return op_id_ == sdiv; }
     bool is_rem() { return op_id_ == srem; }
+    bool is_udiv() { return op_id_ == udiv; }
+    bool is_urem() { return op_id_ == urem; }
+
+    bool is_shl() { return op_id_ == shl; }
+    bool is_ashr() { return op_id_ == ashr; }
+    bool is_lshr() { return op_id_ == lshr; }
+    bool is_and() { return op_id_ == and_; }
+    bool is_or() { return op_id_ == or_; }
+    bool is_xor() { return op_id_ == xor_; }
 
     bool is_fadd() { return op_id_ == fadd; }
     bool is_fsub() { return op_id_ == fsub; }
@@ -115,18 +170,27 @@ public:
 
     bool is_call() { return op_id_ == call; }
     bool is_gep() { return op_id_ == getelementptr; }
+    bool is_select() { return op_id_ == select; }
+    bool is_insertelement() { return op_id_ == insertelement; }
+    bool is_extractelement() { return op_id_ == extractelement; }
     bool is_zext() { return op_id_ == zext; }
+    bool is_sext() { return op_id_ == sext; }
+    bool is_trunc() { return op_id_ == trunc; }
     bool is_fptosi() { return op_id_ == fptosi; }
     bool is_sitofp() { return op_id_ == sitofp; }
+    bool is_bitcast() { return op_id_ == bitcast; }
 
     bool isBinary()
     {
-        return (is_add() || is_sub() || is_mul() || is_div() || is_rem() || 
+        return (is_add() || is_sub() || is_mul() || is_div() || is_rem() || is_udiv() || is_urem() ||
+                is_shl() || is_ashr() || is_lshr() || is_and() || is_or() || is_xor() ||
                 is_fadd() || is_fsub() || is_fmul() || is_fdiv()) && 
                 (get_num_operand() == 2);
     }
 
-    bool isTerminator() { return is_br() || is_ret(); }
+    bool isTerminator() { return is_br() || is_switch() || is_ret(); }
+
+    static bool classof(const Value *val) { return val->get_value_id() >= InstructionVal; }
 
     void set_id(int id){id_ = id;}
     int get_id() const{return id_;}
@@ -153,17 +217,30 @@ private:
                Ptr<BasicBlock> bb);
 
 public:
+    // any binary operator, the result has the type of v1
+    static Ptr<BinaryInst> create(OpID id, Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb);
     static Ptr<BinaryInst> create_add(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m);
     static Ptr<BinaryInst> create_sub(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m);
     static Ptr<BinaryInst> create_mul(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m);
     static Ptr<BinaryInst> create_sdiv(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m);
     static Ptr<BinaryInst> create_srem(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m);
+    static Ptr<BinaryInst> create_udiv(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m);
+    static Ptr<BinaryInst> create_urem(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m);
+    static Ptr<BinaryInst> create_shl(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m);
+    static Ptr<BinaryInst> create_ashr(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m);
+    static Ptr<BinaryInst> create_lshr(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m);
+    static Ptr<BinaryInst> create_and(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m);
+    static Ptr<BinaryInst> create_or(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m);
+    static Ptr<BinaryInst> create_xor(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m);
     static Ptr<BinaryInst> create_fadd(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m);
     static Ptr<BinaryInst> create_fsub(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m);
     static Ptr<BinaryInst> create_fmul(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m);
     static Ptr<BinaryInst> create_fdiv(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m);
 
     virtual std::string print() override;
+    static bool classof(const Value *val) {
+        return val->get_value_id() >= InstructionVal + add && val->get_value_id() <= InstructionVal + fdiv;
+    }
 
 private:
     void init(Ptr<Type> ty, OpID id, Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb);
@@ -192,8 +269,10 @@ public:
                                Ptr<BasicBlock> bb, Ptr<Module> m);
 
     CmpOp get_cmp_op() { return cmp_op_; }
+    void set_cmp_op(CmpOp op) { cmp_op_ = op; }
 
     virtual std::string print() override;
+    static bool classof(const Value *val) { return val->get_value_id() == InstructionVal + cmp; }
 
 private:
     CmpOp cmp_op_;
@@ -224,8 +303,10 @@ public:
                                Ptr<BasicBlock> bb, Ptr<Module> m);
 
     CmpOp get_cmp_op() { return cmp_op_; }
+    void set_cmp_op(CmpOp op) { cmp_op_ = op; }
 
     virtual std::string print() override;
+    static bool classof(const Value *val) { return val->get_value_id() == InstructionVal + fcmp; }
 
 private:
     CmpOp cmp_op_;
@@ -246,6 +327,7 @@ public:
     Ptr<FunctionType> get_function_type() const;
 
     virtual std::string print() override;
+    static bool classof(const Value *val) { return val->get_value_id() == InstructionVal + call; }
 
 };
 
@@ -271,7 +353,29 @@ public:
     bool is_cond_br() const;
 
     virtual std::string print() override;
+    static bool classof(const Value *val) { return val->get_value_id() == InstructionVal + br; }
+
+};
+
+class SwitchInst : public Instruction
+{
+private:
+    explicit SwitchInst(Ptr<Value> cond, Ptr<BasicBlock> default_bb, Ptr<BasicBlock> bb);
+    void init(Ptr<Value> cond, Ptr<BasicBlock> default_bb, Ptr<BasicBlock> bb);
+
+public:
+    // operands are cond, default, then one (value, dest) pair per case
+    static Ptr<SwitchInst> create_switch(Ptr<Value> cond, Ptr<BasicBlock> default_bb, Ptr<BasicBlock> bb);
+    void add_case(Ptr<ConstantInt> val, Ptr<BasicBlock> dest);
 
+    Ptr<Value> get_condition() { return get_operand(0); }
+    Ptr<BasicBlock> get_default_dest();
+    unsigned get_num_cases() { return (get_num_operand() - 2) / 2; }
+    Ptr<ConstantInt> get_case_value(unsigned i);
+    Ptr<BasicBlock> get_case_dest(unsigned i);
+
+    virtual std::string print() override;
+    static bool classof(const Value *val) { return val->get_value_id() == InstructionVal + switch_; }
 };
 
 class ReturnInst : public Instruction
@@ -288,6 +392,7 @@ public:
     bool is_void_ret() const;
 
     virtual std::string print() override;
+    static bool classof(const Value *val) { return val->get_value_id() == InstructionVal + ret; }
 
 };
 
@@ -303,6 +408,7 @@ public:
     Ptr<Type> get_element_type() const;
 
     virtual std::string print() override;
+    static bool classof(const Value *val) { return val->get_value_id() == InstructionVal + getelementptr; }
 
 private:
     WeakPtr<Type> element_ty_;
@@ -320,8 +426,15 @@ public:
     Ptr<Value> get_rval() { return this->get_operand(0); }
     Ptr<Value> get_lval() { return this->get_operand(1); }
 
+    // 0 keeps the natural alignment of the stored type
+    void set_alignment(int align) { align_ = align; }
+    int get_alignment() const { return align_; }
+
     virtual std::string print() override;
+    static bool classof(const Value *val) { return val->get_value_id() == InstructionVal + store; }
 
+private:
+    int align_ = 0;
 };
 
 class LoadInst : public Instruction
@@ -336,8 +449,15 @@ public:
 
     Ptr<Type> get_load_type() const;
 
+    // 0 keeps the natural alignment of the loaded type
+    void set_alignment(int align) { align_ = align; }
+    int get_alignment() const { return align_; }
+
     virtual std::string print() override;
+    static bool classof(const Value *val) { return val->get_value_id() == InstructionVal + load; }
 
+private:
+    int align_ = 0;
 };
 
 class AllocaInst : public Instruction
@@ -352,6 +472,7 @@ public:
     Ptr<Type> get_alloca_type() const;
 
     virtual std::string print() override;
+    static bool classof(const Value *val) { return val->get_value_id() == InstructionVal + alloca; }
 
 private:
     WeakPtr<Type> alloca_ty_;
@@ -369,6 +490,43 @@ public:
     Ptr<Type> get_dest_type() const;
 
     virtual std::string print() override;
+    static bool classof(const Value *val) { return val->get_value_id() == InstructionVal + zext; }
+
+private:
+    WeakPtr<Type> dest_ty_;
+};
+
+class SextInst : public Instruction
+{
+private:
+    explicit SextInst(OpID op, Ptr<Value> val, Ptr<Type> ty, Ptr<BasicBlock> bb);
+    void init(OpID op, Ptr<Value> val, Ptr<Type> ty, Ptr<BasicBlock> bb);
+
+public:
+    static Ptr<SextInst> create_sext(Ptr<Value> val, Ptr<Type> ty, Ptr<BasicBlock> bb);
+
+    Ptr<Type> get_dest_type() const;
+
+    virtual std::string print() override;
+    static bool classof(const Value *val) { return val->get_value_id() == InstructionVal + sext; }
+
+private:
+    WeakPtr<Type> dest_ty_;
+};
+
+class TruncInst : public Instruction
+{
+private:
+    explicit TruncInst(OpID op, Ptr<Value> val, Ptr<Type> ty, Ptr<BasicBlock> bb);
+    void init(OpID op, Ptr<Value> val, Ptr<Type> ty, Ptr<BasicBlock> bb);
+
+public:
+    static Ptr<TruncInst> create_trunc(Ptr<Value> val, Ptr<Type> ty, Ptr<BasicBlock> bb);
+
+    Ptr<Type> get_dest_type() const;
+
+    virtual std::string print() override;
+    static bool classof(const Value *val) { return val->get_value_id() == InstructionVal + trunc; }
 
 private:
     WeakPtr<Type> dest_ty_;
@@ -386,6 +544,7 @@ public:
     Ptr<Type> get_dest_type() const;
 
     virtual std::string print() override;
+    static bool classof(const Value *val) { return val->get_value_id() == InstructionVal + fptosi; }
 
 private:
     WeakPtr<Type> dest_ty_;
@@ -403,11 +562,80 @@ public:
     Ptr<Type> get_dest_type() const;
 
     virtual std::string print() override;
+    static bool classof(const Value *val) { return val->get_value_id() == InstructionVal + sitofp; }
+
+private:
+    WeakPtr<Type> dest_ty_;
+};
+
+class BitCastInst : public Instruction
+{
+private:
+    explicit BitCastInst(OpID op, Ptr<Value> val, Ptr<Type> ty, Ptr<BasicBlock> bb);
+    void init(OpID op, Ptr<Value> val, Ptr<Type> ty, Ptr<BasicBlock> bb);
+
+public:
+    static Ptr<BitCastInst> create_bitcast(Ptr<Value> val, Ptr<Type> ty, Ptr<BasicBlock> bb);
+
+    Ptr<Type> get_dest_type() const;
+
+    virtual std::string print() override;
+    static bool classof(const Value *val) { return val->get_value_id() == InstructionVal + bitcast; }
 
 private:
     WeakPtr<Type> dest_ty_;
 };
 
+class SelectInst : public Instruction
+{
+private:
+    explicit SelectInst(Ptr<Value> cond, Ptr<Value> true_val, Ptr<Value> false_val, Ptr<BasicBlock> bb);
+    void init(Ptr<Value> cond, Ptr<Value> true_val, Ptr<Value> false_val, Ptr<BasicBlock> bb);
+
+public:
+    static Ptr<SelectInst> create_select(Ptr<Value> cond, Ptr<Value> true_val, Ptr<Value> false_val, Ptr<BasicBlock> bb);
+
+    Ptr<Value> get_condition() { return get_operand(0); }
+    Ptr<Value> get_true_value() { return get_operand(1); }
+    Ptr<Value> get_false_value() { return get_operand(2); }
+
+    virtual std::string print() override;
+    static bool classof(const Value *val) { return val->get_value_id() == InstructionVal + select; }
+};
+
+class InsertElementInst : public Instruction
+{
+private:
+    explicit InsertElementInst(Ptr<Value> vec, Ptr<Value> elt, Ptr<Value> idx, Ptr<BasicBlock> bb);
+    void init(Ptr<Value> vec, Ptr<Value> elt, Ptr<Value> idx, Ptr<BasicBlock> bb);
+
+public:
+    static Ptr<InsertElementInst> create_insertelement(Ptr<Value> vec, Ptr<Value> elt, Ptr<Value> idx, Ptr<BasicBlock> bb);
+
+    Ptr<Value> get_vector_operand() { return get_operand(0); }
+    Ptr<Value> get_element_operand() { return get_operand(1); }
+    Ptr<Value> get_index_operand() { return get_operand(2); }
+
+    virtual std::string print() override;
+    static bool classof(const Value *val) { return val->get_value_id() == InstructionVal + insertelement; }
+};
+
+class ExtractElementInst : public Instruction
+{
+private:
+    explicit ExtractElementInst(Ptr<Value> vec, Ptr<Value> idx, Ptr<BasicBlock> bb);
+    void init(Ptr<Value> vec, Ptr<Value> idx, Ptr<BasicBlock> bb);
+
+public:
+    static Ptr<ExtractElementInst> create_extractelement(Ptr<Value> vec, Ptr<Value> idx, Ptr<BasicBlock> bb);
+
+    Ptr<Value> get_vector_operand() { return get_operand(0); }
+    Ptr<Value> get_index_operand() { return get_operand(1); }
+
+    virtual std::string print() override;
+    static bool classof(const Value *val) { return val->get_value_id() == InstructionVal + extractelement; }
+};
+
 class PhiInst : public Instruction
 {
 private:
@@ -424,6 +652,7 @@ public:
         this->add_operand(pre_bb);
     }
     virtual std::string print() override;
+    static bool classof(const Value *val) { return val->get_value_id() == InstructionVal + phi; }
 
 private:
     Ptr<Value> l_val_;
@@ -28,21 +28,27 @@ public:
     Ptr<Type> get_void_type();
     Ptr<Type> get_label_type();
     Ptr<IntegerType> get_int1_type();
+    Ptr<IntegerType> get_int8_type();
     Ptr<IntegerType> get_int32_type();
+    Ptr<IntegerType> get_int64_type();
     Ptr<FloatType> get_float_type();
     Ptr<PointerType> get_int32_ptr_type();
     Ptr<PointerType> get_float_ptr_type();
 
     Ptr<PointerType> get_pointer_type(Ptr<Type> contained);
     Ptr<ArrayType> get_array_type(Ptr<Type> contained, unsigned num_elements);
+    Ptr<VectorType> get_vector_type(Ptr<Type> contained, unsigned num_elements);
 
     void add_function(Ptr<Function> f);
+    void remove_function(Ptr<Function> f);
     PtrList<Function> &get_functions();
     void add_global_variable(Ptr<GlobalVariable> g);
+    void remove_global_variable(Ptr<GlobalVariable> g);
     void add_type(Ptr<Type> t) { all_types_.push_back(t); }
     void add_constant(Ptr<Constant> c) { all_constants_.push_back(c); }
     PtrList<GlobalVariable> &get_global_variable();
     std::string get_instr_op_name( Instruction::OpID instr ) { return instr_id2string_[instr]; }
+    // set_instr_name of every function, printing a function does it too
     void set_print_name();
     void set_file_name(std::string name){source_file_name_ = name;}
     std::string get_file_name(){return source_file_name_;}
@@ -60,13 +66,16 @@ private:
 
 private:
     Ptr<IntegerType> int1_ty_;
+    Ptr<IntegerType> int8_ty_;
     Ptr<IntegerType> int32_ty_;
+    Ptr<IntegerType> int64_ty_;
     Ptr<FloatType> float32_ty_;
     Ptr<Type> label_ty_;
     Ptr<Type> void_ty_;    
     
     std::map<Ptr<Type> , Ptr<PointerType>> pointer_map_;
     std::map<std::pair<Ptr<Type> ,int>, Ptr<ArrayType> > array_map_; 
+    std::map<std::pair<Ptr<Type> ,int>, Ptr<VectorType> > vector_map_;
     std::vector<Ptr<Type>> all_types_;
     std::vector<Ptr<Constant>> all_constants_;
 };
@@ -16,6 +16,7 @@ class FloatType;
 class FunctionType;
 class ArrayType;
 class PointerType;
+class VectorType;
 class Type;
 
 class Type : public std::enable_shared_from_this<Type>
@@ -29,6 +30,7 @@ public:
         FunctionTyID,     // Functions
         ArrayTyID,        // Arrays
         PointerTyID,      // Pointer
+        VectorTyID,       // Fixed length vectors of i32 or float
     };
 
     static Ptr<Type> create(TypeID tid, Ptr<Module> m);
@@ -51,6 +53,8 @@ public:
 
     bool is_pointer_type() const { return get_type_id() == PointerTyID; }
 
+    bool is_vector_type() const { return get_type_id() == VectorTyID; }
+
     static bool is_eq_type(Ptr<Type> ty1, Ptr<Type> ty2);
 
     static Ptr<Type> get_void_type(Ptr<Module> m);
@@ -59,8 +63,12 @@ public:
 
     static Ptr<IntegerType> get_int1_type(Ptr<Module> m);
 
+    static Ptr<IntegerType> get_int8_type(Ptr<Module> m);
+
     static Ptr<IntegerType> get_int32_type(Ptr<Module> m);
 
+    static Ptr<IntegerType> get_int64_type(Ptr<Module> m);
+
     static Ptr<FloatType> get_float_type(Ptr<Module> m);
 
     static Ptr<PointerType> get_int32_ptr_type(Ptr<Module> m);
@@ -71,10 +79,15 @@ public:
 
     static Ptr<ArrayType> get_array_type(Ptr<Type> contained, unsigned num_elements);
 
+    static Ptr<VectorType> get_vector_type(Ptr<Type> contained, unsigned num_elements);
+
     Ptr<Type> get_pointer_element_type();
 
     Ptr<Type> get_array_element_type();
 
+    // element type of a vector, or the type itself for scalars
+    Ptr<Type> get_scalar_type();
+
     int get_size();
     
     Ptr<Module> get_module();
@@ -155,6 +168,23 @@ private:
     WeakPtr<Type> contained_;   // The element type of the ptr.
 };
 
+class VectorType : public Type {
+public:
+    static bool is_valid_element_type(Ptr<Type> ty);
+
+    static Ptr<VectorType> get(Ptr<Type> contained, unsigned num_elements);
+    static Ptr<VectorType> create(Ptr<Type> contained, unsigned num_elements, Ptr<Module> m);
+
+    Ptr<Type> get_element_type() const { return contained_.lock(); }
+    unsigned get_num_of_elements() const { return num_elements_; }
+
+private:
+    explicit VectorType(Ptr<Type> contained, unsigned num_elements, Ptr<Module> m);
+    void init(Ptr<Type> contained, unsigned num_elements, Ptr<Module> m) { Type::init(VectorTyID, m); }
+    WeakPtr<Type> contained_;   // The element type of the vector.
+    unsigned num_elements_;  // Number of lanes.
+};
+
 }
 }
 #endif // _SYSYF_TYPE_H_
@@ -28,11 +28,15 @@ public:
     void remove_use_of_ops();
     void remove_operands(int index1,int index2);
 
+    static bool classof(const Value *val) {
+        return val->get_value_id() >= GlobalVariableVal;
+    }
+
 protected:
-    explicit User(Ptr<Type> ty, const std::string &name = "", unsigned num_ops = 0);
+    explicit User(Ptr<Type> ty, unsigned id, const std::string &name = "", unsigned num_ops = 0);
 
 private:
-    WeakPtrVec<Value> operands_;   // operands of this value
+    SmallVector<WeakPtr<Value>, 3> operands_;   // operands of this value
     unsigned num_ops_;
 };
 
@@ -5,6 +5,9 @@
 #include <list>
 #include <iostream>
 #include <memory>
+#ifdef DEBUG
+#include <cassert>
+#endif
 
 #include "internal_types.h"
 
@@ -26,8 +29,29 @@ struct Use
 class Value : public std::enable_shared_from_this<Value>
 {
 public:
+    // concrete class of a value, tested by the classof of each class;
+    // an instruction has InstructionVal plus its opcode
+    enum ValueID
+    {
+        ArgumentVal,
+        BasicBlockVal,
+        FunctionVal,
+        // users from here on
+        GlobalVariableVal,
+        // constants
+        ConstantIntVal,
+        ConstantFloatVal,
+        ConstantArrayVal,
+        ConstantVectorVal,
+        ConstantZeroVal,
+        // must be last
+        InstructionVal,
+    };
+
     ~Value() = default;
 
+    unsigned get_value_id() const { return value_id_; }
+
     Ptr<Type> get_type() const { return type_.lock(); }
 
     std::list<Use> &get_use_list() { return use_list_; }
@@ -42,28 +66,78 @@ public:
         }   
         return false; 
     }
-    std::string get_name() const;
+    const std::string &get_name() const { return name_; }
+    bool has_name() const { return !name_.empty(); }
 
     void replace_all_use_with(Ptr<Value> new_val);
     void remove_use(Ptr<Value> val);
+    void remove_use(Ptr<Value> val, unsigned arg_no);
 
     virtual std::string print() = 0;
 
-    // cast to Instruction, BasicBlock, Function, ...
+    // cast to Instruction, BasicBlock, Function, ..., null if it is none
     template <typename T>
     Ptr<T> as() {
-        return dynamic_pointer_cast<T>(shared_from_this());
+        if (!T::classof(this)) {
+            return nullptr;
+        }
+        return static_pointer_cast<T>(shared_from_this());
     }
 
+    static bool classof(const Value *) { return true; }
+
 protected:
-    explicit Value(Ptr<Type> ty, const std::string &name = "");
+    explicit Value(Ptr<Type> ty, unsigned id, const std::string &name = "");
 
 private:
+    unsigned value_id_;
     WeakPtr<Type> type_;
     std::list<Use> use_list_;   // who use this value
     std::string name_;    // should we put name field here ?
 };
 
+/****************casts without RTTI****************/
+// isa<T>(v) is true if v is a T, cast<T>(v) converts v that must be one,
+// dyn_cast<T>(v) converts v or gives null; the check is T::classof, which
+// only reads the ValueID. They take plain pointers as well as Ptr, and a
+// null value is no T.
+
+template <typename T, typename U>
+inline bool isa(const U *val) {
+    return val && T::classof(val);
+}
+
+template <typename T, typename U>
+inline bool isa(const Ptr<U> &val) {
+    return isa<T>(val.get());
+}
+
+template <typename T, typename U>
+inline T *cast(U *val) {
+#ifdef DEBUG
+    assert(isa<T>(val) && "cast to a class the value is not of");
+#endif
+    return static_cast<T *>(val);
+}
+
+template <typename T, typename U>
+inline Ptr<T> cast(const Ptr<U> &val) {
+#ifdef DEBUG
+    assert(isa<T>(val) && "cast to a class the value is not of");
+#endif
+    return static_pointer_cast<T>(val);
+}
+
+template <typename T, typename U>
+inline T *dyn_cast(U *val) {
+    return isa<T>(val) ? static_cast<T *>(val) : nullptr;
+}
+
+template <typename T, typename U>
+inline Ptr<T> dyn_cast(const Ptr<U> &val) {
+    return isa<T>(val) ? static_pointer_cast<T>(val) : nullptr;
+}
+
 }
 }
 #endif // _SYSYF_VALUE_H_
@@ -50,7 +50,7 @@ public:
     // but func name could be same with variable name
     bool push(std::string name, Ptr<Value> val) {
         bool result;
-        if (dynamic_pointer_cast<Function>(val)){
+        if (isa<Function>(val)){
             result = (name2func[name2func.size() - 1].insert({name, val})).second;
         }
         else{
@@ -111,6 +111,12 @@ private:
     virtual void visit(SyntaxTree::BreakStmt &) override final;
     virtual void visit(SyntaxTree::ContinueStmt &) override final;
 
+    Ptr<GlobalVariable> create_const_copy(const std::string &name, Ptr<ArrayType> array_type);
+    void init_local_array(Ptr<Value> var, Ptr<ArrayType> array_type, int length,
+                          Ptr<GlobalVariable> const_copy, const std::string &name);
+    Ptr<Function> get_mem_intrinsic(const std::string &name, Ptr<Type> elem_type);
+    Ptr<Constant> get_const_element(Ptr<GlobalVariable> array, int index);
+
     Ptr<IRStmtBuilder> builder;
     Scope scope;
     Ptr<Module> module;
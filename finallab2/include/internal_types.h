@@ -2,9 +2,16 @@
 #define _SYSYF_INTERNAL_TYPES_H_
 
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <initializer_list>
+#include <iterator>
 #include <map>
 #include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
 #include <vector>
 #include <list>
 #include <set>
@@ -22,6 +29,165 @@ using PtrVec = std::vector<Ptr<T>>;
 template <typename T>
 using PtrList = std::list<Ptr<T>>;
 
+template <typename T>
+class IList;
+
+/**
+ * @brief base of the values kept in an IList, remembers where the value is
+ */
+template <typename T>
+class IListNode {
+public:
+    // whether the value is in a list right now
+    bool is_linked() const { return list_ != nullptr; }
+
+protected:
+    // takes the value out of its list
+    void unlink_from_list();
+
+private:
+    friend class IList<T>;
+    typename PtrList<T>::iterator position_;
+    IList<T> *list_ = nullptr;
+    // position in the list, valid while the list has not grown since it was numbered
+    unsigned order_ = 0;
+};
+
+/**
+ * @brief list of reference of type whose elements know their own position
+ *
+ * T derives from IListNode<T>. Finding and erasing an element is constant
+ * time, and iterators stay valid while other elements are inserted or
+ * erased. Otherwise it is used like PtrList, which it wraps. An element
+ * inserted into a second list is only found fast in the second one, the
+ * first keeps its entry until it is erased there by a linear search.
+ *
+ * comes_before() numbers the elements on its first call after an insertion
+ * and compares the numbers, erasing keeps the numbers in order.
+ */
+template <typename T>
+class IList {
+public:
+    using iterator = typename PtrList<T>::iterator;
+    using const_iterator = typename PtrList<T>::const_iterator;
+    using reverse_iterator = typename PtrList<T>::reverse_iterator;
+    using const_reverse_iterator = typename PtrList<T>::const_reverse_iterator;
+    using value_type = Ptr<T>;
+
+    IList() = default;
+    // an element is in one list at a time
+    IList(const IList &) = delete;
+    IList &operator=(const IList &) = delete;
+    ~IList() { clear(); }
+
+    iterator begin() { return list_.begin(); }
+    iterator end() { return list_.end(); }
+    const_iterator begin() const { return list_.begin(); }
+    const_iterator end() const { return list_.end(); }
+    reverse_iterator rbegin() { return list_.rbegin(); }
+    reverse_iterator rend() { return list_.rend(); }
+    const_reverse_iterator rbegin() const { return list_.rbegin(); }
+    const_reverse_iterator rend() const { return list_.rend(); }
+
+    size_t size() const { return list_.size(); }
+    bool empty() const { return list_.empty(); }
+    Ptr<T> &front() { return list_.front(); }
+    Ptr<T> &back() { return list_.back(); }
+    const Ptr<T> &front() const { return list_.front(); }
+    const Ptr<T> &back() const { return list_.back(); }
+
+    iterator insert(iterator pos, Ptr<T> val) {
+        auto iter = list_.insert(pos, val);
+        IListNode<T> &node = *val;
+        node.position_ = iter;
+        node.list_ = this;
+        order_valid_ = false;
+        return iter;
+    }
+    void push_back(Ptr<T> val) { insert(list_.end(), val); }
+    void push_front(Ptr<T> val) { insert(list_.begin(), val); }
+
+    iterator erase(iterator pos) {
+        unlink(pos);
+        return list_.erase(pos);
+    }
+    void pop_back() { erase(std::prev(list_.end())); }
+    void pop_front() { erase(list_.begin()); }
+    void remove(const Ptr<T> &val) {
+        IListNode<T> &node = *val;
+        if (node.list_ == this) {
+            erase(node.position_);
+        } else {
+            list_.remove(val);
+        }
+    }
+    void clear() {
+        for (auto iter = list_.begin(); iter != list_.end(); ++iter) {
+            unlink(iter);
+        }
+        list_.clear();
+    }
+    // moves all elements of other in front of pos
+    void splice(iterator pos, IList &other) {
+        for (auto &val : other.list_) {
+            IListNode<T> &node = *val;
+            node.list_ = this;
+        }
+        list_.splice(pos, other.list_);
+        order_valid_ = false;
+    }
+
+    // the position of val, or end() when it is not in this list
+    iterator find(const Ptr<T> &val) {
+        IListNode<T> &node = *val;
+        if (node.list_ == this) {
+            return node.position_;
+        }
+        return std::find(list_.begin(), list_.end(), val);
+    }
+
+    // whether a is in front of b, both in this list
+    bool comes_before(const Ptr<T> &a, const Ptr<T> &b) {
+        IListNode<T> &node_a = *a;
+        IListNode<T> &node_b = *b;
+        if (node_a.list_ != this || node_b.list_ != this) {
+            auto iter = find(a);
+            return iter != list_.end() && std::find(std::next(iter), list_.end(), b) != list_.end();
+        }
+        if (!order_valid_) {
+            unsigned order = 0;
+            for (auto &val : list_) {
+                IListNode<T> &node = *val;
+                // the numbers of an element that moved on belong to its new list
+                if (node.list_ == this) {
+                    node.order_ = order++;
+                }
+            }
+            order_valid_ = true;
+        }
+        return node_a.order_ < node_b.order_;
+    }
+
+private:
+    void unlink(iterator pos) {
+        IListNode<T> &node = **pos;
+        // an element inserted into another list while still in this one has moved on
+        if (node.list_ == this && node.position_ == pos) {
+            node.list_ = nullptr;
+        }
+    }
+
+    PtrList<T> list_;
+    bool order_valid_ = false;
+};
+
+template <typename T>
+void IListNode<T>::unlink_from_list() {
+    if (list_) {
+        list_->erase(position_);
+    }
+}
+
 template <typename K, typename V, typename Comp = std::less<K>>
 using Map = std::map<K, V, Comp>;
 
@@ -90,6 +256,757 @@ using WeakPtrMap = std::map<std::weak_ptr<K>, V, std::owner_less<std::weak_ptr<K
 template <typename T>
 using WeakPtrVec = std::vector<std::weak_ptr<T>>;
 
+/**
+ * @brief hash of a raw pointer for DenseMap and SmallPtrSet, the low bits
+ * are dropped because they are zero for aligned objects
+ */
+inline std::size_t pointer_hash(const void *ptr) {
+    auto val = reinterpret_cast<std::uintptr_t>(ptr);
+    return static_cast<std::size_t>((val >> 4) ^ (val >> 9));
+}
+
+/**
+ * @brief vector that keeps up to N elements in the object itself
+ *
+ * Used like std::vector, with the same rules for iterator invalidation.
+ * A short list, like the operands of an instruction or the predecessors
+ * of a block, needs no allocation; a longer one moves to the heap.
+ */
+template <typename T, unsigned N>
+class SmallVector {
+    static_assert(N > 0, "SmallVector needs room for an element");
+
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T &;
+    using const_reference = const T &;
+    using iterator = T *;
+    using const_iterator = const T *;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    SmallVector() : data_(inline_data()) {}
+    explicit SmallVector(size_type n, const T &val = T()) : SmallVector() { assign(n, val); }
+    template <typename It, typename = typename std::iterator_traits<It>::iterator_category>
+    SmallVector(It first, It last) : SmallVector() { assign(first, last); }
+    SmallVector(std::initializer_list<T> init) : SmallVector() { assign(init.begin(), init.end()); }
+    SmallVector(const SmallVector &other) : SmallVector() { assign(other.begin(), other.end()); }
+    SmallVector(SmallVector &&other) noexcept : SmallVector() { take(other); }
+    ~SmallVector() {
+        clear();
+        release();
+    }
+
+    SmallVector &operator=(const SmallVector &other) {
+        if (this != &other) {
+            assign(other.begin(), other.end());
+        }
+        return *this;
+    }
+    SmallVector &operator=(SmallVector &&other) noexcept {
+        if (this != &other) {
+            clear();
+            release();
+            take(other);
+        }
+        return *this;
+    }
+    SmallVector &operator=(std::initializer_list<T> init) {
+        assign(init.begin(), init.end());
+        return *this;
+    }
+
+    void assign(size_type n, const T &val) {
+        clear();
+        reserve(n);
+        for (; size_ < n; ++size_) {
+            new (data_ + size_) T(val);
+        }
+    }
+    template <typename It, typename = typename std::iterator_traits<It>::iterator_category>
+    void assign(It first, It last) {
+        clear();
+        for (; first != last; ++first) {
+            push_back(*first);
+        }
+    }
+
+    iterator begin() { return data_; }
+    iterator end() { return data_ + size_; }
+    const_iterator begin() const { return data_; }
+    const_iterator end() const { return data_ + size_; }
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+    size_type size() const { return size_; }
+    size_type capacity() const { return capacity_; }
+    bool empty() const { return size_ == 0; }
+    T *data() { return data_; }
+    const T *data() const { return data_; }
+
+    T &operator[](size_type i) { return data_[i]; }
+    const T &operator[](size_type i) const { return data_[i]; }
+    T &front() { return data_[0]; }
+    const T &front() const { return data_[0]; }
+    T &back() { return data_[size_ - 1]; }
+    const T &back() const { return data_[size_ - 1]; }
+
+    void reserve(size_type n) {
+        if (n > capacity_) {
+            grow(n);
+        }
+    }
+
+    void push_back(const T &val) { emplace_back(val); }
+    void push_back(T &&val) { emplace_back(std::move(val)); }
+
+    template <typename... Args>
+    T &emplace_back(Args &&...args) {
+        if (size_ == capacity_) {
+            // the arguments may refer into the old storage
+            T tmp(std::forward<Args>(args)...);
+            grow(size_ + 1);
+            new (data_ + size_) T(std::move(tmp));
+        } else {
+            new (data_ + size_) T(std::forward<Args>(args)...);
+        }
+        return data_[size_++];
+    }
+
+    void pop_back() {
+        data_[--size_].~T();
+    }
+
+    iterator insert(const_iterator pos, const T &val) { return emplace(pos, val); }
+    iterator insert(const_iterator pos, T &&val) { return emplace(pos, std::move(val)); }
+    template <typename It, typename = typename std::iterator_traits<It>::iterator_category>
+    iterator insert(const_iterator pos, It first, It last) {
+        size_type index = pos - begin();
+        for (size_type i = index; first != last; ++first, ++i) {
+            insert(begin() + i, *first);
+        }
+        return begin() + index;
+    }
+
+    template <typename... Args>
+    iterator emplace(const_iterator pos, Args &&...args) {
+        size_type index = pos - begin();
+        if (index == size_) {
+            emplace_back(std::forward<Args>(args)...);
+            return begin() + index;
+        }
+        T tmp(std::forward<Args>(args)...);
+        emplace_back(std::move(back()));
+        std::move_backward(begin() + index, end() - 2, end() - 1);
+        data_[index] = std::move(tmp);
+        return begin() + index;
+    }
+
+    iterator erase(const_iterator pos) {
+        return erase(pos, pos + 1);
+    }
+    iterator erase(const_iterator first, const_iterator last) {
+        iterator dst = begin() + (first - begin());
+        iterator src = begin() + (last - begin());
+        iterator new_end = std::move(src, end(), dst);
+        while (end() != new_end) {
+            pop_back();
+        }
+        return dst;
+    }
+
+    void resize(size_type n) { resize(n, T()); }
+    void resize(size_type n, const T &val) {
+        while (size_ > n) {
+            pop_back();
+        }
+        reserve(n);
+        for (; size_ < n; ++size_) {
+            new (data_ + size_) T(val);
+        }
+    }
+
+    void clear() {
+        while (size_ > 0) {
+            pop_back();
+        }
+    }
+
+private:
+    T *inline_data() { return reinterpret_cast<T *>(inline_); }
+    bool is_inline() const { return data_ == reinterpret_cast<const T *>(inline_); }
+
+    void grow(size_type min_capacity) {
+        size_type new_capacity = std::max<size_type>(capacity_ * 2, min_capacity);
+        T *new_data = static_cast<T *>(::operator new(new_capacity * sizeof(T)));
+        for (size_type i = 0; i < size_; ++i) {
+            new (new_data + i) T(std::move(data_[i]));
+            data_[i].~T();
+        }
+        release();
+        data_ = new_data;
+        capacity_ = new_capacity;
+    }
+
+    // frees heap storage, the elements must be destroyed
+    void release() {
+        if (!is_inline()) {
+            ::operator delete(data_);
+        }
+        data_ = inline_data();
+        capacity_ = N;
+    }
+
+    // moves the elements of other here, this must be empty and inline
+    void take(SmallVector &other) {
+        if (other.is_inline()) {
+            for (size_type i = 0; i < other.size_; ++i) {
+                new (data_ + i) T(std::move(other.data_[i]));
+            }
+            size_ = other.size_;
+            other.clear();
+            return;
+        }
+        data_ = other.data_;
+        size_ = other.size_;
+        capacity_ = other.capacity_;
+        other.data_ = other.inline_data();
+        other.size_ = 0;
+        other.capacity_ = N;
+    }
+
+    T *data_;
+    size_type size_ = 0;
+    size_type capacity_ = N;
+    alignas(T) unsigned char inline_[N * sizeof(T)];
+};
+
+template <typename T, unsigned N>
+bool operator==(const SmallVector<T, N> &a, const SmallVector<T, N> &b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+template <typename T, unsigned N>
+bool operator!=(const SmallVector<T, N> &a, const SmallVector<T, N> &b) {
+    return !(a == b);
+}
+
+/**
+ * @brief set of raw pointers, a search of N slots in the object while it
+ * is small and an open addressing hash table once it is not
+ *
+ * The order of iteration depends on the addresses, so use it where only
+ * membership matters, like the visited blocks of a walk.
+ */
+template <typename PtrT, unsigned N>
+class SmallPtrSet {
+    static_assert(std::is_pointer<PtrT>::value, "SmallPtrSet holds raw pointers");
+
+public:
+    using value_type = PtrT;
+    using size_type = std::size_t;
+
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = PtrT;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const PtrT *;
+        using reference = const PtrT &;
+
+        const_iterator(const PtrT *pos, const PtrT *end) : pos_(pos), end_(end) { skip(); }
+        reference operator*() const { return *pos_; }
+        const_iterator &operator++() {
+            ++pos_;
+            skip();
+            return *this;
+        }
+        const_iterator operator++(int) {
+            auto old = *this;
+            ++*this;
+            return old;
+        }
+        bool operator==(const const_iterator &other) const { return pos_ == other.pos_; }
+        bool operator!=(const const_iterator &other) const { return pos_ != other.pos_; }
+
+    private:
+        void skip() {
+            while (pos_ != end_ && (*pos_ == empty_key() || *pos_ == tombstone_key())) {
+                ++pos_;
+            }
+        }
+        const PtrT *pos_;
+        const PtrT *end_;
+    };
+    using iterator = const_iterator;
+
+    SmallPtrSet() = default;
+    SmallPtrSet(std::initializer_list<PtrT> init) {
+        for (auto ptr : init) {
+            insert(ptr);
+        }
+    }
+
+    const_iterator begin() const {
+        return is_small() ? const_iterator(small_.begin(), small_.end())
+                          : const_iterator(table_.data(), table_.data() + table_.size());
+    }
+    const_iterator end() const {
+        return is_small() ? const_iterator(small_.end(), small_.end())
+                          : const_iterator(table_.data() + table_.size(), table_.data() + table_.size());
+    }
+
+    size_type size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    // ptr must not be null
+    std::pair<iterator, bool> insert(PtrT ptr) {
+        if (is_small()) {
+            auto pos = std::find(small_.begin(), small_.end(), ptr);
+            if (pos != small_.end()) {
+                return {const_iterator(pos, small_.end()), false};
+            }
+            if (small_.size() < N) {
+                small_.push_back(ptr);
+                ++size_;
+                return {const_iterator(small_.end() - 1, small_.end()), true};
+            }
+            rehash(next_capacity(N * 2));
+            small_.clear();
+        }
+        size_type index = lookup(ptr);
+        if (table_[index] == ptr) {
+            return {make_iterator(index), false};
+        }
+        if ((size_ + tombstones_ + 1) * 4 > table_.size() * 3) {
+            rehash(next_capacity(size_ * 2 + 1));
+            index = lookup(ptr);
+        }
+        if (table_[index] == tombstone_key()) {
+            --tombstones_;
+        }
+        table_[index] = ptr;
+        ++size_;
+        return {make_iterator(index), true};
+    }
+
+    template <typename It>
+    void insert(It first, It last) {
+        for (; first != last; ++first) {
+            insert(*first);
+        }
+    }
+
+    size_type count(PtrT ptr) const {
+        if (is_small()) {
+            return std::find(small_.begin(), small_.end(), ptr) != small_.end();
+        }
+        return table_[lookup(ptr)] == ptr;
+    }
+
+    const_iterator find(PtrT ptr) const {
+        if (is_small()) {
+            return const_iterator(std::find(small_.begin(), small_.end(), ptr), small_.end());
+        }
+        size_type index = lookup(ptr);
+        return table_[index] == ptr ? make_iterator(index) : end();
+    }
+
+    bool erase(PtrT ptr) {
+        if (is_small()) {
+            auto pos = std::find(small_.begin(), small_.end(), ptr);
+            if (pos == small_.end()) {
+                return false;
+            }
+            *pos = small_.back();
+            small_.pop_back();
+            --size_;
+            return true;
+        }
+        size_type index = lookup(ptr);
+        if (table_[index] != ptr) {
+            return false;
+        }
+        table_[index] = tombstone_key();
+        ++tombstones_;
+        --size_;
+        return true;
+    }
+
+    void clear() {
+        small_.clear();
+        table_.clear();
+        size_ = 0;
+        tombstones_ = 0;
+    }
+
+private:
+    static PtrT empty_key() { return nullptr; }
+    static PtrT tombstone_key() { return reinterpret_cast<PtrT>(~std::uintptr_t(0)); }
+    static size_type next_capacity(size_type n) {
+        size_type capacity = 8;
+        while (capacity < n * 4 / 3 + 1) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    bool is_small() const { return table_.empty(); }
+    const_iterator make_iterator(size_type index) const {
+        return const_iterator(table_.data() + index, table_.data() + table_.size());
+    }
+
+    // the slot of ptr, or the slot to put it in
+    size_type lookup(PtrT ptr) const {
+        size_type mask = table_.size() - 1;
+        size_type index = pointer_hash(ptr) & mask;
+        size_type first_tombstone = table_.size();
+        for (size_type step = 1; ; ++step) {
+            PtrT slot = table_[index];
+            if (slot == ptr) {
+                return index;
+            }
+            if (slot == empty_key()) {
+                return first_tombstone != table_.size() ? first_tombstone : index;
+            }
+            if (slot == tombstone_key() && first_tombstone == table_.size()) {
+                first_tombstone = index;
+            }
+            index = (index + step) & mask;
+        }
+    }
+
+    void rehash(size_type capacity) {
+        std::vector<PtrT> old;
+        if (is_small()) {
+            old.assign(small_.begin(), small_.end());
+        } else {
+            old.swap(table_);
+        }
+        table_.assign(capacity, empty_key());
+        tombstones_ = 0;
+        for (auto ptr : old) {
+            if (ptr != empty_key() && ptr != tombstone_key()) {
+                table_[lookup(ptr)] = ptr;
+            }
+        }
+    }
+
+    SmallVector<PtrT, N> small_;
+    std::vector<PtrT> table_;   // empty while the set is small
+    size_type size_ = 0;
+    size_type tombstones_ = 0;
+};
+
+/**
+ * @brief map from raw pointers kept in one open addressing hash table
+ *
+ * Used like std::map for lookups, but an entry is no heap node and a
+ * lookup is a few probes of an array. The order of iteration depends on
+ * the addresses. Inserting may move the entries, erasing does not. V must
+ * be default constructible.
+ */
+template <typename K, typename V>
+class DenseMap {
+    static_assert(std::is_pointer<K>::value, "DenseMap is keyed by raw pointers");
+
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<K, V>;
+    using size_type = std::size_t;
+
+    template <bool Const>
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<K, V>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = typename std::conditional<Const, const value_type *, value_type *>::type;
+        using reference = typename std::conditional<Const, const value_type &, value_type &>::type;
+
+        Iterator(pointer pos, pointer end) : pos_(pos), end_(end) { skip(); }
+        // an iterator converts to a const_iterator
+        template <bool C = Const, typename = typename std::enable_if<C>::type>
+        Iterator(const Iterator<false> &other) : pos_(other.pos_), end_(other.end_) {}
+
+        reference operator*() const { return *pos_; }
+        pointer operator->() const { return pos_; }
+        Iterator &operator++() {
+            ++pos_;
+            skip();
+            return *this;
+        }
+        Iterator operator++(int) {
+            auto old = *this;
+            ++*this;
+            return old;
+        }
+        bool operator==(const Iterator &other) const { return pos_ == other.pos_; }
+        bool operator!=(const Iterator &other) const { return pos_ != other.pos_; }
+
+    private:
+        friend class Iterator<true>;
+        void skip() {
+            while (pos_ != end_ && (pos_->first == empty_key() || pos_->first == tombstone_key())) {
+                ++pos_;
+            }
+        }
+        pointer pos_;
+        pointer end_;
+    };
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    iterator begin() { return make_iterator(0); }
+    iterator end() { return make_iterator(buckets_.size()); }
+    const_iterator begin() const { return make_iterator(0); }
+    const_iterator end() const { return make_iterator(buckets_.size()); }
+
+    size_type size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    iterator find(K key) {
+        if (buckets_.empty()) {
+            return end();
+        }
+        size_type index = lookup(key);
+        return buckets_[index].first == key ? make_iterator(index) : end();
+    }
+    const_iterator find(K key) const {
+        if (buckets_.empty()) {
+            return end();
+        }
+        size_type index = lookup(key);
+        return buckets_[index].first == key ? make_iterator(index) : end();
+    }
+
+    size_type count(K key) const { return find(key) != end(); }
+
+    // the value of key, default constructed if key was not in the map
+    V &operator[](K key) { return insert({key, V()}).first->second; }
+
+    // key must not be null
+    std::pair<iterator, bool> insert(const value_type &kv) {
+        if ((size_ + tombstones_ + 1) * 4 > buckets_.size() * 3) {
+            rehash(next_capacity(size_ * 2 + 1));
+        }
+        size_type index = lookup(kv.first);
+        if (buckets_[index].first == kv.first) {
+            return {make_iterator(index), false};
+        }
+        if (buckets_[index].first == tombstone_key()) {
+            --tombstones_;
+        }
+        buckets_[index] = kv;
+        ++size_;
+        return {make_iterator(index), true};
+    }
+
+    bool erase(K key) {
+        if (buckets_.empty()) {
+            return false;
+        }
+        size_type index = lookup(key);
+        if (buckets_[index].first != key) {
+            return false;
+        }
+        buckets_[index] = {tombstone_key(), V()};
+        ++tombstones_;
+        --size_;
+        return true;
+    }
+
+    void clear() {
+        buckets_.clear();
+        size_ = 0;
+        tombstones_ = 0;
+    }
+
+private:
+    static K empty_key() { return nullptr; }
+    static K tombstone_key() { return reinterpret_cast<K>(~std::uintptr_t(0)); }
+    static size_type next_capacity(size_type n) {
+        size_type capacity = 8;
+        while (capacity < n * 4 / 3 + 1) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    iterator make_iterator(size_type index) {
+        return iterator(buckets_.data() + index, buckets_.data() + buckets_.size());
+    }
+    const_iterator make_iterator(size_type index) const {
+        return const_iterator(buckets_.data() + index, buckets_.data() + buckets_.size());
+    }
+
+    // the bucket of key, or the bucket to put it in; the table is not empty
+    size_type lookup(K key) const {
+        size_type mask = buckets_.size() - 1;
+        size_type index = pointer_hash(key) & mask;
+        size_type first_tombstone = buckets_.size();
+        for (size_type step = 1; ; ++step) {
+            K slot = buckets_[index].first;
+            if (slot == key) {
+                return index;
+            }
+            if (slot == empty_key()) {
+                return first_tombstone != buckets_.size() ? first_tombstone : index;
+            }
+            if (slot == tombstone_key() && first_tombstone == buckets_.size()) {
+                first_tombstone = index;
+            }
+            index = (index + step) & mask;
+        }
+    }
+
+    void rehash(size_type capacity) {
+        std::vector<value_type> old;
+        old.swap(buckets_);
+        buckets_.resize(capacity, value_type(empty_key(), V()));
+        tombstones_ = 0;
+        for (auto &kv : old) {
+            if (kv.first != empty_key() && kv.first != tombstone_key()) {
+                buckets_[lookup(kv.first)] = std::move(kv);
+            }
+        }
+    }
+
+    std::vector<value_type> buckets_;
+    size_type size_ = 0;
+    size_type tombstones_ = 0;
+};
+
+/**
+ * @brief set kept as a sorted vector
+ *
+ * Iterates in the same order as a std::set with the same Compare, but a
+ * small set is one array and a lookup is a binary search. Insert and
+ * erase shift the later elements, so it suits sets that are mostly read,
+ * like dominance frontiers. merge, subtract and intersect work in place.
+ */
+template <typename T, typename Compare = std::less<T>>
+class SortedVectorSet {
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using iterator = const T *;
+    using const_iterator = const T *;
+
+    SortedVectorSet() = default;
+    SortedVectorSet(std::initializer_list<T> init) { insert(init.begin(), init.end()); }
+
+    const_iterator begin() const { return elems_.begin(); }
+    const_iterator end() const { return elems_.end(); }
+    size_type size() const { return elems_.size(); }
+    bool empty() const { return elems_.empty(); }
+    void clear() { elems_.clear(); }
+
+    std::pair<iterator, bool> insert(const T &val) {
+        auto pos = lower_bound(val);
+        if (pos != elems_.end() && !cmp_(val, *pos)) {
+            return {pos, false};
+        }
+        return {elems_.insert(pos, val), true};
+    }
+    template <typename It>
+    void insert(It first, It last) {
+        for (; first != last; ++first) {
+            insert(*first);
+        }
+    }
+
+    const_iterator find(const T &val) const {
+        auto pos = std::lower_bound(elems_.begin(), elems_.end(), val, cmp_);
+        return pos != elems_.end() && !cmp_(val, *pos) ? pos : end();
+    }
+    size_type count(const T &val) const { return find(val) != end(); }
+
+    size_type erase(const T &val) {
+        auto pos = find(val);
+        if (pos == end()) {
+            return 0;
+        }
+        erase(pos);
+        return 1;
+    }
+    iterator erase(const_iterator pos) { return elems_.erase(pos); }
+
+    // this ∪= other
+    void merge(const SortedVectorSet &other) {
+        if (this == &other || other.empty()) {
+            return;
+        }
+        auto mid = elems_.size();
+        elems_.insert(elems_.end(), other.begin(), other.end());
+        std::inplace_merge(elems_.begin(), elems_.begin() + mid, elems_.end(), cmp_);
+        elems_.erase(std::unique(elems_.begin(), elems_.end(), equivalent()), elems_.end());
+    }
+
+    // this -= other
+    void subtract(const SortedVectorSet &other) {
+        if (this == &other) {
+            clear();
+            return;
+        }
+        keep_if(other, false);
+    }
+
+    // this ∩= other
+    void intersect(const SortedVectorSet &other) {
+        if (this != &other) {
+            keep_if(other, true);
+        }
+    }
+
+    friend bool operator==(const SortedVectorSet &a, const SortedVectorSet &b) {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), a.equivalent());
+    }
+    friend bool operator!=(const SortedVectorSet &a, const SortedVectorSet &b) { return !(a == b); }
+
+private:
+    struct Equivalent {
+        Compare cmp;
+        bool operator()(const T &a, const T &b) const { return !cmp(a, b) && !cmp(b, a); }
+    };
+    Equivalent equivalent() const { return Equivalent{cmp_}; }
+
+    T *lower_bound(const T &val) {
+        return std::lower_bound(elems_.begin(), elems_.end(), val, cmp_);
+    }
+
+    // keeps the elements that are in other if in_other, else those that are not
+    void keep_if(const SortedVectorSet &other, bool in_other) {
+        auto out = elems_.begin();
+        auto it2 = other.begin();
+        for (auto it = elems_.begin(); it != elems_.end(); ++it) {
+            while (it2 != other.end() && cmp_(*it2, *it)) {
+                ++it2;
+            }
+            bool found = it2 != other.end() && !cmp_(*it, *it2);
+            if (found == in_other) {
+                if (out != it) {
+                    *out = std::move(*it);
+                }
+                ++out;
+            }
+        }
+        elems_.erase(out, elems_.end());
+    }
+
+    SmallVector<T, 4> elems_;
+    Compare cmp_;
+};
+
+// Sorted vector set of weak references, in the order of WeakPtrSet
+template <typename T>
+using WeakPtrSortedSet = SortedVectorSet<std::weak_ptr<T>, WeakPtrCmp<T>>;
+
 using std::static_pointer_cast;
 using std::dynamic_pointer_cast;
 using std::const_pointer_cast;
@@ -0,0 +1,50 @@
+#include "AliasUtils.h"
+#include "Function.h"
+
+namespace SysYF {
+namespace IR {
+
+Ptr<Value> get_underlying_object(Ptr<Value> ptr) {
+    while (true) {
+        auto inst = dyn_cast<Instruction>(ptr);
+        if (!inst || !(inst->is_gep() || inst->is_bitcast())) {
+            return ptr;
+        }
+        ptr = inst->get_operand(0);
+    }
+}
+
+bool may_alias_objects(Ptr<Value> obj1, Ptr<Value> obj2) {
+    if (obj1 == obj2) {
+        return true;
+    }
+    auto arg1 = dyn_cast<Argument>(obj1);
+    auto arg2 = dyn_cast<Argument>(obj2);
+    if (!arg1 && !arg2) {
+        return false;
+    }
+    if (arg1 && arg2) {
+        return true;
+    }
+    return !dyn_cast<AllocaInst>(arg1 ? obj2 : obj1);
+}
+
+bool get_constant_offset(Ptr<GetElementPtrInst> gep, int &offset) {
+    auto ty = gep->get_operand(0)->get_type()->get_pointer_element_type();
+    offset = 0;
+    for (unsigned i = 1; i < gep->get_num_operand(); i++) {
+        auto idx = dyn_cast<ConstantInt>(gep->get_operand(i));
+        if (!idx) {
+            return false;
+        }
+        // the first index steps over whole pointees, the others into arrays
+        if (i > 1) {
+            ty = ty->get_array_element_type();
+        }
+        offset += idx->get_value() * ty->get_size();
+    }
+    return true;
+}
+
+}
+}
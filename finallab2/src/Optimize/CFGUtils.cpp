@@ -0,0 +1,408 @@
+#include "CFGUtils.h"
+#include "Constant.h"
+#include "Module.h"
+#include <algorithm>
+
+namespace SysYF {
+namespace IR {
+
+namespace {
+
+// moves new_bb, which was just created at the end of its function, in front of pos
+void place_before(Ptr<BasicBlock> new_bb, Ptr<BasicBlock> pos) {
+    auto f = pos->get_parent();
+    if (pos == f->get_entry_block()) {
+        return;
+    }
+    auto &blocks = f->get_basic_blocks();
+    blocks.remove(new_bb);
+    blocks.insert(blocks.find(pos), new_bb);
+}
+
+// the edges from preds into bb go to a new block that jumps to bb
+Ptr<BasicBlock> split_predecessors(Ptr<BasicBlock> bb, const PtrVec<BasicBlock> &preds,
+                                   std::vector<DominateTree::Update> *updates) {
+    auto f = bb->get_parent();
+    auto block = BasicBlock::create(f->get_parent(), "", f);
+    place_before(block, bb);
+    for (auto pred : preds) {
+        auto term = pred->get_terminator();
+        for (unsigned i = 0; i < term->get_num_operand(); i++) {
+            if (term->get_operand(i) == bb) {
+                term->set_operand(i, block);
+            }
+        }
+        // a conditional branch with both targets bb is two edges
+        auto &succs = pred->get_succ_basic_blocks();
+        auto edges = std::count_if(succs.begin(), succs.end(), [&](const WeakPtr<BasicBlock> &succ) {
+            return succ.lock() == bb;
+        });
+        pred->remove_succ_basic_block(bb);
+        bb->remove_pre_basic_block(pred);
+        for (int i = 0; i < edges; i++) {
+            pred->add_succ_basic_block(block);
+            block->add_pre_basic_block(pred);
+        }
+        if (updates) {
+            updates->push_back({DominateTree::Update::Delete, pred, bb});
+            updates->push_back({DominateTree::Update::Insert, pred, block});
+        }
+    }
+    BranchInst::create_br(bb, block);
+    if (updates) {
+        updates->push_back({DominateTree::Update::Insert, block, bb});
+    }
+
+    for (auto inst : bb->get_instructions()) {
+        if (!inst->is_phi()) {
+            break;
+        }
+        // the entries from preds, last first so that they can be removed in this order
+        std::vector<int> entries;
+        for (int i = static_cast<int>(inst->get_num_operand()) - 2; i >= 0; i -= 2) {
+            if (std::find(preds.begin(), preds.end(), inst->get_operand(i + 1)) != preds.end()) {
+                entries.push_back(i);
+            }
+        }
+        if (entries.empty()) {
+            continue;
+        }
+        Ptr<Value> val = inst->get_operand(entries.front());
+        for (int i : entries) {
+            if (inst->get_operand(i) != val) {
+                val = nullptr;
+                break;
+            }
+        }
+        if (!val) {
+            auto phi = PhiInst::create_phi(inst->get_type(), block);
+            block->add_instr_begin(phi);
+            for (auto iter = entries.rbegin(); iter != entries.rend(); ++iter) {
+                phi->add_phi_pair_operand(inst->get_operand(*iter), inst->get_operand(*iter + 1));
+            }
+            val = phi;
+        }
+        for (int i : entries) {
+            inst->remove_operands(i, i + 1);
+        }
+        static_pointer_cast<PhiInst>(inst)->add_phi_pair_operand(val, block);
+    }
+    return block;
+}
+
+// the phis of the successors of from take their values from to instead
+void replace_incoming_block(Ptr<BasicBlock> succ, Ptr<BasicBlock> from, Ptr<BasicBlock> to) {
+    for (auto inst : succ->get_instructions()) {
+        if (!inst->is_phi()) {
+            break;
+        }
+        for (unsigned i = 1; i < inst->get_num_operand(); i += 2) {
+            if (inst->get_operand(i) == from) {
+                inst->set_operand(i, to);
+            }
+        }
+    }
+}
+
+}
+
+PtrVec<BasicBlock> get_reverse_post_order(Ptr<Function> f) {
+    PtrVec<BasicBlock> order;
+    SmallPtrSet<BasicBlock *, 32> visited;
+    // (block, whether its successors were pushed)
+    std::vector<std::pair<Ptr<BasicBlock>, bool>> stack = {{f->get_entry_block(), false}};
+    while (!stack.empty()) {
+        auto top = stack.back();
+        stack.pop_back();
+        if (top.second) {
+            order.push_back(top.first);
+            continue;
+        }
+        if (!visited.insert(top.first.get()).second) {
+            continue;
+        }
+        stack.push_back({top.first, true});
+        for (auto &succ : top.first->get_succ_basic_blocks()) {
+            if (!visited.count(succ.lock().get())) {
+                stack.push_back({succ.lock(), false});
+            }
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+bool remove_unreachable_blocks(Ptr<Function> f, std::vector<DominateTree::Update> *updates) {
+    auto order = get_reverse_post_order(f);
+    SmallPtrSet<BasicBlock *, 32> reachable;
+    for (auto bb : order) {
+        reachable.insert(bb.get());
+    }
+    PtrVec<BasicBlock> dead;
+    for (auto bb : f->get_basic_blocks()) {
+        if (!reachable.count(bb.get())) {
+            dead.push_back(bb);
+        }
+    }
+    if (dead.empty()) {
+        return false;
+    }
+    // mem2reg leaves out the preds a phi is undefined from, so a phi may lose all its entries
+    for (auto bb : order) {
+        PtrVec<Instruction> empty;
+        for (auto inst : bb->get_instructions()) {
+            if (!inst->is_phi()) {
+                break;
+            }
+            for (int i = static_cast<int>(inst->get_num_operand()) - 2; i >= 0; i -= 2) {
+                if (!reachable.count(cast<BasicBlock>(inst->get_operand(i + 1).get()))) {
+                    inst->remove_operands(i, i + 1);
+                }
+            }
+            if (inst->get_num_operand() == 0) {
+                empty.push_back(inst);
+            }
+        }
+        for (auto inst : empty) {
+            auto m = f->get_parent();
+            if (inst->get_type()->is_float_type()) {
+                inst->replace_all_use_with(ConstantFloat::create(0, m));
+            } else {
+                inst->replace_all_use_with(ConstantInt::create(0, m));
+            }
+            bb->delete_instr(inst);
+        }
+    }
+    for (auto bb : dead) {
+        for (auto inst : bb->get_instructions()) {
+            inst->remove_use_of_ops();
+        }
+        if (updates) {
+            for (auto &succ : bb->get_succ_basic_blocks()) {
+                updates->push_back({DominateTree::Update::Delete, bb, succ.lock()});
+            }
+        }
+    }
+    for (auto bb : dead) {
+        bb->erase_from_parent();
+    }
+    return true;
+}
+
+Ptr<BasicBlock> split_edge(Ptr<BasicBlock> from, Ptr<BasicBlock> to, std::vector<DominateTree::Update> *updates) {
+    return split_predecessors(to, {from}, updates);
+}
+
+Ptr<BasicBlock> split_block_at(Ptr<Instruction> inst) {
+    auto bb = inst->get_parent();
+    auto f = bb->get_parent();
+    auto block = BasicBlock::create(f->get_parent(), "", f);
+    auto &blocks = f->get_basic_blocks();
+    blocks.remove(block);
+    blocks.insert(std::next(blocks.find(bb)), block);
+
+    PtrVec<Instruction> moved(bb->find_instruction(inst), bb->get_instructions().end());
+    for (auto moved_inst : moved) {
+        moved_inst->move_to(block);
+    }
+    auto succs = bb->get_succ_basic_blocks();
+    for (auto &succ : succs) {
+        auto succ_bb = succ.lock();
+        for (auto &pred : succ_bb->get_pre_basic_blocks()) {
+            if (pred.lock() == bb) {
+                pred = block;
+            }
+        }
+        replace_incoming_block(succ_bb, bb, block);
+    }
+    block->get_succ_basic_blocks() = succs;
+    bb->get_succ_basic_blocks().clear();
+    BranchInst::create_br(block, bb);
+    return block;
+}
+
+Ptr<BasicBlock> insert_preheader(Ptr<BasicBlock> header, const std::set<Ptr<BasicBlock>> &loop_blocks,
+                                 std::vector<DominateTree::Update> *updates) {
+    PtrVec<BasicBlock> outside;
+    for (auto &pred : header->get_pre_basic_blocks()) {
+        auto pred_bb = pred.lock();
+        if (!loop_blocks.count(pred_bb) && std::find(outside.begin(), outside.end(), pred_bb) == outside.end()) {
+            outside.push_back(pred_bb);
+        }
+    }
+    if (outside.empty()) {
+        return nullptr;
+    }
+    return split_predecessors(header, outside, updates);
+}
+
+bool form_dedicated_exits(const std::set<Ptr<BasicBlock>> &loop_blocks) {
+    if (loop_blocks.empty()) {
+        return false;
+    }
+    auto f = (*loop_blocks.begin())->get_parent();
+    // in the order of the function, so the new blocks do not depend on addresses
+    PtrVec<BasicBlock> exits;
+    for (auto bb : f->get_basic_blocks()) {
+        if (!loop_blocks.count(bb)) {
+            continue;
+        }
+        for (auto &succ : bb->get_succ_basic_blocks()) {
+            auto succ_bb = succ.lock();
+            if (!loop_blocks.count(succ_bb) && std::find(exits.begin(), exits.end(), succ_bb) == exits.end()) {
+                exits.push_back(succ_bb);
+            }
+        }
+    }
+    bool changed = false;
+    for (auto exit : exits) {
+        PtrVec<BasicBlock> inside;
+        bool entered_from_outside = false;
+        for (auto &pred : exit->get_pre_basic_blocks()) {
+            auto pred_bb = pred.lock();
+            if (!loop_blocks.count(pred_bb)) {
+                entered_from_outside = true;
+            } else if (std::find(inside.begin(), inside.end(), pred_bb) == inside.end()) {
+                inside.push_back(pred_bb);
+            }
+        }
+        if (entered_from_outside) {
+            split_predecessors(exit, inside, nullptr);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+PtrVec<BasicBlock> clone_region(const PtrVec<BasicBlock> &blocks, Ptr<Function> f, ValueMap &vmap) {
+    auto m = f->get_parent();
+    PtrVec<BasicBlock> copies;
+    for (auto bb : blocks) {
+        auto copy = BasicBlock::create(m, "", f);
+        vmap[bb] = copy;
+        copies.push_back(copy);
+    }
+    PtrVec<Instruction> new_insts;
+    for (unsigned i = 0; i < blocks.size(); i++) {
+        for (auto inst : blocks[i]->get_instructions()) {
+            auto new_inst = clone_instruction(inst, copies[i], vmap);
+            vmap[inst] = new_inst;
+            new_insts.push_back(new_inst);
+        }
+    }
+    for (auto inst : new_insts) {
+        remap_operands(inst, vmap);
+    }
+
+    for (unsigned i = 0; i < blocks.size(); i++) {
+        PtrVec<BasicBlock> exits;
+        for (auto &succ : blocks[i]->get_succ_basic_blocks()) {
+            auto succ_bb = succ.lock();
+            if (!vmap.count(succ_bb) && std::find(exits.begin(), exits.end(), succ_bb) == exits.end()) {
+                exits.push_back(succ_bb);
+            }
+        }
+        for (auto exit : exits) {
+            for (auto inst : exit->get_instructions()) {
+                if (!inst->is_phi()) {
+                    break;
+                }
+                for (unsigned j = 1; j < inst->get_num_operand(); j += 2) {
+                    if (inst->get_operand(j) == blocks[i]) {
+                        auto iter = vmap.find(inst->get_operand(j - 1));
+                        auto val = iter != vmap.end() ? iter->second : inst->get_operand(j - 1);
+                        static_pointer_cast<PhiInst>(inst)->add_phi_pair_operand(val, copies[i]);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    return copies;
+}
+
+bool merge_into_predecessor(Ptr<BasicBlock> bb, std::vector<DominateTree::Update> *updates) {
+    auto f = bb->get_parent();
+    auto &preds = bb->get_pre_basic_blocks();
+    if (bb == f->get_entry_block() || preds.size() != 1) {
+        return false;
+    }
+    auto pred = preds.front().lock();
+    auto pred_br = pred->get_terminator();
+    if (pred == bb || !pred_br || !pred_br->is_br() || pred_br->get_num_operand() != 1) {
+        return false;
+    }
+    PtrVec<Instruction> phis;
+    for (auto inst : bb->get_instructions()) {
+        if (!inst->is_phi()) {
+            break;
+        }
+        if (inst->get_num_operand() != 2) {
+            return false;
+        }
+        phis.push_back(inst);
+    }
+    for (auto phi : phis) {
+        phi->replace_all_use_with(phi->get_operand(0));
+        bb->delete_instr(phi);
+    }
+    pred->delete_instr(pred_br);
+    for (auto inst : bb->get_instructions()) {
+        inst->set_parent(pred);
+        pred->add_instruction(inst);
+    }
+    bb->get_instructions().clear();
+
+    auto succs = bb->get_succ_basic_blocks();
+    for (auto &succ : succs) {
+        succ.lock()->remove_pre_basic_block(bb);
+    }
+    for (auto &succ : succs) {
+        succ.lock()->add_pre_basic_block(pred);
+        replace_incoming_block(succ.lock(), bb, pred);
+    }
+    pred->get_succ_basic_blocks() = succs;
+    if (updates) {
+        updates->push_back({DominateTree::Update::Delete, pred, bb});
+        for (auto &succ : succs) {
+            updates->push_back({DominateTree::Update::Delete, bb, succ.lock()});
+            updates->push_back({DominateTree::Update::Insert, pred, succ.lock()});
+        }
+    }
+    bb->get_pre_basic_blocks().clear();
+    bb->get_succ_basic_blocks().clear();
+    f->remove(bb);
+    return true;
+}
+
+Ptr<BasicBlock> fold_constant_branch(Ptr<BasicBlock> bb) {
+    auto br = bb->get_terminator();
+    if (!br || !br->is_br() || br->get_num_operand() != 3 || br->get_operand(1) == br->get_operand(2)) {
+        return nullptr;
+    }
+    auto cond = dyn_cast<ConstantInt>(br->get_operand(0));
+    if (!cond) {
+        return nullptr;
+    }
+    auto taken = br->get_operand(cond->get_value() ? 1 : 2)->as<BasicBlock>();
+    auto dead = br->get_operand(cond->get_value() ? 2 : 1)->as<BasicBlock>();
+    for (auto inst : dead->get_instructions()) {
+        if (!inst->is_phi()) {
+            break;
+        }
+        for (int i = static_cast<int>(inst->get_num_operand()) - 2; i >= 0; i -= 2) {
+            if (inst->get_operand(i + 1) == bb) {
+                inst->remove_operands(i, i + 1);
+            }
+        }
+    }
+    dead->remove_pre_basic_block(bb);
+    taken->remove_pre_basic_block(bb);
+    bb->get_succ_basic_blocks().clear();
+    bb->delete_instr(br);
+    BranchInst::create_br(taken, bb);
+    return taken;
+}
+
+}
+}
@@ -1,142 +1,228 @@
 #include "Check.h"
+#include "DominateTree.h"
 #include "Module.h"
-
-// #include "logging.hpp"
-// #include <algorithm>
-// #include <unordered_map>
+#include "Statistics.h"
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
 
 namespace SysYF {
 namespace IR {
 
-void Check::execute() {
-    //TODO write your IR Module checker here.
-    // 4 check in total
-    // BB pred and succ check
-    // use-def chain check
-    // last inst of BB check
-    // def before use check
+static Statistic num_verified("Check", "functions verified");
+static Statistic num_unchanged("Check", "unchanged functions skipped");
+
+namespace {
+
+void hash_combine(std::size_t &seed, std::uintptr_t val) {
+    seed ^= static_cast<std::size_t>(val) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
 
-    std::cout << "Check Start" << std::endl;
+void hash_combine(std::size_t &seed, const void *ptr) {
+    hash_combine(seed, reinterpret_cast<std::uintptr_t>(ptr));
+}
 
-    // some vars
-    // std::unordered_map<Ptr<BasicBlock>, std::set<Ptr<Value>>> bb_insts_map;
-    // std::unordered_map<Ptr<BasicBlock>, std::set<Ptr<Value>>> pre_def;
-    std::set<Ptr<Value>> defs;
-    std::set<Ptr<Value>> globaldefs;
+}
 
-    // get all the globalvars first
-    for(const auto &global : this->module.lock()->get_global_variable()){
-        globaldefs.insert(global);
+bool Check::execute() {
+    if (verify() != 0) {
+        std::cerr << "The IR is broken." << std::endl;
+        exit(1);
     }
-    // 4 check  
-    for(const auto &func : this->module.lock()->get_functions()){
-        // if no bb, next
-        if(func->get_basic_blocks().empty())
+    return false;
+}
+
+int Check::verify() {
+    int errors = 0;
+    // functions that were removed are dropped, their addresses may be reused
+    DenseMap<Function *, std::size_t> still_verified;
+    for (const auto &func : module.lock()->get_functions()) {
+        if (func->get_basic_blocks().empty())
             continue;
-        std::cout << "Now at Func: " << func->get_name() << std::endl;
-        // ----------check BB pred and succ----------
-        for(const auto &bb : func->get_basic_blocks()){
-            for(const auto &pre_bb : bb->get_pre_basic_blocks()){
-                auto pre_succ_bbs = pre_bb.lock()->get_succ_basic_blocks();
-                bool found = false;
-                for (const auto &succ_bb_weak : pre_succ_bbs) {
-                    // weak_ptr -> shared_ptr
-                    auto succ_bb = succ_bb_weak.lock();
-                    if (succ_bb && succ_bb == bb) {
-                        found = true;
-                        break;
-                    }
-                }
-                if(!found){
-                    // there is an error 
-                    std::cout << "A bb's pre-bb's succ-bb has not itself!" << std::endl;
-                    std::cout << "Error bb: " << bb->get_name() <<", whose pre-bb is " << pre_bb.lock()->get_name() << std::endl;
-                    exit(0);
-                }
+        auto hash = fingerprint(func);
+        auto iter = verified.find(func.get());
+        if (iter == verified.end() || iter->second != hash) {
+            ++num_verified;
+            int func_errors = verify_function(func);
+            errors += func_errors;
+            if (func_errors != 0)
+                continue;
+        } else {
+            ++num_unchanged;
+        }
+        still_verified[func.get()] = hash;
+    }
+    verified = std::move(still_verified);
+    return errors;
+}
+
+std::size_t Check::fingerprint(Ptr<Function> func) {
+    // the counts keep sequences of different shape apart
+    std::size_t hash = 0;
+    for (const auto &arg : func->get_args())
+        hash_combine(hash, arg.get());
+    for (const auto &bb : func->get_basic_blocks()) {
+        hash_combine(hash, bb.get());
+        hash_combine(hash, bb->get_pre_basic_blocks().size());
+        for (const auto &pre_bb : bb->get_pre_basic_blocks())
+            hash_combine(hash, pre_bb.lock().get());
+        hash_combine(hash, bb->get_succ_basic_blocks().size());
+        for (const auto &succ_bb : bb->get_succ_basic_blocks())
+            hash_combine(hash, succ_bb.lock().get());
+        hash_combine(hash, bb->get_instructions().size());
+        for (const auto &inst : bb->get_instructions()) {
+            hash_combine(hash, inst.get());
+            hash_combine(hash, inst->get_use_list().size());
+            hash_combine(hash, inst->get_num_operand());
+            for (const auto &op : inst->get_operands())
+                hash_combine(hash, op.lock().get());
+        }
+    }
+    return hash;
+}
+
+int Check::verify_function(Ptr<Function> func) {
+    int errors = 0;
+    // the values are named for the messages, which is what printing the module does too
+    auto error = [&](Ptr<BasicBlock> bb) -> std::ostream & {
+        if (errors++ == 0)
+            func->set_instr_name();
+        return std::cerr << "Error in function " << func->get_name() << ", bb " << bb->get_name() << ": ";
+    };
+
+    // ----------check BB pred and succ----------
+    for (const auto &bb : func->get_basic_blocks()) {
+        for (const auto &pre_bb : bb->get_pre_basic_blocks()) {
+            auto pre = pre_bb.lock();
+            if (!pre) {
+                error(bb) << "a pre-bb is deleted" << std::endl;
+                continue;
             }
-            for(const auto &succ_bb : bb->get_succ_basic_blocks()){
-                auto succ_pre_bbs = succ_bb.lock()->get_pre_basic_blocks();
-                bool found = false;
-                for (const auto &pre_bb_weak : succ_pre_bbs) {
-                    // weak_ptr->shared_ptr
-                    auto pre_bb = pre_bb_weak.lock();
-                    if (pre_bb && pre_bb == bb) {
-                        found = true;
-                        break;
-                    }
-                }
-                if(!found){
-                     // there is an error 
-                    std::cout << "A bb's succ-bb's pre-bb has not itself!" << std::endl;
-                    std::cout << "Error bb: " << bb->get_name() << ", whose succ-bb is " << succ_bb.lock()->get_name() << std::endl;
-                    exit(0);
-                }
+            auto &pre_succ_bbs = pre->get_succ_basic_blocks();
+            bool found = std::any_of(pre_succ_bbs.begin(), pre_succ_bbs.end(),
+                                     [&](const WeakPtr<BasicBlock> &succ_bb) { return succ_bb.lock() == bb; });
+            if (!found)
+                error(bb) << "its pre-bb " << pre->get_name() << " has not it as a succ-bb" << std::endl;
+        }
+        for (const auto &succ_bb : bb->get_succ_basic_blocks()) {
+            auto succ = succ_bb.lock();
+            if (!succ) {
+                error(bb) << "a succ-bb is deleted" << std::endl;
+                continue;
             }
+            auto &succ_pre_bbs = succ->get_pre_basic_blocks();
+            bool found = std::any_of(succ_pre_bbs.begin(), succ_pre_bbs.end(),
+                                     [&](const WeakPtr<BasicBlock> &pre_bb) { return pre_bb.lock() == bb; });
+            if (!found)
+                error(bb) << "its succ-bb " << succ->get_name() << " has not it as a pre-bb" << std::endl;
         }
-        std::cout << "BB Pred-Succ Check Pass." << std::endl;
+    }
 
-        // ----------check last inst of BB----------
-        for(const auto &bb : func->get_basic_blocks()){
-            // get final inst of a bb
-            auto last_inst = bb->get_instructions().back();
-            if(!last_inst->isTerminator()){
-                std::cout << "The last instruction of a bb is neither ret or br!" << std::endl;
-                std::cout << "Error bb: "<< bb->get_name() << ", whose last instruction is " << last_inst->get_instr_op_name() << std::endl;
-                exit(0);
-            }
+    // ----------check last inst of BB----------
+    for (const auto &bb : func->get_basic_blocks()) {
+        auto &insts = bb->get_instructions();
+        if (insts.empty()) {
+            error(bb) << "the bb is empty" << std::endl;
+            continue;
+        }
+        if (!insts.back()->isTerminator())
+            error(bb) << "the last instruction is " << insts.back()->get_instr_op_name() << ", neither ret nor br" << std::endl;
+        for (auto iter = insts.begin(); *iter != insts.back(); ++iter) {
+            if ((*iter)->isTerminator())
+                error(bb) << "a " << (*iter)->get_instr_op_name() << " is not the last instruction" << std::endl;
         }
-        std::cout << "Last inst of BB Check Pass." << std::endl;
+    }
 
-        // ----------check use-def chain----------
-        for(const auto &bb : func->get_basic_blocks()){
-            for(const auto &inst : bb->get_instructions()){
-                for(const auto &operand : inst->get_operands()){
-                    // use std::find_if() for comlpex search with Lambda exp
-                    auto item = std::find_if(operand.lock()->get_use_list().begin(), operand.lock()->get_use_list().end(), [inst](Use use){ return inst == use.val_.lock(); });
-                    if(item == operand.lock()->get_use_list().end()){
-                        std::cout << "Use-Def is not valid!" << std::endl;
-                        std::cout << "Error bb: " << bb->get_name() << ", whose unvalid instruction is " << inst->get_instr_op_name() << 
-                        ", unvalid operand is " << operand.lock()->get_name() << std::endl;
-                        exit(0);
-                    }
+    // ----------check use-def chain----------
+    // the operands an instruction is in the use lists of, each use list is walked once
+    DenseMap<Instruction *, std::vector<bool>> listed;
+    for (const auto &bb : func->get_basic_blocks()) {
+        for (const auto &inst : bb->get_instructions())
+            listed[inst.get()].assign(inst->get_num_operand(), false);
+    }
+    SmallPtrSet<Value *, 32> walked;
+    for (const auto &bb : func->get_basic_blocks()) {
+        for (const auto &inst : bb->get_instructions()) {
+            for (unsigned i = 0; i < inst->get_num_operand(); i++) {
+                auto op = inst->get_operand(i);
+                if (!op) {
+                    error(bb) << "operand " << i << " of " << inst->get_instr_op_name() << " is deleted" << std::endl;
+                    continue;
+                }
+                if (!walked.insert(op.get()).second)
+                    continue;
+                for (const auto &use : op->get_use_list()) {
+                    auto user = dyn_cast<Instruction>(use.val_.lock().get());
+                    if (!user)
+                        continue;
+                    auto iter = listed.find(user);
+                    if (iter != listed.end() && use.arg_no_ < iter->second.size() && user->get_operand(use.arg_no_) == op)
+                        iter->second[use.arg_no_] = true;
                 }
             }
         }
-        std::cout << "Use-Def Chain Check Pass." << std::endl;
+    }
+    for (const auto &bb : func->get_basic_blocks()) {
+        for (const auto &inst : bb->get_instructions()) {
+            auto &ops_listed = listed[inst.get()];
+            for (unsigned i = 0; i < inst->get_num_operand(); i++) {
+                auto op = inst->get_operand(i);
+                if (op && !ops_listed[i])
+                    error(bb) << "Use-Def is not valid for " << inst->get_instr_op_name() << ", operand " << op->get_name() << std::endl;
+            }
+        }
+    }
 
-        // ----------check def before use----------
-            // get all the defs
-        for(const auto &args : func->get_args())
-            defs.insert(args);
-        for(const auto &bb : func->get_basic_blocks()){ 
-            for(const auto &inst : bb->get_instructions()){
-                if(!inst->is_void())
-                    defs.insert(inst);
+    // ----------check def before use----------
+    SmallPtrSet<Value *, 32> defs;
+    for (const auto &global : module.lock()->get_global_variable())
+        defs.insert(global.get());
+    for (const auto &arg : func->get_args())
+        defs.insert(arg.get());
+    for (const auto &bb : func->get_basic_blocks()) {
+        for (const auto &inst : bb->get_instructions()) {
+            if (!inst->is_void())
+                defs.insert(inst.get());
+        }
+    }
+        // make sure all operands are defs
+    for (const auto &bb : func->get_basic_blocks()) {
+        for (const auto &inst : bb->get_instructions()) {
+            for (const auto &op_weak : inst->get_operands()) {
+                auto op = op_weak.lock();
+                // is const, jump it
+                if (!op || isa<Constant>(op))
+                    continue;
+                auto type = op->get_type();
+                if (!(type->is_array_type() || type->is_float_type() || type->is_pointer_type() || type->is_integer_type()))
+                    continue;
+                if (!defs.count(op.get()))
+                    error(bb) << "Use before define in " << inst->get_instr_op_name() << ", operand " << op->get_name() << std::endl;
             }
         }
-            // make sure all operands are defs
-        for(const auto &bb : func->get_basic_blocks()){ 
-            for(const auto &inst : bb->get_instructions()){
-                for(const auto &op : inst->get_operands()){
-                    auto Type = op.lock()->get_type();
-                    // is const, jump it
-                    if(dynamic_pointer_cast<Constant>(op.lock())) 
-                        continue;
-                    if(!(Type->is_array_type() || 
-                    Type->is_float_type() || 
-                    Type->is_pointer_type() || 
-                    Type->is_integer_type())) 
-                        continue;
-                    if(!(defs.count(op.lock()) || globaldefs.count(op.lock()))){
-                        std::cout << "Use before define!" << std::endl;
-                        std::cout << "Error bb: " << bb->get_name() << ", whose instruction is " << inst->get_instr_op_name() << ", operand is " << op.lock()->get_name() << std::endl;
-                        exit(0);
-                    }
-                }
+    }
+    // the dominator tree is only asked about a CFG that passed
+    if (errors != 0)
+        return errors;
+        // make sure the defs dominate their uses
+    DominateTree(module).run(func);
+    for (const auto &bb : func->get_basic_blocks()) {
+        for (const auto &inst : bb->get_instructions()) {
+            for (unsigned i = 0; i < inst->get_num_operand(); i++) {
+                auto def = dyn_cast<Instruction>(inst->get_operand(i));
+                if (!def || def->get_parent()->get_parent() != func)
+                    continue;
+                // an operand of a phi is used at the end of its incoming block
+                bool dominated = inst->is_phi() ?
+                    DominateTree::dominates(def->get_parent(), cast<BasicBlock>(inst->get_operand(i + 1))) :
+                    DominateTree::dominates(def, inst);
+                if (!dominated)
+                    error(bb) << "Use before define in " << inst->get_instr_op_name() << ", operand " << def->get_name() << " does not dominate it" << std::endl;
             }
         }
-        std::cout << "Def Before Use Check Pass." << std::endl;
     }
+    return errors;
+}
+
 }
 }
-}
\ No newline at end of file
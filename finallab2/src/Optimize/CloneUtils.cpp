@@ -0,0 +1,158 @@
+#include "CloneUtils.h"
+#include "Module.h"
+#include <set>
+
+namespace SysYF {
+namespace IR {
+
+static Ptr<Value> lookup(const ValueMap &vmap, Ptr<Value> val) {
+    auto iter = vmap.find(val);
+    return iter == vmap.end() ? val : iter->second;
+}
+
+Ptr<Instruction> clone_instruction(Ptr<Instruction> inst, Ptr<BasicBlock> bb, const ValueMap &vmap) {
+    auto m = bb->get_module();
+    auto op0 = inst->get_num_operand() > 0 ? inst->get_operand(0) : nullptr;
+    auto op1 = inst->get_num_operand() > 1 ? inst->get_operand(1) : nullptr;
+    switch (inst->get_instr_type()) {
+        case Instruction::add: return BinaryInst::create_add(op0, op1, bb, m);
+        case Instruction::sub: return BinaryInst::create_sub(op0, op1, bb, m);
+        case Instruction::mul: return BinaryInst::create_mul(op0, op1, bb, m);
+        case Instruction::sdiv: return BinaryInst::create_sdiv(op0, op1, bb, m);
+        case Instruction::srem: return BinaryInst::create_srem(op0, op1, bb, m);
+        case Instruction::udiv: return BinaryInst::create_udiv(op0, op1, bb, m);
+        case Instruction::urem: return BinaryInst::create_urem(op0, op1, bb, m);
+        case Instruction::shl: return BinaryInst::create_shl(op0, op1, bb, m);
+        case Instruction::ashr: return BinaryInst::create_ashr(op0, op1, bb, m);
+        case Instruction::lshr: return BinaryInst::create_lshr(op0, op1, bb, m);
+        case Instruction::and_: return BinaryInst::create_and(op0, op1, bb, m);
+        case Instruction::or_: return BinaryInst::create_or(op0, op1, bb, m);
+        case Instruction::xor_: return BinaryInst::create_xor(op0, op1, bb, m);
+        case Instruction::fadd: return BinaryInst::create_fadd(op0, op1, bb, m);
+        case Instruction::fsub: return BinaryInst::create_fsub(op0, op1, bb, m);
+        case Instruction::fmul: return BinaryInst::create_fmul(op0, op1, bb, m);
+        case Instruction::fdiv: return BinaryInst::create_fdiv(op0, op1, bb, m);
+        case Instruction::cmp:
+            return CmpInst::create_cmp(static_pointer_cast<CmpInst>(inst)->get_cmp_op(), op0, op1, bb, m);
+        case Instruction::fcmp:
+            return FCmpInst::create_fcmp(static_pointer_cast<FCmpInst>(inst)->get_cmp_op(), op0, op1, bb, m);
+        case Instruction::ret:
+            if (op0) return ReturnInst::create_ret(op0, bb);
+            return ReturnInst::create_void_ret(bb);
+        case Instruction::br:
+            if (inst->get_num_operand() == 1) {
+                return BranchInst::create_br(lookup(vmap, op0)->as<BasicBlock>(), bb);
+            }
+            return BranchInst::create_cond_br(op0, lookup(vmap, op1)->as<BasicBlock>(),
+                                              lookup(vmap, inst->get_operand(2))->as<BasicBlock>(), bb);
+        case Instruction::switch_: {
+            auto sw = static_pointer_cast<SwitchInst>(inst);
+            auto new_sw = SwitchInst::create_switch(op0, lookup(vmap, sw->get_default_dest())->as<BasicBlock>(), bb);
+            for (unsigned i = 0; i < sw->get_num_cases(); i++) {
+                new_sw->add_case(sw->get_case_value(i), lookup(vmap, sw->get_case_dest(i))->as<BasicBlock>());
+            }
+            return new_sw;
+        }
+        case Instruction::alloca:
+            return AllocaInst::create_alloca(static_pointer_cast<AllocaInst>(inst)->get_alloca_type(), bb);
+        case Instruction::load: {
+            auto load = LoadInst::create_load(inst->get_type(), op0, bb);
+            load->set_alignment(static_pointer_cast<LoadInst>(inst)->get_alignment());
+            return load;
+        }
+        case Instruction::store: {
+            auto store = StoreInst::create_store(op0, op1, bb);
+            store->set_alignment(static_pointer_cast<StoreInst>(inst)->get_alignment());
+            return store;
+        }
+        case Instruction::getelementptr: {
+            PtrVec<Value> idxs;
+            for (unsigned i = 1; i < inst->get_num_operand(); i++) {
+                idxs.push_back(inst->get_operand(i));
+            }
+            return GetElementPtrInst::create_gep(op0, idxs, bb);
+        }
+        case Instruction::call: {
+            PtrVec<Value> args;
+            for (unsigned i = 1; i < inst->get_num_operand(); i++) {
+                args.push_back(inst->get_operand(i));
+            }
+            return CallInst::create(op0->as<Function>(), args, bb);
+        }
+        case Instruction::select:
+            return SelectInst::create_select(op0, op1, inst->get_operand(2), bb);
+        case Instruction::insertelement:
+            return InsertElementInst::create_insertelement(op0, op1, inst->get_operand(2), bb);
+        case Instruction::extractelement:
+            return ExtractElementInst::create_extractelement(op0, op1, bb);
+        case Instruction::zext: return ZextInst::create_zext(op0, inst->get_type(), bb);
+        case Instruction::sext: return SextInst::create_sext(op0, inst->get_type(), bb);
+        case Instruction::trunc: return TruncInst::create_trunc(op0, inst->get_type(), bb);
+        case Instruction::fptosi: return FpToSiInst::create_fptosi(op0, inst->get_type(), bb);
+        case Instruction::sitofp: return SiToFpInst::create_sitofp(op0, inst->get_type(), bb);
+        case Instruction::bitcast: return BitCastInst::create_bitcast(op0, inst->get_type(), bb);
+        case Instruction::phi: {
+            auto phi = PhiInst::create_phi(inst->get_type(), bb);
+            bb->add_instruction(phi);
+            for (unsigned i = 0; i < inst->get_num_operand(); i += 2) {
+                phi->add_phi_pair_operand(inst->get_operand(i), lookup(vmap, inst->get_operand(i + 1)));
+            }
+            return phi;
+        }
+        default: return nullptr;
+    }
+}
+
+void remap_operands(Ptr<Instruction> inst, const ValueMap &vmap) {
+    for (unsigned i = 0; i < inst->get_num_operand(); i++) {
+        auto iter = vmap.find(inst->get_operand(i));
+        if (iter != vmap.end()) {
+            inst->set_operand(i, iter->second);
+        }
+    }
+}
+
+void clone_function_body(Ptr<Function> src, Ptr<Function> dst, ValueMap &vmap) {
+    auto m = src->get_parent();
+    auto dst_arg = dst->arg_begin();
+    for (auto arg : src->get_args()) {
+        vmap[arg] = *dst_arg++;
+    }
+    for (auto bb : src->get_basic_blocks()) {
+        auto new_bb = BasicBlock::create(m, "", dst);
+        // explicit names such as label_entry are looked up by other passes,
+        // numbered names are handed out again by set_instr_name
+        if (bb->get_name().compare(0, 6, "label_") == 0) {
+            new_bb->set_name(bb->get_name());
+        }
+        vmap[bb] = new_bb;
+    }
+    PtrVec<Instruction> new_insts;
+    for (auto bb : src->get_basic_blocks()) {
+        auto new_bb = vmap[bb]->as<BasicBlock>();
+        for (auto inst : bb->get_instructions()) {
+            auto new_inst = clone_instruction(inst, new_bb, vmap);
+            vmap[inst] = new_inst;
+            new_insts.push_back(new_inst);
+        }
+    }
+    for (auto inst : new_insts) {
+        remap_operands(inst, vmap);
+    }
+}
+
+std::string get_unique_function_name(Ptr<Module> m, const std::string &prefix) {
+    std::set<std::string> names;
+    for (auto f : m->get_functions()) {
+        names.insert(f->get_name());
+    }
+    for (int i = 0;; i++) {
+        auto name = prefix + std::to_string(i);
+        if (!names.count(name)) {
+            return name;
+        }
+    }
+}
+
+}
+}
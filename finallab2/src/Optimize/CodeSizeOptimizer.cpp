@@ -1,34 +1,45 @@
 #include "CodeSizeOptimizer.h"
+#include "Remarks.h"
+#include "Statistics.h"
 #include <unordered_map>
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <cstdint>
 
 namespace SysYF {
 namespace IR {
 
-void CodeSizeOptimizer::execute() {
+static Statistic num_duplicates("CodeSizeOptimizer", "duplicate loop expressions removed");
+static Statistic num_hoisted("CodeSizeOptimizer", "loop invariant instructions hoisted");
+static Statistic num_merged("CodeSizeOptimizer", "functions merged");
+
+bool CodeSizeOptimizer::execute() {
+    bool changed = false;
     for (auto f : module.lock()->get_functions()) {
         if (f->get_basic_blocks().empty()) {
             continue;
         }
         
-        for (auto bb : f->get_basic_blocks()) {
+        // a preheader is put in front of the block it is made for
+        PtrVec<BasicBlock> blocks(f->get_basic_blocks().begin(), f->get_basic_blocks().end());
+        for (auto bb : blocks) {
             if (is_loop_block(bb)) {
-                optimize_loop_block(bb);
+                changed |= optimize_loop_block(bb);
             }
         }
     }
 
-    merge_similar_functions();
+    changed |= merge_similar_functions();
+    return changed;
 }
 
 bool CodeSizeOptimizer::is_loop_block(Ptr<BasicBlock> bb) {
     for (auto instr : bb->get_instructions()) {
-        if (auto br = std::dynamic_pointer_cast<BranchInst>(instr)) {
+        if (auto br = dyn_cast<BranchInst>(instr)) {
             for (auto op : br->get_operands()) {
                 auto op_shared = op.lock();
-                if (auto bb_op = std::dynamic_pointer_cast<BasicBlock>(op_shared)) {
+                if (auto bb_op = dyn_cast<BasicBlock>(op_shared)) {
                     if (bb_op == bb) {
                         return true;
                     }
@@ -39,36 +50,50 @@ bool CodeSizeOptimizer::is_loop_block(Ptr<BasicBlock> bb) {
     return false;
 }
 
-void CodeSizeOptimizer::optimize_loop_block(Ptr<BasicBlock> bb) {
+bool CodeSizeOptimizer::optimize_loop_block(Ptr<BasicBlock> bb) {
+    bool changed = false;
     std::vector<Ptr<Instruction>> instructions(bb->get_instructions().begin(), 
                                              bb->get_instructions().end());
     std::vector<Ptr<Instruction>> invariant_instrs;
     std::unordered_map<std::string, Ptr<Instruction>> computed_exprs;
     
     for (auto instr : instructions) {
-        if (auto binop = std::dynamic_pointer_cast<BinaryInst>(instr)) {
+        if (auto binop = dyn_cast<BinaryInst>(instr)) {
             if (is_loop_invariant(binop)) {
                 std::string key = get_expression_key(binop);
                 if (computed_exprs.find(key) == computed_exprs.end()) {
                     computed_exprs[key] = binop;
                     invariant_instrs.push_back(binop);
                 } else {
-                    replace_all_uses_with(binop, computed_exprs[key]);
+                    ++num_duplicates;
+                    Remark::emit(Remark(Remark::Passed, get_name(), "DuplicateRemoved", binop)
+                                     .arg("ReplacedBy", computed_exprs[key]));
+                    binop->replace_all_use_with(computed_exprs[key]);
+                    bb->delete_instr(binop);
+                    changed = true;
                 }
             }
         }
     }
     
     if (!invariant_instrs.empty()) {
-        auto preheader = create_loop_preheader(bb, invariant_instrs);
-        move_invariant_instructions(invariant_instrs, preheader);
+        auto preheader = create_loop_preheader(bb);
+        if (preheader) {
+            move_invariant_instructions(invariant_instrs, preheader);
+            changed = true;
+        } else {
+            Remark::emit(Remark(Remark::Missed, get_name(), "NotHoisted", bb)
+                             .arg("Reason", "no preheader can be put in front of the loop")
+                             .arg("Invariants", static_cast<int>(invariant_instrs.size())));
+        }
     }
+    return changed;
 }
 
 bool CodeSizeOptimizer::is_loop_invariant(Ptr<Instruction> instr) {
     for (auto op : instr->get_operands()) {
         auto op_shared = op.lock();
-        if (auto inst_op = std::dynamic_pointer_cast<Instruction>(op_shared)) {
+        if (auto inst_op = dyn_cast<Instruction>(op_shared)) {
             if (inst_op->get_parent() == instr->get_parent()) {
                 return false;
             }
@@ -77,28 +102,17 @@ bool CodeSizeOptimizer::is_loop_invariant(Ptr<Instruction> instr) {
     return true;
 }
 
-Ptr<BasicBlock> CodeSizeOptimizer::create_loop_preheader(Ptr<BasicBlock> loop_header, 
-                                                        const std::vector<Ptr<Instruction>>& invariant_instrs) {
-    auto func = loop_header->get_parent();
-    auto preheader = BasicBlock::create(module.lock(), "loop_preheader", func);
-    
-    auto it = std::find(func->get_basic_blocks().begin(), 
-                       func->get_basic_blocks().end(), 
-                       loop_header);
-    if (it != func->get_basic_blocks().end()) {
-        func->get_basic_blocks().insert(it, preheader);
-    }
-    
-    BranchInst::create_br(loop_header, preheader);
-    
-    return preheader;
+Ptr<BasicBlock> CodeSizeOptimizer::create_loop_preheader(Ptr<BasicBlock> loop_header) {
+    // the loop is the block itself, which branches back to its start
+    return insert_preheader(loop_header, {loop_header});
 }
 
 void CodeSizeOptimizer::move_invariant_instructions(const std::vector<Ptr<Instruction>>& invariant_instrs,
                                                   Ptr<BasicBlock> preheader) {
     for (auto instr : invariant_instrs) {
-        instr->get_parent()->delete_instr(instr);
-        preheader->add_instruction(instr);
+        ++num_hoisted;
+        Remark::emit(Remark(Remark::Passed, get_name(), "Hoisted", instr));
+        instr->move_to(preheader);
     }
 }
 
@@ -111,50 +125,60 @@ std::string CodeSizeOptimizer::get_expression_key(Ptr<BinaryInst> binop) {
 }
 
 std::string CodeSizeOptimizer::get_operand_string(Value* op) {
-    std::string result;
-    if (auto constant_float = dynamic_cast<ConstantFloat*>(op)) {
-        result = std::to_string(constant_float->get_value());
-    } else if (auto constant_int = dynamic_cast<ConstantInt*>(op)) {
-        result = std::to_string(constant_int->get_value());
-    } else {
-        result = op->get_name();
+    // constants by value, other values by identity, their names need not be unique or set
+    if (isa<Constant>(op)) {
+        return op->print();
     }
-    return result;
+    return "%" + std::to_string(reinterpret_cast<uintptr_t>(op));
 }
 
-void CodeSizeOptimizer::replace_all_uses_with(Ptr<Value> old_val, Ptr<Value> new_val) {
-    auto uses = old_val->get_use_list();
-    for (auto &use : uses) {
-        use.val_ = new_val;
-    }
-}
-
-void CodeSizeOptimizer::merge_similar_functions() {
+bool CodeSizeOptimizer::merge_similar_functions() {
+    bool changed = false;
     auto m = module.lock();
-    std::vector<Ptr<Function>> functions(m->get_functions().begin(), m->get_functions().end());
+    std::vector<Ptr<Function>> functions;
+    for (auto f : m->get_functions()) {
+        // main is called from outside and keeps its signature
+        if (!f->is_declaration() && f->get_name() != "main") {
+            functions.push_back(f);
+        }
+    }
     
     for (size_t i = 0; i < functions.size(); i++) {
         for (size_t j = i + 1; j < functions.size(); j++) {
             if (are_functions_similar(functions[i], functions[j])) {
                 auto merged_func = create_merged_function(functions[i], functions[j]);
-                replace_function_calls(functions[i], merged_func);
-                replace_function_calls(functions[j], merged_func);
+                num_merged += 2;
+                Remark::emit(Remark(Remark::Passed, get_name(), "Merged", merged_func)
+                                 .arg("First", functions[i]).arg("Second", functions[j]));
+                replace_function_calls(functions[i], merged_func, 0);
+                replace_function_calls(functions[j], merged_func, 1);
+                m->remove_function(functions[i]);
+                m->remove_function(functions[j]);
                 
                 functions.erase(functions.begin() + j);
                 functions.erase(functions.begin() + i);
                 functions.push_back(merged_func);
                 i--;
+                changed = true;
                 break;
             }
         }
     }
+    return changed;
 }
 
 bool CodeSizeOptimizer::are_functions_similar(Ptr<Function> f1, Ptr<Function> f2) {
-    if (f1->get_return_type() != f2->get_return_type() ||
-        f1->get_args().size() != f2->get_args().size()) {
+    auto ty1 = f1->get_function_type();
+    auto ty2 = f2->get_function_type();
+    if (ty1->get_return_type() != ty2->get_return_type() ||
+        ty1->get_num_of_args() != ty2->get_num_of_args()) {
         return false;
     }
+    for (unsigned i = 0; i < ty1->get_num_of_args(); i++) {
+        if (ty1->get_param_type(i) != ty2->get_param_type(i)) {
+            return false;
+        }
+    }
     
     float similarity = calculate_similarity(f1, f2);
     return similarity > 0.8f;
@@ -164,8 +188,8 @@ float CodeSizeOptimizer::calculate_similarity(Ptr<Function> f1, Ptr<Function> f2
     int matching_instructions = 0;
     int total_instructions = 0;
     
-    auto bb1_list = f1->get_basic_blocks();
-    auto bb2_list = f2->get_basic_blocks();
+    auto &bb1_list = f1->get_basic_blocks();
+    auto &bb2_list = f2->get_basic_blocks();
     
     for (auto &bb1 : bb1_list) {
         for (auto &instr1 : bb1->get_instructions()) {
@@ -197,20 +221,24 @@ Ptr<Function> CodeSizeOptimizer::create_merged_function(Ptr<Function> f1, Ptr<Fu
     
     auto func_type = FunctionType::create(f1->get_return_type(), param_types, m);
     auto merged_func = Function::create(func_type, merged_name, m);
-    
     auto entry_block = BasicBlock::create(m, "entry", merged_func);
-    auto f1_block = BasicBlock::create(m, "f1_body", merged_func);
-    auto f2_block = BasicBlock::create(m, "f2_body", merged_func);
     
-    for (auto &bb : f1->get_basic_blocks()) {
-        for (auto &instr : bb->get_instructions()) {
-            f1_block->add_instruction(instr);
+    Ptr<BasicBlock> bodies[2];
+    Ptr<Function> funcs[2] = {f1, f2};
+    for (int k = 0; k < 2; k++) {
+        auto f = funcs[k];
+        ValueMap vmap;
+        auto merged_arg = merged_func->arg_begin();
+        for (auto arg : f->get_args()) {
+            vmap[arg] = *merged_arg++;
         }
-    }
-    
-    for (auto &bb : f2->get_basic_blocks()) {
-        for (auto &instr : bb->get_instructions()) {
-            f2_block->add_instruction(instr);
+        PtrVec<BasicBlock> blocks(f->get_basic_blocks().begin(), f->get_basic_blocks().end());
+        // the copies are unnamed, so the two bodies do not clash
+        bodies[k] = clone_region(blocks, merged_func, vmap).front();
+        for (auto bb : blocks) {
+            for (auto instr : bb->get_instructions()) {
+                instr->remove_use_of_ops();
+            }
         }
     }
     
@@ -218,39 +246,42 @@ Ptr<Function> CodeSizeOptimizer::create_merged_function(Ptr<Function> f1, Ptr<Fu
     auto discriminator = merged_func->get_args().back();
     
     auto cond = CmpInst::create_cmp(CmpInst::EQ, discriminator, zero, entry_block, m);
-    BranchInst::create_cond_br(cond, f1_block, f2_block, entry_block);
+    BranchInst::create_cond_br(cond, bodies[0], bodies[1], entry_block);
     
     return merged_func;
 }
 
 std::string CodeSizeOptimizer::get_merged_name(Ptr<Function> f1, Ptr<Function> f2) {
-    return "merged_" + f1->get_name() + "_" + f2->get_name();
+    // not both names, merging merged functions again would double the length each time
+    return get_unique_function_name(module.lock(), f1->get_name() + ".merged.");
 }
 
-void CodeSizeOptimizer::replace_function_calls(Ptr<Function> old_func, Ptr<Function> new_func) {
+void CodeSizeOptimizer::replace_function_calls(Ptr<Function> old_func, Ptr<Function> new_func, int discriminator) {
     auto m = module.lock();
     
-    for (auto &f : m->get_functions()) {
-        for (auto &bb : f->get_basic_blocks()) {
-            for (auto &instr : bb->get_instructions()) {
-                if (auto call = std::dynamic_pointer_cast<CallInst>(instr)) {
-                    if (call->get_function() == old_func) {
-                        PtrVec<Value> args;
-                        for (auto &op : call->get_operands()) {
-                            args.push_back(op.lock());
-                        }
-                        
-                        auto discriminator = ConstantInt::create(old_func == new_func ? 0 : 1, m);
-                        args.push_back(discriminator);
-                        
-                        auto new_call = CallInst::create(new_func, args, bb);
-                        replace_all_uses_with(call, new_call);
-                        bb->delete_instr(call);
-                    }
-                }
-            }
+    // collected first, the calls are replaced while walking the uses
+    PtrVec<CallInst> calls;
+    for (auto &use : old_func->get_use_list()) {
+        auto call = dyn_cast<CallInst>(use.val_.lock());
+        if (call && use.arg_no_ == 0) {
+            calls.push_back(call);
         }
     }
+    for (auto call : calls) {
+        PtrVec<Value> args;
+        for (unsigned i = 1; i < call->get_num_operand(); i++) {
+            args.push_back(call->get_operand(i));
+        }
+        args.push_back(ConstantInt::create(discriminator, m));
+        
+        auto bb = call->get_parent();
+        // create appends to bb, move the new call to where the old one is
+        auto new_call = CallInst::create(new_func, args, bb);
+        new_call->insert_before(call);
+        new_call->set_name(call->get_name());
+        call->replace_all_use_with(new_call);
+        bb->delete_instr(call);
+    }
 }
 
 }
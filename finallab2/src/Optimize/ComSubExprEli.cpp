@@ -1,23 +1,32 @@
 #include "Pass.h"
 #include "ComSubExprEli.h"
+#include "Remarks.h"
+#include "Statistics.h"
 #include <set>
 #include <algorithm>
 
 namespace SysYF {
 namespace IR {
 
-void ComSubExprEli::execute() {
+static Statistic num_removed("ComSubExprEli", "common subexpressions removed");
+
+bool ComSubExprEli::execute() {
+    bool changed = false;
     for(auto func : module.lock()->get_functions()) {
         if(func->get_basic_blocks().empty())continue;
         bb_in.clear();
         bb_out.clear();
         bb_gen.clear();
         del_expr.clear();
+        // the expressions of one function, a rerun must not see deleted ones
+        availableExprs.clear();
         ComSubExprEli::compute_local_gen(func);
         ComSubExprEli::compute_global_in_out(func);
         // ComSubExprEli::debug_print_in_out_gen(func);
         ComSubExprEli::compute_global_common_expr(func);
+        changed |= !del_expr.empty();
     }
+    return changed;
 }
 
 void ComSubExprEli::debug_print_in_out_gen(Ptr<Function> func) {
@@ -25,23 +34,23 @@ void ComSubExprEli::debug_print_in_out_gen(Ptr<Function> func) {
         printf("%s: \n", bb->get_name().c_str());
         printf("IN:\n");
         for(auto inst : bb_in[bb]) {
-            std::cout << dynamic_pointer_cast<Instruction>(inst)->print() << "\t";
+            std::cout << cast<Instruction>(inst)->print() << "\t";
         }
         std::cout << std::endl;
         printf("OUT:\n");
         for(auto inst : bb_out[bb]) {
-            std::cout << dynamic_pointer_cast<Instruction>(inst)->print() << "\t";
+            std::cout << cast<Instruction>(inst)->print() << "\t";
         }
         std::cout << std::endl;
         printf("GEN:\n");
         for(auto inst : bb_gen[bb]) {
-            std::cout << dynamic_pointer_cast<Instruction>(inst)->print() << "\t";
+            std::cout << cast<Instruction>(inst)->print() << "\t";
         }
         std::cout << std::endl;
     }
     printf("all_exprs\n");
     for(auto inst : availableExprs) {
-        std::cout << dynamic_pointer_cast<Instruction>(inst)->print() << std::endl;
+        std::cout << cast<Instruction>(inst)->print() << std::endl;
     }
 }
 
@@ -130,12 +139,14 @@ void ComSubExprEli::compute_global_common_expr(Ptr<Function> f){
             if(availableExprs.find(inst) != availableExprs.end() && bb_in[bb].find(inst) != bb_in[bb].end()) {
                 bb_vis.clear();
                 Ptr<Value> pre_def = find_definition_expr(bb, inst);
+                Remark::emit(Remark(Remark::Passed, name, "Eliminated", inst).arg("ReplacedBy", pre_def));
                 inst->replace_all_use_with(pre_def);
                 // bb->delete_instr(inst);
                 del_expr.insert({inst, bb});
             } else {
                 if(bb_cur_expr.find(inst) != bb_cur_expr.end()) {
 					auto iter = bb_cur_expr.find(inst);
+                    Remark::emit(Remark(Remark::Passed, name, "Eliminated", inst).arg("ReplacedBy", *iter));
                     inst->replace_all_use_with(*iter);
                     // bb->delete_instr(inst);
                     del_expr.insert({inst, bb});
@@ -159,6 +170,7 @@ void ComSubExprEli::compute_global_common_expr(Ptr<Function> f){
         }
     }
 
+    num_removed += del_expr.size();
     for(auto iter = del_expr.begin(); iter != del_expr.end(); ++iter)
         iter->second->delete_instr(iter->first);
 }
@@ -0,0 +1,128 @@
+#include "ConditionUtils.h"
+#include "Constant.h"
+
+namespace SysYF {
+namespace IR {
+
+namespace {
+
+// the outcomes of a signed compare among less, equal and greater
+int get_outcomes(CmpInst::CmpOp op) {
+    const int less = 1, equal = 2, greater = 4;
+    switch (op) {
+        case CmpInst::EQ: return equal;
+        case CmpInst::NE: return less | greater;
+        case CmpInst::LT: return less;
+        case CmpInst::LE: return less | equal;
+        case CmpInst::GT: return greater;
+        case CmpInst::GE: return greater | equal;
+    }
+    return 0;
+}
+
+}
+
+CmpInst::CmpOp swap_operands(CmpInst::CmpOp op) {
+    switch (op) {
+        case CmpInst::LT: return CmpInst::GT;
+        case CmpInst::GT: return CmpInst::LT;
+        case CmpInst::LE: return CmpInst::GE;
+        case CmpInst::GE: return CmpInst::LE;
+        default: return op;
+    }
+}
+
+CmpInst::CmpOp negate(CmpInst::CmpOp op) {
+    switch (op) {
+        case CmpInst::EQ: return CmpInst::NE;
+        case CmpInst::NE: return CmpInst::EQ;
+        case CmpInst::LT: return CmpInst::GE;
+        case CmpInst::GE: return CmpInst::LT;
+        case CmpInst::GT: return CmpInst::LE;
+        case CmpInst::LE: return CmpInst::GT;
+    }
+    return op;
+}
+
+bool evaluate_compare(CmpInst::CmpOp op, int lhs, int rhs) {
+    switch (op) {
+        case CmpInst::EQ: return lhs == rhs;
+        case CmpInst::NE: return lhs != rhs;
+        case CmpInst::LT: return lhs < rhs;
+        case CmpInst::LE: return lhs <= rhs;
+        case CmpInst::GT: return lhs > rhs;
+        case CmpInst::GE: return lhs >= rhs;
+    }
+    return false;
+}
+
+bool is_same_value(Ptr<Value> a, Ptr<Value> b) {
+    auto const_a = dyn_cast<ConstantInt>(a);
+    auto const_b = dyn_cast<ConstantInt>(b);
+    if (const_a && const_b) {
+        return const_a->get_value() == const_b->get_value();
+    }
+    return a == b;
+}
+
+bool get_edge_condition(Ptr<BasicBlock> from, Ptr<BasicBlock> to, Condition &cond) {
+    auto br = from->get_terminator();
+    if (!br || !br->is_br() || br->get_num_operand() != 3 || br->get_operand(1) == br->get_operand(2)) {
+        return false;
+    }
+    auto cmp = dyn_cast<CmpInst>(br->get_operand(0));
+    if (!cmp) {
+        return false;
+    }
+    bool taken = br->get_operand(1) == to;
+    // icmp ne (zext %c), 0 is %c itself, icmp eq its negation
+    auto zero = dyn_cast<ConstantInt>(cmp->get_operand(1));
+    auto zext = dyn_cast<ZextInst>(cmp->get_operand(0));
+    auto inner = zext ? dyn_cast<CmpInst>(zext->get_operand(0)) : nullptr;
+    if (inner && zero && zero->get_value() == 0 &&
+        (cmp->get_cmp_op() == CmpInst::NE || cmp->get_cmp_op() == CmpInst::EQ)) {
+        taken ^= cmp->get_cmp_op() == CmpInst::EQ;
+        cmp = inner;
+    }
+    cond = {cmp, taken};
+    return true;
+}
+
+void collect_conditions(const PtrVec<BasicBlock> &order, ConditionMap &conditions) {
+    // a block is only entered along an edge when that edge is its single predecessor
+    for (auto bb : order) {
+        auto idom = bb->get_idom().lock();
+        auto &conds = conditions[bb];
+        if (idom && idom != bb) {
+            conds = conditions[idom];
+        }
+        Condition cond;
+        if (bb->get_pre_basic_blocks().size() == 1 &&
+            get_edge_condition(bb->get_pre_basic_blocks().front().lock(), bb, cond)) {
+            conds.push_back(cond);
+        }
+    }
+}
+
+bool decide_by_conditions(const std::vector<Condition> &conds, CmpInst::CmpOp op,
+                          Ptr<Value> lhs, Ptr<Value> rhs, bool &result) {
+    auto query = get_outcomes(op);
+    for (auto &cond : conds) {
+        auto cond_op = cond.taken ? cond.cmp->get_cmp_op() : negate(cond.cmp->get_cmp_op());
+        if (is_same_value(cond.cmp->get_operand(0), rhs) && is_same_value(cond.cmp->get_operand(1), lhs)) {
+            cond_op = swap_operands(cond_op);
+        }
+        else if (!is_same_value(cond.cmp->get_operand(0), lhs) || !is_same_value(cond.cmp->get_operand(1), rhs)) {
+            continue;
+        }
+        auto known = get_outcomes(cond_op);
+        if ((known & query) == known || (known & query) == 0) {
+            result = (known & query) != 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+}
+}
@@ -0,0 +1,163 @@
+#include "ConstantFolder.h"
+#include "BasicBlock.h"
+#include <climits>
+#include <cmath>
+
+namespace SysYF {
+namespace IR {
+
+static Ptr<Constant> fold_int_binary(Instruction::OpID op, int lhs, int rhs, Ptr<Module> m) {
+    // do the arithmetic on unsigned to get the wrap-around semantics of llvm
+    auto ulhs = static_cast<unsigned>(lhs);
+    auto urhs = static_cast<unsigned>(rhs);
+    switch (op) {
+        case Instruction::add: return ConstantInt::create(static_cast<int>(ulhs + urhs), m);
+        case Instruction::sub: return ConstantInt::create(static_cast<int>(ulhs - urhs), m);
+        case Instruction::mul: return ConstantInt::create(static_cast<int>(ulhs * urhs), m);
+        case Instruction::sdiv:
+            if (rhs == 0 || (lhs == INT_MIN && rhs == -1)) return nullptr;
+            return ConstantInt::create(lhs / rhs, m);
+        case Instruction::srem:
+            if (rhs == 0 || (lhs == INT_MIN && rhs == -1)) return nullptr;
+            return ConstantInt::create(lhs % rhs, m);
+        case Instruction::udiv:
+            if (rhs == 0) return nullptr;
+            return ConstantInt::create(static_cast<int>(ulhs / urhs), m);
+        case Instruction::urem:
+            if (rhs == 0) return nullptr;
+            return ConstantInt::create(static_cast<int>(ulhs % urhs), m);
+        // shifting by the bit width or more is poison
+        case Instruction::shl:
+            if (urhs >= 32) return nullptr;
+            return ConstantInt::create(static_cast<int>(ulhs << urhs), m);
+        case Instruction::ashr:
+            if (urhs >= 32) return nullptr;
+            return ConstantInt::create(lhs >> rhs, m);
+        case Instruction::lshr:
+            if (urhs >= 32) return nullptr;
+            return ConstantInt::create(static_cast<int>(ulhs >> urhs), m);
+        case Instruction::and_: return ConstantInt::create(lhs & rhs, m);
+        case Instruction::or_: return ConstantInt::create(lhs | rhs, m);
+        case Instruction::xor_: return ConstantInt::create(lhs ^ rhs, m);
+        default: return nullptr;
+    }
+}
+
+static Ptr<Constant> fold_float_binary(Instruction::OpID op, float lhs, float rhs, Ptr<Module> m) {
+    switch (op) {
+        case Instruction::fadd: return ConstantFloat::create(lhs + rhs, m);
+        case Instruction::fsub: return ConstantFloat::create(lhs - rhs, m);
+        case Instruction::fmul: return ConstantFloat::create(lhs * rhs, m);
+        case Instruction::fdiv: return ConstantFloat::create(lhs / rhs, m);
+        default: return nullptr;
+    }
+}
+
+Ptr<Constant> fold_binary(Instruction::OpID op, Ptr<ConstantInt> lhs, Ptr<ConstantInt> rhs, Ptr<Module> m) {
+    return fold_int_binary(op, lhs->get_value(), rhs->get_value(), m);
+}
+
+template <typename T>
+static bool eval_cmp(int op, T lhs, T rhs) {
+    // CmpInst::CmpOp and FCmpInst::CmpOp share the same layout
+    switch (op) {
+        case CmpInst::EQ: return lhs == rhs;
+        case CmpInst::NE: return lhs != rhs;
+        case CmpInst::GT: return lhs > rhs;
+        case CmpInst::GE: return lhs >= rhs;
+        case CmpInst::LT: return lhs < rhs;
+        case CmpInst::LE: return lhs <= rhs;
+        default: return false;
+    }
+}
+
+Ptr<Constant> fold_constant(Ptr<Instruction> inst, Ptr<Module> m) {
+    if (inst->isBinary()) {
+        auto lhs_int = dyn_cast<ConstantInt>(inst->get_operand(0));
+        auto rhs_int = dyn_cast<ConstantInt>(inst->get_operand(1));
+        if (lhs_int && rhs_int) {
+            // ConstantInt only holds 32 bits, wider results are not folded
+            if (static_pointer_cast<IntegerType>(inst->get_type())->get_num_bits() != 32) return nullptr;
+            return fold_int_binary(inst->get_instr_type(), lhs_int->get_value(), rhs_int->get_value(), m);
+        }
+        auto lhs_fp = dyn_cast<ConstantFloat>(inst->get_operand(0));
+        auto rhs_fp = dyn_cast<ConstantFloat>(inst->get_operand(1));
+        if (lhs_fp && rhs_fp) {
+            return fold_float_binary(inst->get_instr_type(), lhs_fp->get_value(), rhs_fp->get_value(), m);
+        }
+        return nullptr;
+    }
+    if (inst->is_cmp()) {
+        auto lhs = dyn_cast<ConstantInt>(inst->get_operand(0));
+        auto rhs = dyn_cast<ConstantInt>(inst->get_operand(1));
+        if (!lhs || !rhs) return nullptr;
+        auto op = static_pointer_cast<CmpInst>(inst)->get_cmp_op();
+        return ConstantInt::create(eval_cmp(op, lhs->get_value(), rhs->get_value()), m);
+    }
+    if (inst->is_fcmp()) {
+        auto lhs = dyn_cast<ConstantFloat>(inst->get_operand(0));
+        auto rhs = dyn_cast<ConstantFloat>(inst->get_operand(1));
+        if (!lhs || !rhs) return nullptr;
+        auto op = static_pointer_cast<FCmpInst>(inst)->get_cmp_op();
+        return ConstantInt::create(eval_cmp(op, lhs->get_value(), rhs->get_value()), m);
+    }
+    if (inst->is_zext()) {
+        auto val = dyn_cast<ConstantInt>(inst->get_operand(0));
+        if (!val) return nullptr;
+        return ConstantInt::create(val->get_value() != 0 ? 1 : 0, m);
+    }
+    if (inst->is_sext() || inst->is_trunc()) {
+        // ConstantInt only holds 32 bits, so every i64 constant is a sign
+        // extended i32 and truncating it back to i32 keeps the value
+        auto val = dyn_cast<ConstantInt>(inst->get_operand(0));
+        if (!val) return nullptr;
+        auto src_ty = static_pointer_cast<IntegerType>(val->get_type());
+        auto dst_ty = static_pointer_cast<IntegerType>(inst->get_type());
+        if (dst_ty->get_num_bits() < 32) return nullptr;
+        int v = val->get_value();
+        if (src_ty->get_num_bits() == 1) v = v ? -1 : 0;
+        return ConstantInt::create(dst_ty, v, m);
+    }
+    if (inst->is_sitofp()) {
+        auto val = dyn_cast<ConstantInt>(inst->get_operand(0));
+        if (!val) return nullptr;
+        return ConstantFloat::create(static_cast<float>(val->get_value()), m);
+    }
+    if (inst->is_fptosi()) {
+        auto val = dyn_cast<ConstantFloat>(inst->get_operand(0));
+        if (!val) return nullptr;
+        float fval = val->get_value();
+        // out of range conversions are poison, leave them alone
+        if (std::isnan(fval) || fval >= 2147483648.0f || fval < -2147483648.0f) return nullptr;
+        return ConstantInt::create(static_cast<int>(fval), m);
+    }
+    return nullptr;
+}
+
+bool fold_constants(Ptr<Function> f) {
+    auto m = f->get_parent();
+    bool changed = false;
+    bool local_changed = true;
+    while (local_changed) {
+        local_changed = false;
+        for (auto bb : f->get_basic_blocks()) {
+            PtrVec<Instruction> folded;
+            for (auto inst : bb->get_instructions()) {
+                auto c = fold_constant(inst, m);
+                if (c) {
+                    inst->replace_all_use_with(c);
+                    folded.push_back(inst);
+                }
+            }
+            for (auto inst : folded) {
+                bb->delete_instr(inst);
+            }
+            local_changed |= !folded.empty();
+        }
+        changed |= local_changed;
+    }
+    return changed;
+}
+
+}
+}
@@ -0,0 +1,189 @@
+#include "DivRemLowering.h"
+#include "Remarks.h"
+#include "Statistics.h"
+#include <climits>
+
+namespace SysYF {
+namespace IR {
+
+static Statistic num_lowered("DivRemLowering", "divisions and remainders by constants lowered");
+
+namespace {
+
+struct Magic {
+    int multiplier;
+    int shift;
+};
+
+unsigned abs_value(int val) {
+    return val < 0 ? 0u - static_cast<unsigned>(val) : static_cast<unsigned>(val);
+}
+
+// magic number for signed division by d, 2 <= |d| < 2^31
+Magic signed_magic(int d) {
+    const unsigned two31 = 0x80000000u;
+    unsigned ad = abs_value(d);
+    unsigned t = two31 + (static_cast<unsigned>(d) >> 31);
+    unsigned anc = t - 1 - t % ad;
+    int p = 31;
+    unsigned q1 = two31 / anc, r1 = two31 - q1 * anc;
+    unsigned q2 = two31 / ad, r2 = two31 - q2 * ad;
+    unsigned delta;
+    do {
+        p++;
+        q1 *= 2; r1 *= 2;
+        if (r1 >= anc) { q1++; r1 -= anc; }
+        q2 *= 2; r2 *= 2;
+        if (r2 >= ad) { q2++; r2 -= ad; }
+        delta = ad - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+    unsigned mag = q2 + 1;
+    if (d < 0) mag = 0u - mag;
+    return {static_cast<int>(mag), p - 32};
+}
+
+int log2_exact(unsigned val) {
+    if (val == 0 || (val & (val - 1)) != 0) return -1;
+    int k = 0;
+    while ((val >>= 1) != 0) k++;
+    return k;
+}
+
+}
+
+template <typename T>
+Ptr<T> DivRemLowering::insert(Ptr<T> inst) {
+    inst->insert_before(pos_);
+    return inst;
+}
+
+Ptr<ConstantInt> DivRemLowering::get_int(int val) {
+    return ConstantInt::create(val, module.lock());
+}
+
+bool DivRemLowering::execute() {
+    bool changed = false;
+    for (auto f : module.lock()->get_functions()) {
+        for (auto bb : f->get_basic_blocks()) {
+            PtrVec<Instruction> worklist;
+            for (auto inst : bb->get_instructions()) {
+                if (!inst->is_div() && !inst->is_rem() && !inst->is_udiv() && !inst->is_urem()) {
+                    continue;
+                }
+                auto divisor = dyn_cast<ConstantInt>(inst->get_operand(1));
+                if (!divisor || isa<Constant>(inst->get_operand(0))) {
+                    continue;
+                }
+                // unsigned division is left to the backend unless it is a plain shift or mask
+                if (inst->is_div() || inst->is_rem() ||
+                    ((inst->is_udiv() || inst->is_urem()) && divisor->get_value() > 0 &&
+                     log2_exact(divisor->get_value()) >= 0)) {
+                    worklist.push_back(inst);
+                }
+            }
+            bb_ = bb;
+            for (auto inst : worklist) {
+                int divisor = inst->get_operand(1)->as<ConstantInt>()->get_value();
+                // division by zero is undefined and INT_MIN has no positive
+                // counterpart, keep both as they are
+                if (divisor == 0 || divisor == INT_MIN) {
+                    continue;
+                }
+                ++num_lowered;
+                Remark::emit(Remark(Remark::Passed, name, "Lowered", inst).arg("Divisor", divisor));
+                pos_ = inst;
+                auto res = lower(static_pointer_cast<BinaryInst>(inst), divisor);
+                inst->replace_all_use_with(res);
+                bb->delete_instr(inst);
+                changed = true;
+            }
+        }
+    }
+    return changed;
+}
+
+Ptr<Value> DivRemLowering::lower(Ptr<BinaryInst> inst, int divisor) {
+    auto m = module.lock();
+    auto x = inst->get_operand(0);
+    if (inst->is_udiv()) {
+        return insert(BinaryInst::create_lshr(x, get_int(log2_exact(divisor)), bb_, m));
+    }
+    if (inst->is_urem()) {
+        return insert(BinaryInst::create_and(x, get_int(divisor - 1), bb_, m));
+    }
+    if (divisor == 1 || divisor == -1) {
+        if (inst->is_rem()) return get_int(0);
+        if (divisor == 1) return x;
+        return insert(BinaryInst::create_sub(get_int(0), x, bb_, m));
+    }
+    unsigned abs_divisor = abs_value(divisor);
+    bool is_pow2 = log2_exact(abs_divisor) > 0;
+    if (inst->is_rem() && is_pow2) {
+        return lower_pow2_rem(x, divisor);
+    }
+    auto q = is_pow2 ? lower_pow2_div(x, divisor) : lower_magic_div(x, divisor);
+    if (inst->is_div()) {
+        return q;
+    }
+    auto prod = insert(BinaryInst::create_mul(q, get_int(divisor), bb_, m));
+    return insert(BinaryInst::create_sub(x, prod, bb_, m));
+}
+
+Ptr<Value> DivRemLowering::add_rounding_bias(Ptr<Value> x, int k) {
+    auto m = module.lock();
+    // x + (x < 0 ? 2^k - 1 : 0): the sign bits of x shifted down to the low k bits
+    Ptr<Value> sign = x;
+    if (k > 1) {
+        sign = insert(BinaryInst::create_ashr(x, get_int(k - 1), bb_, m));
+    }
+    auto bias = insert(BinaryInst::create_lshr(sign, get_int(32 - k), bb_, m));
+    return insert(BinaryInst::create_add(x, bias, bb_, m));
+}
+
+Ptr<Value> DivRemLowering::lower_pow2_div(Ptr<Value> x, int divisor) {
+    auto m = module.lock();
+    unsigned abs_divisor = abs_value(divisor);
+    int k = log2_exact(abs_divisor);
+    auto biased = add_rounding_bias(x, k);
+    Ptr<Value> q = insert(BinaryInst::create_ashr(biased, get_int(k), bb_, m));
+    if (divisor < 0) {
+        q = insert(BinaryInst::create_sub(get_int(0), q, bb_, m));
+    }
+    return q;
+}
+
+Ptr<Value> DivRemLowering::lower_pow2_rem(Ptr<Value> x, int divisor) {
+    auto m = module.lock();
+    unsigned abs_divisor = abs_value(divisor);
+    int k = log2_exact(abs_divisor);
+    // the remainder takes the sign of x, so x - ((x + bias) & -2^k)
+    auto biased = add_rounding_bias(x, k);
+    auto rounded = insert(BinaryInst::create_and(biased, get_int(static_cast<int>(0u - abs_divisor)), bb_, m));
+    return insert(BinaryInst::create_sub(x, rounded, bb_, m));
+}
+
+Ptr<Value> DivRemLowering::lower_magic_div(Ptr<Value> x, int divisor) {
+    auto m = module.lock();
+    auto i64 = m->get_int64_type();
+    auto magic = signed_magic(divisor);
+    // high 32 bits of the signed 64 bit product
+    auto wide = insert(SextInst::create_sext(x, i64, bb_));
+    auto prod = insert(BinaryInst::create_mul(wide, ConstantInt::create(i64, magic.multiplier, m), bb_, m));
+    auto high = insert(BinaryInst::create_ashr(prod, ConstantInt::create(i64, 32, m), bb_, m));
+    Ptr<Value> q = insert(TruncInst::create_trunc(high, m->get_int32_type(), bb_));
+    if (divisor > 0 && magic.multiplier < 0) {
+        q = insert(BinaryInst::create_add(q, x, bb_, m));
+    }
+    else if (divisor < 0 && magic.multiplier > 0) {
+        q = insert(BinaryInst::create_sub(q, x, bb_, m));
+    }
+    if (magic.shift > 0) {
+        q = insert(BinaryInst::create_ashr(q, get_int(magic.shift), bb_, m));
+    }
+    // add one to negative quotients to round toward zero
+    auto sign = insert(BinaryInst::create_lshr(q, get_int(31), bb_, m));
+    return insert(BinaryInst::create_add(q, sign, bb_, m));
+}
+
+}
+}
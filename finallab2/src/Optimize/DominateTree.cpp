@@ -3,113 +3,276 @@
 #include "Pass.h"
 #include "DominateTree.h"
 #include "internal_types.h"
+#include <algorithm>
 
 namespace SysYF {
 namespace IR {
 
-void DominateTree::execute() {
+bool DominateTree::execute() {
     for (auto f: module.lock()->get_functions()) {
-        if (f->get_basic_blocks().empty()) {
-            continue;
+        if (!f->get_basic_blocks().empty()) {
+            run(f);
         }
-        get_bb_idom(f);
-        get_bb_dom_front(f);
     }
+    return false;
 }
 
-void DominateTree::get_post_order(Ptr<BasicBlock> bb, PtrSet<BasicBlock> &visited) {
-    visited.insert(bb);
-    auto children = bb->get_succ_basic_blocks();
-    for (auto child: children) {
-        auto is_visited = visited.find(child.lock());
-        if (is_visited == visited.end()) {
-            get_post_order(child.lock(), visited);
-        }
+void DominateTree::run(Ptr<Function> f) {
+    for (auto bb: f->get_basic_blocks()) {
+        bb->set_idom(nullptr);
+        bb->get_dom_children().clear();
+        bb->clear_dom_frontier();
+        bb->set_dom_order(-1, -1);
     }
-    bb2int[bb] = reverse_post_order.size();
-    reverse_post_order.push_back(bb);
+    // the entry is its own idom
+    auto entry = f->get_entry_block();
+    entry->set_idom(entry);
+    update_subtree(entry, 0, -1);
+    number_tree(entry, 0);
 }
 
-void DominateTree::get_revserse_post_order(Ptr<Function> f) {
-    doms.clear();
-    reverse_post_order.clear();
-    bb2int.clear();
+void DominateTree::apply_updates(Ptr<Function> f, const std::vector<Update> &updates) {
     auto entry = f->get_entry_block();
-    PtrSet<BasicBlock> visited = {};
-    get_post_order(entry, visited);
-    reverse_post_order.reverse();
+    if (entry->get_dom_in() < 0) {
+        run(f);
+        return;
+    }
+    // the ends of the changed edges that were reachable, and the blocks an
+    // inserted edge makes reachable lead to; all of them get a new idom or
+    // frontier only below their nearest common dominator
+    PtrVec<BasicBlock> ends;
+    SmallPtrSet<BasicBlock *, 8> reached;
+    PtrVec<BasicBlock> stack;
+    for (auto &update: updates) {
+        if (update.from->get_dom_in() < 0) {
+            continue;
+        }
+        ends.push_back(update.from);
+        if (update.to->get_dom_in() >= 0) {
+            ends.push_back(update.to);
+        } else if (update.kind == Update::Insert && reached.insert(update.to.get()).second) {
+            stack.push_back(update.to);
+        }
+    }
+    while (!stack.empty()) {
+        auto bb = stack.back();
+        stack.pop_back();
+        for (auto &succ: bb->get_succ_basic_blocks()) {
+            auto succ_bb = succ.lock();
+            if (succ_bb->get_dom_in() >= 0) {
+                ends.push_back(succ_bb);
+            } else if (reached.insert(succ_bb.get()).second) {
+                stack.push_back(succ_bb);
+            }
+        }
+    }
+    if (ends.empty()) {
+        return;
+    }
+
+    auto root = ends.front();
+    // false when an idom on the way up was deleted, the old tree is of no use then
+    auto climb_to = [&](Ptr<BasicBlock> bb) {
+        while (!dominates(root, bb)) {
+            root = root->get_idom().lock();
+            if (!root) {
+                return false;
+            }
+        }
+        return true;
+    };
+    for (auto bb: ends) {
+        if (!climb_to(bb)) {
+            run(f);
+            return;
+        }
+    }
+    // a block of the subtree that is no longer reached takes away its edges
+    // to the blocks outside, whose idoms may change as well
+    PtrVec<BasicBlock> dead;
+    while (true) {
+        int lo = root->get_dom_in(), hi = root->get_dom_out();
+        get_reverse_post_order(root, lo, hi);
+        dead.clear();
+        PtrVec<BasicBlock> outside;
+        for (auto bb: f->get_basic_blocks()) {
+            int in = bb->get_dom_in();
+            if (in < lo || in > hi || bb2int.count(bb.get())) {
+                continue;
+            }
+            dead.push_back(bb);
+            for (auto &succ: bb->get_succ_basic_blocks()) {
+                int succ_in = succ.lock()->get_dom_in();
+                if (succ_in >= 0 && (succ_in < lo || succ_in > hi)) {
+                    outside.push_back(succ.lock());
+                }
+            }
+        }
+        if (outside.empty()) {
+            break;
+        }
+        for (auto bb: outside) {
+            if (!climb_to(bb)) {
+                run(f);
+                return;
+            }
+        }
+    }
+
+    int lo = root->get_dom_in(), hi = root->get_dom_out();
+    update_subtree(root, lo, hi);
+    for (auto bb: dead) {
+        bb->set_idom(nullptr);
+        bb->get_dom_children().clear();
+        bb->clear_dom_frontier();
+        bb->set_dom_order(-1, -1);
+    }
+    // the numbers of the subtree are reused when it did not grow
+    if (number_tree(root, lo) - 1 > hi) {
+        number_tree(entry, 0);
+    }
 }
 
-//ref:https://www.cs.rice.edu/~keith/EMBED/dom.pdf
-void DominateTree::get_bb_idom(Ptr<Function> f) {
-    get_revserse_post_order(f);
+void DominateTree::update_subtree(Ptr<BasicBlock> root, int lo, int hi) {
+    get_reverse_post_order(root, lo, hi);
+    for (auto bb: reverse_post_order) {
+        bb->get_dom_children().clear();
+        bb->clear_dom_frontier();
+    }
+    get_bb_idom();
+    get_bb_dom_front();
+}
 
-    auto root = f->get_entry_block();
-    auto root_id = bb2int[root];
-    for(int i = 0;i < root_id;i++){
-        doms.push_back({});
+bool DominateTree::dominates(Ptr<BasicBlock> a, Ptr<BasicBlock> b) {
+    if (b->get_dom_in() < 0) {
+        return true;
     }
+    if (a->get_dom_in() < 0) {
+        return false;
+    }
+    return a->get_dom_in() <= b->get_dom_in() && b->get_dom_out() <= a->get_dom_out();
+}
 
-    doms.push_back(root);
+bool DominateTree::dominates(Ptr<Instruction> a, Ptr<Instruction> b) {
+    auto bb = a->get_parent();
+    if (bb != b->get_parent()) {
+        return dominates(bb, b->get_parent());
+    }
+    return bb->get_instructions().comes_before(a, b);
+}
+
+void DominateTree::get_reverse_post_order(Ptr<BasicBlock> root, int lo, int hi) {
+    reverse_post_order.clear();
+    bb2int.clear();
+    auto takes_part = [&](Ptr<BasicBlock> bb) {
+        int in = bb->get_dom_in();
+        return in < 0 || (lo <= in && in <= hi);
+    };
+    // a block and the index of its next successor, a recursion would overflow the stack on long CFGs
+    std::vector<std::pair<Ptr<BasicBlock>, unsigned>> stack;
+    SmallPtrSet<BasicBlock *, 32> visited;
+    visited.insert(root.get());
+    stack.push_back({root, 0});
+    while (!stack.empty()) {
+        auto bb = stack.back().first;
+        auto &succs = bb->get_succ_basic_blocks();
+        if (stack.back().second < succs.size()) {
+            auto succ = succs[stack.back().second++].lock();
+            if (takes_part(succ) && visited.insert(succ.get()).second) {
+                stack.push_back({succ, 0});
+            }
+        } else {
+            reverse_post_order.push_back(bb);
+            stack.pop_back();
+        }
+    }
+    std::reverse(reverse_post_order.begin(), reverse_post_order.end());
+    for (int i = 0; i < static_cast<int>(reverse_post_order.size()); i++) {
+        bb2int[reverse_post_order[i].get()] = i;
+    }
+}
+
+//ref:https://www.cs.rice.edu/~keith/EMBED/dom.pdf
+void DominateTree::get_bb_idom() {
+    int num = reverse_post_order.size();
+    doms.assign(num, -1);
+    doms[0] = 0;
 
     bool changed = true;
-    while(changed){
+    while (changed) {
         changed = false;
-        for(auto bb:reverse_post_order){
-            if(bb.lock() == root){
-                continue;
-            }
-            auto preds = bb.lock()->get_pre_basic_blocks();
-            Ptr<BasicBlock> new_idom = nullptr;
-            for(auto pred_bb:preds){
-                if(doms[bb2int[pred_bb.lock()]].lock() != nullptr){
-                    new_idom = pred_bb.lock();
-                    break;
-                }
-            }
-            for(auto pred_bb:preds){
-                if(doms[bb2int[pred_bb.lock()]].lock() != nullptr){
-                    new_idom = intersect(pred_bb.lock(),new_idom);
+        for (int i = 1; i < num; i++) {
+            int new_idom = -1;
+            for (auto &pred: reverse_post_order[i]->get_pre_basic_blocks()) {
+                auto iter = bb2int.find(pred.lock().get());
+                if (iter == bb2int.end() || doms[iter->second] < 0) {
+                    continue;
                 }
+                new_idom = new_idom < 0 ? iter->second : intersect(iter->second, new_idom);
             }
-            if(doms[bb2int[bb]].lock() != new_idom){
-                doms[bb2int[bb]] = new_idom;
+            if (doms[i] != new_idom) {
+                doms[i] = new_idom;
                 changed = true;
             }
         }
     }
 
-    for(auto bb:reverse_post_order){
-        bb.lock()->set_idom(doms[bb2int[bb]].lock()); }
+    for (int i = 1; i < num; i++) {
+        auto idom = reverse_post_order[doms[i]];
+        reverse_post_order[i]->set_idom(idom);
+        idom->get_dom_children().push_back(reverse_post_order[i]);
+    }
 }
 
-void DominateTree::get_bb_dom_front(Ptr<Function> f) {
-    for(auto b:f->get_basic_blocks()){
-        auto b_pred = b->get_pre_basic_blocks();
-        if(b_pred.size() >= 2){
-            for(auto pred:b_pred){
-                auto runner = pred;
-                while(runner.lock()!=doms[bb2int[b]].lock()){
-                    runner.lock()->add_dom_frontier(b);
-                    runner = doms[bb2int[runner.lock()]];
+void DominateTree::get_bb_dom_front() {
+    // b is in the frontier of the blocks from a predecessor up to, but not
+    // including, the idom of b; the root stops the walk when that idom is above it
+    for (int i = 0; i < static_cast<int>(reverse_post_order.size()); i++) {
+        for (auto &succ: reverse_post_order[i]->get_succ_basic_blocks()) {
+            auto b = succ.lock();
+            auto iter = bb2int.find(b->get_idom().lock().get());
+            int stop = iter == bb2int.end() ? -1 : iter->second;
+            for (int runner = i; runner != stop; runner = doms[runner]) {
+                reverse_post_order[runner]->add_dom_frontier(b);
+                if (runner == 0) {
+                    break;
                 }
             }
         }
     }
 }
 
-Ptr<BasicBlock> DominateTree::intersect(Ptr<BasicBlock> b1, Ptr<BasicBlock> b2) {
-    auto finger1 = b1;
-    auto finger2 = b2;
-    while(finger1 != finger2){
-        while(bb2int[finger1]<bb2int[finger2]){
-            finger1 = doms[bb2int[finger1]].lock();
+int DominateTree::number_tree(Ptr<BasicBlock> root, int counter) {
+    // a block and the index of its next child
+    std::vector<std::pair<Ptr<BasicBlock>, unsigned>> stack;
+    root->set_dom_order(counter++, -1);
+    stack.push_back({root, 0});
+    while (!stack.empty()) {
+        auto bb = stack.back().first;
+        auto &children = bb->get_dom_children();
+        if (stack.back().second < children.size()) {
+            auto child = children[stack.back().second++].lock();
+            child->set_dom_order(counter++, -1);
+            stack.push_back({child, 0});
+        } else {
+            bb->set_dom_order(bb->get_dom_in(), counter++);
+            stack.pop_back();
+        }
+    }
+    return counter;
+}
+
+int DominateTree::intersect(int b1, int b2) {
+    // positions in reverse post order, an idom comes before the blocks it dominates
+    while (b1 != b2) {
+        while (b1 > b2) {
+            b1 = doms[b1];
         }
-        while(bb2int[finger2]<bb2int[finger1]){
-            finger2 = doms[bb2int[finger2]].lock();
+        while (b2 > b1) {
+            b2 = doms[b2];
         }
     }
-    return finger1;
+    return b1;
 }
 
 }
@@ -0,0 +1,101 @@
+#include "FinalValueReplacement.h"
+#include "Remarks.h"
+#include "Statistics.h"
+
+namespace SysYF {
+namespace IR {
+
+static Statistic num_deleted("FinalValueReplacement", "loops replaced by their final values");
+
+bool FinalValueReplacement::execute() {
+    bool changed = false;
+    for (auto f : module.lock()->get_functions()) {
+        // deleting a loop may leave its parent with nothing to do as well, start over
+        bool replaced = true;
+        while (replaced) {
+            replaced = false;
+            for (auto bb : f->get_basic_blocks()) {
+                if (replace_loop(bb)) {
+                    replaced = true;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+    return changed;
+}
+
+bool FinalValueReplacement::replace_loop(Ptr<BasicBlock> header) {
+    ScalarEvolution::Loop loop;
+    if (!ScalarEvolution::find_loop(header, loop)) {
+        return false;
+    }
+    for (auto bb : loop.blocks) {
+        for (auto inst : bb->get_instructions()) {
+            if (inst->is_store() || inst->is_call()) {
+                return false;
+            }
+        }
+    }
+
+    auto m = module.lock();
+    ScalarEvolution scev(m);
+    scev.set_loop(loop);
+    ScalarEvolution::TripCount trip;
+    if (!scev.get_trip_count(trip)) {
+        return false;
+    }
+    // only the header dominates the exit, so only its values can be used after the loop
+    std::vector<std::pair<Ptr<Instruction>, ScalarEvolution::AddRec>> live_outs;
+    for (auto inst : header->get_instructions()) {
+        bool is_live_out = false;
+        for (auto &use : inst->get_use_list()) {
+            auto user = use.val_.lock()->as<Instruction>();
+            if (!loop.blocks.count(user->get_parent())) {
+                is_live_out = true;
+            }
+        }
+        ScalarEvolution::AddRec rec;
+        if (!is_live_out) {
+            continue;
+        }
+        if (!scev.get_scev(inst, rec) || !ScalarEvolution::is_expandable(rec, trip)) {
+            Remark::emit(Remark(Remark::Missed, name, "NotReplaced", inst)
+                             .arg("Loop", header)
+                             .arg("Reason", "a value used after the loop is no recurrence with a closed form"));
+            return false;
+        }
+        live_outs.push_back({inst, rec});
+    }
+
+    ++num_deleted;
+    Remark::emit(Remark(Remark::Passed, name, "Replaced", header)
+                     .arg("LiveOuts", static_cast<int>(live_outs.size())));
+    auto pre_br = loop.preheader->get_terminator();
+    for (auto &live_out : live_outs) {
+        live_out.first->replace_all_use_with(scev.expand_exit_value(live_out.second, trip, pre_br));
+    }
+    for (auto inst : loop.exit->get_instructions()) {
+        if (!inst->is_phi()) {
+            break;
+        }
+        inst->set_operand(1, loop.preheader);
+    }
+
+    // the uses inside the loop go away with it
+    for (auto bb : loop.blocks) {
+        for (auto inst : bb->get_instructions()) {
+            inst->remove_use_of_ops();
+        }
+    }
+    for (auto bb : loop.blocks) {
+        bb->erase_from_parent();
+    }
+    loop.preheader->delete_instr(pre_br);
+    BranchInst::create_br(loop.exit, loop.preheader);
+    return true;
+}
+
+}
+}
@@ -0,0 +1,199 @@
+#include "GlobalDCE.h"
+#include "BasicBlock.h"
+#include "Remarks.h"
+#include "Statistics.h"
+#include <algorithm>
+
+namespace SysYF {
+namespace IR {
+
+static Statistic num_functions("GlobalDCE", "functions removed");
+static Statistic num_args("GlobalDCE", "arguments removed");
+static Statistic num_globals("GlobalDCE", "globals removed");
+
+bool GlobalDCE::execute() {
+    bool changed = remove_dead_functions();
+    changed |= remove_dead_args();
+    changed |= remove_dead_globals();
+    return changed;
+}
+
+bool GlobalDCE::remove_dead_functions() {
+    auto m = module.lock();
+    std::set<Ptr<Function>> live;
+    PtrVec<Function> worklist;
+    for (auto f : m->get_functions()) {
+        if (f->get_name() == "main") {
+            live.insert(f);
+            worklist.push_back(f);
+        }
+    }
+    if (worklist.empty()) {
+        // not a whole program, nothing is known to be dead
+        return false;
+    }
+    while (!worklist.empty()) {
+        auto f = worklist.back();
+        worklist.pop_back();
+        for (auto bb : f->get_basic_blocks()) {
+            for (auto inst : bb->get_instructions()) {
+                if (!inst->is_call()) {
+                    continue;
+                }
+                auto callee = inst->get_operand(0)->as<Function>();
+                if (live.insert(callee).second) {
+                    worklist.push_back(callee);
+                }
+            }
+        }
+    }
+
+    PtrVec<Function> dead;
+    for (auto f : m->get_functions()) {
+        if (live.find(f) == live.end()) {
+            dead.push_back(f);
+        }
+    }
+    // drop the uses first, dead functions may still refer to each other
+    for (auto f : dead) {
+        for (auto bb : f->get_basic_blocks()) {
+            for (auto inst : bb->get_instructions()) {
+                inst->remove_use_of_ops();
+            }
+        }
+    }
+    for (auto f : dead) {
+        ++num_functions;
+        // declarations of library functions that are not called are not worth a remark
+        if (!f->is_declaration()) {
+            Remark::emit(Remark(Remark::Passed, name, "FunctionRemoved", f));
+        }
+        m->remove_function(f);
+    }
+    return !dead.empty();
+}
+
+bool GlobalDCE::is_write_only(Ptr<Value> ptr, PtrVec<Instruction> &writes) {
+    for (auto use : ptr->get_use_list()) {
+        auto user = dyn_cast<Instruction>(use.val_.lock());
+        if (!user) {
+            return false;
+        }
+        if (user->is_store() && use.arg_no_ == 1) {
+            writes.push_back(user);
+        } else if (user->is_gep() && use.arg_no_ == 0) {
+            if (!is_write_only(user, writes)) {
+                return false;
+            }
+            writes.push_back(user);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool GlobalDCE::remove_dead_globals() {
+    auto m = module.lock();
+    PtrVec<GlobalVariable> dead;
+    for (auto global : m->get_global_variable()) {
+        PtrVec<Instruction> writes;
+        if (!is_write_only(global, writes)) {
+            continue;
+        }
+        // stores come before the geps they write through
+        for (auto inst : writes) {
+            inst->get_parent()->delete_instr(inst);
+        }
+        dead.push_back(global);
+    }
+    num_globals += dead.size();
+    for (auto global : dead) {
+        m->remove_global_variable(global);
+    }
+    return !dead.empty();
+}
+
+bool GlobalDCE::remove_dead_args() {
+    bool changed = false;
+    auto m = module.lock();
+    std::map<Ptr<Function>, PtrVec<CallInst>> call_sites;
+    for (auto f : m->get_functions()) {
+        for (auto bb : f->get_basic_blocks()) {
+            for (auto inst : bb->get_instructions()) {
+                if (inst->is_call()) {
+                    auto callee = inst->get_operand(0)->as<Function>();
+                    call_sites[callee].push_back(static_pointer_cast<CallInst>(inst));
+                }
+            }
+        }
+    }
+    // recreated functions are appended to the list, don't visit them
+    auto funcs = m->get_functions();
+    for (auto f : funcs) {
+        if (f->is_declaration() || f->get_name() == "main") {
+            continue;
+        }
+        std::vector<bool> is_dead;
+        for (auto arg : f->get_args()) {
+            is_dead.push_back(arg->get_use_list().empty());
+        }
+        if (std::find(is_dead.begin(), is_dead.end(), true) == is_dead.end()) {
+            continue;
+        }
+        auto dead_num = std::count(is_dead.begin(), is_dead.end(), true);
+        num_args += dead_num;
+        Remark::emit(Remark(Remark::Passed, name, "ArgumentsRemoved", f).arg("Count", static_cast<int>(dead_num)));
+        auto new_f = drop_args(f, is_dead, call_sites[f]);
+        call_sites[new_f] = call_sites[f];
+        call_sites.erase(f);
+        changed = true;
+    }
+    return changed;
+}
+
+Ptr<Function> GlobalDCE::drop_args(Ptr<Function> f, const std::vector<bool> &is_dead, PtrVec<CallInst> &calls) {
+    auto m = module.lock();
+    auto func_ty = f->get_function_type();
+    PtrVec<Type> params;
+    for (unsigned i = 0; i < func_ty->get_num_of_args(); i++) {
+        if (!is_dead[i]) {
+            params.push_back(func_ty->get_param_type(i));
+        }
+    }
+    auto new_f = Function::create(FunctionType::create(f->get_return_type(), params, m), f->get_name(), m);
+    new_f->move_basic_blocks_from(f);
+    auto new_arg = new_f->arg_begin();
+    for (auto arg : f->get_args()) {
+        if (is_dead[arg->get_arg_no()]) {
+            continue;
+        }
+        (*new_arg)->set_name(arg->get_name());
+        arg->replace_all_use_with(*new_arg);
+        new_arg++;
+    }
+
+    PtrVec<CallInst> new_calls;
+    for (auto call : calls) {
+        PtrVec<Value> args;
+        for (unsigned i = 1; i < call->get_num_operand(); i++) {
+            if (!is_dead[i - 1]) {
+                args.push_back(call->get_operand(i));
+            }
+        }
+        auto bb = call->get_parent();
+        // create appends to bb, move the new call to where the old one is
+        auto new_call = CallInst::create(new_f, args, bb);
+        new_call->insert_before(call);
+        new_call->set_name(call->get_name());
+        call->replace_all_use_with(new_call);
+        bb->delete_instr(call);
+        new_calls.push_back(new_call);
+    }
+    calls = new_calls;
+    m->remove_function(f);
+    return new_f;
+}
+
+}
+}
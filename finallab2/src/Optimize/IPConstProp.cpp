@@ -0,0 +1,281 @@
+#include "IPConstProp.h"
+#include "CFGUtils.h"
+#include "CloneUtils.h"
+#include "ConstantFolder.h"
+#include "Remarks.h"
+#include "Statistics.h"
+#include <algorithm>
+#include <cmath>
+
+namespace SysYF {
+namespace IR {
+
+static Statistic num_args("IPConstProp", "arguments replaced by constants");
+static Statistic num_specialized("IPConstProp", "functions specialized");
+
+bool IPConstProp::execute() {
+    bool changed = false;
+    call_sites.clear();
+    clone_budget = max_clone_budget;
+    for (auto f : module.lock()->get_functions()) {
+        collect_call_sites(f);
+    }
+    // specializations are appended to the function list, don't visit them
+    auto funcs = module.lock()->get_functions();
+    for (auto f : funcs) {
+        if (f->is_declaration() || f->get_name() == "main" || call_sites[f].empty()) {
+            continue;
+        }
+        bool propagated = propagate_uniform_args(f);
+        propagated |= specialize(f);
+        if (propagated) {
+            simplify(f);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+bool IPConstProp::set_option(const std::string &key, const std::string &value) {
+    int budget = 0;
+    if (key == "clone-budget" && parse_int(value, budget)) {
+        max_clone_budget = budget;
+        return true;
+    }
+    return false;
+}
+
+void IPConstProp::collect_call_sites(Ptr<Function> f) {
+    for (auto bb : f->get_basic_blocks()) {
+        for (auto inst : bb->get_instructions()) {
+            if (inst->is_call()) {
+                auto callee = inst->get_operand(0)->as<Function>();
+                call_sites[callee].push_back(static_pointer_cast<CallInst>(inst));
+            }
+        }
+    }
+}
+
+bool IPConstProp::is_same_constant(Ptr<Value> a, Ptr<Value> b) {
+    auto int_a = dyn_cast<ConstantInt>(a);
+    auto int_b = dyn_cast<ConstantInt>(b);
+    if (int_a && int_b) {
+        return int_a->get_value() == int_b->get_value();
+    }
+    auto fp_a = dyn_cast<ConstantFloat>(a);
+    auto fp_b = dyn_cast<ConstantFloat>(b);
+    if (fp_a && fp_b) {
+        // 0.0 and -0.0 compare equal but are different arguments
+        return fp_a->get_value() == fp_b->get_value() &&
+               std::signbit(fp_a->get_value()) == std::signbit(fp_b->get_value());
+    }
+    return false;
+}
+
+bool IPConstProp::is_interesting_arg(Ptr<Argument> arg) {
+    // an argument that is only forwarded to other calls gains nothing from a clone
+    for (auto use : arg->get_use_list()) {
+        auto user = dyn_cast<Instruction>(use.val_.lock());
+        if (user && !user->is_call()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void IPConstProp::simplify(Ptr<Function> f) {
+    fold_constants(f);
+    bool folded_any = false;
+    while (true) {
+        bool folded = false;
+        for (auto bb : f->get_basic_blocks()) {
+            folded |= fold_constant_branch(bb) != nullptr;
+        }
+        if (!folded) {
+            break;
+        }
+        folded_any = true;
+        // the calls in the arms not taken are no call sites anymore
+        auto reachable = get_reverse_post_order(f);
+        std::set<Ptr<BasicBlock>> live(reachable.begin(), reachable.end());
+        for (auto bb : f->get_basic_blocks()) {
+            if (live.count(bb)) {
+                continue;
+            }
+            for (auto inst : bb->get_instructions()) {
+                if (inst->is_call()) {
+                    auto &sites = call_sites[inst->get_operand(0)->as<Function>()];
+                    sites.erase(std::remove(sites.begin(), sites.end(), inst), sites.end());
+                }
+            }
+        }
+        remove_unreachable_blocks(f);
+        // a phi left with one constant is that constant, which may decide further branches
+        for (auto bb : f->get_basic_blocks()) {
+            PtrVec<Instruction> phis;
+            for (auto inst : bb->get_instructions()) {
+                if (!inst->is_phi()) {
+                    break;
+                }
+                phis.push_back(inst);
+            }
+            for (auto phi : phis) {
+                auto val = phi->get_operand(0);
+                bool same = isa<Constant>(val);
+                for (unsigned i = 2; i < phi->get_num_operand(); i += 2) {
+                    same = same && phi->get_operand(i) == val;
+                }
+                if (same) {
+                    phi->replace_all_use_with(val);
+                    bb->delete_instr(phi);
+                }
+            }
+        }
+        fold_constants(f);
+    }
+    if (folded_any) {
+        // what is left of a chain of decided branches is a chain of jumps
+        for (auto bb : PtrVec<BasicBlock>(f->get_basic_blocks().begin(), f->get_basic_blocks().end())) {
+            merge_into_predecessor(bb);
+        }
+    }
+}
+
+unsigned IPConstProp::get_instr_count(Ptr<Function> f) {
+    unsigned cnt = 0;
+    for (auto bb : f->get_basic_blocks()) {
+        cnt += bb->get_num_of_instr();
+    }
+    return cnt;
+}
+
+bool IPConstProp::propagate_uniform_args(Ptr<Function> f) {
+    auto &sites = call_sites[f];
+    bool changed = false;
+    for (auto arg : f->get_args()) {
+        if (arg->get_use_list().empty()) {
+            continue;
+        }
+        auto arg_no = arg->get_arg_no();
+        auto first = sites.front()->get_operand(arg_no + 1);
+        if (!isa<ConstantInt>(first) && !isa<ConstantFloat>(first)) {
+            continue;
+        }
+        bool uniform = true;
+        for (auto call : sites) {
+            if (!is_same_constant(first, call->get_operand(arg_no + 1))) {
+                uniform = false;
+                break;
+            }
+        }
+        if (uniform) {
+            ++num_args;
+            Remark::emit(Remark(Remark::Passed, name, "ArgumentPropagated", f)
+                             .arg("Argument", arg).arg("Constant", first));
+            arg->replace_all_use_with(first);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+IPConstProp::ArgBinding IPConstProp::get_binding(Ptr<Function> f, Ptr<CallInst> call) {
+    ArgBinding binding;
+    for (auto arg : f->get_args()) {
+        auto arg_no = arg->get_arg_no();
+        auto actual = call->get_operand(arg_no + 1);
+        bool is_const = dyn_cast<ConstantInt>(actual) || dyn_cast<ConstantFloat>(actual);
+        if (is_const && is_interesting_arg(arg)) {
+            binding.emplace_back(arg_no, static_pointer_cast<Constant>(actual));
+        }
+    }
+    return binding;
+}
+
+bool IPConstProp::specialize(Ptr<Function> f) {
+    auto size = get_instr_count(f);
+    if (size > max_spec_func_size) {
+        return false;
+    }
+    // cloning a self recursive function only peels one level of the recursion
+    for (auto call : call_sites[f]) {
+        if (call->get_function() == f) {
+            return false;
+        }
+    }
+
+    std::vector<std::pair<ArgBinding, PtrVec<CallInst>>> groups;
+    for (auto call : call_sites[f]) {
+        auto binding = get_binding(f, call);
+        if (binding.empty()) {
+            continue;
+        }
+        auto same_binding = [&binding](const std::pair<ArgBinding, PtrVec<CallInst>> &group) {
+            if (group.first.size() != binding.size()) {
+                return false;
+            }
+            for (unsigned i = 0; i < binding.size(); i++) {
+                if (group.first[i].first != binding[i].first ||
+                    !is_same_constant(group.first[i].second, binding[i].second)) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        auto iter = std::find_if(groups.begin(), groups.end(), same_binding);
+        if (iter == groups.end()) {
+            groups.emplace_back(binding, PtrVec<CallInst>{call});
+        } else {
+            iter->second.push_back(call);
+        }
+    }
+    // the bindings shared by most call sites are worth the most
+    std::stable_sort(groups.begin(), groups.end(), [](const auto &a, const auto &b) {
+        return a.second.size() > b.second.size();
+    });
+
+    unsigned spec_num = 0;
+    for (auto &group : groups) {
+        if (spec_num == max_spec_per_func || clone_budget < size) {
+            Remark::emit(Remark(Remark::Missed, name, "NotSpecialized", f)
+                             .arg("Reason", spec_num == max_spec_per_func ? "the function has enough specializations"
+                                                                           : "the clone budget is used up")
+                             .arg("Calls", static_cast<int>(group.second.size())));
+            break;
+        }
+        auto spec = create_specialization(f, group.first);
+        ++num_specialized;
+        Remark::emit(Remark(Remark::Passed, name, "Specialized", f)
+                         .arg("Clone", spec).arg("Calls", static_cast<int>(group.second.size())));
+        for (auto call : group.second) {
+            call->set_operand(0, spec);
+        }
+        auto &sites = call_sites[f];
+        sites.erase(std::remove_if(sites.begin(), sites.end(), [&group](const Ptr<CallInst> &call) {
+            return std::find(group.second.begin(), group.second.end(), call) != group.second.end();
+        }), sites.end());
+        call_sites[spec] = group.second;
+        clone_budget -= size;
+        spec_num++;
+    }
+    return spec_num > 0;
+}
+
+Ptr<Function> IPConstProp::create_specialization(Ptr<Function> f, const ArgBinding &binding) {
+    auto m = module.lock();
+    // a rerun of the pass must not reuse the name of an earlier specialization
+    auto spec = Function::create(f->get_function_type(), get_unique_function_name(m, f->get_name() + ".spec."), m);
+    ValueMap vmap;
+    clone_function_body(f, spec, vmap);
+    for (auto &arg_const : binding) {
+        auto arg = std::next(spec->arg_begin(), arg_const.first);
+        (*arg)->replace_all_use_with(arg_const.second);
+    }
+    simplify(spec);
+    // calls made by the clone are call sites too
+    collect_call_sites(spec);
+    return spec;
+}
+
+}
+}
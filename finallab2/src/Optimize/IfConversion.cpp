@@ -0,0 +1,189 @@
+#include "IfConversion.h"
+#include "Remarks.h"
+#include "Statistics.h"
+#include <algorithm>
+
+namespace SysYF {
+namespace IR {
+
+static Statistic num_converted("IfConversion", "branches converted to selects");
+
+bool IfConversion::execute() {
+    bool changed = false;
+    for (auto f : module.lock()->get_functions()) {
+        bool converted = true;
+        while (converted) {
+            converted = false;
+            // converting removes blocks, so start over after every change
+            for (auto bb : f->get_basic_blocks()) {
+                if (convert(bb)) {
+                    converted = true;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+    return changed;
+}
+
+Ptr<BasicBlock> IfConversion::get_single_succ(Ptr<BasicBlock> bb) {
+    auto term = bb->get_terminator();
+    if (!term || !term->is_br() || term->get_num_operand() != 1) {
+        return nullptr;
+    }
+    return term->get_operand(0)->as<BasicBlock>();
+}
+
+bool IfConversion::is_speculatable(Ptr<Instruction> inst) {
+    // divisions may trap on a zero divisor that the branch guarded against
+    if (inst->isBinary()) {
+        return !inst->is_div() && !inst->is_rem() && !inst->is_udiv() && !inst->is_urem();
+    }
+    return inst->is_cmp() || inst->is_fcmp() || inst->is_zext() || inst->is_sext() || inst->is_trunc() ||
+           inst->is_sitofp() || inst->is_fptosi() || inst->is_select();
+}
+
+bool IfConversion::is_side_block(Ptr<BasicBlock> bb, Ptr<BasicBlock> head, Ptr<BasicBlock> join) {
+    if (bb == head || bb == join || get_single_succ(bb) != join) {
+        return false;
+    }
+    auto &pre_bbs = bb->get_pre_basic_blocks();
+    if (pre_bbs.size() != 1 || pre_bbs.front().lock() != head) {
+        return false;
+    }
+    if (bb->get_num_of_instr() - 1 > max_side_size) {
+        return false;
+    }
+    for (auto inst : bb->get_instructions()) {
+        if (!inst->isTerminator() && !is_speculatable(inst)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool IfConversion::convert(Ptr<BasicBlock> head) {
+    auto br = head->get_terminator();
+    if (!br || !br->is_br() || br->get_num_operand() != 3) {
+        return false;
+    }
+    auto cond = br->get_operand(0);
+    auto true_bb = br->get_operand(1)->as<BasicBlock>();
+    auto false_bb = br->get_operand(2)->as<BasicBlock>();
+    if (true_bb == false_bb) {
+        return false;
+    }
+
+    // the blocks that join is entered from on the true and on the false path
+    Ptr<BasicBlock> join, true_in, false_in;
+    auto true_succ = get_single_succ(true_bb);
+    auto false_succ = get_single_succ(false_bb);
+    if (true_succ && true_succ == false_succ &&
+        is_side_block(true_bb, head, true_succ) && is_side_block(false_bb, head, false_succ)) {
+        join = true_succ;
+        true_in = true_bb;
+        false_in = false_bb;
+    }
+    else if (true_succ == false_bb && is_side_block(true_bb, head, false_bb)) {
+        join = false_bb;
+        true_in = true_bb;
+        false_in = head;
+    }
+    else if (false_succ == true_bb && is_side_block(false_bb, head, true_bb)) {
+        join = true_bb;
+        true_in = head;
+        false_in = false_bb;
+    }
+    else {
+        return false;
+    }
+    if (join == head) {
+        return false;
+    }
+
+    PtrVec<PhiInst> phis;
+    for (auto inst : join->get_instructions()) {
+        if (!inst->is_phi()) {
+            break;
+        }
+        phis.push_back(static_pointer_cast<PhiInst>(inst));
+    }
+    if (static_cast<int>(phis.size()) > max_side_size) {
+        Remark::emit(Remark(Remark::Missed, name, "NotConverted", br)
+                         .arg("Reason", "the join has more phis than a conversion may add selects for")
+                         .arg("Phis", static_cast<int>(phis.size())));
+        return false;
+    }
+
+    ++num_converted;
+    Remark::emit(Remark(Remark::Passed, name, "Converted", br).arg("Join", join));
+    // hoist the side blocks into head
+    PtrVec<BasicBlock> sides;
+    if (true_in != head) sides.push_back(true_in);
+    if (false_in != head) sides.push_back(false_in);
+    for (auto side : sides) {
+        auto &insts = side->get_instructions();
+        while (insts.front() != side->get_terminator()) {
+            insts.front()->insert_before(br);
+        }
+    }
+
+    // join keeps its other preds and is entered from head instead of the sides
+    int join_preds = 0;
+    for (auto &pre : join->get_pre_basic_blocks()) {
+        auto pre_bb = pre.lock();
+        if (pre_bb != true_in && pre_bb != false_in && pre_bb != head) {
+            join_preds++;
+        }
+    }
+    join_preds++;
+
+    // one select per phi merges the values of both paths; mem2reg leaves out
+    // the entries of the paths a variable is undefined on, any value will do there
+    for (auto phi : phis) {
+        int true_idx = -1, false_idx = -1;
+        for (unsigned i = 0; i < phi->get_num_operand(); i += 2) {
+            auto bb = phi->get_operand(i + 1);
+            if (bb == true_in) true_idx = i;
+            if (bb == false_in) false_idx = i;
+        }
+        if (true_idx < 0 && false_idx < 0) {
+            continue;
+        }
+        auto true_val = phi->get_operand(true_idx < 0 ? false_idx : true_idx);
+        auto false_val = phi->get_operand(false_idx < 0 ? true_idx : false_idx);
+        Ptr<Value> merged = true_val;
+        if (true_val != false_val) {
+            auto select = SelectInst::create_select(cond, true_val, false_val, head);
+            select->insert_before(br);
+            merged = select;
+        }
+        for (int idx : {std::max(true_idx, false_idx), std::min(true_idx, false_idx)}) {
+            if (idx >= 0) {
+                phi->remove_operands(idx, idx + 1);
+            }
+        }
+        phi->add_phi_pair_operand(merged, head);
+        if (join_preds == 1 && merged != phi) {
+            phi->replace_all_use_with(merged);
+            join->delete_instr(phi);
+        }
+    }
+
+    // head now falls through to join
+    head->delete_instr(br);
+    head->remove_succ_basic_block(true_bb);
+    head->remove_succ_basic_block(false_bb);
+    true_bb->remove_pre_basic_block(head);
+    false_bb->remove_pre_basic_block(head);
+    for (auto side : sides) {
+        side->delete_instr(side->get_terminator());
+        side->erase_from_parent();
+    }
+    BranchInst::create_br(join, head);
+    return true;
+}
+
+}
+}
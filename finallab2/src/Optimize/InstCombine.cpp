@@ -0,0 +1,452 @@
+#include "InstCombine.h"
+#include "ConstantFolder.h"
+#include "Remarks.h"
+#include "Statistics.h"
+#include <cmath>
+
+namespace SysYF {
+namespace IR {
+
+static Statistic num_combined("InstCombine", "instructions combined");
+static Statistic num_dead("InstCombine", "dead instructions erased");
+
+namespace {
+
+Ptr<ConstantInt> get_const_int(Ptr<Value> val) {
+    return dyn_cast<ConstantInt>(val);
+}
+
+bool is_const_int(Ptr<Value> val, int expected) {
+    auto c = get_const_int(val);
+    return c && c->get_value() == expected;
+}
+
+bool is_const_float(Ptr<Value> val, float expected) {
+    auto c = dyn_cast<ConstantFloat>(val);
+    return c && c->get_value() == expected && std::signbit(c->get_value()) == std::signbit(expected);
+}
+
+// a op b == b swap(op) a
+CmpInst::CmpOp swap_cmp_op(CmpInst::CmpOp op) {
+    switch (op) {
+        case CmpInst::GT: return CmpInst::LT;
+        case CmpInst::GE: return CmpInst::LE;
+        case CmpInst::LT: return CmpInst::GT;
+        case CmpInst::LE: return CmpInst::GE;
+        default: return op;
+    }
+}
+
+// !(a op b) == a inverse(op) b, only for integers
+CmpInst::CmpOp inverse_cmp_op(CmpInst::CmpOp op) {
+    switch (op) {
+        case CmpInst::EQ: return CmpInst::NE;
+        case CmpInst::NE: return CmpInst::EQ;
+        case CmpInst::GT: return CmpInst::LE;
+        case CmpInst::GE: return CmpInst::LT;
+        case CmpInst::LT: return CmpInst::GE;
+        case CmpInst::LE: return CmpInst::GT;
+        default: return op;
+    }
+}
+
+}
+
+InstCombine::InstCombine(WeakPtr<Module> m) : Pass(m) {
+    const std::vector<Instruction::OpID> int_binary = {
+        Instruction::add, Instruction::sub, Instruction::mul, Instruction::sdiv, Instruction::srem,
+        Instruction::udiv, Instruction::urem,
+        Instruction::shl, Instruction::ashr, Instruction::lshr,
+        Instruction::and_, Instruction::or_, Instruction::xor_};
+    const std::vector<Instruction::OpID> float_binary = {
+        Instruction::fadd, Instruction::fsub, Instruction::fmul, Instruction::fdiv};
+    const std::vector<Instruction::OpID> commutative = {
+        Instruction::add, Instruction::mul, Instruction::and_, Instruction::or_, Instruction::xor_,
+        Instruction::fadd, Instruction::fmul, Instruction::cmp, Instruction::fcmp};
+
+    std::vector<Instruction::OpID> foldable = int_binary;
+    foldable.insert(foldable.end(), float_binary.begin(), float_binary.end());
+    foldable.insert(foldable.end(), {Instruction::cmp, Instruction::fcmp, Instruction::zext, Instruction::sext,
+                                     Instruction::trunc, Instruction::sitofp, Instruction::fptosi});
+
+    // rules of an opcode are tried in the order they are added here
+    add_rule(foldable, "constant-fold", &InstCombine::fold_constant_operands);
+    add_rule(commutative, "constant-to-rhs", &InstCombine::move_constant_to_rhs);
+    add_rule(int_binary, "identity", &InstCombine::fold_identity);
+    add_rule(float_binary, "float-identity", &InstCombine::fold_float_identity);
+    add_rule({Instruction::sub, Instruction::and_, Instruction::or_, Instruction::xor_, Instruction::cmp, Instruction::fcmp},
+             "same-operands", &InstCombine::fold_same_operands);
+    add_rule({Instruction::sub}, "double-negation", &InstCombine::fold_double_negation);
+    add_rule({Instruction::add, Instruction::mul, Instruction::and_, Instruction::or_, Instruction::xor_},
+             "reassociate-constants", &InstCombine::reassociate_constants);
+    add_rule({Instruction::cmp}, "bool-compare", &InstCombine::fold_bool_compare);
+    add_rule({Instruction::cmp}, "compare-difference", &InstCombine::fold_compare_of_difference);
+    add_rule({Instruction::fptosi, Instruction::trunc}, "cast-round-trip", &InstCombine::fold_cast_round_trip);
+    add_rule({Instruction::select}, "select", &InstCombine::fold_select);
+}
+
+void InstCombine::add_rule(std::vector<Instruction::OpID> ops, std::string rule_name, RuleFn apply) {
+    for (auto op : ops) {
+        rules_[op].push_back({rule_name, apply});
+    }
+}
+
+bool InstCombine::execute() {
+    bool changed = false;
+    for (auto f : module.lock()->get_functions()) {
+        changed |= combine(f);
+    }
+    return changed;
+}
+
+bool InstCombine::combine(Ptr<Function> f) {
+    bool changed = false;
+    worklist_.clear();
+    in_worklist_.clear();
+    erased_.clear();
+    for (auto bb : f->get_basic_blocks()) {
+        for (auto inst : bb->get_instructions()) {
+            push(inst);
+        }
+    }
+    while (!worklist_.empty()) {
+        auto inst = worklist_.front();
+        worklist_.pop_front();
+        in_worklist_.erase(inst);
+        if (erased_.count(inst)) {
+            continue;
+        }
+        if (is_trivially_dead(inst)) {
+            ++num_dead;
+            erase(inst);
+            changed = true;
+            continue;
+        }
+        auto iter = rules_.find(inst->get_instr_type());
+        if (iter == rules_.end()) {
+            continue;
+        }
+        for (auto &rule : iter->second) {
+            auto res = (this->*rule.apply)(inst);
+            if (!res) {
+                continue;
+            }
+            ++num_combined;
+            Remark::emit(Remark(Remark::Passed, name, "Combined", inst).arg("Rule", rule.name).arg("Result", res));
+            changed = true;
+            push_users(inst);
+            if (res == inst) {
+                push(inst);
+            }
+            else {
+                inst->replace_all_use_with(res);
+                push(res);
+                erase(inst);
+            }
+            break;
+        }
+    }
+    worklist_.clear();
+    in_worklist_.clear();
+    erased_.clear();
+    return changed;
+}
+
+void InstCombine::push(Ptr<Value> val) {
+    auto inst = dyn_cast<Instruction>(val);
+    if (inst && !erased_.count(inst) && in_worklist_.insert(inst).second) {
+        worklist_.push_back(inst);
+    }
+}
+
+void InstCombine::push_users(Ptr<Instruction> inst) {
+    for (auto &use : inst->get_use_list()) {
+        push(use.val_.lock());
+    }
+}
+
+void InstCombine::erase(Ptr<Instruction> inst) {
+    // operands may lose their last use
+    for (auto op : inst->get_operands()) {
+        push(op.lock());
+    }
+    inst->get_parent()->delete_instr(inst);
+    erased_.insert(inst);
+}
+
+template <typename T>
+Ptr<T> InstCombine::insert_before(Ptr<T> inst, Ptr<Instruction> pos) {
+    inst->insert_before(pos);
+    push(inst);
+    return inst;
+}
+
+bool InstCombine::is_trivially_dead(Ptr<Instruction> inst) {
+    if (!inst->get_use_list().empty()) {
+        return false;
+    }
+    return inst->isBinary() || inst->is_cmp() || inst->is_fcmp() || inst->is_gep() || inst->is_select() ||
+           inst->is_zext() || inst->is_sext() || inst->is_trunc() || inst->is_sitofp() || inst->is_fptosi() ||
+           inst->is_bitcast() || inst->is_insertelement() || inst->is_extractelement();
+}
+
+// whether sitofp of the value is exact, i.e. |val| <= 2^24
+bool InstCombine::is_exact_in_float(Ptr<Value> val) {
+    const int limit = 1 << 24;
+    if (auto c = get_const_int(val)) {
+        return c->get_value() >= -limit && c->get_value() <= limit;
+    }
+    auto inst = dyn_cast<Instruction>(val);
+    if (!inst) {
+        return false;
+    }
+    if (inst->is_zext()) {
+        return static_pointer_cast<IntegerType>(inst->get_operand(0)->get_type())->get_num_bits() <= 24;
+    }
+    if (inst->is_and()) {
+        auto mask = get_const_int(inst->get_operand(1));
+        return mask && mask->get_value() >= 0 && mask->get_value() <= limit;
+    }
+    if (inst->is_rem()) {
+        auto divisor = get_const_int(inst->get_operand(1));
+        return divisor && divisor->get_value() >= -limit && divisor->get_value() <= limit;
+    }
+    if (inst->is_urem()) {
+        auto divisor = get_const_int(inst->get_operand(1));
+        return divisor && divisor->get_value() > 0 && divisor->get_value() <= limit;
+    }
+    return false;
+}
+
+Ptr<Value> InstCombine::fold_constant_operands(Ptr<Instruction> inst) {
+    return fold_constant(inst, module.lock());
+}
+
+Ptr<Value> InstCombine::move_constant_to_rhs(Ptr<Instruction> inst) {
+    auto lhs = inst->get_operand(0);
+    auto rhs = inst->get_operand(1);
+    if (!isa<Constant>(lhs) || isa<Constant>(rhs)) {
+        return nullptr;
+    }
+    inst->set_operand(0, rhs);
+    inst->set_operand(1, lhs);
+    if (inst->is_cmp()) {
+        auto cmp = static_pointer_cast<CmpInst>(inst);
+        cmp->set_cmp_op(swap_cmp_op(cmp->get_cmp_op()));
+    }
+    else if (inst->is_fcmp()) {
+        // FCmpInst::CmpOp has the same layout as CmpInst::CmpOp
+        auto fcmp = static_pointer_cast<FCmpInst>(inst);
+        auto op = swap_cmp_op(static_cast<CmpInst::CmpOp>(fcmp->get_cmp_op()));
+        fcmp->set_cmp_op(static_cast<FCmpInst::CmpOp>(op));
+    }
+    return inst;
+}
+
+Ptr<Value> InstCombine::fold_identity(Ptr<Instruction> inst) {
+    auto lhs = inst->get_operand(0);
+    auto rhs = get_const_int(inst->get_operand(1));
+    if (!rhs) {
+        return nullptr;
+    }
+    int c = rhs->get_value();
+    auto zero = [&]() {
+        return ConstantInt::create(static_pointer_cast<IntegerType>(inst->get_type()), 0, module.lock());
+    };
+    switch (inst->get_instr_type()) {
+        // x + 0, x - 0, x | 0, x ^ 0, x << 0, x >> 0
+        case Instruction::add:
+        case Instruction::sub:
+        case Instruction::xor_:
+        case Instruction::shl:
+        case Instruction::ashr:
+        case Instruction::lshr:
+            return c == 0 ? lhs : nullptr;
+        case Instruction::or_:
+            if (c == 0) return lhs;
+            return c == -1 ? rhs : nullptr;
+        case Instruction::and_:
+            if (c == -1) return lhs;
+            return c == 0 ? rhs : nullptr;
+        case Instruction::mul:
+            if (c == 1) return lhs;
+            return c == 0 ? rhs : nullptr;
+        case Instruction::sdiv:
+        case Instruction::udiv:
+            return c == 1 ? lhs : nullptr;
+        case Instruction::srem:
+            return c == 1 || c == -1 ? zero() : nullptr;
+        case Instruction::urem:
+            return c == 1 ? zero() : nullptr;
+        default:
+            return nullptr;
+    }
+}
+
+Ptr<Value> InstCombine::fold_float_identity(Ptr<Instruction> inst) {
+    auto lhs = inst->get_operand(0);
+    auto rhs = inst->get_operand(1);
+    // x + 0.0 is not x for x = -0.0, but x + -0.0 and x - 0.0 are
+    switch (inst->get_instr_type()) {
+        case Instruction::fadd: return is_const_float(rhs, -0.0f) ? lhs : nullptr;
+        case Instruction::fsub: return is_const_float(rhs, 0.0f) ? lhs : nullptr;
+        case Instruction::fmul:
+        case Instruction::fdiv:
+            return is_const_float(rhs, 1.0f) ? lhs : nullptr;
+        default: return nullptr;
+    }
+}
+
+Ptr<Value> InstCombine::fold_same_operands(Ptr<Instruction> inst) {
+    auto m = module.lock();
+    auto lhs = inst->get_operand(0);
+    if (lhs != inst->get_operand(1)) {
+        return nullptr;
+    }
+    switch (inst->get_instr_type()) {
+        case Instruction::sub:
+        case Instruction::xor_:
+            // the vectorizers make <4 x i32> subs, their zero is a zeroinitializer
+            if (inst->get_type()->is_vector_type()) {
+                return ConstantZero::create(inst->get_type(), m);
+            }
+            return ConstantInt::create(static_pointer_cast<IntegerType>(inst->get_type()), 0, m);
+        case Instruction::and_:
+        case Instruction::or_:
+            return lhs;
+        case Instruction::cmp: {
+            auto op = static_pointer_cast<CmpInst>(inst)->get_cmp_op();
+            return ConstantInt::create(op == CmpInst::EQ || op == CmpInst::GE || op == CmpInst::LE, m);
+        }
+        case Instruction::fcmp: {
+            // the predicates are unordered, so only the ones that include
+            // equality hold for NaN as well
+            auto op = static_pointer_cast<FCmpInst>(inst)->get_cmp_op();
+            if (op == FCmpInst::EQ || op == FCmpInst::GE || op == FCmpInst::LE) {
+                return ConstantInt::create(true, m);
+            }
+            return nullptr;
+        }
+        default:
+            return nullptr;
+    }
+}
+
+// 0 - (0 - x) => x
+Ptr<Value> InstCombine::fold_double_negation(Ptr<Instruction> inst) {
+    if (!is_const_int(inst->get_operand(0), 0)) {
+        return nullptr;
+    }
+    auto inner = dyn_cast<Instruction>(inst->get_operand(1));
+    if (!inner || !inner->is_sub() || !is_const_int(inner->get_operand(0), 0)) {
+        return nullptr;
+    }
+    return inner->get_operand(1);
+}
+
+// (x op c1) op c2 => x op (c1 op c2)
+Ptr<Value> InstCombine::reassociate_constants(Ptr<Instruction> inst) {
+    auto inner = dyn_cast<Instruction>(inst->get_operand(0));
+    auto c2 = get_const_int(inst->get_operand(1));
+    if (!inner || !c2 || inner->get_instr_type() != inst->get_instr_type()) {
+        return nullptr;
+    }
+    auto c1 = get_const_int(inner->get_operand(1));
+    if (!c1) {
+        return nullptr;
+    }
+    if (static_pointer_cast<IntegerType>(inst->get_type())->get_num_bits() != 32) {
+        return nullptr;
+    }
+    auto folded = fold_binary(inst->get_instr_type(), c1, c2, module.lock());
+    if (!folded) {
+        return nullptr;
+    }
+    inst->set_operand(0, inner->get_operand(0));
+    inst->set_operand(1, folded);
+    push(inner);
+    return inst;
+}
+
+// icmp ne (zext i1 c), 0 => c and icmp eq (zext i1 c), 0 => !c
+Ptr<Value> InstCombine::fold_bool_compare(Ptr<Instruction> inst) {
+    auto cmp = static_pointer_cast<CmpInst>(inst);
+    auto op = cmp->get_cmp_op();
+    if (op != CmpInst::EQ && op != CmpInst::NE) {
+        return nullptr;
+    }
+    auto zext = dyn_cast<Instruction>(inst->get_operand(0));
+    auto rhs = get_const_int(inst->get_operand(1));
+    if (!zext || !zext->is_zext() || !rhs) {
+        return nullptr;
+    }
+    auto cond = zext->get_operand(0);
+    if (static_pointer_cast<IntegerType>(cond->get_type())->get_num_bits() != 1) {
+        return nullptr;
+    }
+    auto m = module.lock();
+    int c = rhs->get_value();
+    if (c != 0 && c != 1) {
+        // a bool never equals anything else
+        return ConstantInt::create(op == CmpInst::NE, m);
+    }
+    if ((op == CmpInst::NE) == (c == 0)) {
+        return cond;
+    }
+    auto cond_cmp = dyn_cast<CmpInst>(cond);
+    if (cond_cmp) {
+        auto inverse = CmpInst::create_cmp(inverse_cmp_op(cond_cmp->get_cmp_op()), cond_cmp->get_operand(0),
+                                           cond_cmp->get_operand(1), inst->get_parent(), m);
+        return insert_before(inverse, inst);
+    }
+    // fcmp has no ordered predicates to invert to
+    return insert_before(BinaryInst::create_xor(cond, ConstantInt::create(true, m), inst->get_parent(), m), inst);
+}
+
+// icmp eq/ne (x - y), 0 => icmp eq/ne x, y
+Ptr<Value> InstCombine::fold_compare_of_difference(Ptr<Instruction> inst) {
+    auto op = static_pointer_cast<CmpInst>(inst)->get_cmp_op();
+    if ((op != CmpInst::EQ && op != CmpInst::NE) || !is_const_int(inst->get_operand(1), 0)) {
+        return nullptr;
+    }
+    auto diff = dyn_cast<Instruction>(inst->get_operand(0));
+    if (!diff || !diff->is_sub()) {
+        return nullptr;
+    }
+    inst->set_operand(0, diff->get_operand(0));
+    inst->set_operand(1, diff->get_operand(1));
+    push(diff);
+    return inst;
+}
+
+// fptosi (sitofp x) => x when x is exact in float, trunc (sext x) => x
+Ptr<Value> InstCombine::fold_cast_round_trip(Ptr<Instruction> inst) {
+    auto inner = dyn_cast<Instruction>(inst->get_operand(0));
+    if (!inner) {
+        return nullptr;
+    }
+    auto src = inner->get_num_operand() > 0 ? inner->get_operand(0) : nullptr;
+    if (inst->is_fptosi() && inner->is_sitofp() && is_exact_in_float(src)) {
+        return src;
+    }
+    if (inst->is_trunc() && inner->is_sext() && Type::is_eq_type(src->get_type(), inst->get_type())) {
+        return src;
+    }
+    return nullptr;
+}
+
+// select c, x, x => x and select true/false, x, y => x/y
+Ptr<Value> InstCombine::fold_select(Ptr<Instruction> inst) {
+    auto select = static_pointer_cast<SelectInst>(inst);
+    if (select->get_true_value() == select->get_false_value()) {
+        return select->get_true_value();
+    }
+    auto cond = get_const_int(select->get_condition());
+    if (!cond) {
+        return nullptr;
+    }
+    return cond->get_value() ? select->get_true_value() : select->get_false_value();
+}
+
+}
+}
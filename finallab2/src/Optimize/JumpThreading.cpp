@@ -0,0 +1,364 @@
+#include "JumpThreading.h"
+#include "CFGUtils.h"
+#include "CloneUtils.h"
+#include "ConstantFolder.h"
+#include "DominateTree.h"
+#include "Remarks.h"
+#include "SSAUtils.h"
+#include "Statistics.h"
+#include <algorithm>
+
+namespace SysYF {
+namespace IR {
+
+static Statistic num_threaded("JumpThreading", "edges threaded");
+static Statistic num_merged("JumpThreading", "blocks merged into their predecessor");
+
+namespace {
+
+Ptr<Value> get_incoming_value(Ptr<Instruction> phi, Ptr<BasicBlock> pred) {
+    for (unsigned i = 0; i < phi->get_num_operand(); i += 2) {
+        if (phi->get_operand(i + 1) == pred) {
+            return phi->get_operand(i);
+        }
+    }
+    return nullptr;
+}
+
+}
+
+bool JumpThreading::execute() {
+    bool changed = false;
+    auto m = module.lock();
+    // the dominator tree needs every block to be reachable
+    for (auto f : m->get_functions()) {
+        if (!f->is_declaration()) {
+            changed |= remove_unreachable_blocks(f);
+        }
+    }
+    // kept up to date with the edges each round changes
+    DominateTree dom_tree(module);
+    dom_tree.execute();
+    for (int round = 0; round < max_rounds; round++) {
+        for (auto f : m->get_functions()) {
+            for (auto bb : PtrVec<BasicBlock>(f->get_basic_blocks().begin(), f->get_basic_blocks().end())) {
+                if (merge_into_predecessor(bb, &cfg_updates_)) {
+                    ++num_merged;
+                    changed = true;
+                }
+            }
+            if (!cfg_updates_.empty()) {
+                dom_tree.apply_updates(f, cfg_updates_);
+                cfg_updates_.clear();
+            }
+        }
+        conditions_.clear();
+        loop_headers_.clear();
+        bool threaded_any = false;
+        for (auto f : m->get_functions()) {
+            if (f->is_declaration()) {
+                continue;
+            }
+            collect_conditions(get_reverse_post_order(f), conditions_);
+            find_loop_headers(f);
+            // the blocks an edge was threaded into or out of, the facts about them are stale
+            std::set<Ptr<BasicBlock>> touched;
+            auto blocks = get_reverse_post_order(f);
+            for (auto bb : blocks) {
+                if (touched.count(bb) || !can_thread(bb)) {
+                    continue;
+                }
+                PtrVec<BasicBlock> preds;
+                for (auto &pred : bb->get_pre_basic_blocks()) {
+                    if (std::find(preds.begin(), preds.end(), pred.lock()) == preds.end()) {
+                        preds.push_back(pred.lock());
+                    }
+                }
+                bool threaded = false;
+                for (auto pred : preds) {
+                    if (touched.count(pred) || pred == bb) {
+                        continue;
+                    }
+                    auto target = get_known_target(bb, pred);
+                    if (target && loop_headers_.count(target)) {
+                        Remark::emit(Remark(Remark::Missed, name, "NotThreaded", bb)
+                                         .arg("From", pred).arg("To", target)
+                                         .arg("Reason", "the target is a loop header, the loop would get a second entry"));
+                    }
+                    if (!target || touched.count(target) || loop_headers_.count(target)) {
+                        continue;
+                    }
+                    ++num_threaded;
+                    Remark::emit(Remark(Remark::Passed, name, "Threaded", bb).arg("From", pred).arg("To", target));
+                    thread_edge(pred, bb, target);
+                    touched.insert(pred);
+                    touched.insert(target);
+                    threaded = true;
+                }
+                if (threaded) {
+                    touched.insert(bb);
+                    threaded_any = true;
+                }
+            }
+            if (!cfg_updates_.empty()) {
+                dom_tree.apply_updates(f, cfg_updates_);
+                cfg_updates_.clear();
+            }
+            // a block all of whose predecessors were threaded, and what only it led to
+            remove_unreachable_blocks(f);
+        }
+        if (!threaded_any) {
+            break;
+        }
+        changed = true;
+    }
+    return changed;
+}
+
+bool JumpThreading::set_option(const std::string &key, const std::string &value) {
+    if (key == "max-rounds") {
+        return parse_int(value, max_rounds);
+    }
+    if (key == "max-duplicate") {
+        return parse_int(value, max_duplicate);
+    }
+    return false;
+}
+
+void JumpThreading::find_loop_headers(Ptr<Function> f) {
+    for (auto bb : f->get_basic_blocks()) {
+        for (auto &pred : bb->get_pre_basic_blocks()) {
+            if (DominateTree::dominates(bb, pred.lock())) {
+                loop_headers_.insert(bb);
+            }
+        }
+    }
+}
+
+bool JumpThreading::decide_by_conditions(Ptr<CmpInst> cmp, Ptr<Value> lhs, Ptr<Value> rhs,
+                                         Ptr<BasicBlock> pred, Ptr<BasicBlock> bb, bool &result) {
+    auto conds = conditions_[pred];
+    Condition edge;
+    if (get_edge_condition(pred, bb, edge)) {
+        conds.push_back(edge);
+    }
+    return IR::decide_by_conditions(conds, cmp->get_cmp_op(), lhs, rhs, result);
+}
+
+Ptr<Value> JumpThreading::get_value_on_edge(Ptr<Value> val, Ptr<BasicBlock> bb, Ptr<BasicBlock> pred) {
+    auto m = module.lock();
+    auto inst = dyn_cast<Instruction>(val);
+    if (!inst || inst->get_parent() != bb) {
+        auto cmp = dyn_cast<CmpInst>(val);
+        bool result;
+        if (cmp && decide_by_conditions(cmp, cmp->get_operand(0), cmp->get_operand(1), pred, bb, result)) {
+            return ConstantInt::create(result, m);
+        }
+        return val;
+    }
+    if (inst->is_phi()) {
+        auto in = get_incoming_value(inst, pred);
+        // a phi of bb coming around again would be the value of the previous visit
+        auto in_inst = dyn_cast<Instruction>(in);
+        if (!in || (in_inst && in_inst->get_parent() == bb)) {
+            return nullptr;
+        }
+        return get_value_on_edge(in, bb, pred);
+    }
+    if (inst->is_cmp()) {
+        auto cmp = static_pointer_cast<CmpInst>(inst);
+        auto lhs = get_value_on_edge(cmp->get_operand(0), bb, pred);
+        auto rhs = get_value_on_edge(cmp->get_operand(1), bb, pred);
+        if (!lhs || !rhs) {
+            return nullptr;
+        }
+        auto const_lhs = dyn_cast<ConstantInt>(lhs);
+        auto const_rhs = dyn_cast<ConstantInt>(rhs);
+        if (const_lhs && const_rhs) {
+            return ConstantInt::create(evaluate_compare(cmp->get_cmp_op(), const_lhs->get_value(), const_rhs->get_value()), m);
+        }
+        bool result;
+        if (decide_by_conditions(cmp, lhs, rhs, pred, bb, result)) {
+            return ConstantInt::create(result, m);
+        }
+        return nullptr;
+    }
+    if (inst->is_zext()) {
+        auto op = dyn_cast<ConstantInt>(get_value_on_edge(inst->get_operand(0), bb, pred));
+        return op ? ConstantInt::create(op->get_value(), m) : nullptr;
+    }
+    if (inst->isBinary() && inst->get_type()->is_integer_type()) {
+        auto lhs = dyn_cast<ConstantInt>(get_value_on_edge(inst->get_operand(0), bb, pred));
+        auto rhs = dyn_cast<ConstantInt>(get_value_on_edge(inst->get_operand(1), bb, pred));
+        if (lhs && rhs) {
+            return fold_binary(inst->get_instr_type(), lhs, rhs, m);
+        }
+    }
+    return nullptr;
+}
+
+Ptr<BasicBlock> JumpThreading::get_known_target(Ptr<BasicBlock> bb, Ptr<BasicBlock> pred) {
+    auto br = bb->get_terminator();
+    auto pred_br = pred->get_terminator();
+    if (!pred_br || !pred_br->is_br()) {
+        return nullptr;
+    }
+    // both edges of pred lead to bb, only one of them could be moved
+    if (pred_br->get_num_operand() == 3 && pred_br->get_operand(1) == pred_br->get_operand(2)) {
+        return nullptr;
+    }
+    auto cond = dyn_cast<ConstantInt>(get_value_on_edge(br->get_operand(0), bb, pred));
+    if (!cond) {
+        return nullptr;
+    }
+    auto target = br->get_operand(cond->get_value() ? 1 : 2)->as<BasicBlock>();
+    return target == bb ? nullptr : target;
+}
+
+bool JumpThreading::can_thread(Ptr<BasicBlock> bb) {
+    auto br = bb->get_terminator();
+    if (!br || !br->is_br() || br->get_num_operand() != 3 || br->get_operand(1) == br->get_operand(2)) {
+        return false;
+    }
+    if (loop_headers_.count(bb) || bb == bb->get_parent()->get_entry_block()) {
+        return false;
+    }
+    int size = 0;
+    for (auto inst : bb->get_instructions()) {
+        if (!inst->is_phi() && inst != br) {
+            size++;
+        }
+    }
+    return size <= max_duplicate;
+}
+
+void JumpThreading::thread_edge(Ptr<BasicBlock> pred, Ptr<BasicBlock> bb, Ptr<BasicBlock> target) {
+    auto m = module.lock();
+    auto f = bb->get_parent();
+    auto copy = BasicBlock::create(m, "", f);
+    ValueMap vmap;
+    for (auto inst : bb->get_instructions()) {
+        if (inst->is_phi()) {
+            auto in = get_incoming_value(inst, pred);
+            vmap[inst] = in ? in : get_zero(inst->get_type(), m);
+        }
+        else if (inst != bb->get_terminator()) {
+            auto new_inst = clone_instruction(inst, copy, vmap);
+            remap_operands(new_inst, vmap);
+            vmap[inst] = new_inst;
+        }
+    }
+    BranchInst::create_br(target, copy);
+    for (auto inst : target->get_instructions()) {
+        if (!inst->is_phi()) {
+            break;
+        }
+        auto in = get_incoming_value(inst, bb);
+        if (in) {
+            auto iter = vmap.find(in);
+            static_pointer_cast<PhiInst>(inst)->add_phi_pair_operand(iter != vmap.end() ? iter->second : in, copy);
+        }
+    }
+
+    auto pred_br = pred->get_terminator();
+    for (unsigned i = 0; i < pred_br->get_num_operand(); i++) {
+        if (pred_br->get_operand(i) == bb) {
+            pred_br->set_operand(i, copy);
+        }
+    }
+    pred->remove_succ_basic_block(bb);
+    pred->add_succ_basic_block(copy);
+    bb->remove_pre_basic_block(pred);
+    copy->add_pre_basic_block(pred);
+    for (auto inst : bb->get_instructions()) {
+        if (!inst->is_phi()) {
+            break;
+        }
+        for (int i = static_cast<int>(inst->get_num_operand()) - 2; i >= 0; i -= 2) {
+            if (inst->get_operand(i + 1) == pred) {
+                inst->remove_operands(i, i + 1);
+            }
+        }
+    }
+
+    for (auto inst : bb->get_instructions()) {
+        if (vmap.count(inst)) {
+            repair_ssa(inst, bb, vmap[inst], copy);
+        }
+    }
+    // the copied compares that decided the branch are dead now
+    PtrVec<Instruction> insts(copy->get_instructions().rbegin(), copy->get_instructions().rend());
+    for (auto inst : insts) {
+        if (!inst->is_void() && !inst->is_call() && inst->get_use_list().empty()) {
+            copy->delete_instr(inst);
+        }
+    }
+    // nothing is left but the branch, pred can jump to target itself unless it already does
+    bool reaches_target = false;
+    for (auto &succ : pred->get_succ_basic_blocks()) {
+        reaches_target |= succ.lock() == target;
+    }
+    if (copy->get_instructions().size() == 1 && !reaches_target) {
+        for (unsigned i = 0; i < pred_br->get_num_operand(); i++) {
+            if (pred_br->get_operand(i) == copy) {
+                pred_br->set_operand(i, target);
+            }
+        }
+        for (auto inst : target->get_instructions()) {
+            if (!inst->is_phi()) {
+                break;
+            }
+            for (unsigned i = 1; i < inst->get_num_operand(); i += 2) {
+                if (inst->get_operand(i) == copy) {
+                    inst->set_operand(i, pred);
+                }
+            }
+        }
+        pred->remove_succ_basic_block(copy);
+        pred->add_succ_basic_block(target);
+        target->remove_pre_basic_block(copy);
+        target->add_pre_basic_block(pred);
+        copy->get_pre_basic_blocks().clear();
+        copy->get_succ_basic_blocks().clear();
+        copy->get_terminator()->remove_use_of_ops();
+        f->remove(copy);
+        cfg_updates_.push_back({DominateTree::Update::Delete, pred, bb});
+        cfg_updates_.push_back({DominateTree::Update::Insert, pred, target});
+        return;
+    }
+    cfg_updates_.push_back({DominateTree::Update::Delete, pred, bb});
+    cfg_updates_.push_back({DominateTree::Update::Insert, pred, copy});
+    cfg_updates_.push_back({DominateTree::Update::Insert, copy, target});
+}
+
+void JumpThreading::repair_ssa(Ptr<Instruction> def, Ptr<BasicBlock> bb, Ptr<Value> copy_def, Ptr<BasicBlock> copy) {
+    std::vector<std::pair<Ptr<User>, unsigned>> uses;
+    for (auto &use : def->get_use_list()) {
+        auto user = dyn_cast<Instruction>(use.val_.lock());
+        if (user && user->get_parent() != bb && user->get_parent() != copy) {
+            uses.push_back({user, use.arg_no_});
+        }
+    }
+    if (uses.empty()) {
+        return;
+    }
+    SSAUpdater updater(def->get_type(), module.lock());
+    updater.add_definition(bb, def);
+    updater.add_definition(copy, copy_def);
+    for (auto &use : uses) {
+        auto user = static_pointer_cast<Instruction>(use.first);
+        Ptr<Value> val;
+        if (user->is_phi()) {
+            val = updater.get_value_at_end(user->get_operand(use.second + 1)->as<BasicBlock>());
+        } else {
+            val = updater.get_value_at_entry(user->get_parent());
+        }
+        if (val != def) {
+            user->set_operand(use.second, val);
+        }
+    }
+    updater.remove_trivial_phis();
+}
+
+}
+}
@@ -0,0 +1,404 @@
+#include "LazyCodeMotion.h"
+#include "CFGUtils.h"
+#include "CloneUtils.h"
+#include "Remarks.h"
+#include "SSAUtils.h"
+#include "Statistics.h"
+#include <algorithm>
+#include <cstring>
+
+namespace SysYF {
+namespace IR {
+
+static Statistic num_inserted("LazyCodeMotion", "computations inserted on edges");
+static Statistic num_removed("LazyCodeMotion", "redundant computations removed");
+
+namespace {
+
+bool is_commutative(Ptr<Instruction> inst) {
+    if (inst->is_cmp()) {
+        auto op = inst->as<CmpInst>()->get_cmp_op();
+        return op == CmpInst::EQ || op == CmpInst::NE;
+    }
+    if (inst->is_fcmp()) {
+        auto op = inst->as<FCmpInst>()->get_cmp_op();
+        return op == FCmpInst::EQ || op == FCmpInst::NE;
+    }
+    return inst->is_add() || inst->is_mul() || inst->is_and() || inst->is_or() || inst->is_xor() ||
+           inst->is_fadd() || inst->is_fmul();
+}
+
+// a = a & b for each bit, whether a changed
+bool intersect(std::vector<bool> &a, const std::vector<bool> &b) {
+    bool changed = false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i] && !b[i]) {
+            a[i] = false;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+}
+
+bool LazyCodeMotion::execute() {
+    bool changed = false;
+    for (auto f : module.lock()->get_functions()) {
+        if (f->is_declaration()) {
+            continue;
+        }
+        // an expression whose operand was rewritten is left to the next round
+        for (int round = 0; round < max_rounds; round++) {
+            if (!run(f)) {
+                break;
+            }
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+bool LazyCodeMotion::set_option(const std::string &key, const std::string &value) {
+    if (key == "max-rounds") {
+        return parse_int(value, max_rounds);
+    }
+    return false;
+}
+
+bool LazyCodeMotion::is_candidate(Ptr<Instruction> inst) {
+    if (!inst->isBinary() && !inst->is_cmp() && !inst->is_fcmp() && !inst->is_zext() &&
+        !inst->is_sitofp() && !inst->is_fptosi() && !inst->is_gep()) {
+        return false;
+    }
+    if (inst->get_type()->is_vector_type()) {
+        return false;
+    }
+    for (auto &op : inst->get_operands()) {
+        if (op.lock()->get_type()->is_vector_type()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+LazyCodeMotion::Expression LazyCodeMotion::get_expression(Ptr<Instruction> inst) {
+    Expression expr;
+    expr.op = inst->get_instr_type();
+    expr.cmp_op = -1;
+    if (inst->is_cmp()) {
+        expr.cmp_op = inst->as<CmpInst>()->get_cmp_op();
+    } else if (inst->is_fcmp()) {
+        expr.cmp_op = inst->as<FCmpInst>()->get_cmp_op();
+    }
+    for (auto &op : inst->get_operands()) {
+        auto val = op.lock();
+        // constants are not unique, they are told apart by type and value
+        if (auto const_int = dyn_cast<ConstantInt>(val)) {
+            auto bits = static_pointer_cast<IntegerType>(val->get_type())->get_num_bits();
+            expr.operands.emplace_back(bits == 1 ? 2 : 1, nullptr, const_int->get_value());
+        } else if (auto const_float = dyn_cast<ConstantFloat>(val)) {
+            float value = const_float->get_value();
+            int bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            expr.operands.emplace_back(3, nullptr, bits);
+        } else {
+            expr.operands.emplace_back(0, val, 0);
+        }
+    }
+    if (is_commutative(inst)) {
+        std::sort(expr.operands.begin(), expr.operands.end());
+    }
+    return expr;
+}
+
+bool LazyCodeMotion::run(Ptr<Function> f) {
+    collect_expressions(f);
+    if (occurrences_.empty()) {
+        return false;
+    }
+    compute_local_sets();
+    solve();
+    removed_.clear();
+    split_blocks_.clear();
+    bool changed = false;
+    for (int e = 0; e < static_cast<int>(occurrences_.size()); e++) {
+        if (move_expression(e)) {
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+void LazyCodeMotion::collect_expressions(Ptr<Function> f) {
+    blocks_ = get_reverse_post_order(f);
+    index_.clear();
+    for (int i = 0; i < static_cast<int>(blocks_.size()); i++) {
+        index_[blocks_[i].get()] = i;
+    }
+    reachable_.clear();
+    for (auto &bb : blocks_) {
+        reachable_.insert(bb.get());
+    }
+    edges_.clear();
+    in_edges_.assign(blocks_.size(), {});
+    out_edges_.assign(blocks_.size(), {});
+    for (int i = 0; i < static_cast<int>(blocks_.size()); i++) {
+        SmallPtrSet<BasicBlock *, 4> seen;
+        for (auto &succ : blocks_[i]->get_succ_basic_blocks()) {
+            if (!seen.insert(succ.lock().get()).second) {
+                continue;
+            }
+            int j = index_[succ.lock().get()];
+            out_edges_[i].push_back(edges_.size());
+            in_edges_[j].push_back(edges_.size());
+            edges_.push_back({i, j});
+        }
+    }
+
+    std::map<Expression, int> ids;
+    std::vector<PtrVec<Instruction>> all;
+    for (auto bb : blocks_) {
+        for (auto inst : bb->get_instructions()) {
+            if (!is_candidate(inst)) {
+                continue;
+            }
+            auto iter = ids.insert({get_expression(inst), all.size()}).first;
+            if (iter->second == static_cast<int>(all.size())) {
+                all.emplace_back();
+            }
+            all[iter->second].push_back(inst);
+        }
+    }
+    // an expression computed once is never redundant
+    occurrences_.clear();
+    for (auto &insts : all) {
+        if (insts.size() > 1) {
+            occurrences_.push_back(insts);
+        }
+    }
+}
+
+void LazyCodeMotion::compute_local_sets() {
+    auto num_blocks = blocks_.size();
+    auto num_exprs = occurrences_.size();
+    transp_.assign(num_blocks, std::vector<bool>(num_exprs, true));
+    comp_.assign(num_blocks, std::vector<bool>(num_exprs, false));
+    antloc_.assign(num_blocks, std::vector<bool>(num_exprs, false));
+    for (size_t e = 0; e < num_exprs; e++) {
+        for (auto &op : occurrences_[e].front()->get_operands()) {
+            auto def = dyn_cast<Instruction>(op.lock());
+            if (def && index_.count(def->get_parent().get())) {
+                transp_[index_[def->get_parent().get()]][e] = false;
+            }
+        }
+        for (auto inst : occurrences_[e]) {
+            comp_[index_[inst->get_parent().get()]][e] = true;
+        }
+    }
+    // in SSA form the operands are defined before any computation in the block
+    for (size_t b = 0; b < num_blocks; b++) {
+        for (size_t e = 0; e < num_exprs; e++) {
+            antloc_[b][e] = comp_[b][e] && transp_[b][e];
+        }
+    }
+}
+
+void LazyCodeMotion::solve() {
+    auto num_blocks = blocks_.size();
+    auto num_exprs = occurrences_.size();
+
+    // available at the end of a block
+    avout_.assign(num_blocks, std::vector<bool>(num_exprs, true));
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t b = 0; b < num_blocks; b++) {
+            std::vector<bool> avin(num_exprs, b != 0);
+            for (auto edge : in_edges_[b]) {
+                intersect(avin, avout_[edges_[edge].first]);
+            }
+            for (size_t e = 0; e < num_exprs; e++) {
+                bool out = comp_[b][e] || (avin[e] && transp_[b][e]);
+                if (out != avout_[b][e]) {
+                    avout_[b][e] = out;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    // computed on every path from the start or the end of a block
+    antin_.assign(num_blocks, std::vector<bool>(num_exprs, true));
+    antout_.assign(num_blocks, std::vector<bool>(num_exprs, true));
+    changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t b = num_blocks; b-- > 0;) {
+            std::vector<bool> antout(num_exprs, !out_edges_[b].empty());
+            for (auto edge : out_edges_[b]) {
+                intersect(antout, antin_[edges_[edge].second]);
+            }
+            antout_[b] = antout;
+            for (size_t e = 0; e < num_exprs; e++) {
+                bool in = antloc_[b][e] || (antout[e] && transp_[b][e]);
+                if (in != antin_[b][e]) {
+                    antin_[b][e] = in;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    // the earliest edges a computation can be placed on, without making it redundant
+    std::vector<std::vector<bool>> earliest(edges_.size(), std::vector<bool>(num_exprs));
+    for (size_t i = 0; i < edges_.size(); i++) {
+        auto from = edges_[i].first, to = edges_[i].second;
+        for (size_t e = 0; e < num_exprs; e++) {
+            earliest[i][e] = antin_[to][e] && !avout_[from][e] && (!transp_[from][e] || !antout_[from][e]);
+        }
+    }
+
+    // how far the placement can be delayed; the function is entered by an edge of its own
+    later_ = earliest;
+    laterin_.assign(num_blocks, std::vector<bool>(num_exprs, true));
+    laterin_[0] = antin_[0];
+    changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t b = 0; b < num_blocks; b++) {
+            for (auto edge : out_edges_[b]) {
+                for (size_t e = 0; e < num_exprs; e++) {
+                    later_[edge][e] = earliest[edge][e] || (laterin_[b][e] && !antloc_[b][e]);
+                }
+            }
+        }
+        for (size_t b = 1; b < num_blocks; b++) {
+            for (auto edge : in_edges_[b]) {
+                if (intersect(laterin_[b], later_[edge])) {
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+bool LazyCodeMotion::move_expression(int e) {
+    auto &occurrences = occurrences_[e];
+    auto expr = occurrences.front();
+    for (auto &op : expr->get_operands()) {
+        auto def = dyn_cast<Instruction>(op.lock());
+        if (def && removed_.count(def)) {
+            return false;
+        }
+    }
+    std::map<Ptr<BasicBlock>, PtrVec<Instruction>> insts_in_block;
+    bool local = false;
+    for (auto inst : occurrences) {
+        auto &insts = insts_in_block[inst->get_parent()];
+        insts.push_back(inst);
+        local = local || insts.size() > 1;
+    }
+    std::vector<int> inserts;
+    for (size_t i = 0; i < edges_.size(); i++) {
+        if (later_[i][e] && !laterin_[edges_[i].second][e]) {
+            inserts.push_back(i);
+        }
+    }
+    bool deletes = false;
+    for (size_t b = 0; b < blocks_.size(); b++) {
+        deletes = deletes || (antloc_[b][e] && !laterin_[b][e]);
+    }
+    if (inserts.empty() && !deletes && !local) {
+        return false;
+    }
+    num_inserted += inserts.size();
+    Remark::emit(Remark(Remark::Passed, name, "Moved", expr)
+                     .arg("Occurrences", static_cast<int>(occurrences.size()))
+                     .arg("Inserted", static_cast<int>(inserts.size())));
+
+    // no entries for blocks that are never run, like mem2reg leaves them out for undefined values
+    SSAUpdater updater(expr->get_type(), module.lock(),
+                       [this](Ptr<BasicBlock> pred) { return reachable_.count(pred.get()) != 0; });
+    std::map<Ptr<BasicBlock>, Ptr<Value>> tops, bottoms;
+    for (auto edge : inserts) {
+        auto inst = insert_on_edge(edge, expr);
+        auto bb = inst->get_parent();
+        if (bb == blocks_[edges_[edge].second] && bb != blocks_[edges_[edge].first]) {
+            tops[bb] = inst;
+        } else {
+            bottoms[bb] = inst;
+            updater.add_definition(bb, inst);
+        }
+    }
+    // computations that take the value reaching the start of their block
+    std::vector<std::pair<Ptr<Instruction>, Ptr<BasicBlock>>> from_entry;
+    for (size_t b = 0; b < blocks_.size(); b++) {
+        auto bb = blocks_[b];
+        Ptr<Value> cur = tops.count(bb) ? tops[bb] : nullptr;
+        bool entry = false;
+        for (auto inst : insts_in_block[bb]) {
+            if (cur) {
+                ++num_removed;
+                inst->replace_all_use_with(cur);
+                bb->delete_instr(inst);
+                removed_.insert(inst);
+            } else if (entry || (antloc_[b][e] && !laterin_[b][e])) {
+                from_entry.push_back({inst, bb});
+                entry = true;
+            } else {
+                cur = inst;
+            }
+        }
+        if (!bottoms.count(bb) && cur) {
+            updater.add_definition(bb, cur);
+        }
+    }
+    for (auto &pair : from_entry) {
+        auto val = updater.get_value_at_entry(pair.second);
+        ++num_removed;
+        pair.first->replace_all_use_with(val);
+        pair.second->delete_instr(pair.first);
+        removed_.insert(pair.first);
+    }
+    updater.remove_trivial_phis();
+    return true;
+}
+
+Ptr<Instruction> LazyCodeMotion::insert_on_edge(int edge, Ptr<Instruction> expr) {
+    auto from = edges_[edge].first, to = edges_[edge].second;
+    Ptr<BasicBlock> bb;
+    Ptr<Instruction> pos;
+    if (out_edges_[from].size() == 1) {
+        bb = blocks_[from];
+        pos = bb->get_terminator();
+    } else if (in_edges_[to].size() == 1) {
+        bb = blocks_[to];
+        for (auto inst : bb->get_instructions()) {
+            if (!inst->is_phi()) {
+                pos = inst;
+                break;
+            }
+        }
+    } else {
+        bb = get_edge_block(edge);
+        pos = bb->get_terminator();
+    }
+    auto inst = clone_instruction(expr, bb, {});
+    inst->insert_before(pos);
+    return inst;
+}
+
+Ptr<BasicBlock> LazyCodeMotion::get_edge_block(int edge) {
+    auto iter = split_blocks_.find(edge);
+    if (iter != split_blocks_.end()) {
+        return iter->second;
+    }
+    auto block = split_edge(blocks_[edges_[edge].first], blocks_[edges_[edge].second]);
+    split_blocks_[edge] = block;
+    reachable_.insert(block.get());
+    return block;
+}
+
+}
+}
@@ -28,7 +28,7 @@ struct BasicBlockCompare {
     }
 };
 
-void LiveVar::execute() {
+bool LiveVar::execute() {
     module.lock()->set_print_name();
 
     for (auto func : this->module.lock()->get_functions()) {
@@ -37,6 +37,11 @@ void LiveVar::execute() {
         }
         
         func_ = func;
+        // a rerun starts over, the sets of the last one may hold deleted values
+        for (auto bb : func->get_basic_blocks()) {
+            bb->set_live_in({});
+            bb->set_live_out({});
+        }
         
         std::map<Ptr<BasicBlock>, 
                 std::map<WeakPtr<Value>, 
@@ -61,10 +66,10 @@ void LiveVar::execute() {
                         auto op = instr->get_operand(i);
                         
                         // 跳过常量和特殊类型
-                        if (dynamic_cast<ConstantInt*>(op.get())) continue;
-                        if (dynamic_cast<BasicBlock*>(op.get())) continue;
-                        if (dynamic_cast<Function*>(op.get())) continue;
-                        if (dynamic_cast<GlobalVariable*>(op.get())) continue;
+                        if (isa<ConstantInt>(op.get())) continue;
+                        if (isa<BasicBlock>(op.get())) continue;
+                        if (isa<Function>(op.get())) continue;
+                        if (isa<GlobalVariable>(op.get())) continue;
                         
                         // 修改：如果操作数未定义或在phi指令中，加入IN集合
                         WeakPtr<Value> weak_op = op;
@@ -72,11 +77,11 @@ void LiveVar::execute() {
                             if (instr->is_phi()) {
                                 // 对phi指令特殊处理：记录变量来自哪个基本块
                                 auto next_op = instr->get_operand(i + 1);
-                                WeakPtr<Value> weak_next_op = std::dynamic_pointer_cast<Value>(next_op);
+                                WeakPtr<Value> weak_next_op = next_op;
                                 wherefrom[bb][weak_op].insert(weak_next_op);
                             } else {
                                 // 非phi指令：记录当前基本块
-                                WeakPtr<Value> weak_bb = std::dynamic_pointer_cast<Value>(bb);
+                                WeakPtr<Value> weak_bb = bb;
                                 wherefrom[bb][weak_op].insert(weak_bb);
                             }
                             new_in.insert(op);
@@ -93,7 +98,7 @@ void LiveVar::execute() {
                     if (def_set.find(out) == def_set.end()) {
                         new_in.insert(out);
                         // 修改：传播活跃性
-                        WeakPtr<Value> weak_bb = std::dynamic_pointer_cast<Value>(bb);
+                        WeakPtr<Value> weak_bb = bb;
                         wherefrom[bb][out].insert(weak_bb);
                     }
                 }
@@ -124,7 +129,7 @@ void LiveVar::execute() {
                             new_out.insert(in_val);
                             // 传播活跃性给当前基本块
                             if (def_set.find(in_val) == def_set.end()) {
-                                WeakPtr<Value> weak_bb = std::dynamic_pointer_cast<Value>(bb);
+                                WeakPtr<Value> weak_bb = bb;
                                 wherefrom[bb][in_val].insert(weak_bb);
                             }
                         }
@@ -173,6 +178,7 @@ void LiveVar::execute() {
     }
 
     dump();
+    return false;
 }
 
 void LiveVar::dump() {
@@ -0,0 +1,300 @@
+#include "LoopUnswitch.h"
+#include "CFGUtils.h"
+#include "AliasUtils.h"
+#include "Remarks.h"
+#include "Statistics.h"
+#include <algorithm>
+
+namespace SysYF {
+namespace IR {
+
+static Statistic num_unswitched("LoopUnswitch", "loops unswitched");
+static Statistic num_too_large("LoopUnswitch", "invariant branches left in loops too large to copy");
+
+namespace {
+
+// the computations that may be moved in front of the loop without being executed there before
+bool is_speculatable(Ptr<Instruction> inst) {
+    switch (inst->get_instr_type()) {
+        case Instruction::sdiv:
+        case Instruction::srem:
+        case Instruction::udiv:
+        case Instruction::urem:
+            return false;
+        default:
+            return inst->isBinary() || inst->is_cmp() || inst->is_fcmp() || inst->is_zext();
+    }
+}
+
+}
+
+bool LoopUnswitch::execute() {
+    bool changed = false;
+    for (auto f : module.lock()->get_functions()) {
+        int growth = 0;
+        // both copies may hold further invariant branches, start over
+        bool unswitched = true;
+        while (unswitched) {
+            unswitched = false;
+            for (auto bb : f->get_basic_blocks()) {
+                if (unswitch_loop(bb, growth)) {
+                    unswitched = true;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+    return changed;
+}
+
+bool LoopUnswitch::set_option(const std::string &key, const std::string &value) {
+    if (key == "max-loop-size") {
+        return parse_int(value, max_loop_size);
+    }
+    if (key == "max-growth") {
+        return parse_int(value, max_growth);
+    }
+    return false;
+}
+
+bool LoopUnswitch::unswitch_loop(Ptr<BasicBlock> header, int &growth) {
+    ScalarEvolution::Loop loop;
+    if (!ScalarEvolution::find_loop(header, loop)) {
+        return false;
+    }
+    int size = 0;
+    stored_globals_.clear();
+    calls_defined_function_ = false;
+    for (auto bb : loop.blocks) {
+        size += bb->get_instructions().size();
+        for (auto inst : bb->get_instructions()) {
+            if (inst->is_store()) {
+                stored_globals_.insert(get_underlying_object(inst->get_operand(1)));
+            }
+            if (inst->is_call() && !inst->get_operand(0)->as<Function>()->is_declaration()) {
+                calls_defined_function_ = true;
+            }
+        }
+    }
+    if (size > max_loop_size || growth + size > max_growth) {
+        // a large loop is not searched for a branch, unless it is to be said why it stays
+        if (Remark::enabled()) {
+            if (auto bb = find_invariant_branch(header, loop)) {
+                ++num_too_large;
+                Remark::emit(Remark(Remark::Missed, name, "NotUnswitched", bb->get_terminator())
+                                 .arg("Loop", header)
+                                 .arg("Reason", size > max_loop_size ? "the loop is larger than max-loop-size"
+                                                                     : "the function would grow by more than max-growth")
+                                 .arg("Size", size));
+            }
+        }
+        return false;
+    }
+    auto bb = find_invariant_branch(header, loop);
+    if (!bb) {
+        return false;
+    }
+    ++num_unswitched;
+    Remark::emit(Remark(Remark::Passed, name, "Unswitched", bb->get_terminator())
+                     .arg("Loop", header).arg("Condition", bb->get_terminator()->get_operand(0)));
+    unswitch(loop, bb);
+    growth += size;
+    return true;
+}
+
+Ptr<BasicBlock> LoopUnswitch::find_invariant_branch(Ptr<BasicBlock> header, const ScalarEvolution::Loop &loop) {
+    // in the order of the function, so the result does not depend on addresses
+    for (auto bb : header->get_parent()->get_basic_blocks()) {
+        if (bb == header || !loop.blocks.count(bb)) {
+            continue;
+        }
+        auto br = bb->get_terminator();
+        if (!br->is_br() || br->get_num_operand() != 3 || br->get_operand(1) == br->get_operand(2) ||
+            dyn_cast<Constant>(br->get_operand(0))) {
+            continue;
+        }
+        int cond_size = 0;
+        if (is_invariant(br->get_operand(0), loop, cond_size)) {
+            return bb;
+        }
+    }
+    return nullptr;
+}
+
+bool LoopUnswitch::is_invariant(Ptr<Value> val, const ScalarEvolution::Loop &loop, int &size) {
+    auto inst = dyn_cast<Instruction>(val);
+    if (!inst || !loop.blocks.count(inst->get_parent())) {
+        return true;
+    }
+    if (++size > max_condition_size) {
+        return false;
+    }
+    if (inst->is_load()) {
+        // a scalar global, array elements are reached through a gep
+        auto global = dyn_cast<GlobalVariable>(inst->get_operand(0));
+        if (!global || calls_defined_function_) {
+            return false;
+        }
+        for (auto obj : stored_globals_) {
+            if (may_alias_objects(obj, global)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    if (!is_speculatable(inst)) {
+        return false;
+    }
+    for (auto &op : inst->get_operands()) {
+        if (!is_invariant(op.lock(), loop, size)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Ptr<Value> LoopUnswitch::hoist(Ptr<Value> val, const ScalarEvolution::Loop &loop, ValueMap &vmap) {
+    auto inst = dyn_cast<Instruction>(val);
+    if (!inst || !loop.blocks.count(inst->get_parent())) {
+        return val;
+    }
+    auto iter = vmap.find(inst);
+    if (iter != vmap.end()) {
+        return iter->second;
+    }
+    for (auto &op : inst->get_operands()) {
+        hoist(op.lock(), loop, vmap);
+    }
+    auto preheader = loop.preheader;
+    auto br = preheader->get_terminator();
+    auto new_inst = clone_instruction(inst, preheader, vmap);
+    remap_operands(new_inst, vmap);
+    // in front of the branch to the header
+    new_inst->insert_before(br);
+    vmap[inst] = new_inst;
+    return new_inst;
+}
+
+void LoopUnswitch::unswitch(const ScalarEvolution::Loop &loop, Ptr<BasicBlock> bb) {
+    auto m = module.lock();
+    auto f = bb->get_parent();
+    auto header = loop.header;
+    auto preheader = loop.preheader;
+    auto exit = loop.exit;
+    auto cond = bb->get_terminator()->get_operand(0);
+    ValueMap hoisted;
+    auto pre_cond = hoist(cond, loop, hoisted);
+
+    // the copy runs when the condition is false
+    ValueMap vmap;
+    PtrVec<BasicBlock> blocks;
+    for (auto block : f->get_basic_blocks()) {
+        if (loop.blocks.count(block)) {
+            blocks.push_back(block);
+        }
+    }
+    clone_region(blocks, f, vmap);
+    auto new_header = vmap[header]->as<BasicBlock>();
+
+    // preheader: br cond, true_preheader, false_preheader
+    auto true_preheader = BasicBlock::create(m, "", f);
+    auto false_preheader = BasicBlock::create(m, "", f);
+    preheader->delete_instr(preheader->get_terminator());
+    preheader->remove_succ_basic_block(header);
+    header->remove_pre_basic_block(preheader);
+    BranchInst::create_cond_br(pre_cond, true_preheader, false_preheader, preheader);
+    BranchInst::create_br(header, true_preheader);
+    BranchInst::create_br(new_header, false_preheader);
+    for (auto pair : {std::make_pair(header, true_preheader), std::make_pair(new_header, false_preheader)}) {
+        for (auto inst : pair.first->get_instructions()) {
+            if (!inst->is_phi()) {
+                break;
+            }
+            for (unsigned i = 1; i < inst->get_num_operand(); i += 2) {
+                if (inst->get_operand(i) == preheader) {
+                    inst->set_operand(i, pair.second);
+                }
+            }
+        }
+    }
+
+    // both copies leave through an exit block of their own into exit
+    auto true_exit = split_edge(header, exit);
+    auto false_exit = split_edge(new_header, exit);
+    // only the header dominates the exit, so only its values are used after the loop
+    for (auto inst : header->get_instructions()) {
+        std::vector<std::pair<Ptr<Instruction>, unsigned>> uses;
+        for (auto &use : inst->get_use_list()) {
+            auto user = use.val_.lock()->as<Instruction>();
+            auto parent = user->get_parent();
+            if (loop.blocks.count(parent) || (parent == exit && user->is_phi())) {
+                continue;
+            }
+            uses.push_back({user, use.arg_no_});
+        }
+        if (uses.empty()) {
+            continue;
+        }
+        auto phi = PhiInst::create_phi(inst->get_type(), exit);
+        exit->add_instr_begin(phi);
+        phi->add_phi_pair_operand(inst, true_exit);
+        phi->add_phi_pair_operand(vmap[inst], false_exit);
+        for (auto &use : uses) {
+            use.first->set_operand(use.second, phi);
+        }
+    }
+
+    auto new_bb = vmap[bb]->as<BasicBlock>();
+    fold_branch(bb, true);
+    fold_branch(new_bb, false);
+    remove_dead_condition(cond);
+    remove_dead_condition(vmap[cond]);
+    remove_unreachable_blocks(f);
+}
+
+void LoopUnswitch::fold_branch(Ptr<BasicBlock> bb, bool taken) {
+    auto br = bb->get_terminator();
+    auto target = br->get_operand(taken ? 1 : 2)->as<BasicBlock>();
+    auto dead = br->get_operand(taken ? 2 : 1)->as<BasicBlock>();
+    for (auto inst : dead->get_instructions()) {
+        if (!inst->is_phi()) {
+            break;
+        }
+        for (int i = static_cast<int>(inst->get_num_operand()) - 2; i >= 0; i -= 2) {
+            if (inst->get_operand(i + 1) == bb) {
+                inst->remove_operands(i, i + 1);
+            }
+        }
+    }
+    dead->remove_pre_basic_block(bb);
+    target->remove_pre_basic_block(bb);
+    bb->get_succ_basic_blocks().clear();
+    bb->delete_instr(br);
+    BranchInst::create_br(target, bb);
+}
+
+void LoopUnswitch::remove_dead_condition(Ptr<Value> val) {
+    auto inst = dyn_cast<Instruction>(val);
+    if (!inst || !inst->get_use_list().empty() || inst->is_phi()) {
+        return;
+    }
+    auto bb = inst->get_parent();
+    if (bb->find_instruction(inst) == bb->get_instructions().end()) {
+        return;
+    }
+    if (!inst->is_load() && !is_speculatable(inst)) {
+        return;
+    }
+    PtrVec<Value> ops;
+    for (auto &op : inst->get_operands()) {
+        ops.push_back(op.lock());
+    }
+    bb->delete_instr(inst);
+    for (auto op : ops) {
+        remove_dead_condition(op);
+    }
+}
+
+}
+}
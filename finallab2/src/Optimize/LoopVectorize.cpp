@@ -0,0 +1,582 @@
+#include "LoopVectorize.h"
+#include "AliasUtils.h"
+#include "CloneUtils.h"
+#include "ConditionUtils.h"
+#include "Remarks.h"
+#include "Statistics.h"
+#include <cstdlib>
+#include <limits>
+
+namespace SysYF {
+namespace IR {
+
+static Statistic num_vectorized("LoopVectorize", "loops vectorized");
+static Statistic num_missed("LoopVectorize", "loops not vectorized");
+
+namespace {
+
+Ptr<Value> get_incoming(Ptr<PhiInst> phi, Ptr<BasicBlock> bb) {
+    for (unsigned i = 0; i < phi->get_num_operand(); i += 2) {
+        if (phi->get_operand(i + 1) == bb) {
+            return phi->get_operand(i);
+        }
+    }
+    return nullptr;
+}
+
+void set_incoming(Ptr<PhiInst> phi, Ptr<BasicBlock> old_bb, Ptr<Value> val, Ptr<BasicBlock> new_bb) {
+    for (unsigned i = 0; i < phi->get_num_operand(); i += 2) {
+        if (phi->get_operand(i + 1) == old_bb) {
+            phi->set_operand(i, val);
+            phi->set_operand(i + 1, new_bb);
+        }
+    }
+}
+
+bool is_const_int(Ptr<Value> val, int expected) {
+    auto const_val = dyn_cast<ConstantInt>(val);
+    return const_val && const_val->get_value() == expected;
+}
+
+bool is_vectorizable_type(Ptr<Type> ty) {
+    if (ty->is_integer_type()) {
+        return static_pointer_cast<IntegerType>(ty)->get_num_bits() == 32;
+    }
+    return ty->is_float_type();
+}
+
+}
+
+bool LoopVectorize::execute() {
+    bool changed = false;
+    for (auto f : module.lock()->get_functions()) {
+        // the vector loops are appended to the block list, walk a copy
+        PtrVec<BasicBlock> bbs(f->get_basic_blocks().begin(), f->get_basic_blocks().end());
+        for (auto bb : bbs) {
+            changed |= vectorize(bb);
+        }
+    }
+    return changed;
+}
+
+bool LoopVectorize::vectorize(Ptr<BasicBlock> header) {
+    LoopShape loop;
+    loop_ = &loop;
+    kinds_.clear();
+    offsets_.clear();
+    accesses_.clear();
+    scalars_.clear();
+    vectors_.clear();
+    missed_at_ = nullptr;
+    missed_reason_.clear();
+    if (remainders_.count(header)) {
+        return false;
+    }
+    if (!match_loop(header, loop) || !classify(loop) || !check_dependences()) {
+        // only loops of the right shape say why, most blocks are no loop headers at all
+        if (!missed_reason_.empty()) {
+            ++num_missed;
+            Remark::emit(Remark(Remark::Missed, name, "NotVectorized", missed_at_)
+                             .arg("Loop", header).arg("Reason", missed_reason_));
+        }
+        return false;
+    }
+    ++num_vectorized;
+    Remark::emit(Remark(Remark::Passed, name, "Vectorized", header).arg("Width", vector_width));
+    transform(loop);
+    remainders_.insert(header);
+    return true;
+}
+
+bool LoopVectorize::miss(Ptr<Instruction> inst, const std::string &reason) {
+    missed_at_ = inst;
+    missed_reason_ = reason;
+    return false;
+}
+
+bool LoopVectorize::is_in_loop(Ptr<Value> val) {
+    auto inst = dyn_cast<Instruction>(val);
+    return inst && (inst->get_parent() == loop_->header || inst->get_parent() == loop_->body);
+}
+
+bool LoopVectorize::match_loop(Ptr<BasicBlock> header, LoopShape &loop) {
+    auto br = header->get_terminator();
+    if (!br || !br->is_br() || br->get_num_operand() != 3) {
+        return false;
+    }
+    loop.header = header;
+    loop.body = br->get_operand(1)->as<BasicBlock>();
+    loop.exit = br->get_operand(2)->as<BasicBlock>();
+    if (loop.body == header || loop.exit == header || loop.body == loop.exit) {
+        return false;
+    }
+    auto body_br = loop.body->get_terminator();
+    if (loop.body->get_pre_basic_blocks().size() != 1 || !body_br || !body_br->is_br() ||
+        body_br->get_num_operand() != 1 || body_br->get_operand(0) != header) {
+        return false;
+    }
+    if (header->get_pre_basic_blocks().size() != 2) {
+        return false;
+    }
+    for (auto pre_bb : header->get_pre_basic_blocks()) {
+        if (pre_bb.lock() != loop.body) {
+            loop.preheader = pre_bb.lock();
+        }
+    }
+    if (!loop.preheader) {
+        return false;
+    }
+
+    // the exit test is %i < %n, maybe still wrapped as icmp ne (zext (icmp slt %i, %n)), 0
+    PtrVec<Instruction> exit_test;
+    auto cmp = dyn_cast<CmpInst>(br->get_operand(0));
+    if (!cmp) {
+        return false;
+    }
+    exit_test.push_back(cmp);
+    if (cmp->get_cmp_op() == CmpInst::NE && is_const_int(cmp->get_operand(1), 0)) {
+        auto zext = dyn_cast<ZextInst>(cmp->get_operand(0));
+        auto inner = zext ? dyn_cast<CmpInst>(zext->get_operand(0)) : nullptr;
+        if (inner) {
+            exit_test.push_back(zext);
+            exit_test.push_back(inner);
+            cmp = inner;
+        }
+    }
+    Ptr<Value> iv;
+    if (cmp->get_cmp_op() == CmpInst::LT) {
+        iv = cmp->get_operand(0);
+        loop.bound = cmp->get_operand(1);
+    }
+    else if (cmp->get_cmp_op() == CmpInst::GT) {
+        iv = cmp->get_operand(1);
+        loop.bound = cmp->get_operand(0);
+    }
+    else {
+        return false;
+    }
+    loop.iv = dyn_cast<PhiInst>(iv);
+    if (!loop.iv || loop.iv->get_parent() != header || is_in_loop(loop.bound)) {
+        return false;
+    }
+
+    // the header holds nothing but its phis and the exit test
+    for (auto inst : header->get_instructions()) {
+        if (inst->is_phi() || inst == br) {
+            continue;
+        }
+        if (std::find(exit_test.begin(), exit_test.end(), inst) == exit_test.end()) {
+            return false;
+        }
+        for (auto &use : inst->get_use_list()) {
+            if (use.val_.lock()->as<Instruction>()->get_parent() != header) {
+                return false;
+            }
+        }
+    }
+    for (auto inst : header->get_instructions()) {
+        if (!inst->is_phi()) {
+            break;
+        }
+        auto phi = static_pointer_cast<PhiInst>(inst);
+        if (phi->get_num_operand() != 4) {
+            return false;
+        }
+        if (phi != loop.iv) {
+            if (!match_reduction(phi, loop)) {
+                return miss(phi, "a header phi is neither the induction variable nor an integer sum");
+            }
+            continue;
+        }
+        auto next = dyn_cast<Instruction>(get_incoming(phi, loop.body));
+        if (!next || next->get_parent() != loop.body || !next->is_add() ||
+            !((next->get_operand(0) == phi && is_const_int(next->get_operand(1), 1)) ||
+              (next->get_operand(1) == phi && is_const_int(next->get_operand(0), 1)))) {
+            return false;
+        }
+        loop.iv_next = next;
+    }
+    if (!loop.iv_next) {
+        return false;
+    }
+    for (auto &use : loop.iv_next->get_use_list()) {
+        if (use.val_.lock() != loop.iv) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// phi = [ %init, %pre ], [ phi + x or phi - x, %body ], integer only since
+// summing per lane reorders the additions
+bool LoopVectorize::match_reduction(Ptr<PhiInst> phi, LoopShape &loop) {
+    if (!is_vectorizable_type(phi->get_type()) || !phi->get_type()->is_integer_type()) {
+        return false;
+    }
+    auto update = dyn_cast<Instruction>(get_incoming(phi, loop.body));
+    if (!update || update->get_parent() != loop.body) {
+        return false;
+    }
+    Ptr<Value> x;
+    if (update->is_add()) {
+        x = update->get_operand(0) == phi ? update->get_operand(1) :
+            update->get_operand(1) == phi ? update->get_operand(0) : nullptr;
+    }
+    else if (update->is_sub() && update->get_operand(0) == phi) {
+        x = update->get_operand(1);
+    }
+    if (!x || x == phi) {
+        return false;
+    }
+    for (auto &use : phi->get_use_list()) {
+        auto user = use.val_.lock();
+        if (user != update && is_in_loop(user)) {
+            return false;
+        }
+    }
+    for (auto &use : update->get_use_list()) {
+        if (use.val_.lock() != phi) {
+            return false;
+        }
+    }
+    loop.reductions.push_back(phi);
+    loop.updates.push_back(update);
+    return true;
+}
+
+bool LoopVectorize::classify(LoopShape &loop) {
+    kinds_[loop.iv] = Kind::Induction;
+    offsets_[loop.iv] = 0;
+    auto get_kind = [&](Ptr<Value> val, Kind &kind) {
+        auto iter = kinds_.find(val);
+        if (iter != kinds_.end()) {
+            kind = iter->second;
+            return true;
+        }
+        kind = Kind::Invariant;
+        return !is_in_loop(val);
+    };
+    auto is_update = [&](Ptr<Instruction> inst) {
+        return std::find(loop.updates.begin(), loop.updates.end(), inst) != loop.updates.end();
+    };
+
+    bool has_work = !loop.reductions.empty();
+    for (auto inst : loop.body->get_instructions()) {
+        if (inst->isTerminator() || inst == loop.iv_next || is_update(inst)) {
+            continue;
+        }
+        std::vector<Kind> ops(inst->get_num_operand());
+        for (unsigned i = 0; i < inst->get_num_operand(); i++) {
+            if (!get_kind(inst->get_operand(i), ops[i])) {
+                return miss(inst, "an operand is a header phi or is computed later in the body");
+            }
+        }
+        Kind kind;
+        if (inst->is_gep()) {
+            // all but the last index select the row, the last one walks along it
+            auto gep = static_pointer_cast<GetElementPtrInst>(inst);
+            if (!is_vectorizable_type(gep->get_element_type()) || ops.back() != Kind::Induction) {
+                return miss(inst, "an access is not consecutive in the induction variable");
+            }
+            for (unsigned i = 0; i + 1 < ops.size(); i++) {
+                if (ops[i] != Kind::Invariant) {
+                    return miss(inst, "an access selects a row that changes in the loop");
+                }
+            }
+            kind = Kind::Address;
+        }
+        else if (inst->is_load() || inst->is_store()) {
+            auto ptr_no = inst->is_load() ? 0 : 1;
+            if (ops[ptr_no] != Kind::Address || (inst->is_store() && ops[0] == Kind::Address)) {
+                return miss(inst, "a load or store does not go through a consecutive gep");
+            }
+            auto gep = static_pointer_cast<GetElementPtrInst>(inst->get_operand(ptr_no));
+            auto idx = gep->get_operand(gep->get_num_operand() - 1);
+            accesses_.push_back({inst, inst->is_store(), gep, offsets_[idx]});
+            has_work = true;
+            if (inst->is_store()) {
+                continue;
+            }
+            kind = Kind::Vector;
+        }
+        else if (inst->isBinary()) {
+            if (inst->is_div() || inst->is_rem() || inst->is_udiv() || inst->is_urem() || !is_vectorizable_type(inst->get_type()) ||
+                ops[0] == Kind::Address || ops[1] == Kind::Address) {
+                return miss(inst, "the body divides, or computes on something other than i32 or float");
+            }
+            auto lhs_const = dyn_cast<ConstantInt>(inst->get_operand(0));
+            auto rhs_const = dyn_cast<ConstantInt>(inst->get_operand(1));
+            long long offset = 0;
+            bool affine = false;
+            if (inst->is_add() && ops[0] == Kind::Induction && rhs_const) {
+                offset = static_cast<long long>(offsets_[inst->get_operand(0)]) + rhs_const->get_value();
+                affine = true;
+            }
+            else if (inst->is_add() && ops[1] == Kind::Induction && lhs_const) {
+                offset = static_cast<long long>(offsets_[inst->get_operand(1)]) + lhs_const->get_value();
+                affine = true;
+            }
+            else if (inst->is_sub() && ops[0] == Kind::Induction && rhs_const) {
+                offset = static_cast<long long>(offsets_[inst->get_operand(0)]) - rhs_const->get_value();
+                affine = true;
+            }
+            if (affine && std::llabs(offset) < (1 << 30)) {
+                kind = Kind::Induction;
+                offsets_[inst] = static_cast<int>(offset);
+            }
+            else if (ops[0] == Kind::Invariant && ops[1] == Kind::Invariant) {
+                kind = Kind::Invariant;
+            }
+            else {
+                kind = Kind::Vector;
+                has_work = true;
+            }
+        }
+        else if (inst->is_sitofp() || inst->is_fptosi()) {
+            kind = ops[0] == Kind::Invariant ? Kind::Invariant : Kind::Vector;
+        }
+        else {
+            return miss(inst, std::string("the body has a ") + inst->get_instr_op_name());
+        }
+        kinds_[inst] = kind;
+    }
+
+    // the value a sum adds up must exist per lane
+    for (unsigned k = 0; k < loop.updates.size(); k++) {
+        auto update = loop.updates[k];
+        auto x = update->get_operand(0) == loop.reductions[k] ? update->get_operand(1) : update->get_operand(0);
+        Kind kind;
+        if (!get_kind(x, kind) || kind == Kind::Address) {
+            return miss(update, "a sum adds up a value that does not exist per lane");
+        }
+    }
+
+    // body values stay in the body, geps only serve as load and store pointers
+    for (auto inst : loop.body->get_instructions()) {
+        if (inst->isTerminator() || inst == loop.iv_next || is_update(inst)) {
+            continue;
+        }
+        for (auto &use : inst->get_use_list()) {
+            auto user = use.val_.lock()->as<Instruction>();
+            if (user->get_parent() != loop.body) {
+                return miss(inst, "a value of the body is used outside of it");
+            }
+            if (kinds_[inst] == Kind::Address &&
+                !(user->is_load() || (user->is_store() && use.arg_no_ == 1))) {
+                return miss(inst, "an address is used by other than a load or store");
+            }
+        }
+    }
+    return has_work;
+}
+
+// a vector iteration does the loads and stores of vector_width scalar
+// iterations one instruction at a time, which is only the same when no two
+// of those iterations touch the same element through different accesses
+bool LoopVectorize::check_dependences() {
+    for (unsigned i = 0; i < accesses_.size(); i++) {
+        for (unsigned j = i + 1; j < accesses_.size(); j++) {
+            auto &a = accesses_[i];
+            auto &b = accesses_[j];
+            if (!a.is_store && !b.is_store) {
+                continue;
+            }
+            auto root_a = get_underlying_object(a.gep);
+            auto root_b = get_underlying_object(b.gep);
+            if (root_a != root_b) {
+                if (may_alias_objects(root_a, root_b)) {
+                    return miss(b.inst, "an access may alias an array that is written");
+                }
+                continue;
+            }
+            // the same row of the same array, compare the distance along it
+            auto num_ops = a.gep->get_num_operand();
+            if (num_ops != b.gep->get_num_operand()) {
+                return miss(b.inst, "an array that is written is accessed with different numbers of indices");
+            }
+            for (unsigned k = 0; k + 1 < num_ops; k++) {
+                if (!is_same_value(a.gep->get_operand(k), b.gep->get_operand(k))) {
+                    return miss(b.inst, "an array that is written is accessed in rows that may overlap");
+                }
+            }
+            auto distance = std::abs(a.offset - b.offset);
+            if (distance != 0 && distance < vector_width) {
+                return miss(b.inst, "accesses to an array that is written are less than the vector width apart");
+            }
+        }
+    }
+    return true;
+}
+
+Ptr<Value> LoopVectorize::get_scalar(Ptr<Value> val) {
+    auto iter = scalars_.find(val);
+    return iter == scalars_.end() ? val : iter->second;
+}
+
+Ptr<Value> LoopVectorize::splat(Ptr<Value> val, Ptr<BasicBlock> bb) {
+    auto m = module.lock();
+    Ptr<Value> vec = ConstantZero::create(VectorType::get(val->get_type(), vector_width), m);
+    for (int lane = 0; lane < vector_width; lane++) {
+        vec = InsertElementInst::create_insertelement(vec, val, ConstantInt::create(lane, m), bb);
+    }
+    return vec;
+}
+
+Ptr<Value> LoopVectorize::widen(Ptr<Value> val) {
+    auto iter = vectors_.find(val);
+    if (iter != vectors_.end()) {
+        return iter->second;
+    }
+    auto m = module.lock();
+    Ptr<Value> vec;
+    if (kinds_.count(val) && kinds_[val] == Kind::Induction) {
+        // lane k holds the value of iteration %i + k
+        PtrVec<Constant> steps;
+        for (int lane = 0; lane < vector_width; lane++) {
+            steps.push_back(ConstantInt::create(lane, m));
+        }
+        auto step_ty = VectorType::get(Type::get_int32_type(m), vector_width);
+        vec = BinaryInst::create_add(splat(get_scalar(val), vec_body_), ConstantVector::create(step_ty, steps, m),
+                                     vec_body_, m);
+    }
+    else if (isa<ConstantInt>(val) || isa<ConstantFloat>(val)) {
+        vec = ConstantVector::get_splat(vector_width, val->as<Constant>(), m);
+    }
+    else {
+        vec = splat(get_scalar(val), vec_pre_);
+    }
+    vectors_[val] = vec;
+    return vec;
+}
+
+void LoopVectorize::transform(LoopShape &loop) {
+    auto m = module.lock();
+    auto f = loop.header->get_parent();
+    auto i32 = Type::get_int32_type(m);
+    vec_pre_ = BasicBlock::create(m, "", f);
+    auto vec_header = BasicBlock::create(m, "", f);
+    vec_body_ = BasicBlock::create(m, "", f);
+    auto middle = BasicBlock::create(m, "", f);
+
+    // enter the vector loop first
+    auto pre_br = loop.preheader->get_terminator();
+    for (unsigned i = 0; i < pre_br->get_num_operand(); i++) {
+        if (pre_br->get_operand(i) == loop.header) {
+            pre_br->set_operand(i, vec_pre_);
+        }
+    }
+    loop.preheader->remove_succ_basic_block(loop.header);
+    loop.header->remove_pre_basic_block(loop.preheader);
+    loop.preheader->add_succ_basic_block(vec_pre_);
+    vec_pre_->add_pre_basic_block(loop.preheader);
+
+    // vector header: stay while at least vector_width iterations are left
+    auto vec_iv = PhiInst::create_phi(i32, vec_header);
+    vec_header->add_instruction(vec_iv);
+    vec_iv->add_phi_pair_operand(get_incoming(loop.iv, loop.preheader), vec_pre_);
+    PtrVec<PhiInst> vec_sums;
+    for (auto phi : loop.reductions) {
+        auto vec_ty = VectorType::get(phi->get_type(), vector_width);
+        auto vec_sum = PhiInst::create_phi(vec_ty, vec_header);
+        vec_header->add_instruction(vec_sum);
+        vec_sum->add_phi_pair_operand(ConstantZero::create(vec_ty, m), vec_pre_);
+        vec_sums.push_back(vec_sum);
+    }
+    // bound - iv wraps when they are far apart, compare iv with
+    // bound - (vector_width - 1) instead, which is computed only once it
+    // cannot wrap: a smaller bound leaves room for no vector iteration
+    auto room = CmpInst::create_cmp(CmpInst::GT, loop.bound,
+                                    ConstantInt::create(std::numeric_limits<int>::min() + vector_width - 2, m),
+                                    vec_pre_, m);
+    auto limit = BinaryInst::create_sub(loop.bound, ConstantInt::create(vector_width - 1, m), vec_pre_, m);
+    auto below = CmpInst::create_cmp(CmpInst::LT, vec_iv, limit, vec_header, m);
+    auto full = BinaryInst::create_and(room, below, vec_header, m);
+    BranchInst::create_cond_br(full, vec_body_, middle, vec_header);
+
+    // vector body, invariant computations go to vec_pre_
+    scalars_[loop.iv] = vec_iv;
+    for (auto inst : loop.body->get_instructions()) {
+        if (inst->isTerminator() || inst == loop.iv_next) {
+            continue;
+        }
+        auto update = std::find(loop.updates.begin(), loop.updates.end(), inst);
+        if (update != loop.updates.end()) {
+            auto vec_sum = vec_sums[update - loop.updates.begin()];
+            auto x = inst->get_operand(0) == loop.reductions[update - loop.updates.begin()] ?
+                     inst->get_operand(1) : inst->get_operand(0);
+            vectors_[inst] = BinaryInst::create(inst->get_instr_type(), vec_sum, widen(x), vec_body_);
+            continue;
+        }
+        if (inst->is_store()) {
+            auto val = widen(inst->get_operand(0));
+            auto store = StoreInst::create_store(val, vectors_[inst->get_operand(1)], vec_body_);
+            store->set_alignment(inst->get_operand(0)->get_type()->get_size());
+            continue;
+        }
+        auto elem_ty = inst->get_type()->is_pointer_type() ? inst->get_type()->get_pointer_element_type()
+                                                           : inst->get_type();
+        auto vec_ty = VectorType::get(elem_ty, vector_width);
+        switch (kinds_[inst]) {
+            case Kind::Invariant: {
+                auto copy = clone_instruction(inst, vec_pre_, scalars_);
+                remap_operands(copy, scalars_);
+                scalars_[inst] = copy;
+                break;
+            }
+            case Kind::Induction: {
+                auto copy = clone_instruction(inst, vec_body_, scalars_);
+                remap_operands(copy, scalars_);
+                scalars_[inst] = copy;
+                break;
+            }
+            case Kind::Address: {
+                auto copy = clone_instruction(inst, vec_body_, scalars_);
+                remap_operands(copy, scalars_);
+                vectors_[inst] = BitCastInst::create_bitcast(copy, PointerType::get(vec_ty), vec_body_);
+                break;
+            }
+            case Kind::Vector: {
+                if (inst->is_load()) {
+                    auto load = LoadInst::create_load(vec_ty, vectors_[inst->get_operand(0)], vec_body_);
+                    load->set_alignment(elem_ty->get_size());
+                    vectors_[inst] = load;
+                }
+                else if (inst->is_sitofp()) {
+                    vectors_[inst] = SiToFpInst::create_sitofp(widen(inst->get_operand(0)), vec_ty, vec_body_);
+                }
+                else if (inst->is_fptosi()) {
+                    vectors_[inst] = FpToSiInst::create_fptosi(widen(inst->get_operand(0)), vec_ty, vec_body_);
+                }
+                else {
+                    auto lhs = widen(inst->get_operand(0));
+                    auto rhs = widen(inst->get_operand(1));
+                    vectors_[inst] = BinaryInst::create(inst->get_instr_type(), lhs, rhs, vec_body_);
+                }
+                break;
+            }
+        }
+    }
+    auto vec_iv_next = BinaryInst::create_add(vec_iv, ConstantInt::create(vector_width, m), vec_body_, m);
+    BranchInst::create_br(vec_header, vec_body_);
+    vec_iv->add_phi_pair_operand(vec_iv_next, vec_body_);
+    for (unsigned k = 0; k < vec_sums.size(); k++) {
+        vec_sums[k]->add_phi_pair_operand(vectors_[loop.updates[k]], vec_body_);
+    }
+    BranchInst::create_br(vec_header, vec_pre_);
+
+    // add up the lanes, the scalar loop finishes the remaining iterations
+    set_incoming(loop.iv, loop.preheader, vec_iv, middle);
+    for (unsigned k = 0; k < vec_sums.size(); k++) {
+        auto phi = loop.reductions[k];
+        auto sum = get_incoming(phi, loop.preheader);
+        for (int lane = 0; lane < vector_width; lane++) {
+            auto elem = ExtractElementInst::create_extractelement(vec_sums[k], ConstantInt::create(lane, m), middle);
+            sum = BinaryInst::create_add(sum, elem, middle, m);
+        }
+        set_incoming(phi, loop.preheader, sum, middle);
+    }
+    BranchInst::create_br(loop.header, middle);
+}
+
+}
+}
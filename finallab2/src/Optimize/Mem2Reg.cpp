@@ -1,11 +1,17 @@
 #include "Mem2Reg.h"
 #include "IRBuilder.h"
+#include "Remarks.h"
+#include "Statistics.h"
 #include <cstddef>
 
 namespace SysYF {
 namespace IR {
 
-void Mem2Reg::execute(){
+static Statistic num_phis("Mem2Reg", "phis inserted");
+static Statistic num_promoted("Mem2Reg", "allocas promoted");
+
+bool Mem2Reg::execute(){
+    bool changed = false;
     for(auto fun: module.lock()->get_functions()){
         if(fun->get_basic_blocks().empty())continue;
         func_ = fun;
@@ -13,11 +19,13 @@ void Mem2Reg::execute(){
         no_union_set.clear();
         insideBlockForwarding();
         genPhi();
-        module.lock()->set_print_name();
+        // only the new phis are unnamed, the other functions are left as they are
+        fun->set_instr_name();
         valueDefineCounting();
         valueForwarding(func_.lock()->get_entry_block());
-        removeAlloc();
+        changed |= removeAlloc();
     }
+    return changed;
 }
 
 void Mem2Reg::insideBlockForwarding(){
@@ -31,7 +39,7 @@ void Mem2Reg::insideBlockForwarding(){
             if(inst->get_instr_type() == Instruction::OpID::store){
                 Ptr<Value> lvalue = static_pointer_cast<StoreInst>(inst)->get_lval();
                 Ptr<Value> rvalue = static_pointer_cast<StoreInst>(inst)->get_rval();
-                auto load_inst = dynamic_pointer_cast<Instruction>(rvalue);
+                auto load_inst = dyn_cast<Instruction>(rvalue);
                 if(load_inst && forward_list.find(load_inst) != forward_list.end()){
                     rvalue = forward_list.find(load_inst)->second;
                 }
@@ -61,8 +69,9 @@ void Mem2Reg::insideBlockForwarding(){
         for(auto submap: forward_list){
             auto inst = submap.first; 
             auto value = submap.second;
-            for(auto use: inst->get_use_list()){
-                auto use_inst = dynamic_pointer_cast<Instruction>(use.val_.lock());
+            auto uses = inst->get_use_list();
+            for(auto use: uses){
+                auto use_inst = dyn_cast<Instruction>(use.val_.lock());
                 use_inst->set_operand(use.arg_no_, value);
             }
             bb->delete_instr(inst);
@@ -97,7 +106,22 @@ void Mem2Reg::genPhi(){
 
     Map<Ptr<BasicBlock>, PtrSet<Value>> bb_phi_list;
 
+    // in the order of the allocas, the order of the phis in a block must not depend on addresses
+    PtrVec<Value> vars;
+    for(auto inst: func_.lock()->get_entry_block()->get_instructions()){
+        if(globals.count(inst)){
+            vars.push_back(inst);
+        }
+    }
     for(auto var: globals){
+        if(std::find(vars.begin(), vars.end(), var) == vars.end()){
+            vars.push_back(var);
+        }
+    }
+
+    for(auto var: vars){
+        // the alloca is deleted once its loads and stores are replaced, the remarks keep its name
+        std::string var_name = "%" + var->get_name();
         auto define_bbs = defined_in_block.find(var)->second;
         PtrVec<BasicBlock> queue;
         queue.assign(define_bbs.begin(), define_bbs.end());
@@ -112,6 +136,8 @@ void Mem2Reg::genPhi(){
                             bb_domfront.lock());
                         newphi->set_lval(var);
                         bb_domfront.lock()->add_instr_begin(newphi);
+                        ++num_phis;
+                        Remark::emit(Remark(Remark::Passed, name, "PhiInserted", newphi).arg("Variable", var_name));
                         queue.push_back(bb_domfront.lock());
                     }
                 }
@@ -119,7 +145,9 @@ void Mem2Reg::genPhi(){
                     auto newphi = PhiInst::create_phi(var->get_type()->get_pointer_element_type(), 
                             bb_domfront.lock());
                     newphi->set_lval(var);
-                    bb_domfront.lock()->add_instr_begin(newphi);                  
+                    bb_domfront.lock()->add_instr_begin(newphi);
+                    ++num_phis;
+                    Remark::emit(Remark(Remark::Passed, name, "PhiInserted", newphi).arg("Variable", var_name));
                     queue.push_back(bb_domfront.lock());
                     bb_phi_list.insert({bb_domfront.lock(), {var}});
                 }
@@ -134,12 +162,12 @@ void Mem2Reg::valueDefineCounting(){
         define_var.insert({bb, {}});
         for(auto inst: bb->get_instructions()){
             if(inst->get_instr_type() == Instruction::OpID::phi){
-                auto lvalue = dynamic_pointer_cast<PhiInst>(inst)->get_lval();
+                auto lvalue = cast<PhiInst>(inst)->get_lval();
                 define_var.find(bb)->second.push_back(lvalue);
             }
             else if(inst->get_instr_type() == Instruction::OpID::store){
                 if(!isLocalVarOp(inst))continue;
-                auto lvalue = dynamic_pointer_cast<StoreInst>(inst)->get_lval();
+                auto lvalue = cast<StoreInst>(inst)->get_lval();
                 define_var.find(bb)->second.push_back(lvalue);
             }
         }
@@ -154,7 +182,7 @@ void Mem2Reg::valueForwarding(Ptr<BasicBlock> bb){
     visited.insert(bb);
     for(auto inst: bb->get_instructions()){
         if(inst->get_instr_type() != Instruction::OpID::phi)break;
-        auto lvalue = dynamic_pointer_cast<PhiInst>(inst)->get_lval();
+        auto lvalue = cast<PhiInst>(inst)->get_lval();
         auto value_list = value_status.find(lvalue);
         if(value_list != value_status.end()){
             value_list->second.push_back(inst);
@@ -188,7 +216,7 @@ void Mem2Reg::valueForwarding(Ptr<BasicBlock> bb){
     for(auto succbb: bb->get_succ_basic_blocks()){
         for(auto inst: succbb.lock()->get_instructions()){
             if(inst->get_instr_type() == Instruction::OpID::phi){
-                auto phi = dynamic_pointer_cast<PhiInst>(inst);
+                auto phi = dyn_cast<PhiInst>(inst);
                 auto lvalue = phi->get_lval();
                 if(value_status.find(lvalue) != value_status.end()){
                     if(value_status.find(lvalue)->second.size() > 0){
@@ -227,19 +255,23 @@ void Mem2Reg::valueForwarding(Ptr<BasicBlock> bb){
     }
 } 
 
-void Mem2Reg::removeAlloc(){
+bool Mem2Reg::removeAlloc(){
+    bool changed = false;
     for(auto bb: func_.lock()->get_basic_blocks()){
         PtrSet<Instruction> delete_list;
         for(auto inst: bb->get_instructions()){
             if(inst->get_instr_type() != Instruction::OpID::alloca)continue;
-            auto alloc_inst = dynamic_pointer_cast<AllocaInst>(inst);
+            auto alloc_inst = dyn_cast<AllocaInst>(inst);
             if(alloc_inst->get_alloca_type()->is_integer_type() || alloc_inst->get_alloca_type()->is_float_type() ||
                alloc_inst->get_alloca_type()->is_pointer_type())delete_list.insert(inst);
         }
         for(auto inst: delete_list){
             bb->delete_instr(inst);
         }
+        num_promoted += delete_list.size();
+        changed |= !delete_list.empty();
     }
+    return changed;
 }
 
 
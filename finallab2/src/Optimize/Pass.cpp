@@ -1,2 +1,217 @@
 #include "Pass.h"
+#include "Check.h"
+#include "CodeSizeOptimizer.h"
+#include "ComSubExprEli.h"
+#include "DivRemLowering.h"
+#include "DominateTree.h"
+#include "FinalValueReplacement.h"
+#include "GlobalDCE.h"
+#include "IPConstProp.h"
+#include "IfConversion.h"
+#include "InstCombine.h"
+#include "JumpThreading.h"
+#include "LazyCodeMotion.h"
+#include "LiveVar.h"
+#include "LoopUnswitch.h"
+#include "LoopVectorize.h"
+#include "Mem2Reg.h"
+#include "RDominateTree.h"
+#include "SLPVectorizer.h"
+#include "SwitchFormation.h"
+#include "ValueRange.h"
+#include <cctype>
+#include <iostream>
 
+namespace SysYF{
+namespace IR{
+
+namespace {
+
+bool is_name_char(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_';
+}
+
+// the longest run of name characters at pos
+std::string read_name(const std::string &text, std::size_t &pos) {
+    auto start = pos;
+    while (pos < text.size() && is_name_char(text[pos])) {
+        pos++;
+    }
+    return text.substr(start, pos - start);
+}
+
+bool expect(const std::string &text, std::size_t &pos, char c, std::string &error) {
+    if (pos < text.size() && text[pos] == c) {
+        pos++;
+        return true;
+    }
+    error = std::string("expected '") + c + "' at position " + std::to_string(pos);
+    return false;
+}
+
+}
+
+bool Pass::parse_int(const std::string &value, int &result) {
+    if (value.empty() || value.size() > 9) {
+        return false;
+    }
+    for (char c : value) {
+        if (!std::isdigit(static_cast<unsigned char>(c))) {
+            return false;
+        }
+    }
+    result = std::stoi(value);
+    return true;
+}
+
+std::map<std::string, PassMgr::PassFactory> &PassMgr::get_registry() {
+    static std::map<std::string, PassFactory> registry;
+    static bool initialized = false;
+    if (!initialized) {
+        // set first, register_pass() comes back here
+        initialized = true;
+        register_pass<DominateTree>("domtree");
+        register_pass<RDominateTree>("rdomtree");
+        register_pass<Mem2Reg>("mem2reg");
+        register_pass<Check>("verify");
+        register_pass<LiveVar>("lv");
+        register_pass<ComSubExprEli>("cse");
+        register_pass<IPConstProp>("ipcp");
+        register_pass<GlobalDCE>("gdce");
+        register_pass<InstCombine>("instcombine");
+        register_pass<ValueRange>("vrp");
+        register_pass<JumpThreading>("jump-threading");
+        register_pass<LoopUnswitch>("unswitch");
+        register_pass<LazyCodeMotion>("pre");
+        register_pass<IfConversion>("ifconv");
+        register_pass<SwitchFormation>("switch");
+        register_pass<FinalValueReplacement>("fvr");
+        register_pass<LoopVectorize>("vectorize");
+        register_pass<SLPVectorizer>("slp");
+        register_pass<DivRemLowering>("divrem");
+        register_pass<CodeSizeOptimizer>("optimize-size");
+    }
+    return registry;
+}
+
+bool PassMgr::parse_pipeline(const std::string &text, std::string &error) {
+    std::vector<Node> nodes;
+    std::size_t pos = 0;
+    if (!parse_elements(text, pos, nodes, error)) {
+        return false;
+    }
+    if (pos != text.size()) {
+        error = "unexpected '" + std::string(1, text[pos]) + "' at position " + std::to_string(pos);
+        return false;
+    }
+    pipeline.insert(pipeline.end(), nodes.begin(), nodes.end());
+    return true;
+}
+
+bool PassMgr::parse_elements(const std::string &text, std::size_t &pos, std::vector<Node> &nodes, std::string &error) {
+    while (true) {
+        auto start = pos;
+        auto name = read_name(text, pos);
+        if (name.empty()) {
+            error = "expected a pass at position " + std::to_string(start);
+            return false;
+        }
+        if (name == "repeat" || name == "fixpoint") {
+            Node group{name == "repeat" ? Node::Repeat : Node::Fixpoint, nullptr, max_fixpoint_rounds, {}};
+            if (pos < text.size() && text[pos] == '<') {
+                pos++;
+                auto count_pos = pos;
+                if (!Pass::parse_int(read_name(text, pos), group.count)) {
+                    error = "expected a count at position " + std::to_string(count_pos);
+                    return false;
+                }
+                if (!expect(text, pos, '>', error)) {
+                    return false;
+                }
+            } else if (group.kind == Node::Repeat) {
+                error = "repeat needs a count at position " + std::to_string(pos);
+                return false;
+            }
+            if (!expect(text, pos, '(', error) ||
+                !parse_elements(text, pos, group.children, error) ||
+                !expect(text, pos, ')', error)) {
+                return false;
+            }
+            nodes.push_back(group);
+        } else {
+            auto &registry = get_registry();
+            auto iter = registry.find(name);
+            if (iter == registry.end()) {
+                error = "unknown pass '" + name + "' at position " + std::to_string(start);
+                return false;
+            }
+            auto pass = iter->second(module);
+            if (pos < text.size() && text[pos] == '<') {
+                do {
+                    pos++;
+                    auto option_pos = pos;
+                    auto key = read_name(text, pos);
+                    if (!expect(text, pos, '=', error)) {
+                        return false;
+                    }
+                    auto value = read_name(text, pos);
+                    if (!pass->set_option(key, value)) {
+                        error = "invalid option '" + key + "=" + value + "' of " + name + " at position " + std::to_string(option_pos);
+                        return false;
+                    }
+                } while (pos < text.size() && text[pos] == ';');
+                if (!expect(text, pos, '>', error)) {
+                    return false;
+                }
+            }
+            nodes.push_back({Node::Single, pass, 1, {}});
+        }
+        if (pos == text.size() || text[pos] != ',') {
+            return true;
+        }
+        pos++;
+    }
+}
+
+void PassMgr::execute() {
+    // one checker for the whole pipeline, it skips the functions it saw unchanged
+    Check check(module);
+    ran_pass = false;
+    run(pipeline, check);
+    // checked once at the end, which pass broke the IR is not known
+    if (verify_mode == VerifyAfterPipeline && ran_pass) {
+        verify(check, "the pipeline");
+    }
+}
+
+bool PassMgr::run(const std::vector<Node> &nodes, Check &check) {
+    bool changed = false;
+    for (auto &node : nodes) {
+        if (node.kind == Node::Single) {
+            changed |= node.pass->execute();
+            ran_pass = true;
+            if (verify_mode == VerifyAfterEachPass) {
+                verify(check, node.pass->get_name());
+            }
+        } else if (node.kind == Node::Repeat) {
+            for (int i = 0; i < node.count; i++) {
+                changed |= run(node.children, check);
+            }
+        } else {
+            for (int i = 0; i < node.count && run(node.children, check); i++) {
+                changed = true;
+            }
+        }
+    }
+    return changed;
+}
+
+void PassMgr::verify(Check &check, const std::string &where) {
+    if (check.verify() != 0) {
+        std::cerr << "The IR is broken after " << where << "." << std::endl;
+        exit(1);
+    }
+}
+
+}
+}
@@ -3,7 +3,7 @@
 namespace SysYF {
 namespace IR {
 
-void RDominateTree::execute() {
+bool RDominateTree::execute() {
     for(auto f:module.lock()->get_functions()){
         if(f->get_basic_blocks().empty()){
             continue;
@@ -16,18 +16,18 @@ void RDominateTree::execute() {
         get_bb_rdom_front(f);
         get_bb_rdoms(f);
     }
+    return false;
 }
 
-void RDominateTree::get_post_order(Ptr<BasicBlock> bb, PtrSet<BasicBlock> &visited) {
-    visited.insert(bb);
+void RDominateTree::get_post_order(Ptr<BasicBlock> bb, SmallPtrSet<BasicBlock *, 16> &visited) {
+    visited.insert(bb.get());
     auto parents = bb->get_pre_basic_blocks();
     for(auto parent : parents){
-        auto is_visited = visited.find(parent.lock());
-        if(is_visited==visited.end()){
+        if(!visited.count(parent.lock().get())){
             get_post_order(parent.lock(),visited);
         }
     }
-    bb2int[bb] = reverse_post_order.size();
+    bb2int[bb.get()] = reverse_post_order.size();
     reverse_post_order.push_back(bb);
 }
 
@@ -47,7 +47,7 @@ void RDominateTree::get_revserse_post_order(Ptr<Function> f) {
         std::cerr << "err function:\n" << f->print() << std::endl;
         exit(1);
     }
-    PtrSet<BasicBlock> visited = {};
+    SmallPtrSet<BasicBlock *, 16> visited;
     get_post_order(exit_block, visited);
     reverse_post_order.reverse();
 }
@@ -56,7 +56,7 @@ void RDominateTree::get_bb_irdom(Ptr<Function> f) {
     get_revserse_post_order(f);
 
     auto root = exit_block;
-    auto root_id = bb2int[root];
+    auto root_id = bb2int[root.get()];
 
     for(int i = 0;i < root_id;i++){
         rdoms.push_back(nullptr);
@@ -74,18 +74,18 @@ void RDominateTree::get_bb_irdom(Ptr<Function> f) {
             auto rpreds = bb->get_succ_basic_blocks();
             Ptr<BasicBlock> new_irdom = nullptr;
             for(auto rpred_bb:rpreds){
-                if(rdoms[bb2int[rpred_bb.lock()]] != nullptr){
+                if(rdoms[bb2int[rpred_bb.lock().get()]] != nullptr){
                     new_irdom = rpred_bb.lock();
                     break;
                 }
             }
             for(auto rpred_bb:rpreds){
-                if(rdoms[bb2int[rpred_bb.lock()]] != nullptr){
+                if(rdoms[bb2int[rpred_bb.lock().get()]] != nullptr){
                     new_irdom = intersect(rpred_bb.lock(), new_irdom);
                 }
             }
-            if(rdoms[bb2int[bb]] != new_irdom){
-                rdoms[bb2int[bb]] = new_irdom;
+            if(rdoms[bb2int[bb.get()]] != new_irdom){
+                rdoms[bb2int[bb.get()]] = new_irdom;
                 changed = true;
             }
         }
@@ -100,22 +100,22 @@ void RDominateTree::get_bb_rdoms(Ptr<Function> f) {
         auto current = bb;
         while(current != exit_block){
             bb->add_rdom(current);
-            current = rdoms[bb2int[current]];
+            current = rdoms[bb2int[current.get()]];
         }
     }
 }
 
 void RDominateTree::get_bb_rdom_front(Ptr<Function> f) {
-    auto all_bbs = f->get_basic_blocks();
+    auto &all_bbs = f->get_basic_blocks();
     for(auto bb_iter=all_bbs.rbegin(); bb_iter!=all_bbs.rend(); bb_iter++){//reverse bb order;
         auto bb = *bb_iter;
         auto b_rpred = bb->get_succ_basic_blocks();
         if(b_rpred.size() >= 2){
             for(auto rpred:b_rpred){
                 auto runner = rpred;
-                while(runner.lock()!=rdoms[bb2int[bb]]){
+                while(runner.lock()!=rdoms[bb2int[bb.get()]]){
                     runner.lock()->add_rdom_frontier(bb);
-                    runner = rdoms[bb2int[runner.lock()]];
+                    runner = rdoms[bb2int[runner.lock().get()]];
                 }
             }
         }
@@ -126,11 +126,11 @@ Ptr<BasicBlock> RDominateTree::intersect(Ptr<BasicBlock> b1, Ptr<BasicBlock> b2)
     auto finger1 = b1;
     auto finger2 = b2;
     while(finger1!=finger2){
-        while(bb2int[finger1]<bb2int[finger2]){
-            finger1 = rdoms[bb2int[finger1]];
+        while(bb2int[finger1.get()]<bb2int[finger2.get()]){
+            finger1 = rdoms[bb2int[finger1.get()]];
         }
-        while(bb2int[finger2]<bb2int[finger1]){
-            finger2 = rdoms[bb2int[finger2]];
+        while(bb2int[finger2.get()]<bb2int[finger1.get()]){
+            finger2 = rdoms[bb2int[finger2.get()]];
         }
     }
     return finger1;
@@ -0,0 +1,202 @@
+#include "Remarks.h"
+#include "Constant.h"
+#include "GlobalVariable.h"
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <set>
+
+namespace SysYF {
+namespace IR {
+
+namespace {
+
+std::ofstream remark_file;
+bool as_json = false;
+bool first_remark = true;
+
+const char *kind_name(Remark::Kind kind) {
+    switch (kind) {
+        case Remark::Passed: return "Passed";
+        case Remark::Missed: return "Missed";
+        default: return "Analysis";
+    }
+}
+
+// plain when it cannot be read as anything but a string, single quoted otherwise
+std::string yaml_string(const std::string &str) {
+    bool plain = !str.empty() && !std::isdigit(static_cast<unsigned char>(str[0]));
+    for (char c : str) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '.') {
+            plain = false;
+        }
+    }
+    // a function may well be named like a YAML boolean or null
+    static const std::set<std::string> reserved = {"true", "false", "yes", "no", "on", "off", "y", "n", "null"};
+    std::string lower;
+    for (char c : str) {
+        lower += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    if (plain && !reserved.count(lower)) {
+        return str;
+    }
+    std::string quoted = "'";
+    for (char c : str) {
+        quoted += c;
+        if (c == '\'') {
+            quoted += '\'';
+        }
+    }
+    return quoted + "'";
+}
+
+std::string json_string(const std::string &str) {
+    std::string quoted = "\"";
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escape[8];
+            std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+            quoted += escape;
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "\"";
+}
+
+}
+
+Remark::Remark(Kind kind, const std::string &pass, const std::string &name, Ptr<Function> func)
+    : kind_(kind), pass_(pass), name_(name), function_(func->get_name()) {}
+
+Remark::Remark(Kind kind, const std::string &pass, const std::string &name, Ptr<BasicBlock> bb)
+    : kind_(kind), pass_(pass), name_(name), block_(bb->get_name()) {
+    if (auto func = bb->get_parent()) {
+        function_ = func->get_name();
+    }
+}
+
+Remark::Remark(Kind kind, const std::string &pass, const std::string &name, Ptr<Instruction> inst)
+    : kind_(kind), pass_(pass), name_(name), instruction_(describe(inst)) {
+    if (auto bb = inst->get_parent()) {
+        block_ = bb->get_name();
+        if (auto func = bb->get_parent()) {
+            function_ = func->get_name();
+        }
+    }
+}
+
+Remark &Remark::arg(const std::string &key, const std::string &value) {
+    args_.emplace_back(key, value);
+    return *this;
+}
+
+Remark &Remark::arg(const std::string &key, const char *value) {
+    return arg(key, std::string(value));
+}
+
+Remark &Remark::arg(const std::string &key, int value) {
+    return arg(key, std::to_string(value));
+}
+
+Remark &Remark::arg(const std::string &key, Ptr<Value> value) {
+    return arg(key, describe(value));
+}
+
+std::string Remark::describe(Ptr<Value> value) {
+    if (!value) {
+        return "";
+    }
+    if (isa<Constant>(value)) {
+        return value->print();
+    }
+    if (isa<Function>(value) || isa<GlobalVariable>(value)) {
+        return "@" + value->get_name();
+    }
+    if (value->has_name()) {
+        return "%" + value->get_name();
+    }
+    // made by a pass, the values are named when the module is printed
+    if (auto inst = dyn_cast<Instruction>(value)) {
+        return inst->get_instr_op_name();
+    }
+    return "";
+}
+
+bool Remark::open(const std::string &file) {
+    remark_file.open(file, std::ios::out);
+    if (!remark_file) {
+        return false;
+    }
+    auto ext = std::string(".json");
+    as_json = file.size() >= ext.size() && file.compare(file.size() - ext.size(), ext.size(), ext) == 0;
+    first_remark = true;
+    if (as_json) {
+        remark_file << "[";
+    }
+    return true;
+}
+
+void Remark::close() {
+    if (!remark_file.is_open()) {
+        return;
+    }
+    if (as_json) {
+        remark_file << (first_remark ? "]" : "\n]") << std::endl;
+    }
+    remark_file.close();
+}
+
+bool Remark::enabled() {
+    return remark_file.is_open();
+}
+
+void Remark::emit(const Remark &remark) {
+    if (!enabled()) {
+        return;
+    }
+    // the fields that are known, a function remark has no block or instruction
+    std::vector<std::pair<const char *, const std::string *>> fields = {
+        {"Pass", &remark.pass_}, {"Name", &remark.name_}, {"Function", &remark.function_}};
+    if (!remark.block_.empty()) {
+        fields.push_back({"Block", &remark.block_});
+    }
+    if (!remark.instruction_.empty()) {
+        fields.push_back({"Instruction", &remark.instruction_});
+    }
+
+    auto &out = remark_file;
+    if (as_json) {
+        out << (first_remark ? "\n" : ",\n") << "  {\"Kind\": " << json_string(kind_name(remark.kind_));
+        for (auto &field : fields) {
+            out << ", " << json_string(field.first) << ": " << json_string(*field.second);
+        }
+        out << ", \"Args\": [";
+        for (unsigned i = 0; i < remark.args_.size(); i++) {
+            out << (i == 0 ? "" : ", ") << "{" << json_string(remark.args_[i].first) << ": "
+                << json_string(remark.args_[i].second) << "}";
+        }
+        out << "]}";
+    } else {
+        out << "--- !" << kind_name(remark.kind_) << "\n";
+        for (auto &field : fields) {
+            out << field.first << ":" << std::string(16 - std::string(field.first).size(), ' ')
+                << yaml_string(*field.second) << "\n";
+        }
+        if (!remark.args_.empty()) {
+            out << "Args:\n";
+            for (auto &arg : remark.args_) {
+                out << "  - " << arg.first << ":" << std::string(arg.first.size() < 16 ? 16 - arg.first.size() : 1, ' ')
+                    << yaml_string(arg.second) << "\n";
+            }
+        }
+        out << "...\n";
+    }
+    first_remark = false;
+}
+
+}
+}
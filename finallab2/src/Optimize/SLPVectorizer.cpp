@@ -0,0 +1,383 @@
+#include "SLPVectorizer.h"
+#include "AliasUtils.h"
+#include "Remarks.h"
+#include "Statistics.h"
+#include <algorithm>
+
+namespace SysYF {
+namespace IR {
+
+static Statistic num_bundles("SLPVectorizer", "store groups vectorized");
+static Statistic num_scalars("SLPVectorizer", "scalar instructions replaced");
+
+namespace {
+
+bool is_vectorizable_type(Ptr<Type> ty) {
+    if (ty->is_integer_type()) {
+        return static_pointer_cast<IntegerType>(ty)->get_num_bits() == 32;
+    }
+    return ty->is_float_type();
+}
+
+// the pointer of a load or store
+Ptr<Value> get_pointer(Ptr<Value> inst) {
+    auto store = dyn_cast<StoreInst>(inst);
+    return store ? store->get_lval() : inst->as<Instruction>()->get_operand(0);
+}
+
+// a gep with constant indices; its base and the indices before the last one
+// name the row, the last index the element in it
+bool split_constant_gep(Ptr<Value> ptr, Ptr<Value> &base, std::vector<int> &row, int &elem) {
+    auto gep = dyn_cast<GetElementPtrInst>(ptr);
+    if (!gep || !is_vectorizable_type(gep->get_element_type())) {
+        return false;
+    }
+    base = gep->get_operand(0);
+    row.clear();
+    for (unsigned i = 1; i < gep->get_num_operand(); i++) {
+        auto idx = dyn_cast<ConstantInt>(gep->get_operand(i));
+        if (!idx) {
+            return false;
+        }
+        row.push_back(idx->get_value());
+    }
+    elem = row.back();
+    row.pop_back();
+    return true;
+}
+
+}
+
+template <typename T>
+Ptr<T> SLPVectorizer::insert(Ptr<T> inst) {
+    inst->insert_before(pos_);
+    return inst;
+}
+
+bool SLPVectorizer::execute() {
+    bool changed = false;
+    for (auto f : module.lock()->get_functions()) {
+        for (auto bb : f->get_basic_blocks()) {
+            // every success removes stores, so this terminates
+            while (vectorize_block(bb)) {
+                changed = true;
+            }
+        }
+    }
+    return changed;
+}
+
+bool SLPVectorizer::vectorize_block(Ptr<BasicBlock> bb) {
+    bb_ = bb;
+    position_.clear();
+    // stores grouped by row, then by element
+    std::map<std::pair<Ptr<Value>, std::vector<int>>, std::map<int, PtrVec<Instruction>>> rows;
+    for (auto inst : bb->get_instructions()) {
+        position_[inst] = position_.size();
+        Ptr<Value> base;
+        std::vector<int> row;
+        int elem;
+        if (inst->is_store() && is_vectorizable_type(inst->get_operand(0)->get_type()) &&
+            split_constant_gep(inst->get_operand(1), base, row, elem)) {
+            rows[{base, row}][elem].push_back(inst);
+        }
+    }
+    for (auto &row : rows) {
+        auto &elems = row.second;
+        for (auto &first : elems) {
+            // exactly one store to each of the vector_width elements from here on
+            PtrVec<Instruction> stores;
+            for (int lane = 0; lane < vector_width; lane++) {
+                auto iter = elems.find(first.first + lane);
+                if (iter == elems.end() || iter->second.size() != 1) {
+                    break;
+                }
+                stores.push_back(iter->second.front());
+            }
+            if (static_cast<int>(stores.size()) == vector_width && try_bundle(stores)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool SLPVectorizer::try_bundle(const PtrVec<Instruction> &stores) {
+    auto ty = stores.front()->get_operand(0)->get_type();
+    PtrVec<Value> lanes, values;
+    for (auto store : stores) {
+        if (store->get_operand(0)->get_type() != ty) {
+            return false;
+        }
+        lanes.push_back(store);
+        values.push_back(store->get_operand(0));
+    }
+    tree_.clear();
+    tree_.push_back({NodeKind::Store, lanes, {}});
+    auto child = build_node(values, 1);
+    tree_[0].children.push_back(child);
+
+    // every vectorized node turns vector_width instructions into one,
+    // a gather costs one insertelement per lane
+    int scalar_cost = 0, vector_cost = 0;
+    for (auto &node : tree_) {
+        if (node.kind == NodeKind::Gather) {
+            vector_cost += vector_width;
+        }
+        else if (node.kind != NodeKind::Constant) {
+            scalar_cost += vector_width;
+            vector_cost += 1;
+        }
+    }
+    if (vector_cost >= scalar_cost) {
+        Remark::emit(Remark(Remark::Missed, name, "NotVectorized", stores.front())
+                         .arg("Reason", "the vector code would cost no less than the scalar code")
+                         .arg("ScalarCost", scalar_cost).arg("VectorCost", vector_cost));
+        return false;
+    }
+
+    pos_ = stores.front();
+    for (auto store : stores) {
+        if (position_[store] > position_[pos_]) {
+            pos_ = store;
+        }
+    }
+    if (!check_memory_order()) {
+        Remark::emit(Remark(Remark::Missed, name, "NotVectorized", stores.front())
+                         .arg("Reason", "a load or store in between may alias the bundled accesses"));
+        return false;
+    }
+
+    ++num_bundles;
+    num_scalars += scalar_cost;
+    Remark::emit(Remark(Remark::Passed, name, "Vectorized", stores.front())
+                     .arg("ScalarCost", scalar_cost).arg("VectorCost", vector_cost));
+    emit(0);
+    // users come before their operands in tree_
+    for (auto &node : tree_) {
+        if (node.kind == NodeKind::Constant || node.kind == NodeKind::Gather) {
+            continue;
+        }
+        for (auto lane : node.lanes) {
+            auto inst = lane->as<Instruction>();
+            auto ptr = (inst->is_load() || inst->is_store()) ? get_pointer(inst) : nullptr;
+            bb_->delete_instr(inst);
+            auto gep = dyn_cast<Instruction>(ptr);
+            if (gep && gep->get_use_list().empty()) {
+                gep->get_parent()->delete_instr(gep);
+            }
+        }
+    }
+    return true;
+}
+
+bool SLPVectorizer::is_consecutive(const PtrVec<Value> &ptrs) {
+    Ptr<Value> first_base;
+    std::vector<int> first_row;
+    int first_elem;
+    if (!split_constant_gep(ptrs.front(), first_base, first_row, first_elem)) {
+        return false;
+    }
+    for (unsigned lane = 1; lane < ptrs.size(); lane++) {
+        Ptr<Value> base;
+        std::vector<int> row;
+        int elem;
+        if (!split_constant_gep(ptrs[lane], base, row, elem) || base != first_base || row != first_row ||
+            elem != first_elem + static_cast<int>(lane) ||
+            ptrs[lane]->get_type() != ptrs.front()->get_type()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+SLPVectorizer::NodeKind SLPVectorizer::get_node_kind(const PtrVec<Value> &lanes, int depth) {
+    bool all_constant = true;
+    for (auto lane : lanes) {
+        if (!isa<ConstantInt>(lane) && !isa<ConstantFloat>(lane)) {
+            all_constant = false;
+        }
+    }
+    if (all_constant) {
+        return NodeKind::Constant;
+    }
+    if (depth > max_depth) {
+        return NodeKind::Gather;
+    }
+    PtrVec<Instruction> insts;
+    for (auto lane : lanes) {
+        auto inst = dyn_cast<Instruction>(lane);
+        if (!inst || inst->get_parent() != bb_ || inst->get_use_list().size() != 1 ||
+            std::find(insts.begin(), insts.end(), inst) != insts.end()) {
+            return NodeKind::Gather;
+        }
+        if (!insts.empty() && (inst->get_instr_type() != insts.front()->get_instr_type() ||
+                               inst->get_type() != insts.front()->get_type())) {
+            return NodeKind::Gather;
+        }
+        insts.push_back(inst);
+    }
+    auto inst = insts.front();
+    if (!is_vectorizable_type(inst->get_type())) {
+        return NodeKind::Gather;
+    }
+    if (inst->isBinary() && !inst->is_div() && !inst->is_rem() && !inst->is_udiv() && !inst->is_urem()) {
+        return NodeKind::Binary;
+    }
+    if (inst->is_sitofp() || inst->is_fptosi()) {
+        return NodeKind::Cast;
+    }
+    if (inst->is_load()) {
+        PtrVec<Value> ptrs;
+        for (auto load : insts) {
+            ptrs.push_back(load->get_operand(0));
+        }
+        if (is_consecutive(ptrs)) {
+            return NodeKind::Load;
+        }
+    }
+    return NodeKind::Gather;
+}
+
+int SLPVectorizer::build_node(const PtrVec<Value> &lanes, int depth) {
+    int index = tree_.size();
+    tree_.push_back({get_node_kind(lanes, depth), lanes, {}});
+    auto kind = tree_[index].kind;
+    if (kind != NodeKind::Binary && kind != NodeKind::Cast) {
+        return index;
+    }
+    unsigned num_ops = kind == NodeKind::Binary ? 2 : 1;
+    for (unsigned i = 0; i < num_ops; i++) {
+        PtrVec<Value> ops;
+        for (auto lane : lanes) {
+            ops.push_back(lane->as<Instruction>()->get_operand(i));
+        }
+        auto child = build_node(ops, depth + 1);
+        tree_[index].children.push_back(child);
+    }
+    return index;
+}
+
+// constant geps into the same base only overlap at the same offset
+bool SLPVectorizer::may_alias(Ptr<Value> ptr1, Ptr<Value> ptr2) {
+    auto obj1 = get_underlying_object(ptr1);
+    auto obj2 = get_underlying_object(ptr2);
+    if (obj1 != obj2) {
+        return may_alias_objects(obj1, obj2);
+    }
+    auto gep1 = dyn_cast<GetElementPtrInst>(ptr1);
+    auto gep2 = dyn_cast<GetElementPtrInst>(ptr2);
+    int offset1, offset2;
+    if (gep1 && gep2 && gep1->get_operand(0) == gep2->get_operand(0) &&
+        get_constant_offset(gep1, offset1) && get_constant_offset(gep2, offset2)) {
+        return offset1 == offset2;
+    }
+    return true;
+}
+
+bool SLPVectorizer::check_memory_order() {
+    PtrVec<Instruction> stores, loads;
+    for (auto lane : tree_[0].lanes) {
+        stores.push_back(lane->as<Instruction>());
+    }
+    for (auto &node : tree_) {
+        if (node.kind == NodeKind::Load) {
+            for (auto lane : node.lanes) {
+                loads.push_back(lane->as<Instruction>());
+            }
+        }
+    }
+    int first = position_[pos_];
+    for (auto inst : stores) first = std::min(first, position_[inst]);
+    for (auto inst : loads) first = std::min(first, position_[inst]);
+
+    // stores of the bundle sink to pos_, the loads of the tree as well
+    auto conflicts = [&](const PtrVec<Instruction> &moved, Ptr<Instruction> inst) {
+        for (auto other : moved) {
+            if (position_[other] < position_[inst] && may_alias(get_pointer(other), get_pointer(inst))) {
+                return true;
+            }
+        }
+        return false;
+    };
+    for (auto inst : bb_->get_instructions()) {
+        int pos = position_[inst];
+        if (pos < first) {
+            continue;
+        }
+        if (pos > position_[pos_]) {
+            break;
+        }
+        if (std::find(stores.begin(), stores.end(), inst) != stores.end()) {
+            continue;
+        }
+        if (inst->is_call()) {
+            return false;
+        }
+        if (inst->is_load() && conflicts(stores, inst)) {
+            return false;
+        }
+        if (inst->is_store() && std::find(loads.begin(), loads.end(), inst) == loads.end() &&
+            (conflicts(stores, inst) || conflicts(loads, inst))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Ptr<Value> SLPVectorizer::emit(int index) {
+    auto m = module.lock();
+    auto &node = tree_[index];
+    auto lanes = node.lanes;
+    auto elem_ty = node.kind == NodeKind::Store ? lanes.front()->as<Instruction>()->get_operand(0)->get_type()
+                                                : lanes.front()->get_type();
+    auto vec_ty = VectorType::get(elem_ty, vector_width);
+    switch (node.kind) {
+        case NodeKind::Constant: {
+            PtrVec<Constant> elems;
+            for (auto lane : lanes) {
+                elems.push_back(lane->as<Constant>());
+            }
+            return ConstantVector::create(vec_ty, elems, m);
+        }
+        case NodeKind::Gather: {
+            Ptr<Value> vec = ConstantZero::create(vec_ty, m);
+            for (int lane = 0; lane < vector_width; lane++) {
+                vec = insert(InsertElementInst::create_insertelement(vec, lanes[lane],
+                                                                     ConstantInt::create(lane, m), bb_));
+            }
+            return vec;
+        }
+        case NodeKind::Binary: {
+            auto op = lanes.front()->as<Instruction>()->get_instr_type();
+            auto children = node.children;
+            auto lhs = emit(children[0]);
+            auto rhs = emit(children[1]);
+            return insert(BinaryInst::create(op, lhs, rhs, bb_));
+        }
+        case NodeKind::Cast: {
+            auto val = emit(node.children[0]);
+            if (lanes.front()->as<Instruction>()->is_sitofp()) {
+                return insert(SiToFpInst::create_sitofp(val, vec_ty, bb_));
+            }
+            return insert(FpToSiInst::create_fptosi(val, vec_ty, bb_));
+        }
+        case NodeKind::Load: {
+            auto ptr = insert(BitCastInst::create_bitcast(get_pointer(lanes.front()), PointerType::get(vec_ty), bb_));
+            auto load = insert(LoadInst::create_load(vec_ty, ptr, bb_));
+            load->set_alignment(elem_ty->get_size());
+            return load;
+        }
+        case NodeKind::Store: {
+            auto val = emit(node.children[0]);
+            auto ptr = insert(BitCastInst::create_bitcast(get_pointer(lanes.front()), PointerType::get(vec_ty), bb_));
+            auto store = insert(StoreInst::create_store(val, ptr, bb_));
+            store->set_alignment(elem_ty->get_size());
+            return store;
+        }
+    }
+    return nullptr;
+}
+
+}
+}
@@ -0,0 +1,107 @@
+#include "SSAUtils.h"
+#include "Constant.h"
+#include <algorithm>
+#include <set>
+
+namespace SysYF {
+namespace IR {
+
+Ptr<Value> get_zero(Ptr<Type> ty, Ptr<Module> m) {
+    if (ty->is_float_type()) {
+        return ConstantFloat::create(0, m);
+    }
+    if (ty->is_integer_type() && static_pointer_cast<IntegerType>(ty)->get_num_bits() == 1) {
+        return ConstantInt::create(false, m);
+    }
+    return ConstantInt::create(0, m);
+}
+
+Ptr<PhiInst> SSAUpdater::create_phi(Ptr<BasicBlock> bb) {
+    auto phi = PhiInst::create_phi(type_, bb);
+    bb->add_instr_begin(phi);
+    entry_values_[bb] = phi;
+    new_phis_.push_back(phi);
+    return phi;
+}
+
+Ptr<Value> SSAUpdater::get_value_at_end(Ptr<BasicBlock> bb) {
+    auto iter = defs_.find(bb);
+    if (iter != defs_.end()) {
+        return iter->second;
+    }
+    return get_value_at_entry(bb);
+}
+
+Ptr<Value> SSAUpdater::get_value_at_entry(Ptr<BasicBlock> bb) {
+    auto iter = entry_values_.find(bb);
+    if (iter != entry_values_.end() && iter->second) {
+        return iter->second;
+    }
+    if (iter != entry_values_.end()) {
+        // back at a block whose single predecessor is still being looked at
+        return create_phi(bb);
+    }
+    PtrVec<BasicBlock> preds;
+    for (auto &pred : bb->get_pre_basic_blocks()) {
+        if ((!has_entry_ || has_entry_(pred.lock())) && std::find(preds.begin(), preds.end(), pred.lock()) == preds.end()) {
+            preds.push_back(pred.lock());
+        }
+    }
+    if (preds.empty()) {
+        // the definition does not reach here
+        entry_values_[bb] = get_zero(type_, module_.lock());
+        return entry_values_[bb];
+    }
+    if (preds.size() == 1) {
+        entry_values_[bb] = nullptr;
+        auto val = get_value_at_end(preds.front());
+        if (auto phi = dyn_cast<PhiInst>(entry_values_[bb])) {
+            phi->add_phi_pair_operand(val, preds.front());
+            return phi;
+        }
+        entry_values_[bb] = val;
+        return val;
+    }
+    // placed before its entries are known, a loop leads back to it
+    auto phi = create_phi(bb);
+    for (auto pred : preds) {
+        phi->add_phi_pair_operand(get_value_at_end(pred), pred);
+    }
+    return phi;
+}
+
+void SSAUpdater::remove_trivial_phis() {
+    std::set<Ptr<PhiInst>> removed;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto phi : new_phis_) {
+            if (removed.count(phi)) {
+                continue;
+            }
+            Ptr<Value> same;
+            bool trivial = true;
+            for (unsigned i = 0; i < phi->get_num_operand(); i += 2) {
+                auto in = phi->get_operand(i);
+                if (in == phi || in == same) {
+                    continue;
+                }
+                if (same) {
+                    trivial = false;
+                    break;
+                }
+                same = in;
+            }
+            if (trivial && same) {
+                phi->replace_all_use_with(same);
+                phi->get_parent()->delete_instr(phi);
+                removed.insert(phi);
+                changed = true;
+            }
+        }
+    }
+    new_phis_.clear();
+}
+
+}
+}
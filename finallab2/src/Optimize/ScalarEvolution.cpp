@@ -0,0 +1,503 @@
+#include "ScalarEvolution.h"
+#include "ConditionUtils.h"
+#include <climits>
+
+namespace SysYF {
+namespace IR {
+
+namespace {
+
+using Linear = ScalarEvolution::Linear;
+using AddRec = ScalarEvolution::AddRec;
+
+// i32 arithmetic wraps around, do it on unsigned to stay defined
+int wrap_add(int a, int b) {
+    return static_cast<int>(static_cast<unsigned>(a) + static_cast<unsigned>(b));
+}
+
+int wrap_mul(int a, int b) {
+    return static_cast<int>(static_cast<unsigned>(a) * static_cast<unsigned>(b));
+}
+
+Linear add(const Linear &a, const Linear &b) {
+    Linear sum = a;
+    sum.constant = wrap_add(sum.constant, b.constant);
+    for (auto &term : b.terms) {
+        auto coef = wrap_add(sum.terms[term.first], term.second);
+        if (coef == 0) {
+            sum.terms.erase(term.first);
+        }
+        else {
+            sum.terms[term.first] = coef;
+        }
+    }
+    return sum;
+}
+
+Linear scale(const Linear &a, int factor) {
+    Linear product;
+    product.constant = wrap_mul(a.constant, factor);
+    for (auto &term : a.terms) {
+        auto coef = wrap_mul(term.second, factor);
+        if (coef != 0) {
+            product.terms[term.first] = coef;
+        }
+    }
+    return product;
+}
+
+bool is_zero(const Linear &a) {
+    return a.is_constant() && a.constant == 0;
+}
+
+// drops trailing zero steps, {a, +, 0} is just a
+AddRec normalize(AddRec rec) {
+    while (rec.ops.size() > 1 && is_zero(rec.ops.back())) {
+        rec.ops.pop_back();
+    }
+    return rec;
+}
+
+AddRec add(const AddRec &a, const AddRec &b) {
+    AddRec sum;
+    sum.ops.resize(std::max(a.ops.size(), b.ops.size()));
+    for (unsigned i = 0; i < sum.ops.size(); i++) {
+        if (i < a.ops.size()) {
+            sum.ops[i] = add(sum.ops[i], a.ops[i]);
+        }
+        if (i < b.ops.size()) {
+            sum.ops[i] = add(sum.ops[i], b.ops[i]);
+        }
+    }
+    return normalize(sum);
+}
+
+AddRec scale(const AddRec &a, int factor) {
+    AddRec product;
+    for (auto &op : a.ops) {
+        product.ops.push_back(scale(op, factor));
+    }
+    return normalize(product);
+}
+
+// a * b, where every op of b is a constant
+AddRec scale(const AddRec &b, const Linear &a) {
+    AddRec product;
+    for (auto &op : b.ops) {
+        product.ops.push_back(scale(a, op.constant));
+    }
+    return normalize(product);
+}
+
+bool is_constant_rec(const AddRec &a) {
+    for (auto &op : a.ops) {
+        if (!op.is_constant()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool mentions(const AddRec &a, Ptr<Value> val) {
+    for (auto &op : a.ops) {
+        if (op.terms.count(val)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool is_int32(Ptr<Value> val) {
+    auto ty = val->get_type();
+    return ty->is_integer_type() && static_pointer_cast<IntegerType>(ty)->get_num_bits() == 32;
+}
+
+// C(n, j) modulo 2^32 for j <= 3; one of j consecutive numbers is divisible by each
+// of 2 .. j, so the divisions are done on the factors before they are multiplied
+int binomial(unsigned n, int j) {
+    if (n < static_cast<unsigned>(j)) {
+        return 0;
+    }
+    std::vector<unsigned> factors;
+    for (int i = 0; i < j; i++) {
+        factors.push_back(n - i);
+    }
+    for (int d = j; d >= 2; d--) {
+        for (auto &factor : factors) {
+            if (factor % d == 0) {
+                factor /= d;
+                break;
+            }
+        }
+    }
+    unsigned result = 1;
+    for (auto factor : factors) {
+        result *= static_cast<unsigned>(factor);
+    }
+    return static_cast<int>(result);
+}
+
+}
+
+bool ScalarEvolution::find_loop(Ptr<BasicBlock> header, Loop &loop) {
+    auto br = header->get_terminator();
+    if (!br || !br->is_br() || br->get_num_operand() != 3 || header->get_pre_basic_blocks().size() != 2) {
+        return false;
+    }
+    loop = Loop();
+    for (auto &pre_bb : header->get_pre_basic_blocks()) {
+        // the blocks that reach the latch without passing the header
+        auto latch = pre_bb.lock();
+        std::set<Ptr<BasicBlock>> blocks = {header};
+        PtrVec<BasicBlock> worklist = {latch};
+        bool is_back_edge = true;
+        while (!worklist.empty() && is_back_edge) {
+            auto bb = worklist.back();
+            worklist.pop_back();
+            if (!blocks.insert(bb).second) {
+                continue;
+            }
+            if (bb->get_pre_basic_blocks().empty()) {
+                is_back_edge = false;
+            }
+            for (auto &pre : bb->get_pre_basic_blocks()) {
+                worklist.push_back(pre.lock());
+            }
+        }
+        if (!is_back_edge) {
+            continue;
+        }
+        loop.header = header;
+        loop.latch = latch;
+        loop.blocks = blocks;
+        for (auto &other : header->get_pre_basic_blocks()) {
+            if (other.lock() != latch) {
+                loop.preheader = other.lock();
+            }
+        }
+        break;
+    }
+    if (!loop.preheader || loop.blocks.count(loop.preheader)) {
+        return false;
+    }
+    auto pre_br = loop.preheader->get_terminator();
+    if (!pre_br || !pre_br->is_br() || pre_br->get_num_operand() != 1) {
+        return false;
+    }
+
+    // only entered through the header and only left through its exit test
+    for (auto bb : loop.blocks) {
+        if (bb != header) {
+            for (auto &pre : bb->get_pre_basic_blocks()) {
+                if (!loop.blocks.count(pre.lock())) {
+                    return false;
+                }
+            }
+        }
+        for (auto &succ : bb->get_succ_basic_blocks()) {
+            if (loop.blocks.count(succ.lock())) {
+                continue;
+            }
+            if (bb != header || loop.exit) {
+                return false;
+            }
+            loop.exit = succ.lock();
+        }
+    }
+    return loop.exit && loop.exit->get_pre_basic_blocks().size() == 1;
+}
+
+void ScalarEvolution::set_loop(const Loop &loop) {
+    loop_ = loop;
+    scevs_.clear();
+    pending_.clear();
+    trip_count_ = nullptr;
+}
+
+bool ScalarEvolution::is_in_loop(Ptr<Value> val) {
+    auto inst = dyn_cast<Instruction>(val);
+    return inst && loop_.blocks.count(inst->get_parent());
+}
+
+bool ScalarEvolution::get_scev(Ptr<Value> val, AddRec &scev) {
+    auto iter = scevs_.find(val);
+    if (iter != scevs_.end()) {
+        scev = iter->second;
+        return true;
+    }
+    if (!compute_scev(val, scev)) {
+        return false;
+    }
+    // what still refers to a phi under analysis is not final yet
+    for (auto phi : pending_) {
+        if (mentions(scev, phi)) {
+            return true;
+        }
+    }
+    scevs_[val] = scev;
+    return true;
+}
+
+bool ScalarEvolution::compute_scev(Ptr<Value> val, AddRec &scev) {
+    if (auto const_val = dyn_cast<ConstantInt>(val)) {
+        Linear linear;
+        linear.constant = const_val->get_value();
+        scev.ops = {linear};
+        return true;
+    }
+    if (!is_int32(val)) {
+        return false;
+    }
+    if (!is_in_loop(val)) {
+        Linear linear;
+        linear.terms[val] = 1;
+        scev.ops = {linear};
+        return true;
+    }
+    auto inst = val->as<Instruction>();
+    if (inst->is_phi()) {
+        auto phi = static_pointer_cast<PhiInst>(inst);
+        if (phi->get_parent() != loop_.header) {
+            return false;
+        }
+        if (pending_.count(phi)) {
+            // the value of the phi in the current iteration, resolved by compute_phi_scev
+            Linear linear;
+            linear.terms[phi] = 1;
+            scev.ops = {linear};
+            return true;
+        }
+        return compute_phi_scev(phi, scev);
+    }
+    if (!inst->is_add() && !inst->is_sub() && !inst->is_mul() && !inst->is_shl()) {
+        return false;
+    }
+    AddRec lhs, rhs;
+    if (!get_scev(inst->get_operand(0), lhs) || !get_scev(inst->get_operand(1), rhs)) {
+        return false;
+    }
+    if (inst->is_add()) {
+        scev = add(lhs, rhs);
+    }
+    else if (inst->is_sub()) {
+        scev = add(lhs, scale(rhs, -1));
+    }
+    else if (inst->is_shl()) {
+        auto amount = dyn_cast<ConstantInt>(inst->get_operand(1));
+        if (!amount || amount->get_value() < 0 || amount->get_value() > 31) {
+            return false;
+        }
+        scev = scale(lhs, static_cast<int>(1U << amount->get_value()));
+    }
+    else if (rhs.is_invariant() && rhs.ops[0].is_constant()) {
+        scev = scale(lhs, rhs.ops[0].constant);
+    }
+    else if (lhs.is_invariant() && lhs.ops[0].is_constant()) {
+        scev = scale(rhs, lhs.ops[0].constant);
+    }
+    else if (lhs.is_invariant() && is_constant_rec(rhs)) {
+        scev = scale(rhs, lhs.ops[0]);
+    }
+    else if (rhs.is_invariant() && is_constant_rec(lhs)) {
+        scev = scale(lhs, rhs.ops[0]);
+    }
+    else {
+        return false;
+    }
+    return static_cast<int>(scev.ops.size()) <= max_degree + 1;
+}
+
+bool ScalarEvolution::compute_phi_scev(Ptr<PhiInst> phi, AddRec &scev) {
+    if (phi->get_num_operand() != 4) {
+        return false;
+    }
+    Ptr<Value> init, next;
+    for (unsigned i = 0; i < 4; i += 2) {
+        if (phi->get_operand(i + 1) == loop_.preheader) {
+            init = phi->get_operand(i);
+        }
+        else {
+            next = phi->get_operand(i);
+        }
+    }
+    AddRec start, step;
+    if (!init || !next || !get_scev(init, start)) {
+        return false;
+    }
+    pending_.insert(phi);
+    auto found = get_scev(next, step);
+    pending_.erase(phi);
+    // next must be phi + step, with step not depending on phi
+    if (!found || step.ops[0].terms.count(phi) == 0 || step.ops[0].terms[phi] != 1) {
+        return false;
+    }
+    step.ops[0].terms.erase(phi);
+    if (mentions(step, phi)) {
+        return false;
+    }
+    scev.ops = start.ops;
+    scev.ops.insert(scev.ops.end(), step.ops.begin(), step.ops.end());
+    scev = normalize(scev);
+    return static_cast<int>(scev.ops.size()) <= max_degree + 1;
+}
+
+bool ScalarEvolution::get_trip_count(TripCount &trip) {
+    auto br = loop_.header->get_terminator();
+    auto cmp = dyn_cast<CmpInst>(br->get_operand(0));
+    if (!cmp) {
+        return false;
+    }
+    // the loop goes on while cmp holds, or while it does not when negated
+    bool negated = br->get_operand(1) == loop_.exit;
+    auto zero = dyn_cast<ConstantInt>(cmp->get_operand(1));
+    auto zext = dyn_cast<ZextInst>(cmp->get_operand(0));
+    auto inner = zext ? dyn_cast<CmpInst>(zext->get_operand(0)) : nullptr;
+    if (inner && zero && zero->get_value() == 0 &&
+        (cmp->get_cmp_op() == CmpInst::NE || cmp->get_cmp_op() == CmpInst::EQ)) {
+        negated ^= cmp->get_cmp_op() == CmpInst::EQ;
+        cmp = inner;
+    }
+
+    AddRec lhs, rhs;
+    if (!get_scev(cmp->get_operand(0), lhs) || !get_scev(cmp->get_operand(1), rhs)) {
+        return false;
+    }
+    auto op = cmp->get_cmp_op();
+    if (lhs.is_invariant()) {
+        std::swap(lhs, rhs);
+        op = swap_operands(op);
+    }
+    if (negated) {
+        op = negate(op);
+    }
+    if (lhs.ops.size() != 2 || !rhs.is_invariant() || !lhs.ops[1].is_constant()) {
+        return false;
+    }
+    auto start = lhs.ops[0];
+    auto step = lhs.ops[1].constant;
+    auto bound = rhs.ops[0];
+    if (step != 1 && step != -1) {
+        return false;
+    }
+    // make the bound exclusive, the loop would not end if it was INT_MAX or INT_MIN
+    if (op == CmpInst::LE || op == CmpInst::GE) {
+        if (!bound.is_constant() || bound.constant == (op == CmpInst::LE ? INT_MAX : INT_MIN)) {
+            return false;
+        }
+        bound.constant += op == CmpInst::LE ? 1 : -1;
+        op = op == CmpInst::LE ? CmpInst::LT : CmpInst::GT;
+    }
+
+    trip = TripCount();
+    // counting up to the bound, or down to it
+    auto up = add(bound, scale(start, -1));
+    auto down = add(start, scale(bound, -1));
+    if (op == CmpInst::NE) {
+        // i != n is left after exactly (n - i) mod 2^32 steps
+        trip.count = step == 1 ? up : down;
+        return true;
+    }
+    if ((op == CmpInst::LT && step != 1) || (op == CmpInst::GT && step != -1) || op == CmpInst::EQ) {
+        return false;
+    }
+    trip.count = op == CmpInst::LT ? up : down;
+    if (start.is_constant() && bound.is_constant()) {
+        if (!evaluate_compare(op, start.constant, bound.constant)) {
+            trip.count = Linear();
+        }
+        return true;
+    }
+    trip.has_guard = true;
+    trip.guard_op = op;
+    trip.guard_lhs = start;
+    trip.guard_rhs = bound;
+    return true;
+}
+
+template <typename T>
+Ptr<T> ScalarEvolution::insert(Ptr<T> inst, Ptr<Instruction> pos) {
+    inst->insert_before(pos);
+    return inst;
+}
+
+Ptr<Value> ScalarEvolution::expand_add(Ptr<Value> lhs, Ptr<Value> rhs, Ptr<Instruction> pos) {
+    if (isa<ConstantInt>(lhs)) {
+        std::swap(lhs, rhs);
+    }
+    auto const_rhs = dyn_cast<ConstantInt>(rhs);
+    if (const_rhs && const_rhs->get_value() == 0) {
+        return lhs ? lhs : rhs;
+    }
+    if (!lhs) {
+        return rhs;
+    }
+    return insert(BinaryInst::create_add(lhs, rhs, pos->get_parent(), module_), pos);
+}
+
+Ptr<Value> ScalarEvolution::expand_mul(Ptr<Value> lhs, Ptr<Value> rhs, Ptr<Instruction> pos) {
+    if (isa<ConstantInt>(lhs)) {
+        std::swap(lhs, rhs);
+    }
+    auto const_rhs = dyn_cast<ConstantInt>(rhs);
+    if (const_rhs && (const_rhs->get_value() == 0 || const_rhs->get_value() == 1)) {
+        return const_rhs->get_value() == 0 ? rhs : lhs;
+    }
+    return insert(BinaryInst::create_mul(lhs, rhs, pos->get_parent(), module_), pos);
+}
+
+Ptr<Value> ScalarEvolution::expand(const Linear &linear, Ptr<Instruction> pos) {
+    Ptr<Value> result;
+    for (auto &term : linear.terms) {
+        if (term.second == -1 && result) {
+            result = insert(BinaryInst::create_sub(result, term.first, pos->get_parent(), module_), pos);
+            continue;
+        }
+        result = expand_add(result, expand_mul(term.first, ConstantInt::create(term.second, module_), pos), pos);
+    }
+    return expand_add(result, ConstantInt::create(linear.constant, module_), pos);
+}
+
+bool ScalarEvolution::is_expandable(const AddRec &scev, const TripCount &trip) {
+    return static_cast<int>(scev.ops.size()) <= (trip.is_constant() ? max_degree + 1 : 3);
+}
+
+Ptr<Value> ScalarEvolution::expand_exit_value(const AddRec &scev, const TripCount &trip, Ptr<Instruction> pos) {
+    if (trip.is_constant()) {
+        // sum of ops[j] * C(n, j) is again linear
+        Linear value;
+        auto n = static_cast<unsigned>(trip.count.constant);
+        for (unsigned j = 0; j < scev.ops.size(); j++) {
+            value = add(value, scale(scev.ops[j], binomial(n, j)));
+        }
+        return expand(value, pos);
+    }
+    auto bb = pos->get_parent();
+    auto zero = ConstantInt::create(0, module_);
+    auto one = ConstantInt::create(1, module_);
+    // shared by all values of the loop
+    if (!trip_count_) {
+        trip_count_ = expand(trip.count, pos);
+        if (trip.has_guard) {
+            auto cond = insert(CmpInst::create_cmp(trip.guard_op, expand(trip.guard_lhs, pos),
+                                                   expand(trip.guard_rhs, pos), bb, module_), pos);
+            trip_count_ = insert(SelectInst::create_select(cond, trip_count_, zero, bb), pos);
+        }
+    }
+    auto n = trip_count_;
+    auto value = expand(scev.ops[0], pos);
+    if (scev.ops.size() > 1) {
+        value = expand_add(value, expand_mul(expand(scev.ops[1], pos), n, pos), pos);
+    }
+    if (scev.ops.size() > 2) {
+        // C(n, 2) = (n >> 1) * ((n - 1) | 1) halves whichever of n and n - 1 is even
+        auto half = insert(BinaryInst::create_lshr(n, one, bb, module_), pos);
+        auto pred = insert(BinaryInst::create_sub(n, one, bb, module_), pos);
+        auto odd = insert(BinaryInst::create_or(pred, one, bb, module_), pos);
+        auto pairs = insert(BinaryInst::create_mul(half, odd, bb, module_), pos);
+        value = expand_add(value, expand_mul(expand(scev.ops[2], pos), pairs, pos), pos);
+    }
+    return value;
+}
+
+}
+}
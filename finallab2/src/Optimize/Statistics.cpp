@@ -0,0 +1,37 @@
+#include "Statistics.h"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+
+namespace SysYF {
+namespace IR {
+
+Statistic::Statistic(const char *pass, const char *desc): pass_(pass), desc_(desc) {
+    get_registry().push_back(this);
+}
+
+std::vector<Statistic *> &Statistic::get_registry() {
+    // constructed on first use, the counters are constructed in no given order
+    static std::vector<Statistic *> registry;
+    return registry;
+}
+
+void Statistic::print_all(std::ostream &out) {
+    std::vector<Statistic *> counters;
+    for (auto counter : get_registry()) {
+        if (counter->value_ != 0) {
+            counters.push_back(counter);
+        }
+    }
+    // by pass, the counters of a pass in the order they are defined in
+    std::stable_sort(counters.begin(), counters.end(), [](Statistic *a, Statistic *b) {
+        return std::strcmp(a->pass_, b->pass_) < 0;
+    });
+    out << "===------------------- Statistics -------------------===" << std::endl;
+    for (auto counter : counters) {
+        out << std::setw(8) << counter->value_ << " " << counter->pass_ << " - " << counter->desc_ << std::endl;
+    }
+}
+
+}
+}
@@ -0,0 +1,195 @@
+#include "SwitchFormation.h"
+#include "Remarks.h"
+#include "Statistics.h"
+#include <map>
+
+namespace SysYF {
+namespace IR {
+
+static Statistic num_switches("SwitchFormation", "switches formed");
+static Statistic num_cases("SwitchFormation", "compares turned into cases");
+
+bool SwitchFormation::execute() {
+    bool changed = false;
+    for (auto f : module.lock()->get_functions()) {
+        bool formed = true;
+        while (formed) {
+            formed = false;
+            // forming a switch removes blocks, so start over after every change
+            for (auto bb : f->get_basic_blocks()) {
+                if (form_switch(bb)) {
+                    formed = true;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+    return changed;
+}
+
+bool SwitchFormation::match_link(Ptr<BasicBlock> bb, Ptr<Value> &x, ChainLink &link) {
+    auto br = bb->get_terminator();
+    if (!br || !br->is_br() || br->get_num_operand() != 3) {
+        return false;
+    }
+    auto cmp = dyn_cast<CmpInst>(br->get_operand(0));
+    if (!cmp || cmp->get_parent() != bb) {
+        return false;
+    }
+    auto op = cmp->get_cmp_op();
+    if (op != CmpInst::EQ && op != CmpInst::NE) {
+        return false;
+    }
+    auto lhs = cmp->get_operand(0);
+    auto val = dyn_cast<ConstantInt>(cmp->get_operand(1));
+    if (!val) {
+        val = dyn_cast<ConstantInt>(lhs);
+        lhs = cmp->get_operand(1);
+    }
+    if (!val || isa<Constant>(lhs) || (x && lhs != x)) {
+        return false;
+    }
+    auto ty = lhs->get_type();
+    if (!ty->is_integer_type() || static_pointer_cast<IntegerType>(ty)->get_num_bits() != 32) {
+        return false;
+    }
+    x = lhs;
+    auto true_bb = br->get_operand(1)->as<BasicBlock>();
+    auto false_bb = br->get_operand(2)->as<BasicBlock>();
+    link.bb = bb;
+    link.val = val;
+    link.dest = op == CmpInst::EQ ? true_bb : false_bb;
+    link.next = op == CmpInst::EQ ? false_bb : true_bb;
+    return true;
+}
+
+bool SwitchFormation::can_merge_phi_entries(Ptr<BasicBlock> dest, const std::set<Ptr<BasicBlock>> &chain) {
+    for (auto inst : dest->get_instructions()) {
+        if (!inst->is_phi()) {
+            break;
+        }
+        Ptr<Value> val;
+        for (unsigned i = 0; i < inst->get_num_operand(); i += 2) {
+            auto bb = inst->get_operand(i + 1)->as<BasicBlock>();
+            if (!chain.count(bb)) {
+                continue;
+            }
+            if (val && val != inst->get_operand(i)) {
+                return false;
+            }
+            val = inst->get_operand(i);
+        }
+    }
+    return true;
+}
+
+void SwitchFormation::merge_phi_entries(Ptr<BasicBlock> dest, const std::set<Ptr<BasicBlock>> &chain,
+                                        Ptr<BasicBlock> head, int num_edges) {
+    for (auto inst : dest->get_instructions()) {
+        if (!inst->is_phi()) {
+            break;
+        }
+        auto phi = static_pointer_cast<PhiInst>(inst);
+        Ptr<Value> val;
+        for (int i = static_cast<int>(phi->get_num_operand()) - 2; i >= 0; i -= 2) {
+            if (chain.count(phi->get_operand(i + 1)->as<BasicBlock>())) {
+                // can_merge_phi_entries made sure all of them are the same
+                val = phi->get_operand(i);
+                phi->remove_operands(i, i + 1);
+            }
+        }
+        // undefined on every edge from the chain, mem2reg left the entries out
+        if (!val) {
+            continue;
+        }
+        // llvm wants one entry per edge, also for edges from the same block
+        for (int i = 0; i < num_edges; i++) {
+            phi->add_phi_pair_operand(val, head);
+        }
+    }
+}
+
+bool SwitchFormation::form_switch(Ptr<BasicBlock> head) {
+    Ptr<Value> x;
+    ChainLink link;
+    if (!match_link(head, x, link)) {
+        return false;
+    }
+    std::vector<ChainLink> links = {link};
+    std::set<Ptr<BasicBlock>> chain = {head};
+    std::set<int> seen = {link.val->get_value()};
+    while (true) {
+        auto prev = links.back().bb;
+        auto next = links.back().next;
+        auto &pre_bbs = next->get_pre_basic_blocks();
+        if (chain.count(next) || pre_bbs.size() != 1 || pre_bbs.front().lock() != prev ||
+            next->get_num_of_instr() != 2) {
+            break;
+        }
+        ChainLink next_link;
+        if (!match_link(next, x, next_link)) {
+            break;
+        }
+        // the compare must die with the block, and a repeated value can never match
+        if (next->get_instructions().front()->get_use_list().size() != 1 ||
+            seen.count(next_link.val->get_value())) {
+            break;
+        }
+        links.push_back(next_link);
+        chain.insert(next);
+        seen.insert(next_link.val->get_value());
+    }
+    if (static_cast<int>(links.size()) < min_cases) {
+        return false;
+    }
+
+    auto default_bb = links.back().next;
+    std::map<Ptr<BasicBlock>, int> num_edges = {{default_bb, 1}};
+    for (auto &l : links) {
+        num_edges[l.dest]++;
+    }
+    for (auto &dest : num_edges) {
+        if (chain.count(dest.first) || !can_merge_phi_entries(dest.first, chain)) {
+            return false;
+        }
+    }
+    ++num_switches;
+    num_cases += links.size();
+    Remark::emit(Remark(Remark::Passed, name, "Formed", head->get_terminator())
+                     .arg("Value", x).arg("Cases", static_cast<int>(links.size())));
+    for (auto &dest : num_edges) {
+        merge_phi_entries(dest.first, chain, head, dest.second);
+    }
+
+    // unlink the chain from the cfg and drop its compares and branches
+    for (auto bb : chain) {
+        for (auto &succ : bb->get_succ_basic_blocks()) {
+            succ.lock()->remove_pre_basic_block(bb);
+        }
+        bb->get_succ_basic_blocks().clear();
+    }
+    auto head_br = head->get_terminator();
+    auto head_cmp = head_br->get_operand(0)->as<Instruction>();
+    head->delete_instr(head_br);
+    if (head_cmp->get_use_list().empty()) {
+        head->delete_instr(head_cmp);
+    }
+    for (unsigned i = 1; i < links.size(); i++) {
+        auto bb = links[i].bb;
+        auto br = bb->get_terminator();
+        auto cmp = br->get_operand(0)->as<Instruction>();
+        bb->delete_instr(br);
+        bb->delete_instr(cmp);
+        bb->erase_from_parent();
+    }
+
+    auto sw = SwitchInst::create_switch(x, default_bb, head);
+    for (auto &l : links) {
+        sw->add_case(l.val, l.dest);
+    }
+    return true;
+}
+
+}
+}
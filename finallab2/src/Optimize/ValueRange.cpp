@@ -0,0 +1,445 @@
+#include "ValueRange.h"
+#include "CFGUtils.h"
+#include "DominateTree.h"
+#include "Remarks.h"
+#include "Statistics.h"
+#include <algorithm>
+#include <climits>
+#include <set>
+
+namespace SysYF {
+namespace IR {
+
+static Statistic num_narrowed("ValueRange", "signed divisions made unsigned");
+static Statistic num_compares("ValueRange", "compares folded");
+static Statistic num_branches("ValueRange", "branches folded");
+
+namespace {
+
+const long long int_min = INT_MIN;
+const long long int_max = INT_MAX;
+
+bool is_tracked_type(Ptr<Type> ty) {
+    if (!ty->is_integer_type()) {
+        return false;
+    }
+    auto bits = static_pointer_cast<IntegerType>(ty)->get_num_bits();
+    return bits == 1 || bits == 32;
+}
+
+// functions whose every use is a direct call, so their callers are known
+bool has_known_callers(Ptr<Function> f) {
+    if (f->get_name() == "main" || f->is_declaration()) {
+        return false;
+    }
+    for (auto &use : f->get_use_list()) {
+        auto call = dyn_cast<CallInst>(use.val_.lock());
+        if (!call || call->get_operand(0) != f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+bool ValueRange::execute() {
+    bool changed = false;
+    auto m = module.lock();
+    ranges_.clear();
+    updates_.clear();
+    conditions_.clear();
+    orders_.clear();
+    for (auto f : m->get_functions()) {
+        if (!f->is_declaration()) {
+            changed |= remove_unreachable_blocks(f);
+        }
+    }
+    // the conditions of a block are found through its dominators
+    DominateTree(module).execute();
+    for (auto f : m->get_functions()) {
+        if (!f->is_declaration()) {
+            orders_[f] = get_reverse_post_order(f);
+            collect_conditions(orders_[f], conditions_);
+        }
+    }
+    analyze();
+    for (auto f : m->get_functions()) {
+        if (f->is_declaration()) {
+            continue;
+        }
+        changed |= narrow_divisions(f);
+        changed |= fold_compares(f);
+        if (fold_branches(f)) {
+            remove_unreachable_blocks(f);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+ValueRange::Range ValueRange::get_range(Ptr<Value> val) {
+    if (auto const_val = dyn_cast<ConstantInt>(val)) {
+        long long v = const_val->get_value();
+        return {v, v};
+    }
+    auto iter = ranges_.find(val);
+    if (iter != ranges_.end()) {
+        return iter->second;
+    }
+    // not evaluated yet
+    if (isa<Instruction>(val) || isa<Argument>(val)) {
+        return {1, 0};
+    }
+    if (is_tracked_type(val->get_type()) && static_pointer_cast<IntegerType>(val->get_type())->get_num_bits() == 1) {
+        return {0, 1};
+    }
+    return {int_min, int_max};
+}
+
+ValueRange::Range ValueRange::refine(Ptr<Value> val, Range range, const Condition &cond) {
+    auto op = cond.taken ? cond.cmp->get_cmp_op() : negate(cond.cmp->get_cmp_op());
+    Ptr<Value> other;
+    if (cond.cmp->get_operand(0) == val) {
+        other = cond.cmp->get_operand(1);
+    }
+    else if (cond.cmp->get_operand(1) == val) {
+        other = cond.cmp->get_operand(0);
+        op = swap_operands(op);
+    }
+    else {
+        return range;
+    }
+    // val op other holds for some value of other
+    auto bound = get_range(other);
+    if (bound.is_empty()) {
+        return bound;
+    }
+    switch (op) {
+        case CmpInst::LT: range.hi = std::min(range.hi, bound.hi - 1); break;
+        case CmpInst::LE: range.hi = std::min(range.hi, bound.hi); break;
+        case CmpInst::GT: range.lo = std::max(range.lo, bound.lo + 1); break;
+        case CmpInst::GE: range.lo = std::max(range.lo, bound.lo); break;
+        case CmpInst::EQ:
+            range.lo = std::max(range.lo, bound.lo);
+            range.hi = std::min(range.hi, bound.hi);
+            break;
+        case CmpInst::NE:
+            if (bound.is_single() && range.lo == bound.lo) range.lo++;
+            if (bound.is_single() && range.hi == bound.lo) range.hi--;
+            break;
+    }
+    return range;
+}
+
+ValueRange::Range ValueRange::get_range_at(Ptr<Value> val, Ptr<BasicBlock> bb) {
+    auto range = get_range(val);
+    if (isa<Constant>(val)) {
+        return range;
+    }
+    for (auto &cond : conditions_[bb]) {
+        range = refine(val, range, cond);
+    }
+    return range;
+}
+
+ValueRange::Range ValueRange::get_range_on_edge(Ptr<Value> val, Ptr<BasicBlock> from, Ptr<BasicBlock> to) {
+    auto range = get_range_at(val, from);
+    Condition cond;
+    if (!isa<Constant>(val) && get_edge_condition(from, to, cond)) {
+        range = refine(val, range, cond);
+    }
+    return range;
+}
+
+ValueRange::Range ValueRange::evaluate_binary(Ptr<Instruction> inst, Range a, Range b) {
+    const Range full = {int_min, int_max};
+    if (a.is_empty() || b.is_empty()) {
+        return {1, 0};
+    }
+    // an exact result that leaves the i32 range has wrapped around
+    auto make = [&](long long lo, long long hi) {
+        return lo < int_min || hi > int_max ? full : Range{lo, hi};
+    };
+    // a constant shift amount below the bit width
+    int k = b.is_single() && b.lo >= 0 && b.lo < 32 ? static_cast<int>(b.lo) : -1;
+    switch (inst->get_instr_type()) {
+        case Instruction::add:
+            return make(a.lo + b.lo, a.hi + b.hi);
+        case Instruction::sub:
+            return make(a.lo - b.hi, a.hi - b.lo);
+        case Instruction::mul: {
+            long long products[] = {a.lo * b.lo, a.lo * b.hi, a.hi * b.lo, a.hi * b.hi};
+            return make(*std::min_element(products, products + 4), *std::max_element(products, products + 4));
+        }
+        case Instruction::sdiv:
+            // truncation is monotonic in both operands for a positive divisor
+            if (b.lo > 0) {
+                return {std::min(a.lo / b.lo, a.lo / b.hi), std::max(a.hi / b.lo, a.hi / b.hi)};
+            }
+            if (b.is_single() && b.lo < 0) {
+                return make(a.hi / b.lo, a.lo / b.lo);
+            }
+            return full;
+        case Instruction::srem: {
+            // |x % y| < |y|, and the remainder has the sign of x
+            auto m = std::max(std::abs(b.lo), std::abs(b.hi)) - 1;
+            if (m < 0) {
+                return full;
+            }
+            return {a.lo >= 0 ? 0 : std::max(a.lo, -m), a.hi <= 0 ? 0 : std::min(a.hi, m)};
+        }
+        case Instruction::udiv:
+            return a.lo >= 0 && b.lo > 0 ? Range{a.lo / b.hi, a.hi / b.lo} : full;
+        case Instruction::urem:
+            if (b.lo > 0) {
+                return {0, a.lo >= 0 ? std::min(a.hi, b.hi - 1) : b.hi - 1};
+            }
+            return full;
+        case Instruction::and_:
+            if (a.lo >= 0 || b.lo >= 0) {
+                return {0, std::min(a.lo >= 0 ? a.hi : int_max, b.lo >= 0 ? b.hi : int_max)};
+            }
+            return full;
+        case Instruction::or_:
+        case Instruction::xor_: {
+            if (a.lo < 0 || b.lo < 0) {
+                return full;
+            }
+            long long mask = 1;
+            while (mask <= std::max(a.hi, b.hi)) {
+                mask <<= 1;
+            }
+            return {0, mask - 1};
+        }
+        case Instruction::shl:
+            return k < 0 ? full : make(a.lo * (1LL << k), a.hi * (1LL << k));
+        case Instruction::ashr:
+            return k < 0 ? full : Range{a.lo >> k, a.hi >> k};
+        case Instruction::lshr:
+            if (k < 0) {
+                return full;
+            }
+            if (a.lo >= 0 || k == 0) {
+                return a.lo >= 0 ? Range{a.lo >> k, a.hi >> k} : a;
+            }
+            return {0, 0xFFFFFFFFLL >> k};
+        default:
+            return full;
+    }
+}
+
+ValueRange::Range ValueRange::evaluate(Ptr<Instruction> inst) {
+    auto bb = inst->get_parent();
+    if (inst->is_phi()) {
+        Range range = {1, 0};
+        for (unsigned i = 0; i < inst->get_num_operand(); i += 2) {
+            auto in = get_range_on_edge(inst->get_operand(i), inst->get_operand(i + 1)->as<BasicBlock>(), bb);
+            if (!in.is_empty()) {
+                range = range.is_empty() ? in : Range{std::min(range.lo, in.lo), std::max(range.hi, in.hi)};
+            }
+        }
+        return range;
+    }
+    if (inst->is_cmp()) {
+        auto a = get_range_at(inst->get_operand(0), bb);
+        auto b = get_range_at(inst->get_operand(1), bb);
+        if (a.is_empty() || b.is_empty()) {
+            return {1, 0};
+        }
+        // whether the compare holds for all values, and for none
+        bool always = false, never = false;
+        if (decide_by_conditions(conditions_[bb], static_pointer_cast<CmpInst>(inst)->get_cmp_op(),
+                                 inst->get_operand(0), inst->get_operand(1), always)) {
+            return {always ? 1 : 0, always ? 1 : 0};
+        }
+        switch (static_pointer_cast<CmpInst>(inst)->get_cmp_op()) {
+            case CmpInst::LT: always = a.hi < b.lo; never = a.lo >= b.hi; break;
+            case CmpInst::LE: always = a.hi <= b.lo; never = a.lo > b.hi; break;
+            case CmpInst::GT: always = a.lo > b.hi; never = a.hi <= b.lo; break;
+            case CmpInst::GE: always = a.lo >= b.hi; never = a.hi < b.lo; break;
+            case CmpInst::EQ: always = a.is_single() && a == b; never = a.hi < b.lo || b.hi < a.lo; break;
+            case CmpInst::NE: always = a.hi < b.lo || b.hi < a.lo; never = a.is_single() && a == b; break;
+        }
+        return {never ? 0 : always ? 1 : 0, always ? 1 : never ? 0 : 1};
+    }
+    if (inst->is_zext()) {
+        return get_range_at(inst->get_operand(0), bb);
+    }
+    if (inst->is_select()) {
+        auto cond = get_range_at(inst->get_operand(0), bb);
+        auto t = get_range_at(inst->get_operand(1), bb);
+        auto f = get_range_at(inst->get_operand(2), bb);
+        if (cond.is_empty() || (cond.is_single() && cond.lo == 0)) {
+            return cond.is_empty() ? cond : f;
+        }
+        if (cond.is_single() || f.is_empty()) {
+            return t;
+        }
+        return t.is_empty() ? f : Range{std::min(t.lo, f.lo), std::max(t.hi, f.hi)};
+    }
+    if (inst->isBinary()) {
+        return evaluate_binary(inst, get_range_at(inst->get_operand(0), bb), get_range_at(inst->get_operand(1), bb));
+    }
+    return {int_min, int_max};
+}
+
+bool ValueRange::update(Ptr<Value> val, Range range) {
+    if (range.is_empty()) {
+        return false;
+    }
+    auto iter = ranges_.find(val);
+    if (iter == ranges_.end()) {
+        ranges_[val] = range;
+        return true;
+    }
+    auto old = iter->second;
+    Range joined = {std::min(old.lo, range.lo), std::max(old.hi, range.hi)};
+    if (joined == old) {
+        return false;
+    }
+    // a bound that keeps moving goes straight to the limit of the type
+    if (++updates_[val] > max_updates) {
+        bool is_bool = is_tracked_type(val->get_type()) &&
+                       static_pointer_cast<IntegerType>(val->get_type())->get_num_bits() == 1;
+        if (joined.lo < old.lo) joined.lo = is_bool ? 0 : int_min;
+        if (joined.hi > old.hi) joined.hi = is_bool ? 1 : int_max;
+    }
+    iter->second = joined;
+    return true;
+}
+
+void ValueRange::analyze() {
+    auto m = module.lock();
+    std::set<Ptr<Function>> known_callers;
+    for (auto f : m->get_functions()) {
+        if (has_known_callers(f)) {
+            known_callers.insert(f);
+            continue;
+        }
+        for (auto arg : f->get_args()) {
+            ranges_[arg] = {int_min, int_max};
+        }
+    }
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto f : m->get_functions()) {
+            for (auto bb : orders_[f]) {
+                for (auto inst : bb->get_instructions()) {
+                    if (inst->is_ret()) {
+                        if (inst->get_num_operand() == 1 && is_tracked_type(inst->get_operand(0)->get_type())) {
+                            changed |= update(f, get_range_at(inst->get_operand(0), bb));
+                        }
+                        continue;
+                    }
+                    if (inst->is_call()) {
+                        auto callee = inst->get_operand(0)->as<Function>();
+                        if (known_callers.count(callee)) {
+                            unsigned i = 1;
+                            for (auto arg : callee->get_args()) {
+                                if (is_tracked_type(arg->get_type())) {
+                                    changed |= update(arg, get_range_at(inst->get_operand(i), bb));
+                                }
+                                i++;
+                            }
+                        }
+                        if (is_tracked_type(inst->get_type())) {
+                            changed |= update(inst, callee->is_declaration() ? Range{int_min, int_max}
+                                                                            : get_range(callee));
+                        }
+                        continue;
+                    }
+                    if (is_tracked_type(inst->get_type())) {
+                        changed |= update(inst, evaluate(inst));
+                    }
+                }
+            }
+        }
+    }
+}
+
+bool ValueRange::narrow_divisions(Ptr<Function> f) {
+    bool changed = false;
+    for (auto bb : f->get_basic_blocks()) {
+        PtrVec<Instruction> worklist;
+        for (auto inst : bb->get_instructions()) {
+            if (!inst->is_div() && !inst->is_rem()) {
+                continue;
+            }
+            auto a = get_range_at(inst->get_operand(0), bb);
+            auto b = get_range_at(inst->get_operand(1), bb);
+            if (!a.is_empty() && !b.is_empty() && a.lo >= 0 && b.lo >= 0) {
+                worklist.push_back(inst);
+            }
+        }
+        for (auto inst : worklist) {
+            auto m = module.lock();
+            auto x = inst->get_operand(0);
+            auto y = inst->get_operand(1);
+            Ptr<Instruction> narrow = inst->is_div() ? BinaryInst::create_udiv(x, y, bb, m)
+                                                     : BinaryInst::create_urem(x, y, bb, m);
+            narrow->insert_before(inst);
+            ++num_narrowed;
+            Remark::emit(Remark(Remark::Passed, name, "MadeUnsigned", inst));
+            inst->replace_all_use_with(narrow);
+            bb->delete_instr(inst);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+bool ValueRange::fold_compares(Ptr<Function> f) {
+    auto m = module.lock();
+    PtrVec<Instruction> folded;
+    for (auto bb : f->get_basic_blocks()) {
+        for (auto inst : bb->get_instructions()) {
+            auto iter = ranges_.find(inst);
+            if (inst->is_cmp() && iter != ranges_.end() && iter->second.is_single()) {
+                folded.push_back(inst);
+            }
+        }
+    }
+    for (auto inst : folded) {
+        ++num_compares;
+        Remark::emit(Remark(Remark::Passed, name, "CompareFolded", inst)
+                         .arg("Result", ranges_[inst].lo != 0 ? "true" : "false"));
+        inst->replace_all_use_with(ConstantInt::create(ranges_[inst].lo != 0, m));
+        // the zext and compare of a wrapped condition go with it
+        PtrVec<Instruction> dead = {inst};
+        while (!dead.empty()) {
+            auto top = dead.back();
+            dead.pop_back();
+            PtrVec<Instruction> ops;
+            for (auto &op : top->get_operands()) {
+                if (auto op_inst = dyn_cast<Instruction>(op.lock())) {
+                    ops.push_back(op_inst);
+                }
+            }
+            top->get_parent()->delete_instr(top);
+            for (auto op : ops) {
+                if (op->get_use_list().empty() && (op->is_cmp() || op->is_zext()) &&
+                    std::find(folded.begin(), folded.end(), op) == folded.end()) {
+                    dead.push_back(op);
+                }
+            }
+        }
+    }
+    return !folded.empty();
+}
+
+bool ValueRange::fold_branches(Ptr<Function> f) {
+    bool changed = false;
+    for (auto bb : f->get_basic_blocks()) {
+        if (auto taken = fold_constant_branch(bb)) {
+            ++num_branches;
+            Remark::emit(Remark(Remark::Passed, name, "BranchFolded", bb).arg("Taken", taken));
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+}
+}
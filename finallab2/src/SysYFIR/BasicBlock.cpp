@@ -13,18 +13,18 @@ namespace IR
 {
 BasicBlock::BasicBlock(Ptr<Module> m, const std::string &name = "",
                       Ptr<Function> parent = nullptr)
-    : Value(Type::get_label_type(m), name), parent_(parent)
+    : Value(Type::get_label_type(m), BasicBlockVal, name), parent_(parent)
 {
 #ifdef DEBUG
     assert(parent && "currently parent should not be nullptr");
 #endif
-    // parent_->add_basic_block(dynamic_pointer_cast<BasicBlock>(shared_from_this()));
+    // parent_->add_basic_block(cast<BasicBlock>(shared_from_this()));
 }
 
 void BasicBlock::init(Ptr<Module> m, const std::string &name = "",
                       Ptr<Function> parent = nullptr)
 {
-    parent_.lock()->add_basic_block(dynamic_pointer_cast<BasicBlock>(shared_from_this()));
+    parent_.lock()->add_basic_block(cast<BasicBlock>(shared_from_this()));
 }
 
 Ptr<Module> BasicBlock::get_module()
@@ -37,7 +37,7 @@ void BasicBlock::add_instruction(Ptr<Instruction> instr)
     instr_list_.push_back(instr);
 }
 
-void BasicBlock::add_instruction(PtrList<Instruction>::iterator instr_pos, Ptr<Instruction> instr)
+void BasicBlock::add_instruction(IList<Instruction>::iterator instr_pos, Ptr<Instruction> instr)
 {
     instr_list_.insert(instr_pos, instr);
 }
@@ -47,9 +47,9 @@ void BasicBlock::add_instr_begin(Ptr<Instruction> instr)
     instr_list_.push_front(instr);
 }
 
-PtrList<Instruction>::iterator BasicBlock::find_instruction(Ptr<Instruction> instr)
+IList<Instruction>::iterator BasicBlock::find_instruction(Ptr<Instruction> instr)
 {
-    return std::find(instr_list_.begin(), instr_list_.end(), instr);
+    return instr_list_.find(instr);
 }
 
 void BasicBlock::delete_instr( Ptr<Instruction> instr )
@@ -73,6 +73,10 @@ const Ptr<Instruction> BasicBlock::get_terminator() const
         return instr_list_.back();
         break;
 
+    case Instruction::switch_:
+        return instr_list_.back();
+        break;
+
     default:
         return nullptr;
         break;
@@ -81,7 +85,7 @@ const Ptr<Instruction> BasicBlock::get_terminator() const
 
 void BasicBlock::erase_from_parent()
 {
-    this->get_parent()->remove(dynamic_pointer_cast<BasicBlock>(shared_from_this()));
+    this->get_parent()->remove(cast<BasicBlock>(shared_from_this()));
 }
 
 std::string BasicBlock::print()
@@ -4,6 +4,8 @@
 #include <iostream>
 #include <sstream>
 #include <string.h>
+#include <algorithm>
+#include <cmath>
 
 namespace SysYF
 {
@@ -11,7 +13,21 @@ namespace IR
 {
 
 void Constant::init(Ptr<Type> ty, const std::string &name, unsigned num_ops) {
-    parent_.lock()->add_constant(dynamic_pointer_cast<Constant>(shared_from_this()));
+    parent_.lock()->add_constant(cast<Constant>(shared_from_this()));
+}
+
+bool Constant::is_zero_value()
+{
+    auto self = shared_from_this();
+    if (auto const_int = dyn_cast<ConstantInt>(self)) {
+        return const_int->get_value() == 0;
+    }
+    if (auto const_float = dyn_cast<ConstantFloat>(self)) {
+        // -0.0 is not all zero bits
+        float val = const_float->get_value();
+        return val == 0 && !std::signbit(val);
+    }
+    return isa<ConstantZero>(self);
 }
 
 void ConstantInt::init(Ptr<Type> ty, int val, Ptr<Module> m)
@@ -29,6 +45,11 @@ Ptr<ConstantInt> ConstantInt::create(bool val, Ptr<Module> m)
     RET_AFTER_INIT(ConstantInt, Type::get_int1_type(m), val?1:0, m);
 }
 
+Ptr<ConstantInt> ConstantInt::create(Ptr<IntegerType> ty, int val, Ptr<Module> m)
+{
+    RET_AFTER_INIT(ConstantInt, ty, val, m);
+}
+
 std::string ConstantInt::print()
 {
     std::string const_ir;
@@ -69,42 +90,146 @@ std::string ConstantFloat::print()
 }
 
 ConstantArray::ConstantArray(Ptr<ArrayType> ty, const PtrVec<Constant> &val, Ptr<Module> m)
-    : Constant(ty, "", val.size(), m) 
+    : Constant(ty, ConstantArrayVal, "", val.size(), m) 
 {
 
 }
 
+static Ptr<Constant> create_zero_element(Ptr<Type> elem_ty, Ptr<Module> m)
+{
+    if (elem_ty->is_integer_type()) {
+        return ConstantInt::create(0, m);
+    } else if (elem_ty->is_float_type()) {
+        return ConstantFloat::create(0, m);
+    }
+    return ConstantZero::create(elem_ty, m);
+}
+
 void ConstantArray::init(Ptr<ArrayType> ty, const PtrVec<Constant> &val, Ptr<Module> m)
 {
     Constant::init(ty, "", val.size());
     for (unsigned int i = 0; i < val.size(); i++)
         set_operand(i, val[i]);
     this->const_array.assign(val.begin(),val.end());
+    zero_ = create_zero_element(ty->get_element_type(), m);
 }
 
 Ptr<Constant> ConstantArray::get_element_value(int index) {
-    return this->const_array[index];
+    if (index < static_cast<int>(const_array.size())) {
+        return this->const_array[index];
+    }
+    return zero_;
+}
+
+unsigned ConstantArray::get_size_of_array()
+{
+    return static_pointer_cast<ArrayType>(get_type())->get_num_of_elements();
 }
 
 Ptr<ConstantArray> ConstantArray::create(Ptr<ArrayType> ty, const PtrVec<Constant> &val, Ptr<Module> m)
 {
-    RET_AFTER_INIT(ConstantArray, ty, val, m);
+    // a short zero tail is cheaper to spell out than the packed struct
+    const unsigned min_zero_tail = 16;
+    unsigned length = ty->get_num_of_elements();
+    unsigned explicit_len = std::min<unsigned>(val.size(), length);
+    while (explicit_len > 0 && val[explicit_len - 1]->is_zero_value()) {
+        explicit_len--;
+    }
+    PtrVec<Constant> explicit_val(val.begin(), val.begin() + explicit_len);
+    if (length - explicit_len < min_zero_tail) {
+        explicit_val.assign(val.begin(), val.begin() + std::min<unsigned>(val.size(), length));
+        auto zero = create_zero_element(ty->get_element_type(), m);
+        explicit_val.resize(length, zero);
+    }
+    RET_AFTER_INIT(ConstantArray, ty, explicit_val, m);
+}
+
+Ptr<Constant> ConstantArray::get(Ptr<ArrayType> ty, const PtrVec<Constant> &val, Ptr<Module> m)
+{
+    for (auto elem : val) {
+        if (!elem->is_zero_value()) {
+            return create(ty, val, m);
+        }
+    }
+    return ConstantZero::create(ty, m);
+}
+
+std::string ConstantArray::print_storage_type()
+{
+    if (!has_zero_tail()) {
+        return get_type()->print();
+    }
+    auto elem_ty = get_type()->get_array_element_type();
+    auto size = get_size_of_array();
+    auto explicit_size = get_num_explicit_elements();
+    return "<{ " + ArrayType::get(elem_ty, explicit_size)->print() + ", " +
+           ArrayType::get(elem_ty, size - explicit_size)->print() + " }>";
 }
 
 std::string ConstantArray::print()
 {
     std::string const_ir;
-    const_ir += "[";
-    const_ir += this->get_type()->get_array_element_type()->print();
+    auto elem_ty = this->get_type()->get_array_element_type();
+    auto size = get_size_of_array();
+    auto explicit_size = get_num_explicit_elements();
+    // the explicit elements, padded with zeros if the tail is short
+    auto print_elements = [&](unsigned num) {
+        std::string elems_ir = "[";
+        for (unsigned int i = 0; i < num; i++) {
+            if (i) {
+                elems_ir += ", ";
+            }
+            elems_ir += elem_ty->print();
+            elems_ir += " ";
+            elems_ir += get_element_value(i)->print();
+        }
+        elems_ir += "]";
+        return elems_ir;
+    };
+    if (!has_zero_tail()) {
+        return print_elements(size);
+    }
+    const_ir += "<{ ";
+    const_ir += ArrayType::get(elem_ty, explicit_size)->print();
     const_ir += " ";
-    const_ir += get_element_value(0)->print();
-    for (unsigned int i = 1; i < this->get_size_of_array(); i++) {
-        const_ir += ", ";
-        const_ir += this->get_type()->get_array_element_type()->print();
+    const_ir += print_elements(explicit_size);
+    const_ir += ", ";
+    const_ir += ArrayType::get(elem_ty, size - explicit_size)->print();
+    const_ir += " zeroinitializer }>";
+    return const_ir;
+}
+
+void ConstantVector::init(Ptr<VectorType> ty, const PtrVec<Constant> &val, Ptr<Module> m)
+{
+    Constant::init(ty, "", val.size());
+    for (unsigned int i = 0; i < val.size(); i++)
+        set_operand(i, val[i]);
+    elements_ = val;
+}
+
+Ptr<ConstantVector> ConstantVector::create(Ptr<VectorType> ty, const PtrVec<Constant> &val, Ptr<Module> m)
+{
+    RET_AFTER_INIT(ConstantVector, ty, val, m);
+}
+
+Ptr<ConstantVector> ConstantVector::get_splat(unsigned num_elements, Ptr<Constant> val, Ptr<Module> m)
+{
+    PtrVec<Constant> elements(num_elements, val);
+    return create(VectorType::get(val->get_type(), num_elements), elements, m);
+}
+
+std::string ConstantVector::print()
+{
+    std::string const_ir = "<";
+    for (unsigned int i = 0; i < elements_.size(); i++) {
+        if (i) {
+            const_ir += ", ";
+        }
+        const_ir += elements_[i]->get_type()->print();
         const_ir += " ";
-        const_ir += get_element_value(i)->print();
+        const_ir += elements_[i]->print();
     }
-    const_ir += "]";
+    const_ir += ">";
     return const_ir;
 }
 
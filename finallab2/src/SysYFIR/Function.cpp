@@ -8,13 +8,13 @@ namespace SysYF
 namespace IR
 {
 Function::Function(Ptr<FunctionType> ty, const std::string &name, Ptr<Module> parent)
-    : Value(ty, name), parent_(parent), seq_cnt_(0)
+    : Value(ty, FunctionVal, name), parent_(parent), seq_cnt_(0)
 {
 
 }
 
 void Function::init(Ptr<FunctionType> ty, const std::string &name, Ptr<Module> parent) {
-    get_parent()->add_function(dynamic_pointer_cast<Function>(shared_from_this()));
+    get_parent()->add_function(cast<Function>(shared_from_this()));
     build_args();
 }
 
@@ -66,7 +66,7 @@ void Function::build_args()
     auto func_ty = get_function_type();
     unsigned int num_args = get_num_of_args();
     for (unsigned int i = 0; i < num_args; i++) {
-        arguments_.push_back(Argument::create(func_ty->get_param_type(i), "", dynamic_pointer_cast<Function>(shared_from_this()), i));
+        arguments_.push_back(Argument::create(func_ty->get_param_type(i), "", dyn_cast<Function>(shared_from_this()), i));
     }
 }
 
@@ -75,43 +75,42 @@ void Function::add_basic_block(Ptr<BasicBlock> bb)
     basic_blocks_.push_back(bb);
 }
 
+void Function::move_basic_blocks_from(Ptr<Function> f)
+{
+    for (auto bb : f->basic_blocks_)
+    {
+        bb->set_parent(cast<Function>(shared_from_this()));
+    }
+    basic_blocks_.splice(basic_blocks_.end(), f->basic_blocks_);
+    // the moved values keep their names, don't hand them out again
+    seq_cnt_ = std::max(seq_cnt_, f->seq_cnt_);
+}
+
 void Function::set_instr_name()
 {
-    std::map<Ptr<Value> , int> seq;
-    for (auto arg : this->get_args())
+    // a value keeps the name it has, only the new ones are numbered, so
+    // calling this again costs a walk of the function and no strings
+    for (auto &arg : arguments_)
     {
-        if ( seq.find(arg) == seq.end())
+        if ( !arg->has_name() )
         {
-            auto seq_num = seq.size() + seq_cnt_;
-            if ( arg->set_name("arg"+std::to_string(seq_num) ))
-            {
-                seq.insert( {arg, seq_num} );
-            }
+            arg->set_name("arg"+std::to_string(seq_cnt_++));
         }
     }
-    for (auto bb : basic_blocks_)
+    for (auto &bb : basic_blocks_)
     {
-        if ( seq.find(bb) == seq.end())
+        if ( !bb->has_name() )
         {
-            auto seq_num = seq.size() + seq_cnt_;
-            if ( bb->set_name("label"+std::to_string(seq_num) ))
-            {
-                seq.insert( {bb, seq_num} );
-            }
+            bb->set_name("label"+std::to_string(seq_cnt_++));
         }
-        for (auto instr : bb->get_instructions())
+        for (auto &instr : bb->get_instructions())
         {
-            if ( !instr->is_void() && seq.find(instr) == seq.end())
+            if ( !instr->has_name() && !instr->is_void() )
             {
-                auto seq_num = seq.size() + seq_cnt_;
-                if ( instr->set_name("op"+std::to_string(seq_num) ))
-                {
-                    seq.insert( {instr, seq_num} );
-                }
+                instr->set_name("op"+std::to_string(seq_cnt_++));
             }
         }
     }
-    seq_cnt_ += seq.size();
 }
 
 std::string Function::print()
@@ -13,15 +13,25 @@ std::string print_as_op( Ptr<Value> v, bool print_ty )
         op_ir += " ";
     }
 
-    if (dynamic_pointer_cast<GlobalVariable>(v))
+    if (isa<GlobalVariable>(v))
     {
-        op_ir += "@"+v->get_name();
+        // an initializer with a zero tail changes the type of the storage
+        auto init_array = dyn_cast<ConstantArray>(static_pointer_cast<GlobalVariable>(v)->get_init());
+        if (init_array && init_array->has_zero_tail())
+        {
+            op_ir += "bitcast (" + init_array->print_storage_type() + "* @" + v->get_name();
+            op_ir += " to " + v->get_type()->print() + ")";
+        }
+        else
+        {
+            op_ir += "@"+v->get_name();
+        }
     }
-    else if (dynamic_pointer_cast<Function>(v) )
+    else if (isa<Function>(v))
     {
         op_ir += "@"+v->get_name();
     }
-    else if (dynamic_pointer_cast<Constant>(v))
+    else if (isa<Constant>(v))
     {
         op_ir += v->print();
     }
@@ -19,14 +19,14 @@ namespace SysYF
 namespace IR
 {
 Instruction::Instruction(Ptr<Type> ty, OpID id, unsigned num_ops, Ptr<BasicBlock> parent)
-    : User(ty, "", num_ops), op_id_(id), num_ops_(num_ops), parent_(parent)
+    : User(ty, InstructionVal + id, "", num_ops), op_id_(id), num_ops_(num_ops), parent_(parent)
 {
     
 }
 
 void Instruction::insert_to_bb()
 { 
-    parent_.lock()-> add_instruction(dynamic_pointer_cast<Instruction>(shared_from_this())); 
+    parent_.lock()-> add_instruction(cast<Instruction>(shared_from_this())); 
 }
 
 void Instruction::init(Ptr<Type> ty, OpID id, unsigned num_ops, Ptr<BasicBlock> parent) 
@@ -34,6 +34,49 @@ void Instruction::init(Ptr<Type> ty, OpID id, unsigned num_ops, Ptr<BasicBlock>
     insert_to_bb();
 }
 
+void Instruction::insert_before(Ptr<Instruction> pos)
+{
+    // keeps the instruction alive while it is out of any block
+    auto self = dyn_cast<Instruction>(shared_from_this());
+    remove_from_parent();
+    auto bb = pos->get_parent();
+    bb->add_instruction(bb->find_instruction(pos), self);
+    set_parent(bb);
+}
+
+void Instruction::insert_after(Ptr<Instruction> pos)
+{
+    auto self = dyn_cast<Instruction>(shared_from_this());
+    remove_from_parent();
+    auto bb = pos->get_parent();
+    bb->add_instruction(std::next(bb->find_instruction(pos)), self);
+    set_parent(bb);
+}
+
+void Instruction::move_to(Ptr<BasicBlock> bb)
+{
+    auto self = dyn_cast<Instruction>(shared_from_this());
+    remove_from_parent();
+    auto terminator = bb->get_terminator();
+    if (terminator) {
+        bb->add_instruction(bb->find_instruction(terminator), self);
+    } else {
+        bb->add_instruction(self);
+    }
+    set_parent(bb);
+}
+
+void Instruction::remove_from_parent()
+{
+    // not through get_parent(), a copy is put in a block before its parent is set
+    unlink_from_list();
+}
+
+void Instruction::erase_from_parent()
+{
+    get_parent()->delete_instr(cast<Instruction>(shared_from_this()));
+}
+
 Ptr<Function> Instruction::get_function()
 { 
     return parent_.lock()->get_parent(); 
@@ -57,6 +100,11 @@ void BinaryInst::init(Ptr<Type> ty, OpID id, Ptr<Value> v1, Ptr<Value> v2, Ptr<B
     set_operand(1, v2);
 }
 
+Ptr<BinaryInst> BinaryInst::create(OpID id, Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb)
+{
+    RET_AFTER_INIT(BinaryInst, v1->get_type(), id, v1, v2, bb);
+}
+
 Ptr<BinaryInst> BinaryInst::create_add(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m)
 {
     RET_AFTER_INIT(BinaryInst, v1->get_type()->is_pointer_type() ? v1->get_type() : v2->get_type(), Instruction::add, v1, v2, bb);
@@ -64,42 +112,82 @@ Ptr<BinaryInst> BinaryInst::create_add(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBl
 
 Ptr<BinaryInst> BinaryInst::create_sub(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m)
 {
-    RET_AFTER_INIT(BinaryInst, Type::get_int32_type(m), Instruction::sub, v1, v2, bb);
+    RET_AFTER_INIT(BinaryInst, v1->get_type(), Instruction::sub, v1, v2, bb);
 }
 
 Ptr<BinaryInst> BinaryInst::create_mul(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m)
 {
-    RET_AFTER_INIT(BinaryInst, Type::get_int32_type(m), Instruction::mul, v1, v2, bb);
+    RET_AFTER_INIT(BinaryInst, v1->get_type(), Instruction::mul, v1, v2, bb);
 }
 
 Ptr<BinaryInst> BinaryInst::create_sdiv(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m)
 {
-    RET_AFTER_INIT(BinaryInst, Type::get_int32_type(m), Instruction::sdiv, v1, v2, bb);
+    RET_AFTER_INIT(BinaryInst, v1->get_type(), Instruction::sdiv, v1, v2, bb);
 }
 
 Ptr<BinaryInst> BinaryInst::create_srem(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m)
 {
-    RET_AFTER_INIT(BinaryInst, Type::get_int32_type(m), Instruction::srem, v1, v2, bb);
+    RET_AFTER_INIT(BinaryInst, v1->get_type(), Instruction::srem, v1, v2, bb);
+}
+
+Ptr<BinaryInst> BinaryInst::create_udiv(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m)
+{
+    RET_AFTER_INIT(BinaryInst, v1->get_type(), Instruction::udiv, v1, v2, bb);
+}
+
+Ptr<BinaryInst> BinaryInst::create_urem(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m)
+{
+    RET_AFTER_INIT(BinaryInst, v1->get_type(), Instruction::urem, v1, v2, bb);
+}
+
+Ptr<BinaryInst> BinaryInst::create_shl(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m)
+{
+    RET_AFTER_INIT(BinaryInst, v1->get_type(), Instruction::shl, v1, v2, bb);
+}
+
+Ptr<BinaryInst> BinaryInst::create_ashr(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m)
+{
+    RET_AFTER_INIT(BinaryInst, v1->get_type(), Instruction::ashr, v1, v2, bb);
+}
+
+Ptr<BinaryInst> BinaryInst::create_lshr(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m)
+{
+    RET_AFTER_INIT(BinaryInst, v1->get_type(), Instruction::lshr, v1, v2, bb);
+}
+
+Ptr<BinaryInst> BinaryInst::create_and(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m)
+{
+    RET_AFTER_INIT(BinaryInst, v1->get_type(), Instruction::and_, v1, v2, bb);
+}
+
+Ptr<BinaryInst> BinaryInst::create_or(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m)
+{
+    RET_AFTER_INIT(BinaryInst, v1->get_type(), Instruction::or_, v1, v2, bb);
+}
+
+Ptr<BinaryInst> BinaryInst::create_xor(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m)
+{
+    RET_AFTER_INIT(BinaryInst, v1->get_type(), Instruction::xor_, v1, v2, bb);
 }
 
 Ptr<BinaryInst> BinaryInst::create_fadd(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m)
 {
-    RET_AFTER_INIT(BinaryInst, Type::get_float_type(m), Instruction::fadd, v1, v2, bb);
+    RET_AFTER_INIT(BinaryInst, v1->get_type(), Instruction::fadd, v1, v2, bb);
 }
 
 Ptr<BinaryInst> BinaryInst::create_fsub(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m)
 {
-    RET_AFTER_INIT(BinaryInst, Type::get_float_type(m), Instruction::fsub, v1, v2, bb);
+    RET_AFTER_INIT(BinaryInst, v1->get_type(), Instruction::fsub, v1, v2, bb);
 }
 
 Ptr<BinaryInst> BinaryInst::create_fmul(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m)
 {
-    RET_AFTER_INIT(BinaryInst, Type::get_float_type(m), Instruction::fmul, v1, v2, bb);
+    RET_AFTER_INIT(BinaryInst, v1->get_type(), Instruction::fmul, v1, v2, bb);
 }
 
 Ptr<BinaryInst> BinaryInst::create_fdiv(Ptr<Value> v1, Ptr<Value> v2, Ptr<BasicBlock> bb, Ptr<Module> m)
 {
-    RET_AFTER_INIT(BinaryInst, Type::get_float_type(m), Instruction::fdiv, v1, v2, bb);
+    RET_AFTER_INIT(BinaryInst, v1->get_type(), Instruction::fdiv, v1, v2, bb);
 }
 
 std::string BinaryInst::print()
@@ -273,7 +361,7 @@ std::string CallInst::print()
     
     instr_ir += " ";
 #ifdef DEBUG
-    assert(dynamic_pointer_cast<Function>(this->get_operand(0)) && "Wrong call operand function");
+    assert(isa<Function>(this->get_operand(0)) && "Wrong call operand function");
 #endif
     instr_ir += print_as_op(this->get_operand(0), false);
     instr_ir += "(";
@@ -380,6 +468,82 @@ std::string BranchInst::print()
     return instr_ir;
 }
 
+SwitchInst::SwitchInst(Ptr<Value> cond, Ptr<BasicBlock> default_bb, Ptr<BasicBlock> bb)
+    : Instruction(Type::get_void_type(bb->get_module()), Instruction::switch_, 2, bb)
+{
+
+}
+
+void SwitchInst::init(Ptr<Value> cond, Ptr<BasicBlock> default_bb, Ptr<BasicBlock> bb)
+{
+    Instruction::init(Type::get_void_type(bb->get_module()), Instruction::switch_, 2, bb);
+    set_operand(0, cond);
+    set_operand(1, default_bb);
+}
+
+// a block is a successor only once, however many cases lead to it
+static void add_unique_edge(Ptr<BasicBlock> from, Ptr<BasicBlock> to)
+{
+    for (auto &succ : from->get_succ_basic_blocks())
+    {
+        if (succ.lock() == to)
+        {
+            return;
+        }
+    }
+    from->add_succ_basic_block(to);
+    to->add_pre_basic_block(from);
+}
+
+Ptr<SwitchInst> SwitchInst::create_switch(Ptr<Value> cond, Ptr<BasicBlock> default_bb, Ptr<BasicBlock> bb)
+{
+    add_unique_edge(bb, default_bb);
+
+    RET_AFTER_INIT(SwitchInst, cond, default_bb, bb);
+}
+
+void SwitchInst::add_case(Ptr<ConstantInt> val, Ptr<BasicBlock> dest)
+{
+    add_unique_edge(get_parent(), dest);
+    add_operand(val);
+    add_operand(dest);
+}
+
+Ptr<BasicBlock> SwitchInst::get_default_dest()
+{
+    return static_pointer_cast<BasicBlock>(get_operand(1));
+}
+
+Ptr<ConstantInt> SwitchInst::get_case_value(unsigned i)
+{
+    return static_pointer_cast<ConstantInt>(get_operand(2 + 2 * i));
+}
+
+Ptr<BasicBlock> SwitchInst::get_case_dest(unsigned i)
+{
+    return static_pointer_cast<BasicBlock>(get_operand(3 + 2 * i));
+}
+
+std::string SwitchInst::print()
+{
+    std::string instr_ir;
+    instr_ir += this->get_module()->get_instr_op_name( this->get_instr_type() );
+    instr_ir += " ";
+    instr_ir += print_as_op(this->get_operand(0), true);
+    instr_ir += ", ";
+    instr_ir += print_as_op(this->get_operand(1), true);
+    instr_ir += " [";
+    for (unsigned i = 0; i < get_num_cases(); i++)
+    {
+        instr_ir += " ";
+        instr_ir += print_as_op(get_case_value(i), true);
+        instr_ir += ", ";
+        instr_ir += print_as_op(get_case_dest(i), true);
+    }
+    instr_ir += " ]";
+    return instr_ir;
+}
+
 ReturnInst::ReturnInst(Ptr<Value> val, Ptr<BasicBlock> bb)
     : Instruction(Type::get_void_type(bb->get_module()), Instruction::ret, 1, bb)
 {
@@ -539,6 +703,11 @@ std::string StoreInst::print()
     instr_ir += print_as_op(this->get_operand(0), false);
     instr_ir += ", ";
     instr_ir += print_as_op(this->get_operand(1), true);
+    if (align_ > 0)
+    {
+        instr_ir += ", align ";
+        instr_ir += std::to_string(align_);
+    }
     return instr_ir;
 }
 
@@ -582,6 +751,11 @@ std::string LoadInst::print()
     instr_ir += ",";
     instr_ir += " ";
     instr_ir += print_as_op(this->get_operand(0), true);
+    if (align_ > 0)
+    {
+        instr_ir += ", align ";
+        instr_ir += std::to_string(align_);
+    }
     return instr_ir;
 }
 
@@ -656,6 +830,82 @@ std::string ZextInst::print()
     return instr_ir; 
 }
 
+SextInst::SextInst(OpID op, Ptr<Value> val, Ptr<Type> ty, Ptr<BasicBlock> bb)
+    : Instruction(ty, op, 1, bb), dest_ty_(ty)
+{
+    
+}
+
+void SextInst::init(OpID op, Ptr<Value> val, Ptr<Type> ty, Ptr<BasicBlock> bb)
+{
+    Instruction::init(ty, op, 1, bb);
+    set_operand(0, val);
+}
+
+Ptr<SextInst> SextInst::create_sext(Ptr<Value> val, Ptr<Type> ty, Ptr<BasicBlock> bb)
+{
+    RET_AFTER_INIT(SextInst, Instruction::sext, val, ty, bb);
+}
+
+Ptr<Type> SextInst::get_dest_type() const
+{
+    return dest_ty_.lock();
+}
+
+std::string SextInst::print()
+{
+    std::string instr_ir;
+    instr_ir += "%";
+    instr_ir += this->get_name();
+    instr_ir += " = ";
+    instr_ir += this->get_module()->get_instr_op_name( this->get_instr_type() );
+    instr_ir += " ";
+    instr_ir += this->get_operand(0)->get_type()->print();
+    instr_ir += " ";
+    instr_ir += print_as_op(this->get_operand(0), false);
+    instr_ir += " to ";
+    instr_ir += this->get_dest_type()->print();
+    return instr_ir; 
+}
+
+TruncInst::TruncInst(OpID op, Ptr<Value> val, Ptr<Type> ty, Ptr<BasicBlock> bb)
+    : Instruction(ty, op, 1, bb), dest_ty_(ty)
+{
+    
+}
+
+void TruncInst::init(OpID op, Ptr<Value> val, Ptr<Type> ty, Ptr<BasicBlock> bb)
+{
+    Instruction::init(ty, op, 1, bb);
+    set_operand(0, val);
+}
+
+Ptr<TruncInst> TruncInst::create_trunc(Ptr<Value> val, Ptr<Type> ty, Ptr<BasicBlock> bb)
+{
+    RET_AFTER_INIT(TruncInst, Instruction::trunc, val, ty, bb);
+}
+
+Ptr<Type> TruncInst::get_dest_type() const
+{
+    return dest_ty_.lock();
+}
+
+std::string TruncInst::print()
+{
+    std::string instr_ir;
+    instr_ir += "%";
+    instr_ir += this->get_name();
+    instr_ir += " = ";
+    instr_ir += this->get_module()->get_instr_op_name( this->get_instr_type() );
+    instr_ir += " ";
+    instr_ir += this->get_operand(0)->get_type()->print();
+    instr_ir += " ";
+    instr_ir += print_as_op(this->get_operand(0), false);
+    instr_ir += " to ";
+    instr_ir += this->get_dest_type()->print();
+    return instr_ir; 
+}
+
 FpToSiInst::FpToSiInst(OpID op, Ptr<Value> val, Ptr<Type> ty, Ptr<BasicBlock> bb)
     : Instruction(ty, op, 1, bb), dest_ty_(ty)
 {
@@ -732,6 +982,146 @@ std::string SiToFpInst::print()
     return instr_ir; 
 }
 
+BitCastInst::BitCastInst(OpID op, Ptr<Value> val, Ptr<Type> ty, Ptr<BasicBlock> bb)
+    : Instruction(ty, op, 1, bb), dest_ty_(ty)
+{
+
+}
+
+void BitCastInst::init(OpID op, Ptr<Value> val, Ptr<Type> ty, Ptr<BasicBlock> bb)
+{
+    Instruction::init(ty, op, 1, bb);
+    set_operand(0, val);
+}
+
+Ptr<BitCastInst> BitCastInst::create_bitcast(Ptr<Value> val, Ptr<Type> ty, Ptr<BasicBlock> bb)
+{
+    RET_AFTER_INIT(BitCastInst, Instruction::bitcast, val, ty, bb);
+}
+
+Ptr<Type> BitCastInst::get_dest_type() const
+{
+    return dest_ty_.lock();
+}
+
+std::string BitCastInst::print()
+{
+    std::string instr_ir;
+    instr_ir += "%";
+    instr_ir += this->get_name();
+    instr_ir += " = ";
+    instr_ir += this->get_module()->get_instr_op_name( this->get_instr_type() );
+    instr_ir += " ";
+    instr_ir += this->get_operand(0)->get_type()->print();
+    instr_ir += " ";
+    instr_ir += print_as_op(this->get_operand(0), false);
+    instr_ir += " to ";
+    instr_ir += this->get_dest_type()->print();
+    return instr_ir;
+}
+
+SelectInst::SelectInst(Ptr<Value> cond, Ptr<Value> true_val, Ptr<Value> false_val, Ptr<BasicBlock> bb)
+    : Instruction(true_val->get_type(), Instruction::select, 3, bb)
+{
+
+}
+
+void SelectInst::init(Ptr<Value> cond, Ptr<Value> true_val, Ptr<Value> false_val, Ptr<BasicBlock> bb)
+{
+    Instruction::init(true_val->get_type(), Instruction::select, 3, bb);
+    set_operand(0, cond);
+    set_operand(1, true_val);
+    set_operand(2, false_val);
+}
+
+Ptr<SelectInst> SelectInst::create_select(Ptr<Value> cond, Ptr<Value> true_val, Ptr<Value> false_val, Ptr<BasicBlock> bb)
+{
+    RET_AFTER_INIT(SelectInst, cond, true_val, false_val, bb);
+}
+
+std::string SelectInst::print()
+{
+    std::string instr_ir;
+    instr_ir += "%";
+    instr_ir += this->get_name();
+    instr_ir += " = ";
+    instr_ir += this->get_module()->get_instr_op_name( this->get_instr_type() );
+    instr_ir += " ";
+    instr_ir += print_as_op(this->get_operand(0), true);
+    instr_ir += ", ";
+    instr_ir += print_as_op(this->get_operand(1), true);
+    instr_ir += ", ";
+    instr_ir += print_as_op(this->get_operand(2), true);
+    return instr_ir;
+}
+
+InsertElementInst::InsertElementInst(Ptr<Value> vec, Ptr<Value> elt, Ptr<Value> idx, Ptr<BasicBlock> bb)
+    : Instruction(vec->get_type(), Instruction::insertelement, 3, bb)
+{
+
+}
+
+void InsertElementInst::init(Ptr<Value> vec, Ptr<Value> elt, Ptr<Value> idx, Ptr<BasicBlock> bb)
+{
+    Instruction::init(vec->get_type(), Instruction::insertelement, 3, bb);
+    set_operand(0, vec);
+    set_operand(1, elt);
+    set_operand(2, idx);
+}
+
+Ptr<InsertElementInst> InsertElementInst::create_insertelement(Ptr<Value> vec, Ptr<Value> elt, Ptr<Value> idx, Ptr<BasicBlock> bb)
+{
+    RET_AFTER_INIT(InsertElementInst, vec, elt, idx, bb);
+}
+
+std::string InsertElementInst::print()
+{
+    std::string instr_ir;
+    instr_ir += "%";
+    instr_ir += this->get_name();
+    instr_ir += " = ";
+    instr_ir += this->get_module()->get_instr_op_name( this->get_instr_type() );
+    instr_ir += " ";
+    instr_ir += print_as_op(this->get_operand(0), true);
+    instr_ir += ", ";
+    instr_ir += print_as_op(this->get_operand(1), true);
+    instr_ir += ", ";
+    instr_ir += print_as_op(this->get_operand(2), true);
+    return instr_ir;
+}
+
+ExtractElementInst::ExtractElementInst(Ptr<Value> vec, Ptr<Value> idx, Ptr<BasicBlock> bb)
+    : Instruction(vec->get_type()->get_scalar_type(), Instruction::extractelement, 2, bb)
+{
+
+}
+
+void ExtractElementInst::init(Ptr<Value> vec, Ptr<Value> idx, Ptr<BasicBlock> bb)
+{
+    Instruction::init(vec->get_type()->get_scalar_type(), Instruction::extractelement, 2, bb);
+    set_operand(0, vec);
+    set_operand(1, idx);
+}
+
+Ptr<ExtractElementInst> ExtractElementInst::create_extractelement(Ptr<Value> vec, Ptr<Value> idx, Ptr<BasicBlock> bb)
+{
+    RET_AFTER_INIT(ExtractElementInst, vec, idx, bb);
+}
+
+std::string ExtractElementInst::print()
+{
+    std::string instr_ir;
+    instr_ir += "%";
+    instr_ir += this->get_name();
+    instr_ir += " = ";
+    instr_ir += this->get_module()->get_instr_op_name( this->get_instr_type() );
+    instr_ir += " ";
+    instr_ir += print_as_op(this->get_operand(0), true);
+    instr_ir += ", ";
+    instr_ir += print_as_op(this->get_operand(1), true);
+    return instr_ir;
+}
+
 PhiInst::PhiInst(OpID op, PtrVec<Value> vals, PtrVec<BasicBlock> val_bbs, Ptr<Type> ty, Ptr<BasicBlock> bb)
     : Instruction(ty, op, 2*vals.size(), bb)
 {
@@ -10,12 +10,22 @@ Module::Module(std::string name)
     // init instr_id2string
     instr_id2string_.insert({ Instruction::ret, "ret" }); 
     instr_id2string_.insert({ Instruction::br, "br" }); 
+    instr_id2string_.insert({ Instruction::switch_, "switch" });
     
     instr_id2string_.insert({ Instruction::add, "add" });
     instr_id2string_.insert({ Instruction::sub, "sub" });
     instr_id2string_.insert({ Instruction::mul, "mul" });
     instr_id2string_.insert({ Instruction::sdiv, "sdiv" });
     instr_id2string_.insert({ Instruction::srem, "srem" });
+    instr_id2string_.insert({ Instruction::udiv, "udiv" });
+    instr_id2string_.insert({ Instruction::urem, "urem" });
+
+    instr_id2string_.insert({ Instruction::shl, "shl" });
+    instr_id2string_.insert({ Instruction::ashr, "ashr" });
+    instr_id2string_.insert({ Instruction::lshr, "lshr" });
+    instr_id2string_.insert({ Instruction::and_, "and" });
+    instr_id2string_.insert({ Instruction::or_, "or" });
+    instr_id2string_.insert({ Instruction::xor_, "xor" });
 
     instr_id2string_.insert({ Instruction::fadd, "fadd" });
     instr_id2string_.insert({ Instruction::fsub, "fsub" });
@@ -30,16 +40,24 @@ Module::Module(std::string name)
     instr_id2string_.insert({ Instruction::phi, "phi" });
     instr_id2string_.insert({ Instruction::call, "call" });
     instr_id2string_.insert({ Instruction::getelementptr, "getelementptr" });
+    instr_id2string_.insert({ Instruction::select, "select" });
+    instr_id2string_.insert({ Instruction::insertelement, "insertelement" });
+    instr_id2string_.insert({ Instruction::extractelement, "extractelement" });
     instr_id2string_.insert({ Instruction::zext, "zext" });
+    instr_id2string_.insert({ Instruction::sext, "sext" });
+    instr_id2string_.insert({ Instruction::trunc, "trunc" });
     instr_id2string_.insert({ Instruction::fptosi, "fptosi" });
     instr_id2string_.insert({ Instruction::sitofp, "sitofp" });
+    instr_id2string_.insert({ Instruction::bitcast, "bitcast" });
 }
 
 void Module::init(std::string name) {
     void_ty_ = Type::create(Type::VoidTyID, shared_from_this());
     label_ty_ = Type::create(Type::LabelTyID, shared_from_this());
     int1_ty_ = IntegerType::create(1, shared_from_this());
+    int8_ty_ = IntegerType::create(8, shared_from_this());
     int32_ty_ = IntegerType::create(32, shared_from_this());
+    int64_ty_ = IntegerType::create(64, shared_from_this());
     float32_ty_ = FloatType::create(shared_from_this());
 }
 
@@ -62,11 +80,21 @@ Ptr<IntegerType> Module::get_int1_type()
     return int1_ty_;
 }
 
+Ptr<IntegerType> Module::get_int8_type()
+{
+    return int8_ty_;
+}
+
 Ptr<IntegerType> Module::get_int32_type()
 {
     return int32_ty_;
 }
 
+Ptr<IntegerType> Module::get_int64_type()
+{
+    return int64_ty_;
+}
+
 Ptr<FloatType> Module::get_float_type()
 {
     return float32_ty_;
@@ -90,6 +118,15 @@ Ptr<ArrayType> Module::get_array_type(Ptr<Type> contained, unsigned num_elements
     return array_map_[{contained, num_elements}];
 }
 
+Ptr<VectorType> Module::get_vector_type(Ptr<Type> contained, unsigned num_elements)
+{
+    if( vector_map_.find({contained, num_elements}) == vector_map_.end() )
+    {
+        vector_map_[{contained, num_elements}] = VectorType::create(contained, num_elements, shared_from_this());
+    }
+    return vector_map_[{contained, num_elements}];
+}
+
 Ptr<PointerType> Module::get_int32_ptr_type()
 {
     return get_pointer_type(int32_ty_);
@@ -104,6 +141,10 @@ void Module::add_function(Ptr<Function> f)
 {
     function_list_.push_back(f);
 }
+void Module::remove_function(Ptr<Function> f)
+{
+    function_list_.remove(f);
+}
 PtrList<Function> &Module::get_functions(){
     return function_list_;
 }
@@ -111,6 +152,10 @@ void Module::add_global_variable(Ptr<GlobalVariable> g)
 {
     global_list_.push_back(g);
 }
+void Module::remove_global_variable(Ptr<GlobalVariable> g)
+{
+    global_list_.remove(g);
+}
 PtrList<GlobalVariable> &Module::get_global_variable(){
     return global_list_;
 }
@@ -49,11 +49,21 @@ Ptr<IntegerType> Type::get_int1_type(Ptr<Module> m)
     return m->get_int1_type();
 }
 
+Ptr<IntegerType> Type::get_int8_type(Ptr<Module> m)
+{
+    return m->get_int8_type();
+}
+
 Ptr<IntegerType> Type::get_int32_type(Ptr<Module> m)
 {
     return m->get_int32_type();
 }
 
+Ptr<IntegerType> Type::get_int64_type(Ptr<Module> m)
+{
+    return m->get_int64_type();
+}
+
 Ptr<FloatType> Type::get_float_type(Ptr<Module> m)
 {
     return m->get_float_type();
@@ -69,6 +79,11 @@ Ptr<ArrayType> Type::get_array_type(Ptr<Type> contained, unsigned num_elements)
     return ArrayType::get(contained, num_elements);
 }
 
+Ptr<VectorType> Type::get_vector_type(Ptr<Type> contained, unsigned num_elements)
+{
+    return VectorType::get(contained, num_elements);
+}
+
 Ptr<PointerType> Type::get_int32_ptr_type(Ptr<Module> m)
 {
     return m->get_int32_ptr_type();
@@ -93,6 +108,13 @@ Ptr<Type> Type::get_array_element_type(){
         return nullptr;
 }
 
+Ptr<Type> Type::get_scalar_type(){
+    if( this->is_vector_type() )
+        return static_pointer_cast<VectorType>(shared_from_this())->get_element_type();
+    else
+        return shared_from_this();
+}
+
 int Type::get_size()
 {
     if (this->is_integer_type())
@@ -110,6 +132,12 @@ int Type::get_size()
         auto num_elements = static_pointer_cast<ArrayType>(shared_from_this())->get_num_of_elements();
         return element_size * num_elements;
     }
+    if (this->is_vector_type())
+    {
+        auto element_size = static_pointer_cast<VectorType>(shared_from_this())->get_element_type()->get_size();
+        auto num_elements = static_pointer_cast<VectorType>(shared_from_this())->get_num_of_elements();
+        return element_size * num_elements;
+    }
     if (this->is_pointer_type())
     {
         if (this->get_pointer_element_type()->is_array_type())
@@ -163,6 +191,13 @@ std::string Type::print(){
         type_ir += static_pointer_cast<ArrayType>(shared_from_this())->get_element_type()->print();
         type_ir += "]";
         break;
+    case VectorTyID:
+        type_ir += "<";
+        type_ir += std::to_string( static_pointer_cast<VectorType>(shared_from_this())->get_num_of_elements());
+        type_ir += " x ";
+        type_ir += static_pointer_cast<VectorType>(shared_from_this())->get_element_type()->print();
+        type_ir += ">";
+        break;
     default:
         break;
     }
@@ -284,5 +319,29 @@ Ptr<PointerType> PointerType::create(Ptr<Type> contained, Ptr<Module> m)
     RET_AFTER_INIT(PointerType, contained, m);
 }
 
+VectorType::VectorType(Ptr<Type> contained, unsigned num_elements, Ptr<Module> m)
+    : Type(Type::VectorTyID, contained->get_module()), num_elements_(num_elements)
+{
+#ifdef DEBUG
+    assert(is_valid_element_type(contained) && "Not a valid type for vector element!");
+#endif
+    contained_ = contained;
+}
+
+bool VectorType::is_valid_element_type(Ptr<Type> ty)
+{
+    return ty->is_integer_type()||ty->is_float_type();
+}
+
+Ptr<VectorType> VectorType::get(Ptr<Type> contained, unsigned num_elements)
+{
+    return contained->get_module()->get_vector_type(contained, num_elements);
+}
+
+Ptr<VectorType> VectorType::create(Ptr<Type> contained, unsigned num_elements, Ptr<Module> m)
+{
+    RET_AFTER_INIT(VectorType, contained, num_elements, m);
+}
+
 }
 }
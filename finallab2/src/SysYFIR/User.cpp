@@ -10,8 +10,8 @@ namespace SysYF
 {
 namespace IR
 {
-User::User(Ptr<Type> ty, const std::string &name , unsigned num_ops)
-    : Value(ty, name), num_ops_(num_ops)
+User::User(Ptr<Type> ty, unsigned id, const std::string &name , unsigned num_ops)
+    : Value(ty, id, name), num_ops_(num_ops)
 {
     // if (num_ops_ > 0)
     //   operands_.reset(new std::list<Ptr<Value> >());
@@ -29,6 +29,10 @@ void User::set_operand(unsigned i, Ptr<Value> v)
     assert(i < num_ops_ && "set_operand out of index");
 #endif
     // assert(operands_[i] == nullptr && "ith operand is not null");
+    auto old_val = operands_[i].lock();
+    if (old_val) {
+        old_val->remove_use(shared_from_this(), i);
+    }
     operands_[i] = v;  
     v->add_use(shared_from_this(), i);
 }
@@ -53,8 +57,19 @@ void User::remove_use_of_ops()
 }
 
 void User::remove_operands(int index1,int index2){
+    auto self = shared_from_this();
     for(int i=index1;i<=index2;i++){
-        operands_[i].lock()->remove_use(shared_from_this());
+        operands_[i].lock()->remove_use(self, i);
+    }
+    // the operands behind the removed range move forward
+    int removed = index2 - index1 + 1;
+    for(unsigned i=index2+1;i<num_ops_;i++){
+        for(auto &use : operands_[i].lock()->get_use_list()){
+            if(use.arg_no_ == i && use.val_.lock() == self){
+                use.arg_no_ = i - removed;
+                break;
+            }
+        }
     }
     operands_.erase(operands_.begin()+index1,operands_.begin()+index2+1);
     // std::cout<<operands_.size()<<std::endl;
@@ -9,8 +9,8 @@ namespace SysYF
 {
 namespace IR
 {
-Value::Value(Ptr<Type> ty, const std::string &name)
-  : type_(ty), name_(name)
+Value::Value(Ptr<Type> ty, unsigned id, const std::string &name)
+  : value_id_(id), type_(ty), name_(name)
 {
 
 }
@@ -20,15 +20,12 @@ void Value::add_use(Ptr<Value> val, unsigned arg_no)
     use_list_.push_back(Use(val, arg_no));
 }
 
-std::string Value::get_name() const
-{
-    return name_;
-}
-
 void Value::replace_all_use_with(Ptr<Value> new_val)
 {
-    for (auto use : use_list_) {
-        auto val = dynamic_pointer_cast<User>(use.val_.lock());
+    // set_operand unlinks each use from use_list_, so walk a copy
+    auto uses = use_list_;
+    for (auto use : uses) {
+        auto val = dyn_cast<User>(use.val_.lock());
 #ifdef DEBUG
         assert(val && "new_val is not a user");
 #endif
@@ -42,5 +39,11 @@ void Value::remove_use(Ptr<Value> val)
     use_list_.remove_if(is_val);
 }
 
+void Value::remove_use(Ptr<Value> val, unsigned arg_no)
+{
+    auto is_use = [val, arg_no] (const Use &use) { return use.arg_no_ == arg_no && use.val_.lock() == val; };
+    use_list_.remove_if(is_use);
+}
+
 }
 }
@@ -53,6 +53,11 @@ std::map<Ptr<Value> , Ptr<Value> > local2global;
 Ptr<BasicBlock> ret_BB;
 Ptr<Value> ret_addr;
 
+// llvm.memset/llvm.memcpy declarations, created on first use
+std::map<std::string, Ptr<Function> > mem_intrinsics;
+// local arrays up to this length are initialized element by element
+const int ARRAY_STORE_LIMIT = 16;
+
 /* Global Variable */
 
 bool match_type(Ptr<IRStmtBuilder> builder, Ptr<Value> *lhs_ptr, Ptr<Value> *rhs_ptr) {
@@ -88,15 +93,15 @@ void IRBuilder::visit(SyntaxTree::InitVal &node) {
     // simple ver
     if (node.isExp) {
         node.expr->accept(*this);
-        auto tmp_int32_val = dynamic_pointer_cast<ConstantInt>(tmp_val);
-        auto tmp_float_val = dynamic_pointer_cast<ConstantFloat>(tmp_val);
+        auto tmp_int32_val = dyn_cast<ConstantInt>(tmp_val);
+        auto tmp_float_val = dyn_cast<ConstantFloat>(tmp_val);
         if (var_type == INT32_T && tmp_float_val != nullptr) {
             if (tmp_float_val)
             tmp_val = CONST_INT(int(tmp_float_val->get_value()));
         } else if (var_type == FLOAT_T && tmp_int32_val != nullptr) {
             tmp_val = CONST_FLOAT(float(tmp_int32_val->get_value()));
         }
-        init_val.push_back(dynamic_pointer_cast<Constant>(tmp_val));
+        init_val.push_back(dyn_cast<Constant>(tmp_val));
     }
     else {
         for (const auto &elem : node.elementList){
@@ -233,16 +238,16 @@ void IRBuilder::visit(SyntaxTree::VarDef &node) {
         if (node.array_length.empty()) {
             node.initializers->accept(*this);
             if (var_type == INT32_T) {
-                if (dynamic_pointer_cast<ConstantFloat>(tmp_val)) {
-                    tmp_val = CONST_INT(int(dynamic_pointer_cast<ConstantFloat>(tmp_val)->get_value()));
+                if (isa<ConstantFloat>(tmp_val)) {
+                    tmp_val = CONST_INT(int(cast<ConstantFloat>(tmp_val)->get_value()));
                 }
-                auto initializer = dynamic_pointer_cast<ConstantInt>(tmp_val)->get_value();
+                auto initializer = cast<ConstantInt>(tmp_val)->get_value();
                 var = ConstantInt::create(initializer, module);
             } else if (var_type == FLOAT_T) {
-                if (dynamic_pointer_cast<ConstantInt>(tmp_val)) {
-                    tmp_val = CONST_FLOAT(float(dynamic_pointer_cast<ConstantInt>(tmp_val)->get_value()));
+                if (isa<ConstantInt>(tmp_val)) {
+                    tmp_val = CONST_FLOAT(float(cast<ConstantInt>(tmp_val)->get_value()));
                 }
-                auto initializer = dynamic_pointer_cast<ConstantFloat>(tmp_val)->get_value();
+                auto initializer = cast<ConstantFloat>(tmp_val)->get_value();
                 var = ConstantFloat::create(initializer, module);
             }
             scope.push(node.name, var);
@@ -251,22 +256,13 @@ void IRBuilder::visit(SyntaxTree::VarDef &node) {
             int length;
             assert(node.array_length.size() == 1 && "invalid array dimension");
             node.array_length[0]->accept(*this);
-            auto length_const = dynamic_pointer_cast<ConstantInt>(tmp_val);
+            auto length_const = dyn_cast<ConstantInt>(tmp_val);
             length = length_const->get_value();
             auto array_type = ArrayType::get(var_type, length);
             init_val.clear();
             node.initializers->accept(*this);
             if (scope.in_global()) {
-                int cur_size = init_val.size();
-                while (cur_size < length){
-                    if (var_type == INT32_T) {
-                        init_val.push_back(CONST_INT(0));
-                    } else if (var_type == FLOAT_T) {
-                        init_val.push_back(CONST_FLOAT(0));
-                    }
-                    cur_size++;
-                }
-                auto initializer = ConstantArray::create(array_type, init_val, module);
+                auto initializer = ConstantArray::get(array_type, init_val, module);
                 var = GlobalVariable::create(node.name, module, array_type, true, initializer);
                 scope.push(node.name, var);
             }
@@ -277,45 +273,15 @@ void IRBuilder::visit(SyntaxTree::VarDef &node) {
                 }
                 var = builder->create_alloca(array_type);
                 cur_fun_cur_block->get_instructions().pop_back();
-                cur_fun_entry_block->add_instruction(dynamic_pointer_cast<Instruction>(var));
+                cur_fun_entry_block->add_instruction(cast<Instruction>(var));
                 var->as<Instruction>()->set_parent(cur_fun_entry_block);
                 if (tmp_terminator != nullptr) {
                     cur_fun_entry_block->add_instruction(tmp_terminator);
                 }
-                int pos = 0;
-                for (auto init : init_val){
-                    builder->create_store(init, builder->create_gep(var, {CONST_INT(0), CONST_INT(pos)}));
-                    pos++;
-                }
-                while (pos < length){
-                    if (var_type == INT32_T) {
-                        builder->create_store(CONST_INT(0), builder->create_gep(var, {CONST_INT(0), CONST_INT(pos)}));
-                    } else if (var_type == FLOAT_T) {
-                        builder->create_store(CONST_FLOAT(0), builder->create_gep(var, {CONST_INT(0), CONST_INT(pos)}));
-                    }
-                    pos++;
-                }
-                scope.push(node.name, var);
                 //add a const global array as llvm
-                int cur_size = init_val.size();
-                while (cur_size < length){
-                    if (var_type == INT32_T) {
-                        init_val.push_back(CONST_INT(0));
-                    } else if (var_type == FLOAT_T) {
-                        init_val.push_back(CONST_FLOAT(0));
-                    }
-                    cur_size++;
-                }
-                auto initializer = ConstantArray::create(array_type, init_val, module);
-                std::string const_name = "__const." + cur_fun->get_name() + "." + node.name;
-                std::string const_num = "";
-                int suffix = 0;
-                while (scope.find(const_name + const_num,false) != nullptr){
-                    suffix ++ ;
-                    const_num = "." + std::to_string(suffix);
-                }
-                auto const_var = GlobalVariable::create(const_name + const_num, module, array_type, true, initializer);
-                scope.push(const_name + const_num, const_var);
+                auto const_var = create_const_copy(node.name, array_type);
+                init_local_array(var, array_type, length, const_var, node.name);
+                scope.push(node.name, var);
                 local2global[var] = const_var;
             }
         }
@@ -327,15 +293,15 @@ void IRBuilder::visit(SyntaxTree::VarDef &node) {
                     node.initializers->accept(*this);
                     Ptr<Constant> initializer;
                     if (var_type == INT32_T) {
-                        if (dynamic_pointer_cast<ConstantFloat>(tmp_val)) {
-                            tmp_val = CONST_INT(int(dynamic_pointer_cast<ConstantFloat>(tmp_val)->get_value()));
+                        if (isa<ConstantFloat>(tmp_val)) {
+                            tmp_val = CONST_INT(int(cast<ConstantFloat>(tmp_val)->get_value()));
                         }
-                        initializer = dynamic_pointer_cast<ConstantInt>(tmp_val);
+                        initializer = dyn_cast<ConstantInt>(tmp_val);
                     } else if (var_type == FLOAT_T) {
-                        if (dynamic_pointer_cast<ConstantInt>(tmp_val)) {
-                            tmp_val = CONST_FLOAT(float(dynamic_pointer_cast<ConstantInt>(tmp_val)->get_value()));
+                        if (isa<ConstantInt>(tmp_val)) {
+                            tmp_val = CONST_FLOAT(float(cast<ConstantInt>(tmp_val)->get_value()));
                         }
-                        initializer = dynamic_pointer_cast<ConstantFloat>(tmp_val);
+                        initializer = dyn_cast<ConstantFloat>(tmp_val);
                     }
                     var = GlobalVariable::create(node.name, module, var_type, false, initializer);
                     scope.push(node.name, var);
@@ -351,7 +317,7 @@ void IRBuilder::visit(SyntaxTree::VarDef &node) {
                 }
                 var = builder->create_alloca(var_type);
                 cur_fun_cur_block->get_instructions().pop_back();
-                cur_fun_entry_block->add_instruction(dynamic_pointer_cast<Instruction>(var));
+                cur_fun_entry_block->add_instruction(cast<Instruction>(var));
                 var->as<Instruction>()->set_parent(cur_fun_entry_block);
                 if (tmp_terminator != nullptr) {
                     cur_fun_entry_block->add_instruction(tmp_terminator);
@@ -372,7 +338,7 @@ void IRBuilder::visit(SyntaxTree::VarDef &node) {
             int length;
             assert(node.array_length.size() == 1 && "invalid array dimension");
             node.array_length[0]->accept(*this);
-            auto length_const = dynamic_pointer_cast<ConstantInt>(tmp_val);
+            auto length_const = dyn_cast<ConstantInt>(tmp_val);
             length = length_const->get_value();
             auto array_type = ArrayType::get(var_type, length);
             Ptr<Value> var;
@@ -380,16 +346,7 @@ void IRBuilder::visit(SyntaxTree::VarDef &node) {
                 if (node.is_inited) {
                     init_val.clear();
                     node.initializers->accept(*this);
-                    int cur_size = init_val.size();
-                    while (cur_size < length){
-                        if (var_type == INT32_T) {
-                            init_val.push_back(CONST_INT(0));
-                        } else if (var_type == FLOAT_T) {
-                            init_val.push_back(CONST_FLOAT(0));
-                        }
-                        cur_size++;
-                    }
-                    auto initializer = ConstantArray::create(array_type, init_val, module);
+                    auto initializer = ConstantArray::get(array_type, init_val, module);
                     var = GlobalVariable::create(node.name, module, array_type, false, initializer);
                     scope.push(node.name, var);
                 } else {
@@ -406,26 +363,14 @@ void IRBuilder::visit(SyntaxTree::VarDef &node) {
                 var = builder->create_alloca(array_type);
                 cur_fun_cur_block->get_instructions().pop_back();
                 var->as<Instruction>()->set_parent(cur_fun_entry_block);
-                cur_fun_entry_block->add_instruction(dynamic_pointer_cast<Instruction>(var));
+                cur_fun_entry_block->add_instruction(cast<Instruction>(var));
                 if (tmp_terminator != nullptr) {
                     cur_fun_entry_block->add_instruction(tmp_terminator);
                 }
                 if (node.is_inited) {
                     init_val.clear();
                     node.initializers->accept(*this);
-                    int pos = 0;
-                    for (auto init : init_val){
-                        builder->create_store(init, builder->create_gep(var, {CONST_INT(0), CONST_INT(pos)}));
-                        pos++;
-                    }
-                    while (pos < length){
-                        if (var_type == INT32_T) {
-                            builder->create_store(CONST_INT(0), builder->create_gep(var, {CONST_INT(0), CONST_INT(pos)}));
-                        } else if (var_type == FLOAT_T) {
-                            builder->create_store(CONST_FLOAT(0), builder->create_gep(var, {CONST_INT(0), CONST_INT(pos)}));
-                        }
-                        pos++;
-                    }
+                    init_local_array(var, array_type, length, nullptr, node.name);
                 }
                 scope.push(node.name, var);
             }
@@ -433,6 +378,108 @@ void IRBuilder::visit(SyntaxTree::VarDef &node) {
     }
 }
 
+// put init_val (zeros past its end) in a constant global
+Ptr<GlobalVariable> IRBuilder::create_const_copy(const std::string &name, Ptr<ArrayType> array_type) {
+    auto initializer = ConstantArray::get(array_type, init_val, module);
+    std::string const_name = "__const." + cur_fun->get_name() + "." + name;
+    std::string const_num = "";
+    int suffix = 0;
+    while (scope.find(const_name + const_num,false) != nullptr){
+        suffix ++ ;
+        const_num = "." + std::to_string(suffix);
+    }
+    auto const_var = GlobalVariable::create(const_name + const_num, module, array_type, true, initializer);
+    scope.push(const_name + const_num, const_var);
+    return const_var;
+}
+
+// store init_val (zeros past its end) to the local array var.
+// Short arrays get one store per element, mostly-zero arrays a memset
+// followed by stores of the non-zero elements, and dense arrays a memcpy
+// from a constant copy (const_copy, or a new one if it is null).
+void IRBuilder::init_local_array(Ptr<Value> var, Ptr<ArrayType> array_type, int length,
+                                 Ptr<GlobalVariable> const_copy, const std::string &name) {
+    if (length <= ARRAY_STORE_LIMIT) {
+        int pos = 0;
+        for (auto init : init_val){
+            if (pos >= length) {
+                break;
+            }
+            builder->create_store(init, builder->create_gep(var, {CONST_INT(0), CONST_INT(pos)}));
+            pos++;
+        }
+        while (pos < length){
+            if (var_type == INT32_T) {
+                builder->create_store(CONST_INT(0), builder->create_gep(var, {CONST_INT(0), CONST_INT(pos)}));
+            } else if (var_type == FLOAT_T) {
+                builder->create_store(CONST_FLOAT(0), builder->create_gep(var, {CONST_INT(0), CONST_INT(pos)}));
+            }
+            pos++;
+        }
+        return;
+    }
+    int non_zero = 0;
+    for (auto init : init_val) {
+        non_zero += init->is_zero_value() ? 0 : 1;
+    }
+    auto array_ptr = builder->create_gep(var, {CONST_INT(0), CONST_INT(0)});
+    auto size = CONST_INT(length * 4);
+    if (non_zero * 4 > length) {
+        if (const_copy == nullptr) {
+            const_copy = create_const_copy(name, array_type);
+        }
+        auto src_ptr = builder->create_gep(const_copy, {CONST_INT(0), CONST_INT(0)});
+        builder->create_call(get_mem_intrinsic("memcpy", var_type), {array_ptr, src_ptr, size, CONST_INT(false)});
+        return;
+    }
+    auto zero = ConstantInt::create(Type::get_int8_type(module), 0, module);
+    builder->create_call(get_mem_intrinsic("memset", var_type), {array_ptr, zero, size, CONST_INT(false)});
+    int pos = 0;
+    for (auto init : init_val) {
+        if (!init->is_zero_value()) {
+            builder->create_store(init, builder->create_gep(var, {CONST_INT(0), CONST_INT(pos)}));
+        }
+        pos++;
+    }
+}
+
+// the intrinsics are overloaded on their pointer types, declare the
+// i32*/float* variant the first time it is needed
+Ptr<Function> IRBuilder::get_mem_intrinsic(const std::string &name, Ptr<Type> elem_type) {
+    std::string ptr_suffix = elem_type->is_float_type() ? ".p0f32" : ".p0i32";
+    bool is_memcpy = (name == "memcpy");
+    std::string func_name = "llvm." + name + ptr_suffix + (is_memcpy ? ptr_suffix : "") + ".i32";
+    auto iter = mem_intrinsics.find(func_name);
+    if (iter != mem_intrinsics.end()) {
+        return iter->second;
+    }
+    auto ptr_type = Type::get_pointer_type(elem_type);
+    PtrVec<Type> params;
+    params.push_back(ptr_type);
+    if (is_memcpy) {
+        params.push_back(ptr_type);
+    } else {
+        params.push_back(Type::get_int8_type(module));
+    }
+    params.push_back(INT32_T);
+    params.push_back(INT1_T);
+    auto func = Function::create(FunctionType::create(VOID_T, params, module), func_name, module);
+    mem_intrinsics[func_name] = func;
+    return func;
+}
+
+// element index of a constant array, the initializer may be a zeroinitializer
+Ptr<Constant> IRBuilder::get_const_element(Ptr<GlobalVariable> array, int index) {
+    auto init_array = dyn_cast<ConstantArray>(array->get_init());
+    if (init_array) {
+        return init_array->get_element_value(index);
+    }
+    if (array->get_type()->get_pointer_element_type()->get_array_element_type()->is_float_type()) {
+        return CONST_FLOAT(0);
+    }
+    return CONST_INT(0);
+}
+
 void IRBuilder::visit(SyntaxTree::AssignStmt &node) {
     node.value->accept(*this);
     auto result = tmp_val;
@@ -463,8 +510,8 @@ void IRBuilder::visit(SyntaxTree::LVal &node) {
             }
             require_lvalue = false;
         } else {
-            auto val_const_int = dynamic_pointer_cast<ConstantInt>(var);
-            auto val_const_float = dynamic_pointer_cast<ConstantFloat>(var);
+            auto val_const_int = dyn_cast<ConstantInt>(var);
+            auto val_const_float = dyn_cast<ConstantFloat>(var);
             if (val_const_int != nullptr) {
                 tmp_val = val_const_int;
             } else if (val_const_float != nullptr) {
@@ -477,29 +524,23 @@ void IRBuilder::visit(SyntaxTree::LVal &node) {
         //simple ver
         node.array_index[0]->accept(*this);
         auto index = tmp_val;
-        auto const_index = dynamic_pointer_cast<ConstantInt>(index);
+        auto const_index = dyn_cast<ConstantInt>(index);
         if (const_index!=nullptr){
             //global const array
-            auto global_var = dynamic_pointer_cast<GlobalVariable>(var);
+            auto global_var = dyn_cast<GlobalVariable>(var);
             if (global_var!=nullptr){
                 if (global_var->is_const()){
-                    auto init = global_var->get_init();
-                    auto init_array = dynamic_pointer_cast<ConstantArray>(init);
-                    auto index_value = const_index->get_value();
-                    tmp_val = init_array->get_element_value(index_value);
+                    tmp_val = get_const_element(global_var, const_index->get_value());
                     return ;
                 }
             }
             //local const array
             auto const_var = local2global[var];
             if (const_var!=nullptr){
-                auto global_const_var = dynamic_pointer_cast<GlobalVariable>(const_var);
+                auto global_const_var = dyn_cast<GlobalVariable>(const_var);
                 if (global_const_var!=nullptr){
                     if (global_const_var->is_const()){
-                        auto init = global_const_var->get_init();
-                        auto init_array = dynamic_pointer_cast<ConstantArray>(init);
-                        auto index_value = const_index->get_value();
-                        tmp_val = init_array->get_element_value(index_value);
+                        tmp_val = get_const_element(global_const_var, const_index->get_value());
                         return ;
                     }
                 }
@@ -588,8 +629,8 @@ void IRBuilder::visit(SyntaxTree::BinaryCondExpr &node) {
         IF_While_And_Cond_Stack.push_back({trueBB, IF_While_Or_Cond_Stack.back().falseBB});
         node.lhs->accept(*this);
         IF_While_And_Cond_Stack.pop_back();
-        cond_val = dynamic_pointer_cast<CmpInst>(tmp_val);
-        f_cond_val = dynamic_pointer_cast<FCmpInst>(tmp_val);
+        cond_val = dyn_cast<CmpInst>(tmp_val);
+        f_cond_val = dyn_cast<FCmpInst>(tmp_val);
         if (tmp_val->get_type()->is_integer_type() || cond_val != nullptr) {
             if (cond_val == nullptr) {
                 cond_val = builder->create_icmp_ne(tmp_val, CONST_INT(0));
@@ -608,8 +649,8 @@ void IRBuilder::visit(SyntaxTree::BinaryCondExpr &node) {
         IF_While_Or_Cond_Stack.push_back({IF_While_Or_Cond_Stack.back().trueBB, falseBB});
         node.lhs->accept(*this);
         IF_While_Or_Cond_Stack.pop_back();
-        cond_val = dynamic_pointer_cast<CmpInst>(tmp_val);
-        f_cond_val = dynamic_pointer_cast<FCmpInst>(tmp_val);
+        cond_val = dyn_cast<CmpInst>(tmp_val);
+        f_cond_val = dyn_cast<FCmpInst>(tmp_val);
         if (tmp_val->get_type()->is_integer_type() || cond_val != nullptr) {
             if (cond_val == nullptr) {
                 cond_val = builder->create_icmp_ne(tmp_val, CONST_INT(0));
@@ -685,12 +726,12 @@ void IRBuilder::visit(SyntaxTree::BinaryExpr &node) {
         node.lhs->accept(*this);
     } else {
         node.lhs->accept(*this);
-        auto l_val_const_i = dynamic_pointer_cast<ConstantInt>(tmp_val);
-        auto l_val_const_f = dynamic_pointer_cast<ConstantFloat>(tmp_val);
+        auto l_val_const_i = dyn_cast<ConstantInt>(tmp_val);
+        auto l_val_const_f = dyn_cast<ConstantFloat>(tmp_val);
         auto l_val = tmp_val;
         node.rhs->accept(*this);
-        auto r_val_const_i = dynamic_pointer_cast<ConstantInt>(tmp_val);
-        auto r_val_const_f = dynamic_pointer_cast<ConstantFloat>(tmp_val);
+        auto r_val_const_i = dyn_cast<ConstantInt>(tmp_val);
+        auto r_val_const_f = dyn_cast<ConstantFloat>(tmp_val);
         auto r_val = tmp_val;
         bool both_const = ((l_val_const_i != nullptr || l_val_const_f != nullptr) && (r_val_const_i != nullptr || r_val_const_f != nullptr));
         if (both_const) {
@@ -798,8 +839,8 @@ void IRBuilder::visit(SyntaxTree::BinaryExpr &node) {
 void IRBuilder::visit(SyntaxTree::UnaryExpr &node) {
     node.rhs->accept(*this);
     if (node.op == SyntaxTree::UnaryOp::MINUS) {
-        auto val_const_i = dynamic_pointer_cast<ConstantInt>(tmp_val);
-        auto val_const_f = dynamic_pointer_cast<ConstantFloat>(tmp_val);
+        auto val_const_i = dyn_cast<ConstantInt>(tmp_val);
+        auto val_const_f = dyn_cast<ConstantFloat>(tmp_val);
         auto r_val = tmp_val;
         if (val_const_i != nullptr) {
             tmp_val = CONST_INT(0 - val_const_i->get_value());
@@ -816,7 +857,7 @@ void IRBuilder::visit(SyntaxTree::UnaryExpr &node) {
 }
 
 void IRBuilder::visit(SyntaxTree::FuncCallStmt &node) {
-    auto fun = dynamic_pointer_cast<Function>(scope.find(node.name,true));
+    auto fun = dyn_cast<Function>(scope.find(node.name,true));
     PtrVec<Value> params;
     int i = 0;
     for (auto &param : node.params) {
@@ -829,14 +870,14 @@ void IRBuilder::visit(SyntaxTree::FuncCallStmt &node) {
         param->accept(*this);
         require_lvalue = false;
         if (param_type->is_float_type() && tmp_val->get_type()->is_integer_type()) {
-            auto const_tmp_val_i = dynamic_pointer_cast<ConstantInt>(tmp_val);
+            auto const_tmp_val_i = dyn_cast<ConstantInt>(tmp_val);
             if (const_tmp_val_i != nullptr) {
                 tmp_val = CONST_FLOAT(float(const_tmp_val_i->get_value()));
             } else {
                 tmp_val = builder->create_sitofp(tmp_val, FLOAT_T);
             }
         } else if (param_type->is_integer_type() && tmp_val->get_type()->is_float_type()) {
-            auto const_tmp_val_f = dynamic_pointer_cast<ConstantFloat>(tmp_val);
+            auto const_tmp_val_f = dyn_cast<ConstantFloat>(tmp_val);
             if (const_tmp_val_f != nullptr) {
                 tmp_val = CONST_INT(int(const_tmp_val_f->get_value()));
             } else {
@@ -862,8 +903,8 @@ void IRBuilder::visit(SyntaxTree::IfStmt &node) {
     node.cond_exp->accept(*this);
     IF_While_Or_Cond_Stack.pop_back();
     auto ret_val = tmp_val;
-    auto cond_val = dynamic_pointer_cast<CmpInst>(ret_val);
-    auto f_cond_val = dynamic_pointer_cast<FCmpInst>(ret_val);
+    auto cond_val = dyn_cast<CmpInst>(ret_val);
+    auto f_cond_val = dyn_cast<FCmpInst>(ret_val);
     Ptr<Value> cond;
     if (cond_val == nullptr && f_cond_val == nullptr) {
         if (tmp_val->get_type()->is_integer_type()) {
@@ -938,8 +979,8 @@ void IRBuilder::visit(SyntaxTree::WhileStmt &node) {
     node.cond_exp->accept(*this);
     IF_While_Or_Cond_Stack.pop_back();
     auto ret_val = tmp_val;
-    auto cond_val = dynamic_pointer_cast<CmpInst>(ret_val);
-    auto f_cond_val = dynamic_pointer_cast<FCmpInst>(ret_val);
+    auto cond_val = dyn_cast<CmpInst>(ret_val);
+    auto f_cond_val = dyn_cast<FCmpInst>(ret_val);
     Ptr<Value> cond;
     if (cond_val == nullptr && f_cond_val == nullptr) {
         if (tmp_val->get_type()->is_integer_type()) {
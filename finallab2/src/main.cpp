@@ -1,22 +1,18 @@
 #include <iostream>
-#include "Check.h"
-#include "ComSubExprEli.h"
 #include "IRBuilder.h"
 #include "SysYFDriver.h"
 #include "SyntaxTreePrinter.h"
 #include "ErrorReporter.h"
 #include "Pass.h"
-#include "DominateTree.h"
-#include "Mem2Reg.h"
-#include "LiveVar.h"
+#include "Remarks.h"
+#include "Statistics.h"
 #include "SyntaxTreeChecker.h"
-#include "CodeSizeOptimizer.h"
 
 
 void print_help(const std::string& exe_name) {
   std::cout << "Usage: " << exe_name
             << " [ -h | --help ] [ -p | --trace_parsing ] [ -s | --trace_scanning ] [ -emit-ast ] [ -check ]"
-            << " [ -emit-ir ] [ -O2 ] [ -O ] [ -lv ] [ -cse ] [ -optimize-size ] [ -o <output-file> ]"
+            << " [ -emit-ir ] [ -O2 ] [ -O ] [ -lv ] [ -cse ] [ -ipcp ] [ -gdce ] [ -instcombine ] [ -vrp ] [ -jump-threading ] [ -unswitch ] [ -pre ] [ -ifconv ] [ -switch ] [ -fvr ] [ -vectorize ] [ -slp ] [ -divrem ] [ -optimize-size ] [ -passes=<pipeline> ] [ -verify=off|pipeline|each ] [ -stats ] [ -remarks=<file> ] [ -o <output-file> ]"
             << " <input-file>"
             << std::endl;
 }
@@ -39,7 +35,24 @@ int main(int argc, char *argv[])
 
     bool lv = false;
     bool cse = false;
+    bool ipcp = false;
+    bool gdce = false;
+    bool instcombine = false;
+    bool ifconv = false;
+    bool switch_formation = false;
+    bool vrp = false;
+    bool jump_threading = false;
+    bool unswitch = false;
+    bool pre = false;
+    bool fvr = false;
+    bool vectorize = false;
+    bool slp = false;
+    bool divrem = false;
     bool optimize_size = false;
+    auto verify_mode = IR::PassMgr::VerifyAfterPipeline;
+    std::string pipeline;
+    bool stats = false;
+    std::string remarks_file;
 
     std::string filename = "-";
     std::string output_llvm_file = "-";
@@ -81,10 +94,81 @@ int main(int argc, char *argv[])
             optimize = true;
             cse = true;
         }
+        else if(argv[i] == std::string("-ipcp")){
+            optimize = true;
+            ipcp = true;
+        }
+        else if(argv[i] == std::string("-gdce")){
+            optimize = true;
+            gdce = true;
+        }
+        else if(argv[i] == std::string("-instcombine")){
+            optimize = true;
+            instcombine = true;
+        }
+        else if(argv[i] == std::string("-ifconv")){
+            optimize = true;
+            ifconv = true;
+        }
+        else if(argv[i] == std::string("-switch")){
+            optimize = true;
+            switch_formation = true;
+        }
+        else if(argv[i] == std::string("-vrp")){
+            optimize = true;
+            vrp = true;
+        }
+        else if(argv[i] == std::string("-jump-threading")){
+            optimize = true;
+            jump_threading = true;
+        }
+        else if(argv[i] == std::string("-unswitch")){
+            optimize = true;
+            unswitch = true;
+        }
+        else if(argv[i] == std::string("-pre")){
+            optimize = true;
+            pre = true;
+        }
+        else if(argv[i] == std::string("-fvr")){
+            optimize = true;
+            fvr = true;
+        }
+        else if(argv[i] == std::string("-vectorize")){
+            optimize = true;
+            vectorize = true;
+        }
+        else if(argv[i] == std::string("-slp")){
+            optimize = true;
+            slp = true;
+        }
+        else if(argv[i] == std::string("-divrem")){
+            optimize = true;
+            divrem = true;
+        }
         else if (argv[i] == std::string("-optimize-size")) {
             optimize = true;
             optimize_size = true;
         }
+        else if (std::string(argv[i]).compare(0, 8, "-passes=") == 0) {
+            optimize = true;
+            pipeline = std::string(argv[i]).substr(8);
+        }
+        else if (argv[i] == std::string("-verify=off")) {
+            verify_mode = IR::PassMgr::VerifyOff;
+        }
+        else if (argv[i] == std::string("-verify=pipeline")) {
+            verify_mode = IR::PassMgr::VerifyAfterPipeline;
+        }
+        else if (argv[i] == std::string("-verify=each")) {
+            verify_mode = IR::PassMgr::VerifyAfterEachPass;
+        }
+        else if (argv[i] == std::string("-stats")) {
+            stats = true;
+        }
+        else if (std::string(argv[i]).compare(0, 9, "-remarks=") == 0) {
+            remarks_file = std::string(argv[i]).substr(9);
+        }
         //  ...
         else {
             filename = argv[i];
@@ -101,34 +185,43 @@ int main(int argc, char *argv[])
         m->set_file_name(filename);
         m->set_print_name();
         if(optimize){
-            IR::PassMgr passmgr(m);
-            passmgr.addPass<IR::DominateTree>();
-            passmgr.addPass<IR::Mem2Reg>();
-            if(optimize_all){
-                passmgr.addPass<IR::LiveVar>();
-                passmgr.addPass<IR::ComSubExprEli>();
-                passmgr.addPass<IR::CodeSizeOptimizer>();
-                passmgr.addPass<IR::Check>();
-            }
-            else {
-                if(lv){
-                    passmgr.addPass<IR::LiveVar>();
-                    passmgr.addPass<IR::Check>();
-                }
-                if(cse){
-                    passmgr.addPass<IR::ComSubExprEli>();
-                    passmgr.addPass<IR::Check>();
+            if(pipeline.empty()){
+                pipeline = "domtree,mem2reg";
+                if(optimize_all){
+                    pipeline += ",lv,cse,ipcp,gdce,optimize-size,instcombine,vrp,jump-threading,unswitch,pre,"
+                                "ifconv,switch,fvr,vectorize,slp,divrem";
                 }
-                if(optimize_size){
-                    passmgr.addPass<IR::CodeSizeOptimizer>();
-                    passmgr.addPass<IR::Check>();
-                }
-                else{
-                    passmgr.addPass<IR::Check>();
+                else {
+                    // in this order, whatever the order of the flags
+                    std::pair<bool, const char *> passes[] = {
+                        {lv, "lv"}, {ipcp, "ipcp"}, {gdce, "gdce"}, {instcombine, "instcombine"},
+                        {vrp, "vrp"}, {jump_threading, "jump-threading"}, {unswitch, "unswitch"},
+                        {pre, "pre"}, {ifconv, "ifconv"}, {switch_formation, "switch"}, {fvr, "fvr"},
+                        {vectorize, "vectorize"}, {slp, "slp"}, {divrem, "divrem"}, {cse, "cse"},
+                        {optimize_size, "optimize-size"}};
+                    for(auto &pass : passes){
+                        if(pass.first){
+                            pipeline += std::string(",") + pass.second;
+                        }
+                    }
                 }
             }
+            IR::PassMgr passmgr(m);
+            passmgr.set_verify_mode(verify_mode);
+            std::string error;
+            if(!passmgr.parse_pipeline(pipeline, error)){
+                std::cerr << "Invalid pass pipeline: " << error << std::endl;
+                return 1;
+            }
+            if(!remarks_file.empty() && !IR::Remark::open(remarks_file)){
+                std::cerr << "Cannot write the remarks to " << remarks_file << std::endl;
+                return 1;
+            }
             passmgr.execute();
-            m->set_print_name();
+            IR::Remark::close();
+            if(stats){
+                IR::Statistic::print_all(std::cerr);
+            }
         }
         auto IR = m->print();
         if(output_llvm_file == "-"){
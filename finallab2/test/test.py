@@ -94,7 +94,21 @@ if __name__ == "__main__":
         "./Test/Easy",
         "./Test/Medium",
         "./Test/Hard",
-        "./Opt/CSE"
+        "./Opt/CSE",
+        "./Opt/IPCP",
+        "./Opt/GlobalDCE",
+        "./Opt/ArrayInit",
+        "./Opt/DivRem",
+        "./Opt/InstCombine",
+        "./Opt/ValueRange",
+        "./Opt/JumpThreading",
+        "./Opt/LoopUnswitch",
+        "./Opt/LazyCodeMotion",
+        "./Opt/IfConversion",
+        "./Opt/Switch",
+        "./Opt/FinalValue",
+        "./Opt/LoopVectorize",
+        "./Opt/SLP"
     ]
     # you can only modify this to add your testcase
     parser = argparse.ArgumentParser(description="Test script")
@@ -109,6 +123,45 @@ if __name__ == "__main__":
     parser.add_argument(
         "-cse", action="store_true", help="Enable common subexpression elimination"
     )
+    parser.add_argument(
+        "-ipcp", action="store_true", help="Enable interprocedural constant propagation"
+    )
+    parser.add_argument(
+        "-gdce", action="store_true", help="Enable global dead code elimination"
+    )
+    parser.add_argument(
+        "-instcombine", action="store_true", help="Enable instruction combining"
+    )
+    parser.add_argument(
+        "-vrp", action="store_true", help="Enable value range propagation"
+    )
+    parser.add_argument(
+        "-jump-threading", action="store_true", help="Enable jump threading"
+    )
+    parser.add_argument(
+        "-unswitch", action="store_true", help="Enable loop unswitching"
+    )
+    parser.add_argument(
+        "-pre", action="store_true", help="Enable partial redundancy elimination"
+    )
+    parser.add_argument(
+        "-ifconv", action="store_true", help="Enable branch to select conversion"
+    )
+    parser.add_argument(
+        "-switch", action="store_true", help="Enable compare chain to switch conversion"
+    )
+    parser.add_argument(
+        "-fvr", action="store_true", help="Enable final value replacement of loops"
+    )
+    parser.add_argument(
+        "-vectorize", action="store_true", help="Enable loop vectorization"
+    )
+    parser.add_argument(
+        "-slp", action="store_true", help="Enable straight-line code vectorization"
+    )
+    parser.add_argument(
+        "-divrem", action="store_true", help="Enable division by constant lowering"
+    )
     args = parser.parse_args()
     opts: list[str] = []
 
@@ -122,6 +175,32 @@ if __name__ == "__main__":
         opts.append("-lv")
     if args.cse:
         opts.append("-cse")
+    if args.ipcp:
+        opts.append("-ipcp")
+    if args.gdce:
+        opts.append("-gdce")
+    if args.instcombine:
+        opts.append("-instcombine")
+    if args.vrp:
+        opts.append("-vrp")
+    if args.jump_threading:
+        opts.append("-jump-threading")
+    if args.unswitch:
+        opts.append("-unswitch")
+    if args.pre:
+        opts.append("-pre")
+    if args.ifconv:
+        opts.append("-ifconv")
+    if args.switch:
+        opts.append("-switch")
+    if args.fvr:
+        opts.append("-fvr")
+    if args.vectorize:
+        opts.append("-vectorize")
+    if args.slp:
+        opts.append("-slp")
+    if args.divrem:
+        opts.append("-divrem")
     for TEST_BASE_PATH in TEST_DIRS:
         testcases: dict[str, bool] = {}  # { name: need_input }
         EXE_PATH = os.path.abspath("../build/compiler")
@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+import subprocess
+import os
+import shlex
+import sys
+import tempfile
+
+# A case is <name>.args in a test dir: the options of one run of the
+# compiler, with the .sy input relative to the dir. The compiler runs in a
+# temporary directory, where -lv leaves its live_var.out. <name>.out holds what
+# the compiler writes to stderr followed by its exit code. When the options
+# contain {remarks}, it is replaced by a temporary file with the extension of
+# <name>.remarks.yaml or <name>.remarks.json, which the file must match. The
+# options are not given to a shell, pipelines such as repeat<2>(cse) need no
+# quotes.
+
+def eprint(*objects: object, sep: str = " ", end: str = "\n", flush: bool = False):
+    print(*objects, sep=sep, end=end, file=sys.stderr, flush=flush)
+
+
+def run_command(cmd: list[str], cwd: str):
+    return subprocess.run(
+        cmd, capture_output=True, text=True, cwd=cwd
+    )
+
+
+def read_lines(path: str):
+    return [line for line in open(path).read().splitlines() if line]
+
+
+def task_eval(exe_path: str, test_base_path: str, testcases: list[str]):
+    eprint("===========TEST START===========")
+    eprint(f"now in {test_base_path}")
+    dir_succ = True
+    succ_count = 0
+    max_len = max(len(case) for case in testcases)
+    with tempfile.TemporaryDirectory() as tmp_dir:
+        for case in testcases:
+            eprint(f"Case \x1b[1m{case:<{max_len}}\x1b[0m", end="")
+            test_path = os.path.join(test_base_path, case)
+            args = open(test_path + ".args").read().strip()
+            remarks_answer = None
+            for ext in ["yaml", "json"]:
+                if os.path.exists(f"{test_path}.remarks.{ext}"):
+                    remarks_answer = f"{test_path}.remarks.{ext}"
+            remarks_path = None
+            if remarks_answer is not None:
+                remarks_path = os.path.join(tmp_dir, case + os.path.splitext(remarks_answer)[1])
+                args = args.replace("{remarks}", remarks_path)
+
+            ll_path = os.path.join(tmp_dir, case + ".ll")
+            options = [os.path.abspath(os.path.join(test_base_path, arg)) if arg.endswith(".sy") else arg
+                       for arg in shlex.split(args)]
+            result = run_command([exe_path, "-emit-ir", "-o", ll_path] + options, tmp_dir)
+            outs = result.stderr.splitlines()
+            outs.append(str(result.returncode))
+            outs = [line for line in outs if line]  # Remove empty line
+            case_succ = outs == read_lines(test_path + ".out")
+            if case_succ and remarks_path is not None:
+                case_succ = os.path.exists(remarks_path) and \
+                    read_lines(remarks_path) == read_lines(remarks_answer)
+            dir_succ = dir_succ and case_succ
+            if case_succ:
+                eprint("\t\x1b[1;32mPass\x1b[0m")
+                succ_count += 1
+            else:
+                eprint("\t\x1b[1;31mWrong Answer\x1b[0m")
+    eprint(
+        f"\t\x1b[1m{succ_count} Passed / {len(testcases) - succ_count} Failed\x1b[0m"
+    )
+    if dir_succ:
+        eprint(f"\t\x1b[1;32mSuccess\x1b[0m in dir {test_base_path}")
+    else:
+        eprint(f"\t\x1b[1;31mFail\x1b[0m in dir {test_base_path}")
+
+    eprint("============TEST END============")
+    return dir_succ
+
+if __name__ == "__main__":
+    # you can only modify this to add your testcase
+    TEST_DIRS = [
+        "./Cli/Verify",
+        "./Cli/Passes",
+        "./Cli/Report",
+    ]
+    # you can only modify this to add your testcase
+    succ = True
+    for TEST_BASE_PATH in TEST_DIRS:
+        EXE_PATH = os.path.abspath("../build/compiler")
+        testcases = sorted(name[:-len(".args")] for name in os.listdir(TEST_BASE_PATH) if name.endswith(".args"))
+        succ = task_eval(EXE_PATH, TEST_BASE_PATH, testcases) and succ
+    sys.exit(0 if succ else 1)